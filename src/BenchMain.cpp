@@ -0,0 +1,768 @@
+#include <QBuffer>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "BlpLoader.h"
+#include "MdxGenerator.h"
+#include "MdxLoader.h"
+#include "ModelAnim.h"
+#include "ModelData.h"
+#include "ParticleSim.h"
+
+// w3preview-bench: microbenchmarks for the loader / animation hot paths.
+// Inputs are synthesized from fixed seeds so numbers are comparable between builds;
+// generated MDX models come from MdxGenerator and only the optional corpus comes from disk.
+
+namespace
+{
+    constexpr std::uint32_t kSeed = 0x5EED1234u;
+    constexpr int kBlpSize = 256;
+
+    struct BenchOptions
+    {
+        int iterations = 200;
+        int warmup = 20;
+        QString filter;
+        QString corpus;
+    };
+
+    struct CaseResult
+    {
+        QString name;
+        int iterations = 0;
+        double items = 1.0; // work items per iteration (samples, vertices, bytes...)
+        QString itemUnit;
+        double minNs = 0.0;
+        double medianNs = 0.0;
+        double p90Ns = 0.0;
+        double p99Ns = 0.0;
+        double meanNs = 0.0;
+        double maxNs = 0.0;
+        bool ok = true;
+        QString error;
+    };
+
+    // Keeps results observable so the optimizer cannot drop the measured work.
+    volatile double g_sink = 0.0;
+
+    static double Percentile(const std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty())
+            return 0.0;
+        const double rank = p * double(sorted.size() - 1);
+        const std::size_t lo = std::size_t(rank);
+        const std::size_t hi = std::min(lo + 1, sorted.size() - 1);
+        const double frac = rank - double(lo);
+        return sorted[lo] + (sorted[hi] - sorted[lo]) * frac;
+    }
+
+    // Runs `fn` warmup + iterations times; each call is timed separately.
+    // `fn` returns false to abort the case (error already set by the caller).
+    static CaseResult RunCase(const QString& name, const BenchOptions& opt, double items, const QString& itemUnit,
+                              const std::function<bool()>& fn)
+    {
+        CaseResult r;
+        r.name = name;
+        r.items = items;
+        r.itemUnit = itemUnit;
+
+        for (int i = 0; i < opt.warmup; ++i)
+        {
+            if (!fn())
+            {
+                r.ok = false;
+                return r;
+            }
+        }
+
+        std::vector<double> samples;
+        samples.reserve(std::size_t(opt.iterations));
+        QElapsedTimer t;
+        for (int i = 0; i < opt.iterations; ++i)
+        {
+            t.start();
+            const bool ok = fn();
+            const double ns = double(t.nsecsElapsed());
+            if (!ok)
+            {
+                r.ok = false;
+                return r;
+            }
+            samples.push_back(ns);
+        }
+
+        std::sort(samples.begin(), samples.end());
+        r.iterations = int(samples.size());
+        if (!samples.empty())
+        {
+            double sum = 0.0;
+            for (double s : samples)
+                sum += s;
+            r.minNs = samples.front();
+            r.maxNs = samples.back();
+            r.meanNs = sum / double(samples.size());
+            r.medianNs = Percentile(samples, 0.50);
+            r.p90Ns = Percentile(samples, 0.90);
+            r.p99Ns = Percentile(samples, 0.99);
+        }
+        return r;
+    }
+
+    // ---- Synthetic BLP files ----
+
+    static void PutU32(QByteArray& b, std::uint32_t v)
+    {
+        const char bytes[4] = { char(v & 0xFF), char((v >> 8) & 0xFF), char((v >> 16) & 0xFF), char((v >> 24) & 0xFF) };
+        b.append(bytes, 4);
+    }
+
+    static void PutU8(QByteArray& b, std::uint8_t v)
+    {
+        b.append(char(v));
+    }
+
+    static QByteArray RandomBytes(std::size_t count, std::mt19937& rng)
+    {
+        QByteArray b;
+        b.resize(int(count));
+        for (std::size_t i = 0; i < count; ++i)
+            b[int(i)] = char(rng() & 0xFF);
+        return b;
+    }
+
+    // Mipmap locator with only level 0 filled.
+    static void PutMipTable(QByteArray& b, std::uint32_t offset0, std::uint32_t size0)
+    {
+        PutU32(b, offset0);
+        for (int i = 1; i < 16; ++i)
+            PutU32(b, 0);
+        PutU32(b, size0);
+        for (int i = 1; i < 16; ++i)
+            PutU32(b, 0);
+    }
+
+    // BLP1 direct content: 256 palette entries, indices + packed alpha.
+    static QByteArray MakeBlp1Palettized(int size, std::uint32_t alphaBits)
+    {
+        std::mt19937 rng(kSeed + alphaBits);
+        const std::uint32_t pixels = std::uint32_t(size) * std::uint32_t(size);
+        const std::uint32_t alphaLen = (pixels * alphaBits + 7) / 8;
+        const std::uint32_t headerSize = 7 * 4 + 16 * 4 * 2 + 256 * 4;
+
+        QByteArray b;
+        b.append("BLP1", 4);
+        PutU32(b, 1); // content: direct
+        PutU32(b, alphaBits);
+        PutU32(b, std::uint32_t(size));
+        PutU32(b, std::uint32_t(size));
+        PutU32(b, 4); // extra
+        PutU32(b, 0); // hasMipmaps
+        PutMipTable(b, headerSize, pixels + alphaLen);
+        b.append(RandomBytes(256 * 4, rng));
+        b.append(RandomBytes(pixels + alphaLen, rng));
+        return b;
+    }
+
+    // BLP2 DXT content (alphaEncoding 0=DXT1, 1=DXT3, 7=DXT5); random blocks are valid DXT data.
+    static QByteArray MakeBlp2Dxt(int size, std::uint8_t alphaEncoding)
+    {
+        std::mt19937 rng(kSeed + alphaEncoding);
+        const std::uint32_t blocks = std::uint32_t((size + 3) / 4) * std::uint32_t((size + 3) / 4);
+        const std::uint32_t dataSize = blocks * (alphaEncoding == 0 ? 8u : 16u);
+        const std::uint32_t headerSize = 4 + 4 + 4 + 8 + 16 * 4 * 2 + 256 * 4;
+
+        QByteArray b;
+        b.append("BLP2", 4);
+        PutU32(b, 1); // content: direct
+        PutU8(b, 2);  // encoding: DXT
+        PutU8(b, alphaEncoding == 0 ? 0 : 8);
+        PutU8(b, alphaEncoding);
+        PutU8(b, 0);  // hasMipmaps
+        PutU32(b, std::uint32_t(size));
+        PutU32(b, std::uint32_t(size));
+        PutMipTable(b, headerSize, dataSize);
+        b.append(QByteArray(256 * 4, '\0'));
+        b.append(RandomBytes(dataSize, rng));
+        return b;
+    }
+
+    // BLP1 JPEG content: empty shared header, whole JPEG stream in mipmap 0.
+    static QByteArray MakeBlp1Jpeg(int size, QString* outError)
+    {
+        QImage img(size, size, QImage::Format_RGB32);
+        for (int y = 0; y < size; ++y)
+        {
+            QRgb* row = reinterpret_cast<QRgb*>(img.scanLine(y));
+            for (int x = 0; x < size; ++x)
+                row[x] = qRgb((x * 7) & 0xFF, (y * 5) & 0xFF, ((x ^ y) * 3) & 0xFF);
+        }
+
+        QByteArray jpeg;
+        QBuffer buf(&jpeg);
+        buf.open(QIODevice::WriteOnly);
+        if (!img.save(&buf, "JPG", 90))
+        {
+            if (outError) *outError = "No JPEG image writer available.";
+            return {};
+        }
+
+        const std::uint32_t headerSize = 7 * 4 + 16 * 4 * 2 + 4;
+        QByteArray b;
+        b.append("BLP1", 4);
+        PutU32(b, 0); // content: JPEG
+        PutU32(b, 8);
+        PutU32(b, std::uint32_t(size));
+        PutU32(b, std::uint32_t(size));
+        PutU32(b, 4);
+        PutU32(b, 0);
+        PutMipTable(b, headerSize, std::uint32_t(jpeg.size()));
+        PutU32(b, 0); // JPEG header size
+        b.append(jpeg);
+        return b;
+    }
+
+    // ---- Synthetic animation data ----
+
+    template<typename T>
+    static MdxTrack<T> MakeTrack(MdxInterp interp, int keyCount, std::uint32_t durationMs,
+                                 const std::function<T(std::mt19937&)>& value, std::mt19937& rng)
+    {
+        MdxTrack<T> tr;
+        tr.interp = interp;
+        tr.keys.resize(std::size_t(keyCount));
+        for (int i = 0; i < keyCount; ++i)
+        {
+            auto& k = tr.keys[std::size_t(i)];
+            k.timeMs = std::uint32_t(std::uint64_t(durationMs) * std::uint64_t(i) / std::uint64_t(std::max(1, keyCount - 1)));
+            k.value = value(rng);
+            k.inTan = value(rng);
+            k.outTan = value(rng);
+        }
+        return tr;
+    }
+
+    static float RandRange(std::mt19937& rng, float lo, float hi)
+    {
+        return std::uniform_real_distribution<float>(lo, hi)(rng);
+    }
+
+    static Vec3 RandVec3(std::mt19937& rng)
+    {
+        return { RandRange(rng, -10.0f, 10.0f), RandRange(rng, -10.0f, 10.0f), RandRange(rng, -10.0f, 10.0f) };
+    }
+
+    static Vec4 RandQuat(std::mt19937& rng)
+    {
+        Vec4 q{ RandRange(rng, -1.0f, 1.0f), RandRange(rng, -1.0f, 1.0f), RandRange(rng, -1.0f, 1.0f), RandRange(rng, -1.0f, 1.0f) };
+        const float len = std::sqrt(q.x*q.x + q.y*q.y + q.z*q.z + q.w*q.w);
+        if (len <= 0.000001f)
+            return {0, 0, 0, 1};
+        return { q.x / len, q.y / len, q.z / len, q.w / len };
+    }
+
+    // Balanced binary bone tree with animated TRS, one sequence and skinned vertices.
+    static ModelData MakeAnimatedModel(int boneCount, int vertexCount, int keyCount, MdxInterp interp)
+    {
+        std::mt19937 rng(kSeed);
+        const std::uint32_t durationMs = 10000;
+
+        ModelData m;
+        ModelData::Sequence seq;
+        seq.name = "Stand";
+        seq.startMs = 0;
+        seq.endMs = durationMs;
+        m.sequences.push_back(seq);
+
+        m.maxObjectId = boneCount - 1;
+        m.nodeCount = boneCount;
+        m.nodeIdToIndex.assign(std::size_t(boneCount), -1);
+        for (int i = 0; i < boneCount; ++i)
+        {
+            ModelData::Node n;
+            n.name = "Bone" + std::to_string(i);
+            n.type = "BONE";
+            n.objectId = i;
+            n.parentId = (i == 0) ? -1 : (i - 1) / 2;
+            n.pivot = RandVec3(rng);
+            n.trackTranslation = MakeTrack<Vec3>(interp, keyCount, durationMs, RandVec3, rng);
+            n.trackRotation = MakeTrack<Vec4>(interp, keyCount, durationMs, RandQuat, rng);
+            n.trackScaling = MakeTrack<Vec3>(interp, keyCount, durationMs,
+                                              [](std::mt19937& r) { const float s = RandRange(r, 0.8f, 1.2f); return Vec3{s, s, s}; }, rng);
+            m.nodeIdToIndex[std::size_t(i)] = int(m.nodes.size());
+            m.boneNodeIds.push_back(i);
+            m.nodes.push_back(std::move(n));
+        }
+
+        const int groupCount = std::max(1, boneCount * 2);
+        for (int g = 0; g < groupCount; ++g)
+        {
+            ModelData::SkinGroup group;
+            const int size = 1 + int(rng() % 4u);
+            for (int k = 0; k < size; ++k)
+                group.nodeIndices.push_back(std::int32_t(rng() % std::uint32_t(boneCount)));
+            m.skinGroups.push_back(std::move(group));
+        }
+
+        m.bindVertices.resize(std::size_t(vertexCount));
+        m.vertexGroups.resize(std::size_t(vertexCount));
+        for (int i = 0; i < vertexCount; ++i)
+        {
+            auto& v = m.bindVertices[std::size_t(i)];
+            const Vec3 p = RandVec3(rng);
+            v.px = p.x; v.py = p.y; v.pz = p.z;
+            v.nx = 0; v.ny = 0; v.nz = 1;
+            m.vertexGroups[std::size_t(i)] = std::uint16_t(rng() % std::uint32_t(groupCount));
+        }
+        m.vertices = m.bindVertices;
+        return m;
+    }
+
+    static void AddEmitters(ModelData& m, int emitterCount)
+    {
+        std::mt19937 rng(kSeed + 7);
+        for (int i = 0; i < emitterCount; ++i)
+        {
+            ModelData::ParticleEmitter2 e;
+            e.name = "Emitter" + std::to_string(i);
+            e.objectId = int(rng() % std::uint32_t(std::max(1, m.maxObjectId + 1)));
+            e.speed = RandRange(rng, 50.0f, 200.0f);
+            e.variation = 0.2f;
+            e.latitude = RandRange(rng, 0.1f, 1.0f);
+            e.gravity = RandRange(rng, 0.0f, 100.0f);
+            e.lifespan = 2.0f;
+            e.emissionRate = 100.0f;
+            e.width = 10.0f;
+            e.length = 10.0f;
+            e.headOrTail = (i % 3 == 0) ? 2 : 0;
+            e.flags = (i % 2 == 0) ? 0x80000u : 0u; // alternate model-space emitters
+            m.emitters2.push_back(std::move(e));
+        }
+    }
+
+    static QStringList CollectCorpus(const QString& root)
+    {
+        QStringList files;
+        QDirIterator it(root, QStringList() << "*.mdx", QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext())
+            files << it.next();
+        files.sort(Qt::CaseInsensitive);
+        return files;
+    }
+
+    static QJsonObject CaseToJson(const CaseResult& r)
+    {
+        QJsonObject o;
+        o["name"] = r.name;
+        o["ok"] = r.ok;
+        if (!r.ok)
+        {
+            o["error"] = r.error;
+            return o;
+        }
+        o["iterations"] = r.iterations;
+        o["items"] = r.items;
+        o["itemUnit"] = r.itemUnit;
+        o["minNs"] = r.minNs;
+        o["medianNs"] = r.medianNs;
+        o["p90Ns"] = r.p90Ns;
+        o["p99Ns"] = r.p99Ns;
+        o["meanNs"] = r.meanNs;
+        o["maxNs"] = r.maxNs;
+        o["medianNsPerItem"] = r.items > 0.0 ? r.medianNs / r.items : 0.0;
+        return o;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("w3preview-bench");
+    QCoreApplication::setApplicationVersion("0.1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Microbenchmarks for the MDX/BLP loaders and the animation kernels.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    const QCommandLineOption itersOpt(QStringList() << "n" << "iterations", "Timed iterations per case (default 200).", "n", "200");
+    const QCommandLineOption warmupOpt(QStringList() << "w" << "warmup", "Untimed warmup iterations per case (default 20).", "n", "20");
+    const QCommandLineOption filterOpt(QStringList() << "f" << "filter", "Only run cases whose name contains <text>.", "text");
+    const QCommandLineOption corpusOpt("corpus", "Folder of .mdx files for the LoadFromBytes case.", "dir");
+    const QCommandLineOption outOpt(QStringList() << "o" << "out", "Write the JSON report to <file> instead of stdout.", "file");
+    const QCommandLineOption listOpt("list", "Print case names and exit.");
+    parser.addOption(itersOpt);
+    parser.addOption(warmupOpt);
+    parser.addOption(filterOpt);
+    parser.addOption(corpusOpt);
+    parser.addOption(outOpt);
+    parser.addOption(listOpt);
+    parser.process(app);
+
+    BenchOptions opt;
+    opt.iterations = std::max(1, parser.value(itersOpt).toInt());
+    opt.warmup = std::max(0, parser.value(warmupOpt).toInt());
+    opt.filter = parser.value(filterOpt);
+    opt.corpus = parser.value(corpusOpt);
+
+    struct Case
+    {
+        QString name;
+        std::function<CaseResult()> run;
+    };
+    std::vector<Case> cases;
+    QJsonArray skipped;
+
+    auto skip = [&](const QString& name, const QString& reason)
+    {
+        QJsonObject o;
+        o["name"] = name;
+        o["reason"] = reason;
+        skipped.append(o);
+    };
+
+    // ---- MdxLoader::LoadFromBytes over a corpus (one iteration = every file once) ----
+    std::vector<QByteArray> corpus;
+    double corpusBytes = 0.0;
+    if (!opt.corpus.isEmpty())
+    {
+        for (const QString& path : CollectCorpus(opt.corpus))
+        {
+            QFile f(path);
+            if (!f.open(QIODevice::ReadOnly))
+                continue;
+            corpus.push_back(f.readAll());
+            corpusBytes += double(corpus.back().size());
+        }
+    }
+    if (corpus.empty())
+    {
+        skip("mdx.load_corpus", opt.corpus.isEmpty() ? "no --corpus given" : "no .mdx files in corpus");
+    }
+    else
+    {
+        cases.push_back({"mdx.load_corpus", [&]()
+        {
+            return RunCase("mdx.load_corpus", opt, corpusBytes, "byte", [&]()
+            {
+                for (const QByteArray& bytes : corpus)
+                {
+                    const auto m = MdxLoader::LoadFromBytes(bytes);
+                    g_sink = g_sink + (m ? double(m->vertices.size()) : 0.0);
+                }
+                return true;
+            });
+        }});
+    }
+
+    // ---- MdxLoader::LoadFromBytes over generated models (deep / wide rigs, long tracks) ----
+    std::vector<MdxGenerator::Params> generated(4);
+    generated[0].verticesPerGeoset = 1024;
+    generated[1].geosets = 4;
+    generated[1].verticesPerGeoset = 16384;
+    generated[1].bones = 128;
+    generated[1].hierarchy = MdxGenerator::Hierarchy::Chain;
+    generated[1].keysPerTrack = 32;
+    generated[1].interp = MdxGenerator::InterpMode::Hermite;
+    generated[2].bones = 512;
+    generated[2].hierarchy = MdxGenerator::Hierarchy::Wide;
+    generated[2].keysPerTrack = 256;
+    generated[2].interp = MdxGenerator::InterpMode::Mixed;
+    generated[3].emitters = 64;
+    generated[3].keysPerTrack = 64;
+    generated[3].interp = MdxGenerator::InterpMode::Bezier;
+    for (const MdxGenerator::Params& p : generated)
+    {
+        const QString name = "mdx.load_generated." + MdxGenerator::Describe(p);
+        const QByteArray bytes = MdxGenerator::Generate(p);
+        cases.push_back({name, [&opt, name, bytes]()
+        {
+            return RunCase(name, opt, double(bytes.size()), "byte", [&bytes]()
+            {
+                const auto m = MdxLoader::LoadFromBytes(bytes);
+                g_sink = g_sink + (m ? double(m->vertices.size()) : 0.0);
+                return bool(m);
+            });
+        }});
+    }
+
+    // ---- BlpLoader decode paths (256x256, mipmap 0 only) ----
+    struct BlpCase
+    {
+        QString name;
+        QByteArray bytes;
+        QString prepError;
+    };
+    std::vector<BlpCase> blpCases;
+    for (std::uint32_t alphaBits : {0u, 1u, 4u, 8u})
+        blpCases.push_back({QString("blp.palettized.alpha%1").arg(alphaBits), MakeBlp1Palettized(kBlpSize, alphaBits), {}});
+    blpCases.push_back({"blp.dxt1", MakeBlp2Dxt(kBlpSize, 0), {}});
+    blpCases.push_back({"blp.dxt3", MakeBlp2Dxt(kBlpSize, 1), {}});
+    blpCases.push_back({"blp.dxt5", MakeBlp2Dxt(kBlpSize, 7), {}});
+    {
+        BlpCase jpeg;
+        jpeg.name = "blp.jpeg";
+        jpeg.bytes = MakeBlp1Jpeg(kBlpSize, &jpeg.prepError);
+        blpCases.push_back(jpeg);
+    }
+    for (const BlpCase& bc : blpCases)
+    {
+        if (bc.bytes.isEmpty())
+        {
+            skip(bc.name, bc.prepError);
+            continue;
+        }
+        cases.push_back({bc.name, [&opt, bc]()
+        {
+            QString err;
+            CaseResult r = RunCase(bc.name, opt, double(kBlpSize) * double(kBlpSize), "pixel", [&]()
+            {
+                QImage img;
+                if (!BlpLoader::LoadFromBytes(bc.bytes, &img, &err))
+                    return false;
+                g_sink = g_sink + double(img.width());
+                return true;
+            });
+            r.error = err;
+            return r;
+        }});
+    }
+
+    // ---- Track sampling per interpolation mode (1024 sample times over 64 keys) ----
+    const std::uint32_t trackDuration = 10000;
+    const int trackKeys = 64;
+    const int sampleCount = 1024;
+    const ModelData emptyModel;
+    std::vector<std::uint32_t> sampleTimes(std::size_t(sampleCount));
+    {
+        std::mt19937 rng(kSeed + 3);
+        for (auto& t : sampleTimes)
+            t = rng() % (trackDuration + 1);
+    }
+    const struct { MdxInterp interp; const char* name; } interps[] = {
+        { MdxInterp::None, "none" },
+        { MdxInterp::Linear, "linear" },
+        { MdxInterp::Hermite, "hermite" },
+        { MdxInterp::Bezier, "bezier" },
+    };
+    for (const auto& mode : interps)
+    {
+        std::mt19937 rng(kSeed + 11 + std::uint32_t(mode.interp));
+        const auto floatTrack = MakeTrack<float>(mode.interp, trackKeys, trackDuration,
+                                                 [](std::mt19937& r) { return RandRange(r, -1.0f, 1.0f); }, rng);
+        const auto vecTrack = MakeTrack<Vec3>(mode.interp, trackKeys, trackDuration, RandVec3, rng);
+        const auto quatTrack = MakeTrack<Vec4>(mode.interp, trackKeys, trackDuration, RandQuat, rng);
+
+        const QString base = QString("track.%1").arg(mode.name);
+        cases.push_back({base + ".float", [&, floatTrack, base]()
+        {
+            return RunCase(base + ".float", opt, double(sampleCount), "sample", [&]()
+            {
+                float acc = 0.0f;
+                for (std::uint32_t t : sampleTimes)
+                    acc += ModelAnim::SampleTrackFloat(floatTrack, t, 0.0f, emptyModel);
+                g_sink = g_sink + double(acc);
+                return true;
+            });
+        }});
+        cases.push_back({base + ".vec3", [&, vecTrack, base]()
+        {
+            return RunCase(base + ".vec3", opt, double(sampleCount), "sample", [&]()
+            {
+                float acc = 0.0f;
+                for (std::uint32_t t : sampleTimes)
+                    acc += ModelAnim::SampleTrackVec3(vecTrack, t, Vec3{}, emptyModel).x;
+                g_sink = g_sink + double(acc);
+                return true;
+            });
+        }});
+        cases.push_back({base + ".quat", [&, quatTrack, base]()
+        {
+            return RunCase(base + ".quat", opt, double(sampleCount), "sample", [&]()
+            {
+                float acc = 0.0f;
+                for (std::uint32_t t : sampleTimes)
+                    acc += ModelAnim::SampleTrackQuat(quatTrack, t, Vec4{}, emptyModel).w;
+                g_sink = g_sink + double(acc);
+                return true;
+            });
+        }});
+    }
+
+    // ---- Node hierarchy, skinning and particles on one synthetic rig ----
+    const int boneCount = 128;
+    const int vertexCount = 16384;
+    ModelData rig = MakeAnimatedModel(boneCount, vertexCount, 32, MdxInterp::Hermite);
+    AddEmitters(rig, 8);
+
+    cases.push_back({"anim.compute_node_world", [&]()
+    {
+        std::vector<QMatrix4x4> world;
+        std::uint32_t t = 0;
+        return RunCase("anim.compute_node_world", opt, double(boneCount), "node", [&]()
+        {
+            ModelAnim::ComputeNodeWorld(rig, t, world);
+            t = (t + 16) % 10000;
+            g_sink = g_sink + double(world.back()(0, 3));
+            return true;
+        });
+    }});
+
+    cases.push_back({"anim.skin_vertices", [&]()
+    {
+        std::vector<QMatrix4x4> bind;
+        std::vector<QMatrix4x4> anim;
+        ModelAnim::ComputeNodeWorld(rig, 0, bind);
+        ModelAnim::ComputeNodeWorld(rig, 5000, anim);
+        std::vector<QMatrix4x4> skinMats(anim.size());
+        for (std::size_t i = 0; i < anim.size(); ++i)
+            skinMats[i] = anim[i] * bind[i].inverted();
+        std::vector<ModelVertex> out;
+        return RunCase("anim.skin_vertices", opt, double(vertexCount), "vertex", [&]()
+        {
+            ModelAnim::SkinVertices(rig, skinMats, out);
+            g_sink = g_sink + double(out.back().px);
+            return true;
+        });
+    }});
+
+    cases.push_back({"particles.step", [&]()
+    {
+        // Steady state first: 3 simulated seconds at 60 Hz before warmup.
+        std::vector<ParticleSim::EmitterState> emitters;
+        ModelAnim::NodePose pose;
+        ParticleSim::StepParams params;
+        params.dtSeconds = 1.0f / 60.0f;
+        params.seed = kSeed;
+        auto step = [&]()
+        {
+            params.localTimeMs += 16;
+            params.globalTimeMs = params.localTimeMs % 10000;
+            ModelAnim::ComputeNodePose(rig, params.globalTimeMs, pose);
+            ParticleSim::StepEmitters(rig, pose, params, emitters);
+        };
+        for (int i = 0; i < 180; ++i)
+            step();
+
+        std::size_t live = 0;
+        for (const auto& e : emitters)
+            live += e.particles.size();
+
+        return RunCase("particles.step", opt, double(std::max<std::size_t>(1, live)), "particle", [&]()
+        {
+            step();
+            g_sink = g_sink + double(emitters.front().particles.size());
+            return true;
+        });
+    }});
+
+    // Dense effect: ~100k live particles across 20 emitters.
+    ModelData denseRig = MakeAnimatedModel(32, 64, 8, MdxInterp::Linear);
+    AddEmitters(denseRig, 20);
+    for (auto& e : denseRig.emitters2)
+        e.emissionRate = 1250.0f; // x2 in the sim, 2 s lifespan -> ~5000 live each
+
+    cases.push_back({"particles.step_dense", [&]()
+    {
+        std::vector<ParticleSim::EmitterState> emitters;
+        ModelAnim::NodePose pose;
+        ParticleSim::StepParams params;
+        params.dtSeconds = 1.0f / 60.0f;
+        params.maxParticlesPerEmitter = 8192;
+        params.seed = kSeed;
+        auto step = [&]()
+        {
+            params.localTimeMs += 16;
+            params.globalTimeMs = params.localTimeMs % 10000;
+            ModelAnim::ComputeNodePose(denseRig, params.globalTimeMs, pose);
+            ParticleSim::StepEmitters(denseRig, pose, params, emitters);
+        };
+        for (int i = 0; i < 180; ++i)
+            step();
+
+        std::size_t live = 0;
+        for (const auto& e : emitters)
+            live += e.particles.size();
+
+        return RunCase("particles.step_dense", opt, double(std::max<std::size_t>(1, live)), "particle", [&]()
+        {
+            step();
+            g_sink = g_sink + double(emitters.front().particles.size());
+            return true;
+        });
+    }});
+
+    if (parser.isSet(listOpt))
+    {
+        for (const Case& c : cases)
+            std::printf("%s\n", qPrintable(c.name));
+        return 0;
+    }
+
+    QJsonArray results;
+    int failed = 0;
+    for (const Case& c : cases)
+    {
+        if (!opt.filter.isEmpty() && !c.name.contains(opt.filter, Qt::CaseInsensitive))
+            continue;
+        std::fprintf(stderr, "%s...\n", qPrintable(c.name));
+        const CaseResult r = c.run();
+        if (!r.ok)
+        {
+            failed++;
+            std::fprintf(stderr, "  failed: %s\n", qPrintable(r.error));
+        }
+        results.append(CaseToJson(r));
+    }
+
+    QJsonObject root;
+    root["tool"] = "w3preview-bench";
+    root["version"] = QCoreApplication::applicationVersion();
+    root["qt"] = QString::fromLatin1(qVersion());
+#ifdef NDEBUG
+    root["build"] = "release";
+#else
+    root["build"] = "debug";
+#endif
+    root["iterations"] = opt.iterations;
+    root["warmup"] = opt.warmup;
+    root["seed"] = double(kSeed);
+    root["cases"] = results;
+    root["skipped"] = skipped;
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+
+    const QString outPath = parser.value(outOpt);
+    if (outPath.isEmpty())
+    {
+        std::fwrite(json.constData(), 1, std::size_t(json.size()), stdout);
+    }
+    else
+    {
+        QFile f(outPath);
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            std::fprintf(stderr, "Cannot write report: %s\n", qPrintable(outPath));
+            return 1;
+        }
+        f.write(json);
+    }
+
+    return failed > 0 ? 1 : 0;
+}
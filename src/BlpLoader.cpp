@@ -7,6 +7,8 @@
 #include <QMutexLocker>
 #include <QtGlobal>
 
+#include "Trace.h"
+
 namespace
 {
     struct Reader
@@ -351,9 +353,9 @@ namespace BlpLoader
                 setErr(outError, "Failed reading BLP2 fields.");
                 return false;
             }
-            // BLP2 layout: alphaBits, alphaType, hasMipmaps, unknown
-            alphaBits = encodingType;
-            alphaType = alphaBits_u8;
+            // BLP2 layout: encoding (1=palette, 2=DXT, 3=ARGB), alphaDepth, alphaEncoding (0=DXT1, 1=DXT3, 7=DXT5), hasMipmaps
+            alphaBits = alphaBits_u8;
+            alphaType = sampleType;
         }
         else
         {
@@ -403,10 +405,9 @@ namespace BlpLoader
         // Content header
         QByteArray jpegHeader;
         quint32 palette[256] = {};
-        const quint32 compression = (version >= 2) ? content : 0;
-        const bool isJpeg = (version >= 2) ? (compression == 0) : (content == 0);
-        const bool isPaletted = (version >= 2) ? (compression == 2) : (content == 1);
-        const bool isDxt = (version >= 2) ? (compression == 1) : false;
+        const bool isJpeg = (content == 0);
+        const bool isPaletted = (version >= 2) ? (content == 1 && encodingType == 1) : (content == 1);
+        const bool isDxt = (version >= 2) && content == 1 && encodingType == 2;
 
         if (isJpeg) // JPEG
         {
@@ -428,7 +429,7 @@ namespace BlpLoader
                 return false;
             }
         }
-        else if (isPaletted) // Paletted
+        else if (isPaletted || isDxt) // Paletted (BLP2 stores the palette for DXT as well)
         {
             for (int i = 0; i < 256; ++i)
             {
@@ -527,6 +528,13 @@ namespace BlpLoader
                 setErr(outError, "Invalid dimensions.");
                 return false;
             }
+            const quint64 blockBytes = (alphaType == 1 || alphaType == 7) ? 16 : 8;
+            const quint64 needed = quint64((width + 3) / 4) * quint64((height + 3) / 4) * blockBytes;
+            if (needed > size0)
+            {
+                setErr(outError, "DXT mipmap data too small for expected block count.");
+                return false;
+            }
             std::vector<quint8> rgba;
             if (alphaType == 0)
                 decodeDxt1(mip0, width, height, rgba);
@@ -588,7 +596,12 @@ namespace BlpLoader
             setErr(outError, QString("Failed to open: %1").arg(filePath));
             return false;
         }
-        const QByteArray bytes = f.readAll();
+        QByteArray bytes;
+        {
+            Trace::Scope trace("io", "ReadFile", filePath);
+            bytes = f.readAll();
+        }
+        Trace::Scope trace("blp", "DecodeBlp", filePath);
         return LoadFromBytesInternal(bytes, outImage, outError);
     }
 
@@ -631,6 +644,7 @@ namespace BlpLoader
 
     bool LoadBlpToImageFromBytes(const QByteArray& bytes, QImage* outImage, QString* outError)
     {
+        Trace::Scope trace("blp", "DecodeBlp");
         return LoadFromBytesInternal(bytes, outImage, outError);
     }
 }
@@ -0,0 +1,575 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "BlpLoader.h"
+#include "LogSink.h"
+#include "MdlWriter.h"
+#include "MdxLoader.h"
+#include "MdxValidator.h"
+#include "Trace.h"
+#include "Vfs.h"
+#include "WorkStealing.h"
+
+// w3preview-cli: headless batch validate / summarize / convert over a folder tree or an MPQ.
+
+namespace
+{
+    enum class Command
+    {
+        Validate,
+        Summarize,
+        Convert
+    };
+
+    enum class FileKind
+    {
+        Mdx,
+        Blp
+    };
+
+    struct Options
+    {
+        Command command = Command::Validate;
+        QString input;
+        QString outDir;
+        int jobs = 1;
+        bool mdx = true;
+        bool blp = true;
+    };
+
+    struct Job
+    {
+        QString source; // disk path, or path inside the MPQ
+        QString relPath;
+        FileKind kind = FileKind::Mdx;
+    };
+
+    struct FileReport
+    {
+        QString path;
+        FileKind kind = FileKind::Mdx;
+        bool ok = false;
+        QString error;
+        qint64 bytes = 0;
+        double readMs = 0.0;
+        double parseMs = 0.0;
+        double convertMs = 0.0;
+        double validateMs = 0.0;
+        QString output;
+        QStringList issues; // "check: message"
+
+        // MDX summary
+        int vertices = 0;
+        int triangles = 0;
+        int geosets = 0;
+        int materials = 0;
+        int textures = 0;
+        int sequences = 0;
+        int nodes = 0;
+        int emitters = 0;
+        std::uint32_t mdxVersion = 0;
+
+        // BLP summary
+        int width = 0;
+        int height = 0;
+    };
+
+    static QString CommandName(Command c)
+    {
+        switch (c)
+        {
+        case Command::Validate: return "validate";
+        case Command::Summarize: return "summarize";
+        case Command::Convert: return "convert";
+        }
+        return "validate";
+    }
+
+    static QString KindName(FileKind k)
+    {
+        return k == FileKind::Mdx ? "mdx" : "blp";
+    }
+
+    static double ElapsedMs(const QElapsedTimer& t)
+    {
+        return double(t.nsecsElapsed()) / 1.0e6;
+    }
+
+    static bool KindFromName(const QString& fileName, const Options& opt, FileKind* outKind)
+    {
+        const QString lower = fileName.toLower();
+        if (opt.mdx && lower.endsWith(".mdx"))
+        {
+            *outKind = FileKind::Mdx;
+            return true;
+        }
+        if (opt.blp && lower.endsWith(".blp"))
+        {
+            *outKind = FileKind::Blp;
+            return true;
+        }
+        return false;
+    }
+
+    static std::vector<Job> CollectDiskJobs(const QString& root, const Options& opt)
+    {
+        std::vector<Job> jobs;
+        QDir base(root);
+        QDirIterator it(root, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext())
+        {
+            const QString path = it.next();
+            Job job;
+            if (!KindFromName(path, opt, &job.kind))
+                continue;
+            job.source = path;
+            job.relPath = base.relativeFilePath(path);
+            jobs.push_back(job);
+        }
+        std::sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b)
+        {
+            return QString::compare(a.relPath, b.relPath, Qt::CaseInsensitive) < 0;
+        });
+        return jobs;
+    }
+
+    static std::vector<Job> CollectMpqJobs(const MpqVfs& mpq, const Options& opt)
+    {
+        QStringList names;
+        if (opt.mdx)
+            names << mpq.listFiles("*.mdx");
+        if (opt.blp)
+            names << mpq.listFiles("*.blp");
+        names.sort(Qt::CaseInsensitive);
+
+        std::vector<Job> jobs;
+        for (const auto& name : names)
+        {
+            Job job;
+            if (!KindFromName(name, opt, &job.kind))
+                continue;
+            job.source = name;
+            job.relPath = QString(name).replace('\\', '/');
+            jobs.push_back(job);
+        }
+        return jobs;
+    }
+
+    static QString OutputPath(const Options& opt, const QString& relPath, const QString& suffix)
+    {
+        const QFileInfo fi(relPath);
+        const QString dir = fi.path() == "." ? QString() : fi.path();
+        return QDir(QDir(opt.outDir).filePath(dir)).filePath(fi.completeBaseName() + "." + suffix);
+    }
+
+    static FileReport ProcessJob(const Job& job, const Options& opt, const MpqVfs* mpq)
+    {
+        FileReport r;
+        r.path = job.relPath;
+        r.kind = job.kind;
+
+        QElapsedTimer t;
+        t.start();
+        QByteArray bytes;
+        if (mpq)
+        {
+            bytes = mpq->readAll(job.source);
+        }
+        else
+        {
+            QFile f(job.source);
+            if (f.open(QIODevice::ReadOnly))
+                bytes = f.readAll();
+        }
+        r.readMs = ElapsedMs(t);
+        r.bytes = bytes.size();
+        if (bytes.isEmpty())
+        {
+            r.error = "Read failed or empty file.";
+            return r;
+        }
+
+        QString err;
+        t.restart();
+        if (job.kind == FileKind::Mdx)
+        {
+            const auto model = MdxLoader::LoadFromBytes(bytes, &err);
+            r.parseMs = ElapsedMs(t);
+            if (!model)
+            {
+                r.error = err;
+                return r;
+            }
+
+            r.vertices = int(model->vertices.size());
+            r.triangles = int(model->indices.size() / 3);
+            r.geosets = int(model->geosetCount);
+            r.materials = int(model->materials.size());
+            r.textures = int(model->textures.size());
+            r.sequences = int(model->sequences.size());
+            r.nodes = int(model->nodes.size());
+            r.emitters = int(model->emitters2.size());
+            r.mdxVersion = model->mdxVersion;
+
+            if (opt.command == Command::Validate)
+            {
+                t.restart();
+                for (const auto& issue : MdxValidator::ValidateModel(*model))
+                    r.issues << QString("%1: %2").arg(issue.check, issue.message);
+                r.validateMs = ElapsedMs(t);
+                if (!r.issues.isEmpty())
+                {
+                    r.error = QString("%1 validation issue(s)").arg(r.issues.size());
+                    return r;
+                }
+            }
+
+            if (opt.command == Command::Convert)
+            {
+                t.restart();
+                r.output = OutputPath(opt, job.relPath, "mdl");
+                QDir().mkpath(QFileInfo(r.output).absolutePath());
+                const bool written = MdlWriter::WriteModel(*model, r.output, QFileInfo(job.relPath).fileName(), &err);
+                r.convertMs = ElapsedMs(t);
+                if (!written)
+                {
+                    r.error = err;
+                    return r;
+                }
+            }
+        }
+        else
+        {
+            QImage image;
+            const bool decoded = BlpLoader::LoadBlpToImageFromBytes(bytes, &image, &err);
+            r.parseMs = ElapsedMs(t);
+            if (!decoded)
+            {
+                r.error = err;
+                return r;
+            }
+            r.width = image.width();
+            r.height = image.height();
+
+            if (opt.command == Command::Convert)
+            {
+                t.restart();
+                r.output = OutputPath(opt, job.relPath, "png");
+                QDir().mkpath(QFileInfo(r.output).absolutePath());
+                const bool written = image.save(r.output, "PNG");
+                r.convertMs = ElapsedMs(t);
+                if (!written)
+                {
+                    r.error = QString("Cannot write %1").arg(r.output);
+                    return r;
+                }
+            }
+        }
+
+        r.ok = true;
+        return r;
+    }
+
+    // Results land in job order, so reports are identical regardless of thread count.
+    static std::vector<FileReport> RunJobs(const std::vector<Job>& jobs, const Options& opt, const MpqVfs* mpq)
+    {
+        std::vector<FileReport> reports(jobs.size());
+        std::atomic<std::size_t> done{0};
+        WorkStealing::ParallelFor(jobs.size(), opt.jobs, [&](std::size_t i)
+        {
+            reports[i] = ProcessJob(jobs[i], opt, mpq);
+            const std::size_t n = done.fetch_add(1) + 1;
+            if (n % 500 == 0)
+                std::fprintf(stderr, "  %zu / %zu\n", n, jobs.size());
+        });
+        return reports;
+    }
+
+    static QJsonObject ReportToJson(const FileReport& r)
+    {
+        QJsonObject o;
+        o["path"] = r.path;
+        o["kind"] = KindName(r.kind);
+        o["ok"] = r.ok;
+        if (!r.error.isEmpty())
+            o["error"] = r.error;
+        o["bytes"] = double(r.bytes);
+        o["readMs"] = r.readMs;
+        o["parseMs"] = r.parseMs;
+        if (r.validateMs > 0.0)
+            o["validateMs"] = r.validateMs;
+        if (!r.issues.isEmpty())
+            o["issues"] = QJsonArray::fromStringList(r.issues);
+        if (!r.output.isEmpty())
+        {
+            o["convertMs"] = r.convertMs;
+            o["output"] = r.output;
+        }
+        if (r.kind == FileKind::Mdx && r.mdxVersion != 0)
+        {
+            o["mdxVersion"] = double(r.mdxVersion);
+            o["vertices"] = r.vertices;
+            o["triangles"] = r.triangles;
+            o["geosets"] = r.geosets;
+            o["materials"] = r.materials;
+            o["textures"] = r.textures;
+            o["sequences"] = r.sequences;
+            o["nodes"] = r.nodes;
+            o["emitters"] = r.emitters;
+        }
+        else if (r.width > 0)
+        {
+            o["width"] = r.width;
+            o["height"] = r.height;
+        }
+        return o;
+    }
+
+    static QString CsvField(const QString& s)
+    {
+        if (!s.contains(',') && !s.contains('"') && !s.contains('\n'))
+            return s;
+        QString q = s;
+        q.replace("\"", "\"\"");
+        return "\"" + q + "\"";
+    }
+
+    struct RunTotals
+    {
+        int ok = 0;
+        int failed = 0;
+        qint64 bytes = 0;
+        double wallMs = 0.0;
+    };
+
+    static QByteArray BuildJson(const Options& opt, const std::vector<FileReport>& reports, const RunTotals& totals)
+    {
+        QJsonObject root;
+        root["command"] = CommandName(opt.command);
+        root["input"] = opt.input;
+        root["jobs"] = opt.jobs;
+        root["files"] = int(reports.size());
+        root["ok"] = totals.ok;
+        root["failed"] = totals.failed;
+        root["totalBytes"] = double(totals.bytes);
+        root["wallMs"] = totals.wallMs;
+        const double secs = totals.wallMs / 1000.0;
+        root["filesPerSec"] = secs > 0.0 ? double(reports.size()) / secs : 0.0;
+        root["mbPerSec"] = secs > 0.0 ? double(totals.bytes) / (1024.0 * 1024.0) / secs : 0.0;
+
+        QJsonArray files;
+        for (const auto& r : reports)
+            files.append(ReportToJson(r));
+        root["results"] = files;
+        return QJsonDocument(root).toJson(QJsonDocument::Indented);
+    }
+
+    static QByteArray BuildCsv(const std::vector<FileReport>& reports)
+    {
+        QString out;
+        QTextStream ts(&out);
+        ts << "path,kind,ok,bytes,read_ms,parse_ms,validate_ms,convert_ms,mdx_version,vertices,triangles,geosets,"
+              "materials,textures,sequences,nodes,emitters,width,height,output,error,issues\n";
+        for (const auto& r : reports)
+        {
+            ts << CsvField(r.path) << ',' << KindName(r.kind) << ',' << (r.ok ? 1 : 0) << ','
+               << r.bytes << ','
+               << QString::number(r.readMs, 'f', 3) << ','
+               << QString::number(r.parseMs, 'f', 3) << ','
+               << QString::number(r.validateMs, 'f', 3) << ','
+               << QString::number(r.convertMs, 'f', 3) << ','
+               << r.mdxVersion << ',' << r.vertices << ',' << r.triangles << ',' << r.geosets << ','
+               << r.materials << ',' << r.textures << ',' << r.sequences << ',' << r.nodes << ','
+               << r.emitters << ',' << r.width << ',' << r.height << ','
+               << CsvField(r.output) << ',' << CsvField(r.error) << ','
+               << CsvField(r.issues.join("; ")) << '\n';
+        }
+        ts.flush();
+        return out.toUtf8();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("w3preview-cli");
+    QCoreApplication::setApplicationVersion("0.1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Batch validate, summarize or convert Warcraft III MDX/BLP files.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("command", "validate | summarize | convert");
+    parser.addPositionalArgument("input", "Folder to scan recursively, or an .mpq archive.");
+
+    const QCommandLineOption jobsOpt(QStringList() << "j" << "jobs", "Worker threads (default: CPU count).", "n");
+    const QCommandLineOption reportOpt(QStringList() << "r" << "report", "Write the report to <file> (.json or .csv).", "file");
+    const QCommandLineOption formatOpt("format", "Report format when writing to stdout: json | csv.", "format", "json");
+    const QCommandLineOption outOpt(QStringList() << "o" << "out", "Output folder for convert.", "dir");
+    const QCommandLineOption typeOpt("type", "File types to process: mdx | blp | all.", "type", "all");
+    const QCommandLineOption logOpt("log", "Write the loader log to <file>.", "file");
+    const QCommandLineOption logLevelOpt("log-level", "Minimum log level: debug | info | warn | error.", "level");
+    const QCommandLineOption traceOpt("trace", "Write a Chrome trace JSON of read/parse/decode spans to <file>.", "file");
+    parser.addOption(jobsOpt);
+    parser.addOption(reportOpt);
+    parser.addOption(formatOpt);
+    parser.addOption(outOpt);
+    parser.addOption(typeOpt);
+    parser.addOption(logOpt);
+    parser.addOption(logLevelOpt);
+    parser.addOption(traceOpt);
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 2)
+    {
+        std::fprintf(stderr, "%s\n", qPrintable(parser.helpText()));
+        return 2;
+    }
+
+    Options opt;
+    const QString command = args[0].toLower();
+    if (command == "validate")
+        opt.command = Command::Validate;
+    else if (command == "summarize")
+        opt.command = Command::Summarize;
+    else if (command == "convert")
+        opt.command = Command::Convert;
+    else
+    {
+        std::fprintf(stderr, "Unknown command: %s\n", qPrintable(args[0]));
+        return 2;
+    }
+
+    opt.input = QFileInfo(args[1]).absoluteFilePath();
+    opt.jobs = parser.isSet(jobsOpt) ? parser.value(jobsOpt).toInt() : QThread::idealThreadCount();
+    opt.jobs = std::max(1, opt.jobs);
+    const QString type = parser.value(typeOpt).toLower();
+    opt.mdx = (type == "all" || type == "mdx");
+    opt.blp = (type == "all" || type == "blp");
+    if (!opt.mdx && !opt.blp)
+    {
+        std::fprintf(stderr, "Unknown --type: %s\n", qPrintable(type));
+        return 2;
+    }
+    if (opt.command == Command::Convert)
+    {
+        if (!parser.isSet(outOpt))
+        {
+            std::fprintf(stderr, "convert requires --out <dir>\n");
+            return 2;
+        }
+        opt.outDir = QFileInfo(parser.value(outOpt)).absoluteFilePath();
+        QDir().mkpath(opt.outDir);
+    }
+
+    if (parser.isSet(logLevelOpt))
+    {
+        LogLevel level = LogLevel::Info;
+        if (!LogSink::ParseLevel(parser.value(logLevelOpt), &level))
+        {
+            std::fprintf(stderr, "Unknown --log-level: %s\n", qPrintable(parser.value(logLevelOpt)));
+            return 2;
+        }
+        LogSink::instance().setMinLevel(level);
+    }
+    if (parser.isSet(logOpt))
+        LogSink::instance().init(parser.value(logOpt));
+    if (parser.isSet(traceOpt))
+    {
+        Trace::SetEnabled(true);
+        Trace::SetThreadName("main");
+    }
+
+    std::unique_ptr<MpqVfs> mpq;
+    std::vector<Job> jobs;
+    const QFileInfo inputInfo(opt.input);
+    if (inputInfo.isDir())
+    {
+        jobs = CollectDiskJobs(opt.input, opt);
+    }
+    else if (inputInfo.isFile() && inputInfo.suffix().compare("mpq", Qt::CaseInsensitive) == 0)
+    {
+        mpq = std::make_unique<MpqVfs>();
+        if (!mpq->mountArchive(opt.input))
+        {
+            std::fprintf(stderr, "Cannot open archive: %s\n", qPrintable(opt.input));
+            return 1;
+        }
+        jobs = CollectMpqJobs(*mpq, opt);
+    }
+    else
+    {
+        std::fprintf(stderr, "Input must be a folder or an .mpq file: %s\n", qPrintable(opt.input));
+        return 2;
+    }
+
+    std::fprintf(stderr, "%s: %zu files, %d threads\n", qPrintable(CommandName(opt.command)), jobs.size(), opt.jobs);
+
+    QElapsedTimer wall;
+    wall.start();
+    const std::vector<FileReport> reports = RunJobs(jobs, opt, mpq.get());
+
+    RunTotals totals;
+    totals.wallMs = ElapsedMs(wall);
+    for (const auto& r : reports)
+    {
+        totals.bytes += r.bytes;
+        if (r.ok)
+            totals.ok++;
+        else
+            totals.failed++;
+    }
+
+    const QString reportPath = parser.value(reportOpt);
+    const bool csv = reportPath.isEmpty()
+                         ? parser.value(formatOpt).compare("csv", Qt::CaseInsensitive) == 0
+                         : reportPath.endsWith(".csv", Qt::CaseInsensitive);
+    const QByteArray report = csv ? BuildCsv(reports) : BuildJson(opt, reports, totals);
+    if (reportPath.isEmpty())
+    {
+        std::fwrite(report.constData(), 1, std::size_t(report.size()), stdout);
+    }
+    else
+    {
+        QFile f(reportPath);
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            std::fprintf(stderr, "Cannot write report: %s\n", qPrintable(reportPath));
+            return 1;
+        }
+        f.write(report);
+    }
+
+    if (parser.isSet(traceOpt))
+    {
+        QString err;
+        if (!Trace::WriteChromeJson(parser.value(traceOpt), &err))
+            std::fprintf(stderr, "%s\n", qPrintable(err));
+    }
+
+    const double secs = totals.wallMs / 1000.0;
+    std::fprintf(stderr, "%d ok, %d failed, %.2f s (%.1f files/s, %.1f MB/s)\n",
+                 totals.ok, totals.failed, secs,
+                 secs > 0.0 ? double(reports.size()) / secs : 0.0,
+                 secs > 0.0 ? double(totals.bytes) / (1024.0 * 1024.0) / secs : 0.0);
+
+    return totals.failed > 0 && opt.command == Command::Validate ? 1 : 0;
+}
@@ -0,0 +1,192 @@
+#include "FilterIndex.h"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+namespace
+{
+    // Below this many substring hits the fuzzy (subsequence) pass runs as well.
+    static constexpr std::size_t kFuzzyFillThreshold = 512;
+}
+
+void FilterIndex::build(const QStringList& names)
+{
+    names_.clear();
+    fileNameStart_.clear();
+    postings_.clear();
+    names_.reserve(std::size_t(names.size()));
+    fileNameStart_.reserve(std::size_t(names.size()));
+
+    for (int row = 0; row < names.size(); ++row)
+    {
+        const QString lower = names[row].toLower();
+        const int slash = std::max(lower.lastIndexOf('/'), lower.lastIndexOf('\\'));
+        fileNameStart_.push_back(slash + 1);
+
+        const QChar* data = lower.constData();
+        for (int i = 0; i + 3 <= lower.size(); ++i)
+        {
+            auto& list = postings_[trigramKey(data + i)];
+            if (list.empty() || list.back() != row)
+                list.push_back(row);
+        }
+        names_.push_back(lower);
+    }
+}
+
+std::uint64_t FilterIndex::trigramKey(const QChar* s)
+{
+    return (std::uint64_t(s[0].unicode()) << 32) |
+           (std::uint64_t(s[1].unicode()) << 16) |
+           std::uint64_t(s[2].unicode());
+}
+
+std::vector<int> FilterIndex::substringCandidates(const QString& query) const
+{
+    std::vector<std::uint64_t> keys;
+    for (int i = 0; i + 3 <= query.size(); ++i)
+        keys.push_back(trigramKey(query.constData() + i));
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    std::vector<const std::vector<int>*> lists;
+    lists.reserve(keys.size());
+    for (std::uint64_t key : keys)
+    {
+        const auto it = postings_.find(key);
+        if (it == postings_.end())
+            return {};
+        lists.push_back(&it->second);
+    }
+    if (lists.empty())
+        return {};
+
+    // Intersect smallest posting lists first so the working set shrinks fast.
+    std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) { return a->size() < b->size(); });
+    std::vector<int> result = *lists.front();
+    std::vector<int> tmp;
+    for (std::size_t i = 1; i < lists.size() && !result.empty(); ++i)
+    {
+        tmp.clear();
+        std::set_intersection(result.begin(), result.end(),
+                              lists[i]->begin(), lists[i]->end(),
+                              std::back_inserter(tmp));
+        result.swap(tmp);
+    }
+    return result;
+}
+
+int FilterIndex::score(int row, const QString& query) const
+{
+    const QString& name = names_[std::size_t(row)];
+    const int fileStart = fileNameStart_[std::size_t(row)];
+
+    // Substring inside the file name ranks above one in the directory part.
+    const int pos = name.indexOf(query, fileStart);
+    if (pos >= 0)
+        return (pos == fileStart) ? 4000 : 3000 - std::min(pos - fileStart, 999);
+    const int dirPos = name.indexOf(query);
+    if (dirPos >= 0)
+        return 2000 - std::min(dirPos, 999);
+
+    // Fuzzy: query characters appear in order; fewer and smaller gaps rank higher.
+    int from = 0;
+    int first = -1;
+    int gaps = 0;
+    for (const QChar c : query)
+    {
+        const int at = name.indexOf(c, from);
+        if (at < 0)
+            return -1;
+        if (first < 0)
+            first = at;
+        else
+            gaps += at - from;
+        from = at + 1;
+    }
+    return std::clamp(1000 - gaps * 8 - first, 1, 999);
+}
+
+std::vector<int> FilterIndex::match(const QString& query, const std::vector<int>* scope, bool* outComplete) const
+{
+    if (outComplete)
+        *outComplete = true;
+    const QString q = query.toLower();
+    if (q.isEmpty())
+    {
+        if (scope)
+            return *scope;
+        std::vector<int> all(names_.size());
+        std::iota(all.begin(), all.end(), 0);
+        return all;
+    }
+
+    std::vector<std::pair<int, int>> ranked; // (score, row)
+    auto consider = [&](int row)
+    {
+        const int s = score(row, q);
+        if (s > 0)
+            ranked.emplace_back(s, row);
+    };
+    auto scanAll = [&](const std::vector<char>* skip)
+    {
+        if (scope)
+        {
+            for (int row : *scope)
+            {
+                if (!skip || !(*skip)[std::size_t(row)])
+                    consider(row);
+            }
+            return;
+        }
+        for (int row = 0; row < size(); ++row)
+        {
+            if (!skip || !(*skip)[std::size_t(row)])
+                consider(row);
+        }
+    };
+
+    if (q.size() < 3)
+    {
+        scanAll(nullptr);
+    }
+    else
+    {
+        std::vector<char> inScope;
+        if (scope)
+        {
+            inScope.assign(names_.size(), 0);
+            for (int row : *scope)
+                inScope[std::size_t(row)] = 1;
+        }
+
+        std::vector<char> seen(names_.size(), 0);
+        for (int row : substringCandidates(q))
+        {
+            if (scope && !inScope[std::size_t(row)])
+                continue;
+            seen[std::size_t(row)] = 1;
+            consider(row);
+        }
+
+        // Plenty of exact hits: skip the fuzzy tail instead of scanning every row.
+        if (ranked.size() < kFuzzyFillThreshold)
+            scanAll(&seen);
+        else if (outComplete)
+            *outComplete = false;
+    }
+
+    std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b)
+    {
+        if (a.first != b.first)
+            return a.first > b.first;
+        return a.second < b.second;
+    });
+
+    std::vector<int> out;
+    out.reserve(ranked.size());
+    for (const auto& r : ranked)
+        out.push_back(r.second);
+    return out;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Trigram index over list display names (relative paths).
+// Built once per folder scan, then shared read-only between filter jobs.
+class FilterIndex
+{
+public:
+    void build(const QStringList& names);
+
+    int size() const { return int(names_.size()); }
+
+    // Returns matching rows ranked best-first (substring hits, then fuzzy
+    // subsequence hits). When `scope` is given only those rows are considered,
+    // which lets a growing query refine the previous result. `outComplete` is
+    // set to false when the fuzzy pass was skipped for having plenty of
+    // substring hits; such a result must not be used as a later scope.
+    std::vector<int> match(const QString& query, const std::vector<int>* scope = nullptr,
+                           bool* outComplete = nullptr) const;
+
+private:
+    static std::uint64_t trigramKey(const QChar* s);
+    std::vector<int> substringCandidates(const QString& query) const;
+    int score(int row, const QString& query) const;
+
+    std::vector<QString> names_; // lower-cased
+    std::vector<int> fileNameStart_;
+    std::unordered_map<std::uint64_t, std::vector<int>> postings_;
+};
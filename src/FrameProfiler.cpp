@@ -0,0 +1,88 @@
+#include "FrameProfiler.h"
+
+#include <algorithm>
+
+FrameProfiler::FrameProfiler(std::size_t capacity)
+    : ring_(std::max<std::size_t>(1, capacity))
+{
+    current_.index = nextIndex_++;
+}
+
+void FrameProfiler::beginPaint()
+{
+    phaseSumAtPaint_ = phaseSum();
+    paintTimer_.start();
+}
+
+void FrameProfiler::endPaint()
+{
+    current_.paintMs = paintTimer_.isValid() ? double(paintTimer_.nsecsElapsed()) / 1.0e6 : 0.0;
+    const double claimed = phaseSum() - phaseSumAtPaint_;
+    current_.phaseMs[Draw] += std::max(0.0, current_.paintMs - claimed);
+
+    if (intervalTimer_.isValid())
+        current_.intervalMs = double(intervalTimer_.nsecsElapsed()) / 1.0e6;
+    intervalTimer_.start();
+
+    ring_[head_] = current_;
+    head_ = (head_ + 1) % ring_.size();
+    count_ = std::min(count_ + 1, ring_.size());
+
+    const std::size_t textureBytes = current_.textureBytes;
+    current_ = Frame();
+    current_.index = nextIndex_++;
+    current_.textureBytes = textureBytes;
+}
+
+void FrameProfiler::reset()
+{
+    head_ = 0;
+    count_ = 0;
+    current_ = Frame();
+    current_.index = nextIndex_++;
+    intervalTimer_.invalidate();
+}
+
+bool FrameProfiler::setGpuMs(std::uint64_t frameIndex, double ms)
+{
+    for (std::size_t i = 0; i < count_; ++i)
+    {
+        Frame& f = ring_[(head_ + ring_.size() - 1 - i) % ring_.size()];
+        if (f.index == frameIndex)
+        {
+            f.gpuMs = ms;
+            return true;
+        }
+        if (f.index < frameIndex)
+            break;
+    }
+    return false;
+}
+
+const FrameProfiler::Frame& FrameProfiler::at(std::size_t i) const
+{
+    const std::size_t oldest = (head_ + ring_.size() - count_) % ring_.size();
+    return ring_[(oldest + i) % ring_.size()];
+}
+
+const char* FrameProfiler::PhaseName(Phase phase)
+{
+    switch (phase)
+    {
+    case Sampling: return "sampling";
+    case Skinning: return "skinning";
+    case Particles: return "particles";
+    case Textures: return "textures";
+    case Draw: return "draw";
+    case PhaseCount: break;
+    }
+    return "unknown";
+}
+
+double FrameProfiler::phaseSum() const
+{
+    double sum = 0.0;
+    for (int p = 0; p < PhaseCount; ++p)
+        sum += current_.phaseMs[p];
+    return sum;
+}
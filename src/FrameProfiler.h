@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lightweight per-frame profiler: scoped CPU timers per phase plus counters,
+// kept in a fixed-size ring of recent frames. GPU time is filled in later by
+// the owner once its timer query for that frame resolves.
+
+class FrameProfiler
+{
+public:
+    enum Phase
+    {
+        Sampling,  // node pose evaluation
+        Skinning,  // CPU skinning + VBO upload
+        Particles, // PRE2 simulation
+        Textures,  // texture lookup / decode / upload
+        Draw,      // paintGL submission not covered by the phases above
+        PhaseCount
+    };
+
+    struct Frame
+    {
+        std::uint64_t index = 0;
+        double phaseMs[PhaseCount] = {};
+        double paintMs = 0.0;    // paintGL wall time
+        double intervalMs = 0.0; // since the previous frame ended
+        double gpuMs = -1.0;     // -1 until (unless) the timer query resolves
+        int drawCalls = 0;
+        int textureUploads = 0;
+        std::size_t skinnedVertices = 0;
+        std::size_t liveParticles = 0;
+        std::size_t textureBytes = 0; // resident texture memory at frame end
+    };
+
+    class Scope
+    {
+    public:
+        Scope(FrameProfiler& profiler, Phase phase)
+            : profiler_(profiler), phase_(phase)
+        {
+            timer_.start();
+        }
+        ~Scope() { profiler_.add(phase_, double(timer_.nsecsElapsed()) / 1.0e6); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        FrameProfiler& profiler_;
+        Phase phase_;
+        QElapsedTimer timer_;
+    };
+
+    explicit FrameProfiler(std::size_t capacity = 240);
+
+    // Frame being accumulated; work done between frames (animation ticks) lands here too.
+    Frame& current() { return current_; }
+    void add(Phase phase, double ms) { current_.phaseMs[phase] += ms; }
+
+    // Brackets paintGL. endPaint() derives Draw from the paint time not claimed
+    // by other phases, pushes the frame into the ring and starts the next one.
+    void beginPaint();
+    void endPaint();
+    void reset();
+
+    // Backfills GPU time; false if the frame already dropped out of the ring.
+    bool setGpuMs(std::uint64_t frameIndex, double ms);
+
+    std::size_t size() const { return count_; }
+    std::size_t capacity() const { return ring_.size(); }
+    const Frame& at(std::size_t i) const; // 0 = oldest
+    const Frame* last() const { return count_ ? &at(count_ - 1) : nullptr; }
+
+    static const char* PhaseName(Phase phase);
+
+private:
+    double phaseSum() const;
+
+    std::vector<Frame> ring_;
+    std::size_t head_ = 0; // next write slot
+    std::size_t count_ = 0;
+    Frame current_;
+    std::uint64_t nextIndex_ = 0;
+    QElapsedTimer paintTimer_;
+    QElapsedTimer intervalTimer_;
+    double phaseSumAtPaint_ = 0.0;
+};
@@ -0,0 +1,213 @@
+#include "GLMeshCache.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    constexpr std::size_t kGrowQuantum = 64 * 1024;
+    constexpr std::size_t kMaxPooledMeshes = 8;
+
+    static std::size_t RoundUp(std::size_t bytes)
+    {
+        return (bytes + kGrowQuantum - 1) / kGrowQuantum * kGrowQuantum;
+    }
+
+    // New capacity for a buffer that must hold `needed` bytes. Regrown buffers
+    // get headroom so a run of slightly larger models does not realloc each time.
+    static std::size_t GrowCapacity(std::size_t current, std::size_t needed)
+    {
+        if (current == 0)
+            return RoundUp(needed);
+        return RoundUp(std::max(needed, current + current / 2));
+    }
+}
+
+void GLMeshCache::init(QOpenGLFunctions_3_3_Core* gl, std::size_t budgetBytes)
+{
+    destroy();
+    gl_ = gl;
+    budgetBytes_ = budgetBytes;
+}
+
+void GLMeshCache::destroy()
+{
+    if (gl_)
+    {
+        for (const Entry& e : entries_)
+            deleteMesh(e.mesh);
+        for (const Mesh& m : pool_)
+            deleteMesh(m);
+    }
+    entries_.clear();
+    pool_.clear();
+    currentKey_.clear();
+    useCounter_ = 0;
+    stats_ = Stats();
+    gl_ = nullptr;
+}
+
+void GLMeshCache::setBudget(std::size_t budgetBytes)
+{
+    budgetBytes_ = budgetBytes;
+    if (gl_)
+        evict();
+}
+
+const GLMeshCache::Mesh* GLMeshCache::acquire(const QString& key, const QString& stamp,
+                                              const void* vertices, std::size_t vertexBytes,
+                                              const void* indices, std::size_t indexBytes,
+                                              bool* outUploaded)
+{
+    if (outUploaded)
+        *outUploaded = false;
+    if (!gl_)
+        return nullptr;
+
+    currentKey_ = key;
+    auto it = entries_.find(key);
+    const bool hit = it != entries_.end() && !key.isEmpty() && it->stamp == stamp;
+    if (hit)
+    {
+        ++stats_.hits;
+    }
+    else
+    {
+        ++stats_.misses;
+        if (it == entries_.end())
+        {
+            it = entries_.insert(key, Entry());
+            it->mesh = takeFromPool(vertexBytes, indexBytes);
+        }
+        upload(it->mesh, vertices, vertexBytes, indices, indexBytes);
+        it->stamp = stamp;
+        if (outUploaded)
+            *outUploaded = true;
+    }
+    it->lastUse = ++useCounter_;
+
+    evict();
+    it = entries_.find(key); // eviction may move entries
+    return it != entries_.end() ? &it->mesh : nullptr;
+}
+
+GLMeshCache::Mesh GLMeshCache::takeFromPool(std::size_t vertexBytes, std::size_t indexBytes)
+{
+    // Best fit among pooled meshes that hold the model without wasting more than
+    // the model itself; anything else starts from fresh buffers.
+    const std::size_t needed = vertexBytes + indexBytes;
+    std::size_t best = pool_.size();
+    std::size_t bestBytes = std::numeric_limits<std::size_t>::max();
+    for (std::size_t i = 0; i < pool_.size(); ++i)
+    {
+        const Mesh& m = pool_[i];
+        if (m.vboCapacity < vertexBytes || m.iboCapacity < indexBytes)
+            continue;
+        const std::size_t bytes = bytesOf(m);
+        if (bytes <= 2 * RoundUp(needed) && bytes < bestBytes)
+        {
+            best = i;
+            bestBytes = bytes;
+        }
+    }
+    if (best == pool_.size())
+        return Mesh();
+
+    const Mesh m = pool_[best];
+    pool_.erase(pool_.begin() + std::ptrdiff_t(best));
+    stats_.pooledBytes -= bytesOf(m);
+    return m;
+}
+
+void GLMeshCache::upload(Mesh& mesh, const void* vertices, std::size_t vertexBytes,
+                         const void* indices, std::size_t indexBytes)
+{
+    if (!mesh.vao)
+        gl_->glGenVertexArrays(1, &mesh.vao);
+    if (!mesh.vbo)
+        gl_->glGenBuffers(1, &mesh.vbo);
+    if (!mesh.ibo)
+        gl_->glGenBuffers(1, &mesh.ibo);
+
+    gl_->glBindVertexArray(mesh.vao);
+
+    gl_->glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+    if (vertexBytes > mesh.vboCapacity)
+    {
+        mesh.vboCapacity = GrowCapacity(mesh.vboCapacity, vertexBytes);
+        gl_->glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(mesh.vboCapacity), nullptr, GL_STATIC_DRAW);
+    }
+    if (vertexBytes)
+        gl_->glBufferSubData(GL_ARRAY_BUFFER, 0, GLsizeiptr(vertexBytes), vertices);
+
+    // Bound while the VAO is, so the VAO keeps it.
+    gl_->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ibo);
+    if (indexBytes > mesh.iboCapacity)
+    {
+        mesh.iboCapacity = GrowCapacity(mesh.iboCapacity, indexBytes);
+        gl_->glBufferData(GL_ELEMENT_ARRAY_BUFFER, GLsizeiptr(mesh.iboCapacity), nullptr, GL_STATIC_DRAW);
+    }
+    if (indexBytes)
+        gl_->glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, GLsizeiptr(indexBytes), indices);
+
+    gl_->glBindVertexArray(0);
+    gl_->glBindBuffer(GL_ARRAY_BUFFER, 0);
+    stats_.uploadedBytes += vertexBytes + indexBytes;
+}
+
+void GLMeshCache::evict()
+{
+    std::size_t resident = 0;
+    for (const Entry& e : entries_)
+        resident += bytesOf(e.mesh);
+
+    while (resident > budgetBytes_)
+    {
+        auto lru = entries_.end();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it)
+        {
+            if (it.key() == currentKey_)
+                continue;
+            if (lru == entries_.end() || it->lastUse < lru->lastUse)
+                lru = it;
+        }
+        if (lru == entries_.end())
+            break; // only the current mesh is left; it stays even if over budget
+
+        resident -= bytesOf(lru->mesh);
+        release(lru->mesh);
+        entries_.erase(lru);
+    }
+
+    stats_.residentMeshes = int(entries_.size());
+    stats_.residentBytes = resident;
+}
+
+void GLMeshCache::release(const Mesh& mesh)
+{
+    pool_.push_back(mesh);
+    stats_.pooledBytes += bytesOf(mesh);
+    trimPool();
+}
+
+void GLMeshCache::trimPool()
+{
+    // Oldest first; the pool only bridges the next few loads.
+    const std::size_t maxBytes = budgetBytes_ / 2;
+    while (!pool_.empty() && (pool_.size() > kMaxPooledMeshes || stats_.pooledBytes > maxBytes))
+    {
+        stats_.pooledBytes -= bytesOf(pool_.front());
+        deleteMesh(pool_.front());
+        pool_.erase(pool_.begin());
+    }
+}
+
+void GLMeshCache::deleteMesh(const Mesh& mesh)
+{
+    if (mesh.ibo)
+        gl_->glDeleteBuffers(1, &mesh.ibo);
+    if (mesh.vbo)
+        gl_->glDeleteBuffers(1, &mesh.vbo);
+    if (mesh.vao)
+        gl_->glDeleteVertexArrays(1, &mesh.vao);
+}
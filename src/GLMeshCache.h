@@ -0,0 +1,82 @@
+#pragma once
+
+#include <QHash>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QString>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Static mesh buffers (VAO + VBO + IBO) of recently viewed models, kept
+// resident within a byte budget so switching back to a model uploads nothing.
+// Least recently used meshes are evicted once the budget is exceeded; their
+// buffers go to a small pool and are refilled by later models with
+// glBufferSubData, growing only when a model does not fit.
+//
+// A mesh is identified by a key (the model path) plus a stamp (file time and
+// sizes); a stale stamp re-uploads into the entry's own buffers. An empty key
+// is never cached: it always uploads into a single scratch entry.
+
+class GLMeshCache
+{
+public:
+    struct Mesh
+    {
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        GLuint ibo = 0;
+        std::size_t vboCapacity = 0;
+        std::size_t iboCapacity = 0;
+    };
+
+    struct Stats
+    {
+        int residentMeshes = 0;
+        std::size_t residentBytes = 0; // buffer capacity, not just the used part
+        std::size_t pooledBytes = 0;
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::size_t uploadedBytes = 0; // since init()
+    };
+
+    // Needs a current context.
+    void init(QOpenGLFunctions_3_3_Core* gl, std::size_t budgetBytes);
+    void destroy();
+    void setBudget(std::size_t budgetBytes);
+    std::size_t budget() const { return budgetBytes_; }
+
+    // Returns the resident mesh for key/stamp, uploading it if needed; `*outUploaded`
+    // says which. The returned mesh is the current one and is never evicted until
+    // another acquire(). The VAO has the IBO bound; vertex attributes are the caller's.
+    const Mesh* acquire(const QString& key, const QString& stamp,
+                        const void* vertices, std::size_t vertexBytes,
+                        const void* indices, std::size_t indexBytes,
+                        bool* outUploaded = nullptr);
+
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct Entry
+    {
+        Mesh mesh;
+        QString stamp;
+        std::uint64_t lastUse = 0;
+    };
+
+    Mesh takeFromPool(std::size_t vertexBytes, std::size_t indexBytes);
+    void upload(Mesh& mesh, const void* vertices, std::size_t vertexBytes, const void* indices, std::size_t indexBytes);
+    void release(const Mesh& mesh);
+    void evict();
+    void trimPool();
+    void deleteMesh(const Mesh& mesh);
+    static std::size_t bytesOf(const Mesh& mesh) { return mesh.vboCapacity + mesh.iboCapacity; }
+
+    QOpenGLFunctions_3_3_Core* gl_ = nullptr;
+    std::size_t budgetBytes_ = 0;
+    QHash<QString, Entry> entries_;
+    std::vector<Mesh> pool_;
+    QString currentKey_;
+    std::uint64_t useCounter_ = 0;
+    Stats stats_;
+};
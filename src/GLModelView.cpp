@@ -1,37 +1,41 @@
 #include "GLModelView.h"
 
 #include <QFile>
+#include <QFutureWatcher>
 #include <QMouseEvent>
 #include <QWheelEvent>
 #include <QKeyEvent>
 #include <QFileInfo>
 #include <QDir>
+#include <QGuiApplication>
 #include <QDirIterator>
 #include <QImage>
 #include <QOpenGLContext>
+#include <QPainter>
 #include <QQuaternion>
+#include <QScreen>
 #include <QMatrix3x3>
 #include <QTextStream>
 #include <QVector2D>
 #include <QVector4D>
+#include <QWindow>
+#include <QtConcurrent/QtConcurrent>
 
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <cstring>
 #include <limits>
-#include <random>
 
 #include "BlpLoader.h"
 #include "LogSink.h"
+#include "ModelAnim.h"
+#include "ParticleSim.h"
+#include "Trace.h"
 #include "Vfs.h"
 
 namespace
 {
-    using MdxInterp = ModelData::MdxInterp;
-
-    template<typename T>
-    using MdxTrack = ModelData::MdxTrack<T>;
-
     static QString normPath(const QString& p)
     {
         QString s = p;
@@ -39,73 +43,35 @@ namespace
         return s;
     }
 
-    static float clampf(float v, float lo, float hi)
-    {
-        return (v < lo) ? lo : (v > hi) ? hi : v;
-    }
-
-    static float lerpf(float a, float b, float t)
-    {
-        return a + (b - a) * t;
-    }
-
-    static float hermite(float p0, float m0, float p1, float m1, float t)
-    {
-        const float t2 = t * t;
-        const float t3 = t2 * t;
-        return (2*t3 - 3*t2 + 1) * p0 +
-               (t3 - 2*t2 + t) * m0 +
-               (-2*t3 + 3*t2) * p1 +
-               (t3 - t2) * m1;
-    }
-
-    static float bezier(float p0, float c1, float c2, float p1, float t)
-    {
-        const float it = 1.0f - t;
-        return it*it*it*p0 + 3*it*it*t*c1 + 3*it*t*t*c2 + t*t*t*p1;
-    }
-
-    static Vec3 lerpVec3(const Vec3& a, const Vec3& b, float t)
+    // Elapsed ms since the last call (or start), then restarts the timer.
+    static double TakeMs(QElapsedTimer& t)
     {
-        return { lerpf(a.x, b.x, t), lerpf(a.y, b.y, t), lerpf(a.z, b.z, t) };
+        const double ms = double(t.nsecsElapsed()) / 1.0e6;
+        t.start();
+        return ms;
     }
 
-    static Vec3 hermiteVec3(const Vec3& p0, const Vec3& m0, const Vec3& p1, const Vec3& m1, float t)
-    {
-        return {
-            hermite(p0.x, m0.x, p1.x, m1.x, t),
-            hermite(p0.y, m0.y, p1.y, m1.y, t),
-            hermite(p0.z, m0.z, p1.z, m1.z, t)
-        };
-    }
-
-    static Vec3 bezierVec3(const Vec3& p0, const Vec3& c1, const Vec3& c2, const Vec3& p1, float t)
-    {
-        return {
-            bezier(p0.x, c1.x, c2.x, p1.x, t),
-            bezier(p0.y, c1.y, c2.y, p1.y, t),
-            bezier(p0.z, c1.z, c2.z, p1.z, t)
-        };
-    }
-
-    static Vec4 lerpVec4(const Vec4& a, const Vec4& b, float t)
+    static float clampf(float v, float lo, float hi)
     {
-        return { lerpf(a.x, b.x, t), lerpf(a.y, b.y, t), lerpf(a.z, b.z, t), lerpf(a.w, b.w, t) };
+        return (v < lo) ? lo : (v > hi) ? hi : v;
     }
 
-    static Vec4 normalizeQuat(const Vec4& q)
+    // Filter modes drawn in the blended pass: Blend, Additive, AddAlpha, Modulate, Modulate2x.
+    static bool IsBlendedFilter(std::uint32_t filter)
     {
-        const float len = std::sqrt(q.x*q.x + q.y*q.y + q.z*q.z + q.w*q.w);
-        if (len <= 0.000001f)
-            return {0,0,0,1};
-        const float inv = 1.0f / len;
-        return { q.x * inv, q.y * inv, q.z * inv, q.w * inv };
+        return filter >= 2 && filter <= 6;
     }
 
-    static float dotQuat(const Vec4& a, const Vec4& b)
+    // std140 mirror of MaterialBlock in the mesh shader.
+    struct MaterialParams
     {
-        return a.x*b.x + a.y*b.y + a.z*b.z + a.w*b.w;
-    }
+        float color[4];
+        float uvTransRot[4];
+        float uvParams[4];
+        std::int32_t flags[4];
+    };
+    static_assert(sizeof(MaterialParams) == 64, "MaterialParams must match the std140 block");
+    constexpr GLuint kMaterialBlockBinding = 0;
 
     static bool LoadTgaFromBytes(const QByteArray& bytes, QImage* outImage, QString* outError)
     {
@@ -240,181 +206,6 @@ namespace
         return true;
     }
 
-    static Vec4 slerpQuat(Vec4 a, Vec4 b, float t, bool invertIfNecessary)
-    {
-        float dot = dotQuat(a, b);
-        if (invertIfNecessary && dot < 0.0f)
-        {
-            dot = -dot;
-            b.x = -b.x; b.y = -b.y; b.z = -b.z; b.w = -b.w;
-        }
-
-        if (dot > 0.95f)
-        {
-            return normalizeQuat(lerpVec4(a, b, t));
-        }
-
-        dot = clampf(dot, -1.0f, 1.0f);
-        const float theta0 = std::acos(dot);
-        const float sinTheta0 = std::sin(theta0);
-        if (sinTheta0 <= 0.000001f)
-            return normalizeQuat(lerpVec4(a, b, t));
-        const float theta = theta0 * t;
-        const float sinTheta = std::sin(theta);
-        const float s0 = std::cos(theta) - dot * sinTheta / sinTheta0;
-        const float s1 = sinTheta / sinTheta0;
-        return { a.x * s0 + b.x * s1, a.y * s0 + b.y * s1, a.z * s0 + b.z * s1, a.w * s0 + b.w * s1 };
-    }
-
-    static float sampleTrackFloat(const MdxTrack<float>& tr, std::uint32_t timeMs, float def, const ModelData& model)
-    {
-        if (tr.keys.empty())
-            return def;
-
-        if (tr.globalSeqId >= 0 && std::size_t(tr.globalSeqId) < model.globalSequencesMs.size())
-        {
-            const std::uint32_t len = model.globalSequencesMs[std::size_t(tr.globalSeqId)];
-            if (len != 0)
-                timeMs = timeMs % len;
-        }
-
-        const auto& keys = tr.keys;
-        if (timeMs <= keys.front().timeMs)
-            return keys.front().value;
-        if (timeMs >= keys.back().timeMs)
-            return keys.back().value;
-
-        // find segment
-        std::size_t hi = 1;
-        while (hi < keys.size() && timeMs > keys[hi].timeMs)
-            ++hi;
-        if (hi >= keys.size())
-            return keys.back().value;
-        const std::size_t lo = hi - 1;
-
-        const auto& k0 = keys[lo];
-        const auto& k1 = keys[hi];
-        const float denom = float(k1.timeMs - k0.timeMs);
-        const float t = denom > 0.0f ? float(timeMs - k0.timeMs) / denom : 0.0f;
-
-        switch (tr.interp)
-        {
-        case MdxInterp::None:
-            return k0.value;
-        case MdxInterp::Linear:
-            return lerpf(k0.value, k1.value, t);
-        case MdxInterp::Hermite:
-            // MDX stores tangents per key; use outTan of k0 and inTan of k1.
-            return hermite(k0.value, k0.outTan, k1.value, k1.inTan, t);
-        case MdxInterp::Bezier:
-            // Treat tangents as Bezier control points.
-            return bezier(k0.value, k0.outTan, k1.inTan, k1.value, t);
-        default:
-            return k0.value;
-        }
-    }
-
-    static Vec3 sampleTrackVec3(const MdxTrack<Vec3>& tr, std::uint32_t timeMs, const Vec3& def, const ModelData& model)
-    {
-        if (tr.keys.empty())
-            return def;
-
-        if (tr.globalSeqId >= 0 && std::size_t(tr.globalSeqId) < model.globalSequencesMs.size())
-        {
-            const std::uint32_t len = model.globalSequencesMs[std::size_t(tr.globalSeqId)];
-            if (len != 0)
-                timeMs = timeMs % len;
-        }
-
-        const auto& keys = tr.keys;
-        if (timeMs <= keys.front().timeMs)
-            return keys.front().value;
-        if (timeMs >= keys.back().timeMs)
-            return keys.back().value;
-
-        std::size_t hi = 1;
-        while (hi < keys.size() && timeMs > keys[hi].timeMs)
-            ++hi;
-        if (hi >= keys.size())
-            return keys.back().value;
-        const std::size_t lo = hi - 1;
-
-        const auto& k0 = keys[lo];
-        const auto& k1 = keys[hi];
-        const float denom = float(k1.timeMs - k0.timeMs);
-        const float t = denom > 0.0f ? float(timeMs - k0.timeMs) / denom : 0.0f;
-
-        switch (tr.interp)
-        {
-        case MdxInterp::None:
-            return k0.value;
-        case MdxInterp::Linear:
-            return lerpVec3(k0.value, k1.value, t);
-        case MdxInterp::Hermite:
-            return hermiteVec3(k0.value, k0.outTan, k1.value, k1.inTan, t);
-        case MdxInterp::Bezier:
-            return bezierVec3(k0.value, k0.outTan, k1.inTan, k1.value, t);
-        default:
-            return k0.value;
-        }
-    }
-
-    static Vec4 sampleTrackQuat(const MdxTrack<Vec4>& tr, std::uint32_t timeMs, const Vec4& def, const ModelData& model)
-    {
-        if (tr.keys.empty())
-            return def;
-
-        if (tr.globalSeqId >= 0 && std::size_t(tr.globalSeqId) < model.globalSequencesMs.size())
-        {
-            const std::uint32_t len = model.globalSequencesMs[std::size_t(tr.globalSeqId)];
-            if (len != 0)
-                timeMs = timeMs % len;
-        }
-
-        const auto& keys = tr.keys;
-        if (timeMs <= keys.front().timeMs)
-            return normalizeQuat(keys.front().value);
-        if (timeMs >= keys.back().timeMs)
-            return normalizeQuat(keys.back().value);
-
-        std::size_t hi = 1;
-        while (hi < keys.size() && timeMs > keys[hi].timeMs)
-            ++hi;
-        if (hi >= keys.size())
-            return normalizeQuat(keys.back().value);
-        const std::size_t lo = hi - 1;
-
-        const auto& k0 = keys[lo];
-        const auto& k1 = keys[hi];
-        const float denom = float(k1.timeMs - k0.timeMs);
-        const float t = denom > 0.0f ? float(timeMs - k0.timeMs) / denom : 0.0f;
-
-        switch (tr.interp)
-        {
-        case MdxInterp::None:
-            return normalizeQuat(k0.value);
-        case MdxInterp::Linear:
-            return slerpQuat(k0.value, k1.value, t, true);
-        case MdxInterp::Hermite:
-        {
-            const Vec4 slerp = slerpQuat(k0.value, k1.value, t, false);
-            const Vec4 slerpTan = slerpQuat(k0.outTan, k1.inTan, t, false);
-            return slerpQuat(slerp, slerpTan, 2.0f * t * (1.0f - t), false);
-        }
-        case MdxInterp::Bezier:
-        {
-            const Vec4 s0 = slerpQuat(k0.value, k0.outTan, t, false);
-            const Vec4 s1 = slerpQuat(k0.outTan, k1.inTan, t, false);
-            const Vec4 s2 = slerpQuat(k1.inTan, k1.value, t, false);
-            const Vec4 s3 = slerpQuat(s0, s1, t, false);
-            const Vec4 s4 = slerpQuat(s1, s2, t, false);
-            return slerpQuat(s3, s4, t, false);
-        }
-        default:
-            return normalizeQuat(k0.value);
-        }
-    }
-
     // MDX Layer shading flags (common ones used for preview)
     constexpr std::uint32_t LAYER_UNSHADED   = 0x1;
     constexpr std::uint32_t LAYER_TWOSIDED   = 0x10;
@@ -426,9 +217,19 @@ namespace
     constexpr std::uint32_t NODE_DONT_INHERIT_SCALING     = 0x2;
     constexpr std::uint32_t NODE_DONT_INHERIT_ROTATION    = 0x4;
 
-    constexpr std::uint32_t PRE2_LINE_EMITTER = 0x20000;
-    constexpr std::uint32_t PRE2_MODEL_SPACE  = 0x80000;
     constexpr std::uint32_t PRE2_XY_QUAD      = 0x100000;
+
+    // Resident static mesh buffers across model switches (GLMeshCache).
+    constexpr int kDefaultMeshCacheMb = 256;
+
+    // Frame scheduling (see GLModelView::requestTick).
+    constexpr int kThrottledIntervalMs = 100;
+    constexpr int kPausedPollMs = 500;
+    constexpr int kSwapWatchdogMs = 250;
+
+#ifndef GL_TIME_ELAPSED
+    constexpr GLenum GL_TIME_ELAPSED = 0x88BF;
+#endif
 }
 
 GLModelView::GLModelView(QWidget* parent)
@@ -436,15 +237,26 @@ GLModelView::GLModelView(QWidget* parent)
 {
     setFocusPolicy(Qt::StrongFocus);
 
-    // Drive animation with a timer (keeps particles alive even without input)
+    // Finished simulation frames trigger a repaint on the GUI thread.
+    sim_ = std::make_unique<SimThread>([this]
+    {
+        QMetaObject::invokeMethod(this, [this] { update(); }, Qt::QueuedConnection);
+    });
+    packedVertices_ = qEnvironmentVariableIntValue("W3PREVIEW_PACKED_VERTICES") != 0;
+    sim_->setPackVertices(packedVertices_);
+
+    // Animation ticks are scheduled on demand (see requestTick); a static model only
+    // repaints on input.
+    frameTick_.setSingleShot(true);
     connect(&frameTick_, &QTimer::timeout, this, &GLModelView::tickAnimation);
-    frameTick_.setInterval(16); // ~60 FPS
-    frameTick_.start();
+    connect(this, &QOpenGLWidget::frameSwapped, this, &GLModelView::requestTick);
+    connect(qApp, &QGuiApplication::applicationStateChanged, this, &GLModelView::requestTick);
     frameTimer_.start();
 }
 
 GLModelView::~GLModelView()
 {
+    sim_.reset(); // joins the thread before anything it calls back into goes away
     makeCurrent();
     clearGpuResources();
     doneCurrent();
@@ -455,6 +267,166 @@ void GLModelView::setGlPhase(const char* phase)
     glPhase_ = QString::fromLatin1(phase);
 }
 
+void GLModelView::setDeterministic(bool enabled, std::uint32_t particleSeed)
+{
+    deterministic_ = enabled;
+    particleSeed_ = particleSeed; // applied by the next setModel()
+    if (enabled)
+        frameTick_.stop();
+    else
+        requestTick();
+}
+
+FrameProfiler::Frame GLModelView::renderFixedFrame(float dtSeconds)
+{
+    if (model_)
+    {
+        sim_->step(dtSeconds, playbackSpeed_, forceParticleVisible_);
+        sim_->waitIdle();
+    }
+
+    makeCurrent();
+    paintGL();
+    collectGpuQueries(true);
+    doneCurrent();
+
+    const FrameProfiler::Frame* last = profiler_.last();
+    return last ? *last : FrameProfiler::Frame();
+}
+
+void GLModelView::setHudVisible(bool visible)
+{
+    hudVisible_ = visible;
+    update();
+}
+
+void GLModelView::setPackedVertices(bool enabled)
+{
+    if (packedVertices_ == enabled)
+        return;
+    packedVertices_ = enabled;
+    sim_->setPackVertices(enabled);
+    if (model_ && context() && context()->isValid())
+    {
+        makeCurrent();
+        rebuildGpuBuffers();
+        doneCurrent();
+    }
+    update();
+}
+
+double GLModelView::packedVertexErrorPixels() const
+{
+    if (!model_ || model_->vertices.empty() || gpuSubmeshes_.empty())
+        return 0.0;
+
+    // Measures what the last frame drew: skinned submeshes as packed on the
+    // simulation thread with that frame's bounds, the rest from the static
+    // buffer's packing, moved by their rigid group matrix where they have one.
+    const auto& verts = model_->bindVertices.empty() ? model_->vertices : model_->bindVertices;
+    std::vector<VertexPacking::PackedVertex> meshPacked(verts.size());
+    const VertexPacking::Decode meshDecode = VertexPacking::Pack(verts.data(), verts.size(), meshPacked.data());
+
+    const SimThread::Frame& frame = sim_->front();
+    const bool framePacked = frame.generation == modelGeneration_ && frame.skinned && frame.packed &&
+                             frame.packedVertices.size() == frame.skinnedVertices.size() &&
+                             frame.skinnedVertices.size() == verts.size();
+
+    const QMatrix4x4 viewProj = proj_ * viewMatrix();
+    auto toPixels = [&](const QMatrix4x4& mvp, const ModelVertex& v, bool* outClipped) {
+        const QVector4D clip = mvp * QVector4D(v.px, v.py, v.pz, 1.0f);
+        *outClipped = clip.w() <= near_;
+        const float w = std::max(clip.w(), near_);
+        return QVector2D((clip.x() / w * 0.5f + 0.5f) * float(viewportW_),
+                         (clip.y() / w * 0.5f + 0.5f) * float(viewportH_));
+    };
+
+    double maxPx = 0.0;
+    std::vector<char> seen(verts.size(), 0);
+    for (const GpuSubmesh& sm : gpuSubmeshes_)
+    {
+        const bool stream = framePacked && streamValid_ && sm.rigidGroup < 0;
+        const QMatrix4x4 mvp = sm.rigidGroup >= 0 && std::size_t(sm.rigidGroup) < rigidMatrices_.size()
+                                   ? viewProj * rigidMatrices_[std::size_t(sm.rigidGroup)]
+                                   : viewProj;
+        const std::size_t end = std::min<std::size_t>(std::size_t(sm.indexOffset) + sm.indexCount, model_->indices.size());
+        for (std::size_t k = sm.indexOffset; k < end; ++k)
+        {
+            const std::uint32_t v = model_->indices[k];
+            if (v >= verts.size() || seen[v])
+                continue;
+            seen[v] = 1;
+            const ModelVertex& exact = stream ? frame.skinnedVertices[v] : verts[v];
+            const ModelVertex drawn = stream ? VertexPacking::Unpack(frame.packedVertices[v], frame.packedDecode)
+                                             : VertexPacking::Unpack(meshPacked[v], meshDecode);
+            bool clipped = false;
+            const QVector2D a = toPixels(mvp, exact, &clipped);
+            if (clipped)
+                continue; // behind the near plane
+            const QVector2D b = toPixels(mvp, drawn, &clipped);
+            maxPx = std::max(maxPx, double((a - b).length()));
+        }
+    }
+    return maxPx;
+}
+
+void GLModelView::beginGpuQuery()
+{
+    activeGpuQuery_ = nullptr;
+    if (isGles_)
+        return;
+
+    // Reuse a slot whose result has been collected; if the GPU is more than
+    // gpuQueries_.size() frames behind, this frame simply goes untimed.
+    for (auto& q : gpuQueries_)
+    {
+        if (q.pending)
+            continue;
+        if (q.id == 0)
+            glGenQueries(1, &q.id);
+        q.frameIndex = profiler_.current().index;
+        q.pending = true;
+        glBeginQuery(GL_TIME_ELAPSED, q.id);
+        activeGpuQuery_ = &q;
+        return;
+    }
+}
+
+void GLModelView::endGpuQuery()
+{
+    if (!activeGpuQuery_)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    activeGpuQuery_ = nullptr;
+}
+
+void GLModelView::collectGpuQueries(bool wait)
+{
+    for (auto& q : gpuQueries_)
+    {
+        if (!q.pending)
+            continue;
+        if (!wait)
+        {
+            GLint available = 0;
+            glGetQueryObjectiv(q.id, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                continue;
+        }
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(q.id, GL_QUERY_RESULT, &ns);
+        profiler_.setGpuMs(q.frameIndex, double(ns) / 1.0e6);
+        q.pending = false;
+    }
+}
+
+void GLModelView::noteTextureUpload(int w, int h)
+{
+    // RGBA8 plus a full mip chain (~4/3).
+    textureBytes_ += std::size_t(w) * std::size_t(h) * 4u * 4u / 3u;
+    profiler_.current().textureUploads += 1;
+}
+
 void GLModelView::setPlaybackSpeed(float speed)
 {
     playbackSpeed_ = clampf(speed, 0.05f, 10.0f);
@@ -487,18 +459,18 @@ void GLModelView::setCurrentSequence(int seqIndex)
     if (!model_ || model_->sequences.empty())
     {
         currentSeq_ = 0;
-        localTimeMs_ = 0;
         return;
     }
     const int maxIndex = int(model_->sequences.size()) - 1;
     currentSeq_ = std::max(0, std::min(seqIndex, maxIndex));
-    localTimeMs_ = 0;
-    invalidateBindCache();
+    sim_->setSequence(currentSeq_);
+    requestTick();
 }
 
 void GLModelView::setForceParticleVisible(bool enabled)
 {
     forceParticleVisible_ = enabled;
+    update();
 }
 
 void GLModelView::setAssetRoot(const QString& assetRoot)
@@ -597,66 +569,56 @@ void GLModelView::recordMissingTexture(const QString& ref, const QStringList& at
 
 void GLModelView::setModel(std::optional<ModelData> model, const QString& displayName, const QString& filePath)
 {
+    Trace::Scope trace("gl", "setModel", filePath);
     displayName_ = displayName;
     modelPath_ = filePath;
     modelDir_ = filePath.isEmpty() ? QString() : QFileInfo(filePath).absolutePath();
-    model_ = std::move(model);
-    skinnedVertices_.clear();
-    nodeWorldMat_.clear();
-    nodeWorldLoc_.clear();
-    nodeInvWorldLoc_.clear();
-    nodeWorldRot_.clear();
-    nodeInvWorldRot_.clear();
-    nodeWorldScale_.clear();
-    nodeInvWorldScale_.clear();
+    model_ = model ? std::make_shared<const ModelData>(std::move(*model)) : nullptr;
 
     missingTextures_.clear();
     missingTextureSet_.clear();
     emit missingTexturesChanged(missingTextures_);
 
-    localTimeMs_ = 0;
     currentSeq_ = 0;
+    lastGlobalTimeMs_ = 0;
+    simFrameFresh_ = false;
     frameTimer_.restart();
+    profiler_.reset();
     fpsFrames_ = 0;
     fps_ = 0.0f;
     fpsTimer_.invalidate();
     loggedBlank_ = false;
+    loadTiming_ = LoadTiming();
+    firstFrameTimer_.start();
+    firstFramePending_ = model_ != nullptr;
 
-    runtimeEmitters2_.clear();
-    if (model_)
-    {
-        runtimeEmitters2_.resize(model_->emitters2.size());
-        const std::size_t worldSize =
-            (model_->maxObjectId >= 0) ? std::size_t(model_->maxObjectId + 1) : 0;
-        nodeWorldMat_.assign(worldSize, QMatrix4x4());
-        nodeWorldLoc_.assign(worldSize, QVector3D(0, 0, 0));
-        nodeInvWorldLoc_.assign(worldSize, QVector3D(0, 0, 0));
-        nodeWorldRot_.assign(worldSize, QQuaternion(1, 0, 0, 0));
-        nodeInvWorldRot_.assign(worldSize, QQuaternion(1, 0, 0, 0));
-        nodeWorldScale_.assign(worldSize, QVector3D(1, 1, 1));
-        nodeInvWorldScale_.assign(worldSize, QVector3D(1, 1, 1));
-        for (auto& m : nodeWorldMat_)
-            m.setToIdentity();
-    }
-    invalidateBindCache();
+    // Deterministic mode replays the same particles for the same seed. Frames
+    // still in flight for the previous model are told apart by generation.
+    const std::uint32_t seed = deterministic_ ? particleSeed_ : QRandomGenerator::global()->generate();
+    sim_->setModel(model_, ++modelGeneration_, seed);
+    startTextureDecodes();
 
     // Reset texture cache (textures are tied to model/material IDs)
     if (context() && context()->isValid())
     {
         makeCurrent();
         textureCache_.clear();
+        textureBytes_ = 0;
         if (placeholderTex_ != 0)
         {
             glDeleteTextures(1, &placeholderTex_);
             placeholderTex_ = 0;
         }
+        QElapsedTimer uploadTimer;
+        uploadTimer.start();
         rebuildGpuBuffers();
+        loadTiming_.gpuUploadMs = TakeMs(uploadTimer);
         doneCurrent();
     }
 
     computeModelBounds();
     resetView();
-    LogSink::instance().log(QString("Camera fit: target=%1,%2,%3 dist=%4 near=%5 far=%6")
+    LogSink::instance().log(LogLevel::Debug, QString("Camera fit: target=%1,%2,%3 dist=%4 near=%5 far=%6")
                                 .arg(modelCenter_.x()).arg(modelCenter_.y()).arg(modelCenter_.z())
                                 .arg(distance_)
                                 .arg(near_)
@@ -704,19 +666,22 @@ void GLModelView::initializeGL()
                         return;
                     if (msg.id() == 131185 || msg.id() == 131169)
                         return;
+                    // Drivers can repeat the same message every draw call.
+                    static LogSink::RateLimit glMessageLimit(20);
                     const QString line = QString("GL: [%1] %2 (id=%3)")
                                              .arg(msg.severity())
                                              .arg(msg.message())
                                              .arg(msg.id());
                     if (msg.id() == 1281)
                     {
-                        LogSink::instance().log(QString("%1 | phase=%2")
+                        LogSink::instance().log(LogLevel::Warning, QString("%1 | phase=%2")
                                                     .arg(line)
-                                                    .arg(glPhase_.isEmpty() ? "unknown" : glPhase_));
+                                                    .arg(glPhase_.isEmpty() ? "unknown" : glPhase_),
+                                                &glMessageLimit);
                     }
                     else
                     {
-                        LogSink::instance().log(line);
+                        LogSink::instance().log(LogLevel::Warning, line, &glMessageLimit);
                     }
                 });
         glLogger_.startLogging(QOpenGLDebugLogger::SynchronousLogging);
@@ -731,6 +696,10 @@ void GLModelView::initializeGL()
     isGles_ = QOpenGLContext::currentContext()
                             ? QOpenGLContext::currentContext()->isOpenGLES()
                             : false;
+    glInfo_ = QString("%1 | %2")
+                  .arg(reinterpret_cast<const char*>(glGetString(GL_RENDERER)))
+                  .arg(reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+    LogSink::instance().log("GL: " + glInfo_);
     const QString glslHeader = isGles_ ? "#version 300 es\n" : "#version 330 core\n";
     const QString glslFragPreamble = isGles_ ? "precision mediump float;\n" : "";
 
@@ -738,19 +707,33 @@ void GLModelView::initializeGL()
     program_.addShaderFromSourceCode(QOpenGLShader::Vertex, QString(R"GLSL(
         %1
         layout(location=0) in vec3 aPos;
-        layout(location=1) in vec3 aNrm;
+        layout(location=1) in vec3 aNrm; // packed: octahedral in xy
         layout(location=2) in vec2 aUV;
 
         uniform mat4 uMVP;
         uniform mat3 uNormalMat;
+        // Identity for float vertices; VertexPacking::Decode for packed ones.
+        uniform vec3 uPosScale;
+        uniform vec3 uPosBias;
+        uniform vec4 uUvScaleBias;
+        uniform int uOctNormal;
 
         out vec3 vNrm;
         out vec2 vUV;
 
+        vec3 oct_decode(vec2 e){
+            vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+            float t = max(-n.z, 0.0);
+            n.x += n.x >= 0.0 ? -t : t;
+            n.y += n.y >= 0.0 ? -t : t;
+            return n;
+        }
+
         void main(){
-            gl_Position = uMVP * vec4(aPos, 1.0);
-            vNrm = normalize(uNormalMat * aNrm);
-            vUV = aUV;
+            gl_Position = uMVP * vec4(aPos * uPosScale + uPosBias, 1.0);
+            vec3 n = uOctNormal != 0 ? oct_decode(aNrm.xy) : aNrm;
+            vNrm = normalize(uNormalMat * n);
+            vUV = aUV * uUvScaleBias.xy + uUvScaleBias.zw;
         }
     )GLSL").arg(glslHeader));
 
@@ -761,15 +744,14 @@ void GLModelView::initializeGL()
         in vec2 vUV;
 
         uniform sampler2D uTex;
-        uniform int uHasTex;
-        uniform int uAlphaTest;
-        uniform float uAlphaCutoff;
-        uniform float uMatAlpha;
-        uniform vec3 uMatColor;
-        uniform int uUnshaded;
-        uniform vec2 uUvTrans;
-        uniform vec2 uUvRot;
-        uniform float uUvScale;
+
+        // One slot per draw, selected with glBindBufferRange. Mirrors MaterialParams.
+        layout(std140) uniform MaterialBlock {
+            vec4 uMatColor;   // rgb: geoset color, a: layer * geoset alpha
+            vec4 uUvTransRot; // xy: translation, zw: rotation
+            vec4 uUvParams;   // x: scale, y: alpha cutoff
+            ivec4 uFlags;     // x: has texture, y: alpha test, z: unshaded
+        };
 
         out vec4 FragColor;
 
@@ -782,21 +764,21 @@ void GLModelView::initializeGL()
         void main(){
             vec4 base = vec4(0.78, 0.78, 0.78, 1.0);
             vec2 uv = vUV;
-            uv += uUvTrans;
-            uv = quat_transform(uUvRot, uv - 0.5) + 0.5;
-            uv = uUvScale * (uv - 0.5) + 0.5;
-            if(uHasTex != 0){
+            uv += uUvTransRot.xy;
+            uv = quat_transform(uUvTransRot.zw, uv - 0.5) + 0.5;
+            uv = uUvParams.x * (uv - 0.5) + 0.5;
+            if(uFlags.x != 0){
                 base = texture(uTex, uv);
             }
-            base.rgb *= uMatColor;
-            base.a *= uMatAlpha;
+            base.rgb *= uMatColor.rgb;
+            base.a *= uMatColor.a;
 
-            if(uAlphaTest != 0 && base.a < uAlphaCutoff){
+            if(uFlags.y != 0 && base.a < uUvParams.y){
                 discard;
             }
 
             float lit = 1.0;
-            if(uUnshaded == 0){
+            if(uFlags.z == 0){
                 vec3 n = normalize(vNrm);
                 vec3 l = normalize(vec3(0.3, 0.5, 0.8));
                 lit = max(dot(n, l), 0.15);
@@ -810,29 +792,103 @@ void GLModelView::initializeGL()
     if (!programReady_)
     {
         emit statusTextChanged("Mesh shader link failed: " + program_.log());
-        LogSink::instance().log("Mesh shader link failed: " + program_.log());
+        LogSink::instance().log(LogLevel::Error, "Mesh shader link failed: " + program_.log());
     }
     else if (!program_.log().isEmpty())
     {
-        LogSink::instance().log("Mesh shader log: " + program_.log());
+        LogSink::instance().log(LogLevel::Debug, "Mesh shader log: " + program_.log());
+    }
+    if (programReady_)
+    {
+        meshUniforms_.mvp = program_.uniformLocation("uMVP");
+        meshUniforms_.normalMat = program_.uniformLocation("uNormalMat");
+        meshUniforms_.tex = program_.uniformLocation("uTex");
+        meshUniforms_.posScale = program_.uniformLocation("uPosScale");
+        meshUniforms_.posBias = program_.uniformLocation("uPosBias");
+        meshUniforms_.uvScaleBias = program_.uniformLocation("uUvScaleBias");
+        meshUniforms_.octNormal = program_.uniformLocation("uOctNormal");
+        const GLuint block = glGetUniformBlockIndex(program_.programId(), "MaterialBlock");
+        if (block != GL_INVALID_INDEX)
+            glUniformBlockBinding(program_.programId(), block, kMaterialBlockBinding);
     }
 
-    // Particle shader (unlit)
+    // Per-draw material parameters, refilled once per frame.
+    glGenBuffers(1, &materialUbo_);
+    GLint uboAlign = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uboAlign);
+    uboAlign = std::max<GLint>(uboAlign, 16);
+    materialStride_ = (sizeof(MaterialParams) + std::size_t(uboAlign) - 1) / std::size_t(uboAlign) * std::size_t(uboAlign);
+
+    // Particle shader (unlit). One instance per head/tail; the quad is expanded
+    // here from gl_VertexID, with segment color/alpha/scale and tail stretching.
     particleProgram_.addShaderFromSourceCode(QOpenGLShader::Vertex, QString(R"GLSL(
         %1
-        layout(location=0) in vec3 aPos;
-        layout(location=1) in vec2 aUV;
-        layout(location=2) in vec4 aColor;
+        layout(location=0) in vec4 aPosLife;    // xyz: position (emitter-local in model space), w: age / life
+        layout(location=1) in vec4 aVelFacing;  // xyz: velocity, w: XY-quad facing
+        layout(location=2) in uvec2 aFrameTail; // x: sprite cell, y: 1 for tails
 
         uniform mat4 uMVP;
+        uniform mat4 uEmitterWorld;
+        uniform vec3 uCamRight;
+        uniform vec3 uCamUp;
+        uniform vec3 uCamFwd;
+        uniform vec4 uSegColor[3]; // rgb + alpha
+        uniform vec3 uSegScale;    // world units (MDX percent / 100)
+        uniform float uTimeMiddle;
+        uniform float uSizeScale;
+        uniform float uTailLength;
+        uniform int uXyQuad;
+        uniform int uColumns;
+        uniform vec2 uCellSize;
 
         out vec2 vUV;
         out vec4 vColor;
 
+        const vec2 kCorners[6] = vec2[6](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+                                         vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
+
         void main(){
-            gl_Position = uMVP * vec4(aPos, 1.0);
-            vUV = aUV;
-            vColor = aColor;
+            vec2 c = kCorners[gl_VertexID];
+            float lifeT = aPosLife.w;
+            vec4 col;
+            float scale;
+            if(lifeT <= uTimeMiddle){
+                float t = lifeT / uTimeMiddle;
+                col = mix(uSegColor[0], uSegColor[1], t);
+                scale = mix(uSegScale.x, uSegScale.y, t);
+            } else {
+                float t = (lifeT - uTimeMiddle) / (1.0 - uTimeMiddle);
+                col = mix(uSegColor[1], uSegColor[2], t);
+                scale = mix(uSegScale.y, uSegScale.z, t);
+            }
+            float hs = 0.5 * max(0.01, scale) * uSizeScale;
+
+            vec3 pos = (uEmitterWorld * vec4(aPosLife.xyz, 1.0)).xyz;
+            vec3 world;
+            if(aFrameTail.y != 0u){
+                vec3 dir = aVelFacing.xyz;
+                dir = dot(dir, dir) < 1e-6 ? uCamFwd : normalize(dir);
+                vec3 side = cross(uCamFwd, dir);
+                side = dot(side, side) < 1e-6 ? uCamRight : normalize(side);
+                vec3 tailEnd = (uEmitterWorld * vec4(aPosLife.xyz - dir * uTailLength, 1.0)).xyz;
+                world = mix(pos, tailEnd, c.y) + side * (hs * (1.0 - 2.0 * c.x));
+            } else {
+                vec3 right = uCamRight;
+                vec3 up = uCamUp;
+                if(uXyQuad != 0){
+                    float cs = cos(aVelFacing.w);
+                    float sn = sin(aVelFacing.w);
+                    vec3 r2 = right * cs - up * sn;
+                    up = right * sn + up * cs;
+                    right = r2;
+                }
+                world = pos + (right * (2.0 * c.x - 1.0) + up * (2.0 * c.y - 1.0)) * hs;
+            }
+
+            int frame = int(aFrameTail.x);
+            vUV = (vec2(float(frame % uColumns), float(frame / uColumns)) + c) * uCellSize;
+            vColor = col;
+            gl_Position = uMVP * vec4(world, 1.0);
         }
     )GLSL").arg(glslHeader));
 
@@ -860,11 +916,30 @@ void GLModelView::initializeGL()
     if (!particleProgramReady_)
     {
         emit statusTextChanged("Particle shader link failed: " + particleProgram_.log());
-        LogSink::instance().log("Particle shader link failed: " + particleProgram_.log());
+        LogSink::instance().log(LogLevel::Error, "Particle shader link failed: " + particleProgram_.log());
     }
     else if (!particleProgram_.log().isEmpty())
     {
-        LogSink::instance().log("Particle shader log: " + particleProgram_.log());
+        LogSink::instance().log(LogLevel::Debug, "Particle shader log: " + particleProgram_.log());
+    }
+    if (particleProgramReady_)
+    {
+        particleUniforms_.mvp = particleProgram_.uniformLocation("uMVP");
+        particleUniforms_.tex = particleProgram_.uniformLocation("uTex");
+        particleUniforms_.camRight = particleProgram_.uniformLocation("uCamRight");
+        particleUniforms_.camUp = particleProgram_.uniformLocation("uCamUp");
+        particleUniforms_.camFwd = particleProgram_.uniformLocation("uCamFwd");
+        particleUniforms_.alphaTest = particleProgram_.uniformLocation("uAlphaTest");
+        particleUniforms_.alphaCutoff = particleProgram_.uniformLocation("uAlphaCutoff");
+        particleUniforms_.emitterWorld = particleProgram_.uniformLocation("uEmitterWorld");
+        particleUniforms_.segColor = particleProgram_.uniformLocation("uSegColor");
+        particleUniforms_.segScale = particleProgram_.uniformLocation("uSegScale");
+        particleUniforms_.timeMiddle = particleProgram_.uniformLocation("uTimeMiddle");
+        particleUniforms_.sizeScale = particleProgram_.uniformLocation("uSizeScale");
+        particleUniforms_.tailLength = particleProgram_.uniformLocation("uTailLength");
+        particleUniforms_.xyQuad = particleProgram_.uniformLocation("uXyQuad");
+        particleUniforms_.columns = particleProgram_.uniformLocation("uColumns");
+        particleUniforms_.cellSize = particleProgram_.uniformLocation("uCellSize");
     }
 
     debugProgram_.addShaderFromSourceCode(QOpenGLShader::Vertex, QString(R"GLSL(
@@ -894,24 +969,37 @@ void GLModelView::initializeGL()
 
     debugProgramReady_ = debugProgram_.link();
     if (!debugProgramReady_)
-        LogSink::instance().log("Debug shader link failed: " + debugProgram_.log());
+        LogSink::instance().log(LogLevel::Error, "Debug shader link failed: " + debugProgram_.log());
     else if (!debugProgram_.log().isEmpty())
-        LogSink::instance().log("Debug shader log: " + debugProgram_.log());
+        LogSink::instance().log(LogLevel::Debug, "Debug shader log: " + debugProgram_.log());
 
-    // Particle buffer
+    // Skinned vertices and particle instances are rewritten every frame.
+    streamBuffer_.init(this, 4 * 1024 * 1024);
+    LogSink::instance().log(LogLevel::Debug, QString("Stream buffer: %1")
+                                .arg(streamBuffer_.persistent() ? "persistent mapping" : "map/unmap ring"));
+
+    // W3PREVIEW_MESH_CACHE_MB overrides the resident mesh budget.
+    const int meshCacheMb = qEnvironmentVariableIsSet("W3PREVIEW_MESH_CACHE_MB")
+                                ? std::max(0, qEnvironmentVariableIntValue("W3PREVIEW_MESH_CACHE_MB"))
+                                : kDefaultMeshCacheMb;
+    meshCache_.init(this, std::size_t(meshCacheMb) * 1024 * 1024);
+
+    // Particle VAO: per-instance attributes only, the six quad corners come from
+    // gl_VertexID. Attribute pointers are set per draw into the stream buffer.
     glGenVertexArrays(1, &pVao_);
     glBindVertexArray(pVao_);
-    glGenBuffers(1, &pVbo_);
-    glBindBuffer(GL_ARRAY_BUFFER, pVbo_);
-    glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW);
+    for (GLuint attr = 0; attr < 3; ++attr)
+    {
+        glEnableVertexAttribArray(attr);
+        glVertexAttribDivisor(attr, 1);
+    }
 
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ParticleVertex), (void*)offsetof(ParticleVertex, px));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ParticleVertex), (void*)offsetof(ParticleVertex, u));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleVertex), (void*)offsetof(ParticleVertex, r));
+    glBindVertexArray(0);
 
+    glGenVertexArrays(1, &streamVao_);
+    glBindVertexArray(streamVao_);
+    for (GLuint attr = 0; attr < 3; ++attr)
+        glEnableVertexAttribArray(attr);
     glBindVertexArray(0);
 
     // Debug buffer
@@ -956,212 +1044,143 @@ void GLModelView::resizeGL(int w, int h)
     updateProjection(w, h);
 }
 
-void GLModelView::tickAnimation()
+bool GLModelView::hasAnimation() const
 {
-    // Only advance if we have a model loaded.
     if (!model_)
-        return;
+        return false;
+    if (!model_->emitters2.empty() || !model_->globalSequencesMs.empty())
+        return true;
+    for (const auto& seq : model_->sequences)
+    {
+        if (seq.endMs > seq.startMs)
+            return true;
+    }
+    return false;
+}
 
-    // dt in seconds
-    const qint64 ns = frameTimer_.nsecsElapsed();
-    frameTimer_.restart();
-    float dt = float(ns) / 1.0e9f;
-    dt = clampf(dt, 0.0f, 0.1f);
+GLModelView::RenderMode GLModelView::evaluateRenderMode() const
+{
+    if (!hasAnimation())
+        return RenderMode::Idle;
+
+    const Qt::ApplicationState state = QGuiApplication::applicationState();
+    if (!isVisible() || state == Qt::ApplicationHidden || state == Qt::ApplicationSuspended)
+        return RenderMode::Paused;
+    const QWindow* handle = window()->windowHandle();
+    if (handle && (!handle->isExposed() || handle->visibility() == QWindow::Minimized))
+        return RenderMode::Paused;
+
+    if (state != Qt::ApplicationActive || !window()->isActiveWindow())
+        return RenderMode::Throttled;
+    return RenderMode::Animating;
+}
 
-    updateEmitters(dt);
-    update(); // trigger repaint
+const char* GLModelView::renderModeName(RenderMode mode)
+{
+    switch (mode)
+    {
+    case RenderMode::Idle: return "idle";
+    case RenderMode::Animating: return "animating";
+    case RenderMode::Throttled: return "throttled";
+    case RenderMode::Paused: return "paused";
+    }
+    return "";
 }
 
-void GLModelView::updateEmitters(float dtSeconds)
+void GLModelView::setRenderMode(RenderMode mode)
 {
-    if (!model_)
+    if (mode == renderMode_)
         return;
-
-    // Advance local time (monotonic)
-    localTimeMs_ += std::uint32_t(dtSeconds * 1000.0f * playbackSpeed_);
-
-    // Determine global time (sequence mapping)
-    std::uint32_t globalTimeMs = localTimeMs_;
-    if (!model_->sequences.empty())
+    renderMode_ = mode;
+    if (mode == RenderMode::Idle || mode == RenderMode::Paused)
     {
-        const std::size_t seqIndex = std::min<std::size_t>(model_->sequences.size() - 1,
-                                                           std::size_t(std::max(0, currentSeq_)));
-        const auto& seq = model_->sequences[seqIndex];
-        const std::uint32_t start = seq.startMs;
-        const std::uint32_t end = std::max(seq.endMs, seq.startMs + 1);
-        const std::uint32_t len = end - start;
-        const std::uint32_t local = (len != 0) ? (localTimeMs_ % len) : 0;
-        globalTimeMs = start + local;
+        fpsFrames_ = 0;
+        fps_ = 0.0f;
+        fpsTimer_.invalidate();
     }
-    lastGlobalTimeMs_ = globalTimeMs;
-
-    // Update node transforms for this frame (particles may rely on them).
-    buildNodeWorldCached(globalTimeMs);
+    statusTimer_.invalidate(); // show the change right away
+    updateStatusText();
+}
 
-    // RNG (fixed seed per run; adequate for preview)
-    static thread_local std::mt19937 rng(1337u);
-    std::uniform_real_distribution<float> u01(0.0f, 1.0f);
-    auto randSigned = [&]() { return u01(rng) * 2.0f - 1.0f; };
+void GLModelView::requestTick()
+{
+    if (deterministic_)
+        return;
 
-    // Ensure runtime storage matches emitter count
-    if (runtimeEmitters2_.size() != model_->emitters2.size())
-        runtimeEmitters2_.assign(model_->emitters2.size(), {});
+    const RenderMode mode = evaluateRenderMode();
+    setRenderMode(mode);
 
-    for (std::size_t ei = 0; ei < model_->emitters2.size(); ++ei)
+    int delayMs = 0;
+    switch (mode)
     {
-        const auto& e = model_->emitters2[ei];
-        auto& rt = runtimeEmitters2_[ei];
-
-        const float vis = forceParticleVisible_
-                              ? 1.0f
-                              : clampf(sampleTrackFloat(e.trackVisibility, globalTimeMs, 1.0f, *model_), 0.0f, 1.0f);
-        if (vis <= 0.001f)
-        {
-            // Still age existing particles so they fade out naturally.
-        }
-
-        const float speed = sampleTrackFloat(e.trackSpeed, globalTimeMs, e.speed, *model_);
-        const float variation = sampleTrackFloat(e.trackVariation, globalTimeMs, e.variation, *model_);
-        const float latitude = sampleTrackFloat(e.trackLatitude, globalTimeMs, e.latitude, *model_);
-        const float emissionRate = std::max(0.0f, sampleTrackFloat(e.trackEmissionRate, globalTimeMs, e.emissionRate, *model_)) * 2.0f;
-        const float gravity = sampleTrackFloat(e.trackGravity, globalTimeMs, e.gravity, *model_);
-        const float lifespan = std::max(0.01f, sampleTrackFloat(e.trackLifespan, globalTimeMs, e.lifespan, *model_));
-        const float width = sampleTrackFloat(e.trackWidth, globalTimeMs, e.width, *model_);
-        const float length = sampleTrackFloat(e.trackLength, globalTimeMs, e.length, *model_);
-
-        const bool modelSpace = (e.flags & PRE2_MODEL_SPACE) != 0;
-        const bool lineEmitter = (e.flags & PRE2_LINE_EMITTER) != 0;
-        const bool xyQuad = (e.flags & PRE2_XY_QUAD) != 0;
-
-        QVector3D pivot(0, 0, 0);
-        QMatrix4x4 nodeWorld;
-        nodeWorld.setToIdentity();
-        QQuaternion nodeRot(1, 0, 0, 0);
-        QVector3D nodeScale(1, 1, 1);
-
-        if (e.objectId >= 0 && e.objectId < static_cast<int>(model_->nodeIdToIndex.size()))
-        {
-            const int idx = model_->nodeIdToIndex[e.objectId];
-            if (idx >= 0 && std::size_t(idx) < model_->nodes.size())
-            {
-                const auto& n = model_->nodes[std::size_t(idx)];
-                pivot = QVector3D(n.pivot.x, n.pivot.y, n.pivot.z);
-            }
-            if (std::size_t(e.objectId) < nodeWorldMat_.size())
-            {
-                nodeWorld = nodeWorldMat_[std::size_t(e.objectId)];
-                nodeRot = nodeWorldRot_[std::size_t(e.objectId)];
-                nodeScale = nodeWorldScale_[std::size_t(e.objectId)];
-            }
-        }
-        else if (e.objectId >= 0 && std::size_t(e.objectId) < model_->pivots.size())
-        {
-            const auto& p = model_->pivots[std::size_t(e.objectId)];
-            pivot = QVector3D(p.x, p.y, p.z);
-        }
-
-        // Spawn particles
-        if (vis > 0.001f && emissionRate > 0.0f)
-        {
-            rt.spawnAccum += double(emissionRate) * double(dtSeconds);
-            int toSpawn = int(rt.spawnAccum);
-            if (toSpawn > 0)
-            {
-                rt.spawnAccum -= double(toSpawn);
-                toSpawn = std::min(toSpawn, 200); // safety cap
-
-                for (int i = 0; i < toSpawn; ++i)
-                {
-                    auto spawnParticle = [&](int tailType)
-                    {
-                        Particle p;
-                        p.age = 0.0f;
-                        p.life = lifespan;
-                        p.tailType = tailType;
-
-                        // Initial position: pivot + scatter in X/Y
-                        const float sx = randSigned() * width;
-                        const float sy = randSigned() * length;
-                        QVector3D localPos = pivot + QVector3D(sx, sy, 0.0f);
-
-                        // Build local rotation (match mdx-m3-viewer)
-                        const float lat = latitude;
-                        const float ay = randSigned() * lat;
-                        const float ax = randSigned() * lat;
-                        QQuaternion rot = QQuaternion::fromAxisAndAngle(0, 0, 1, 90.0f);
-                        rot *= QQuaternion::fromAxisAndAngle(0, 1, 0, ay * 57.2957795f);
-                        if (!lineEmitter)
-                            rot *= QQuaternion::fromAxisAndAngle(1, 0, 0, ax * 57.2957795f);
-
-                        if (!modelSpace)
-                            rot = nodeRot * rot;
-
-                        QVector3D dir = rot.rotatedVector(QVector3D(0, 0, 1));
-                        dir.normalize();
-
-                        const float sp = speed * (1.0f + randSigned() * variation);
-                        QVector3D vel = dir * sp;
-
-                        if (!modelSpace)
-                        {
-                            vel = QVector3D(vel.x() * nodeScale.x(),
-                                            vel.y() * nodeScale.y(),
-                                            vel.z() * nodeScale.z());
-                            localPos = (nodeWorld * QVector4D(localPos, 1.0f)).toVector3D();
-                        }
+    case RenderMode::Idle:
+        frameTick_.stop();
+        return;
+    case RenderMode::Paused:
+        // Nothing is presented; poll slowly so an uncovered window resumes by itself.
+        delayMs = kPausedPollMs;
+        break;
+    case RenderMode::Throttled:
+        delayMs = std::max<int>(0, kThrottledIntervalMs - int(frameTimer_.elapsed()));
+        break;
+    case RenderMode::Animating:
+    {
+        // Called from frameSwapped: with vsync the swap already paced us, so the next
+        // tick is due now. The floor only matters when the swap does not block.
+        const qreal hz = screen() ? screen()->refreshRate() : 60.0;
+        const int minIntervalMs = std::max(1, int(1000.0 / std::max<qreal>(hz, 1.0)) - 1);
+        delayMs = std::max<int>(0, minIntervalMs - int(frameTimer_.elapsed()));
+        break;
+    }
+    }
+    frameTick_.start(delayMs);
+}
 
-                        p.pos = localPos;
-                        p.vel = vel;
-                        p.gravity = modelSpace ? gravity : (gravity * nodeScale.z());
+void GLModelView::tickAnimation()
+{
+    const RenderMode mode = evaluateRenderMode();
+    setRenderMode(mode);
+    if (mode == RenderMode::Idle)
+        return;
+    if (mode == RenderMode::Paused)
+    {
+        frameTimer_.restart(); // resume without a time jump
+        frameTick_.start(kPausedPollMs);
+        return;
+    }
 
-                        if (xyQuad)
-                            p.facing = std::atan2(p.vel.y(), p.vel.x()) - float(M_PI) + float(M_PI / 8.0);
+    // dt in seconds
+    const qint64 ns = frameTimer_.nsecsElapsed();
+    frameTimer_.restart();
+    float dt = float(ns) / 1.0e9f;
+    dt = clampf(dt, 0.0f, 0.1f);
 
-                        rt.particles.push_back(p);
-                    };
+    // The published frame schedules the repaint; the next tick is requested from frameSwapped.
+    sim_->step(dt, playbackSpeed_, forceParticleVisible_);
 
-                    const bool wantHead = (e.headOrTail == 0 || e.headOrTail == 2);
-                    const bool wantTail = (e.headOrTail == 1 || e.headOrTail == 2);
-                    if (wantHead)
-                        spawnParticle(0);
-                    if (wantTail)
-                        spawnParticle(1);
-                }
-            }
-        }
-        else if (!rt.loggedNoSpawn && localTimeMs_ > 1000)
-        {
-            rt.loggedNoSpawn = true;
-            LogSink::instance().log(QString("PRE2 %1 no spawn: vis=%2 rate=%3 life=%4 rows=%5 cols=%6 flags=0x%7")
-                                        .arg(ei)
-                                        .arg(vis, 0, 'f', 3)
-                                        .arg(emissionRate, 0, 'f', 3)
-                                        .arg(lifespan, 0, 'f', 3)
-                                        .arg(e.rows)
-                                        .arg(e.columns)
-                                        .arg(QString::number(e.flags, 16)));
-        }
+    // Fallback if the frame never reaches the screen (no frameSwapped).
+    frameTick_.start(kSwapWatchdogMs);
+}
 
-        // Update existing particles
-        for (auto& p : rt.particles)
-        {
-            p.age += dtSeconds;
-            // gravity pulls down in Z
-            p.vel.setZ(p.vel.z() - p.gravity * dtSeconds);
-            p.pos += p.vel * dtSeconds;
-        }
+void GLModelView::showEvent(QShowEvent* e)
+{
+    QOpenGLWidget::showEvent(e);
+    frameTimer_.restart();
+    requestTick();
+}
 
-        // Remove dead
-        rt.particles.erase(
-            std::remove_if(rt.particles.begin(), rt.particles.end(),
-                           [](const Particle& p) { return p.age >= p.life; }),
-            rt.particles.end()
-        );
+void GLModelView::hideEvent(QHideEvent* e)
+{
+    QOpenGLWidget::hideEvent(e);
+    frameTick_.stop();
+    setRenderMode(hasAnimation() ? RenderMode::Paused : RenderMode::Idle);
+}
 
-        // Keep count bounded for safety
-        if (rt.particles.size() > 5000)
-            rt.particles.erase(rt.particles.begin(), rt.particles.end() - 5000);
-    }
+void GLModelView::changeEvent(QEvent* e)
+{
+    QOpenGLWidget::changeEvent(e);
+    if (e->type() == QEvent::ActivationChange || e->type() == QEvent::WindowStateChange)
+        requestTick();
 }
 
 void GLModelView::buildDebugGeometry()
@@ -1237,347 +1256,128 @@ void GLModelView::drawDebug(const QMatrix4x4& mvp)
     debugProgram_.release();
 }
 
-void GLModelView::computeNodeWorld(std::uint32_t globalTimeMs, std::vector<QMatrix4x4>& outWorld) const
+const SimThread::Frame* GLModelView::takeSimFrame()
 {
-    if (!model_)
+    if (sim_->acquire())
+        simFrameFresh_ = true;
+    const SimThread::Frame& frame = sim_->front();
+    if (frame.generation != modelGeneration_)
+        return nullptr;
+
+    // Simulation time is charged once, to the first frame that shows its result.
+    if (simFrameFresh_)
+    {
+        simFrameFresh_ = false;
+        profiler_.add(FrameProfiler::Sampling, frame.samplingMs);
+        profiler_.add(FrameProfiler::Skinning, frame.skinningMs);
+        profiler_.add(FrameProfiler::Particles, frame.particlesMs);
+    }
+    lastGlobalTimeMs_ = frame.globalTimeMs;
+    return &frame;
+}
+
+void GLModelView::uploadSkinnedVertices(const SimThread::Frame& frame)
+{
+    if (!frame.skinned || vbo_ == 0 || frame.skinnedVertices.empty())
         return;
 
-    const int maxObjectId = model_->maxObjectId;
-    const std::size_t worldSize = (maxObjectId >= 0) ? std::size_t(maxObjectId + 1) : 0;
-    outWorld.assign(worldSize, QMatrix4x4());
-    for (auto& m : outWorld)
-        m.setToIdentity();
+    // Camera-only repaints and static poses see the same pose serial again.
+    // The stream region it went to is recycled within kFrames, so an
+    // unchanged pose is copied once into skinVbo_ and drawn from there.
+    const bool samePose = frame.poseSerial == streamPoseSerial_;
+    if (samePose && skinResident_)
+        return;
 
-    if (worldSize == 0 || model_->nodes.empty())
+    FrameProfiler::Scope scope(profiler_, FrameProfiler::Skinning);
+    if (!samePose && frame.groupMatrices.size() == rigidMatrices_.size())
+        rigidMatrices_ = frame.groupMatrices;
+    streamPoseSerial_ = frame.poseSerial;
+    skinResident_ = false;
+    if (frame.skinnedRanges.empty())
+    {
+        skinResident_ = true; // every submesh is rigid
         return;
+    }
 
-    std::vector<int> state(worldSize, 0);
+    // Laid out like vbo_, so the shared IBO indexes it; only the skinned ranges are written.
+    const bool packed = frame.packed && frame.packedVertices.size() == frame.skinnedVertices.size();
+    const std::size_t stride = packed ? sizeof(VertexPacking::PackedVertex) : sizeof(ModelVertex);
+    const unsigned char* data = packed ? reinterpret_cast<const unsigned char*>(frame.packedVertices.data())
+                                       : reinterpret_cast<const unsigned char*>(frame.skinnedVertices.data());
+    const std::size_t bytes = frame.skinnedRanges.back().second * stride;
+    std::size_t skinned = 0;
+    for (const auto& r : frame.skinnedRanges)
+        skinned += r.second - r.first;
 
-    auto buildNode = [&](auto&& self, int objectId) -> void
+    if (samePose && streamValid_)
     {
-        if (objectId < 0 || std::size_t(objectId) >= worldSize)
-            return;
-        if (state[std::size_t(objectId)] == 2)
-            return;
-        if (state[std::size_t(objectId)] == 1)
+        if (!skinVbo_)
+            glGenBuffers(1, &skinVbo_);
+        glBindBuffer(GL_ARRAY_BUFFER, skinVbo_);
+        if (bytes > skinVboBytes_)
         {
-            outWorld[std::size_t(objectId)].setToIdentity();
-            state[std::size_t(objectId)] = 2;
-            return;
+            glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(bytes), nullptr, GL_DYNAMIC_DRAW);
+            skinVboBytes_ = bytes;
         }
-        state[std::size_t(objectId)] = 1;
-
-        if (objectId >= static_cast<int>(model_->nodeIdToIndex.size()))
-        {
-            outWorld[std::size_t(objectId)].setToIdentity();
-            state[std::size_t(objectId)] = 2;
-            return;
-        }
-
-        const int nodeIndex = model_->nodeIdToIndex[objectId];
-        if (nodeIndex < 0 || std::size_t(nodeIndex) >= model_->nodes.size())
-        {
-            outWorld[std::size_t(objectId)].setToIdentity();
-            state[std::size_t(objectId)] = 2;
-            return;
-        }
-
-        const auto& n = model_->nodes[std::size_t(nodeIndex)];
-
-        QMatrix4x4 parentWorld;
-        parentWorld.setToIdentity();
-        if (n.parentId >= 0)
-        {
-            if (n.parentId < static_cast<int>(model_->nodeIdToIndex.size()) &&
-                model_->nodeIdToIndex[n.parentId] >= 0)
-            {
-                self(self, n.parentId);
-                parentWorld = outWorld[std::size_t(n.parentId)];
-            }
-            else
-            {
-#ifndef NDEBUG
-                LogSink::instance().log(QString("Missing parent nodeId=%1 parentId=%2")
-                                            .arg(n.objectId)
-                                            .arg(n.parentId));
-#endif
-            }
-        }
-
-        const Vec3 defT{0, 0, 0};
-        const Vec3 defS{1, 1, 1};
-        const Vec4 defR{0, 0, 0, 1};
-
-        const Vec3 t = sampleTrackVec3(n.trackTranslation, globalTimeMs, defT, *model_);
-        const Vec3 s = sampleTrackVec3(n.trackScaling, globalTimeMs, defS, *model_);
-        Vec4 r = sampleTrackQuat(n.trackRotation, globalTimeMs, defR, *model_);
-
-        const QVector3D pivot(n.pivot.x, n.pivot.y, n.pivot.z);
-        const QVector3D localLoc(t.x, t.y, t.z);
-        const QVector3D localScale(s.x, s.y, s.z);
-
-        QQuaternion localRot(r.w, r.x, r.y, r.z);
-        localRot.normalize();
-
-        QMatrix4x4 localM;
-        localM.setToIdentity();
-        localM.translate(localLoc);
-        localM.translate(pivot);
-        localM.rotate(localRot);
-        localM.scale(localScale);
-        localM.translate(-pivot);
-
-        outWorld[std::size_t(objectId)] = parentWorld * localM;
-        state[std::size_t(objectId)] = 2;
-    };
-
-    for (const auto& n : model_->nodes)
-        buildNode(buildNode, n.objectId);
-}
-
-void GLModelView::buildNodeWorldCached(std::uint32_t globalTimeMs)
-{
-    if (!model_)
+        for (const auto& r : frame.skinnedRanges)
+            glBufferSubData(GL_ARRAY_BUFFER, GLintptr(r.first * stride), GLsizeiptr((r.second - r.first) * stride),
+                            data + r.first * stride);
+        setMeshVertexSource(streamVao_, skinVbo_, 0, packed);
+        skinResident_ = true;
+        profiler_.current().skinnedVertices = skinned;
         return;
-
-    const std::size_t worldSize =
-        (model_->maxObjectId >= 0) ? std::size_t(model_->maxObjectId + 1) : 0;
-
-    if (nodeWorldMat_.size() != worldSize)
-    {
-        nodeWorldMat_.assign(worldSize, QMatrix4x4());
-        nodeWorldLoc_.assign(worldSize, QVector3D(0, 0, 0));
-        nodeInvWorldLoc_.assign(worldSize, QVector3D(0, 0, 0));
-        nodeWorldRot_.assign(worldSize, QQuaternion(1, 0, 0, 0));
-        nodeInvWorldRot_.assign(worldSize, QQuaternion(1, 0, 0, 0));
-        nodeWorldScale_.assign(worldSize, QVector3D(1, 1, 1));
-        nodeInvWorldScale_.assign(worldSize, QVector3D(1, 1, 1));
-        for (auto& m : nodeWorldMat_)
-            m.setToIdentity();
     }
 
-    computeNodeWorld(globalTimeMs, nodeWorldMat_);
-
-    if (nodeWorldMat_.empty())
-        return;
+    // A new pose goes to a fresh stream region.
+    const GLStreamBuffer::Allocation alloc = streamBuffer_.allocate(bytes);
+    streamValid_ = alloc.ptr != nullptr;
+    if (!streamValid_)
+        return; // skinned submeshes fall back to the bind pose this frame
 
-    for (std::size_t objectId = 0; objectId < nodeWorldMat_.size(); ++objectId)
+    for (const auto& r : frame.skinnedRanges)
     {
-        Vec3 pivot{0, 0, 0};
-        if (objectId < model_->nodeIdToIndex.size())
-        {
-            const int idx = model_->nodeIdToIndex[static_cast<int>(objectId)];
-            if (idx >= 0 && std::size_t(idx) < model_->nodes.size())
-                pivot = model_->nodes[std::size_t(idx)].pivot;
-        }
-
-        const QMatrix4x4& worldM = nodeWorldMat_[objectId];
-        const QVector4D wlp = worldM * QVector4D(pivot.x, pivot.y, pivot.z, 1.0f);
-        const QVector3D wl(wlp.x(), wlp.y(), wlp.z());
-        nodeWorldLoc_[objectId] = wl;
-        nodeInvWorldLoc_[objectId] = -wl;
-
-        QVector3D xAxis(worldM(0, 0), worldM(1, 0), worldM(2, 0));
-        QVector3D yAxis(worldM(0, 1), worldM(1, 1), worldM(2, 1));
-        QVector3D zAxis(worldM(0, 2), worldM(1, 2), worldM(2, 2));
-
-        const float sx = xAxis.length();
-        const float sy = yAxis.length();
-        const float sz = zAxis.length();
-        nodeWorldScale_[objectId] = QVector3D(sx, sy, sz);
-
-        if (sx > 1e-8f) xAxis /= sx;
-        if (sy > 1e-8f) yAxis /= sy;
-        if (sz > 1e-8f) zAxis /= sz;
-
-        QMatrix3x3 rotM;
-        rotM(0, 0) = xAxis.x(); rotM(1, 0) = xAxis.y(); rotM(2, 0) = xAxis.z();
-        rotM(0, 1) = yAxis.x(); rotM(1, 1) = yAxis.y(); rotM(2, 1) = yAxis.z();
-        rotM(0, 2) = zAxis.x(); rotM(1, 2) = zAxis.y(); rotM(2, 2) = zAxis.z();
-
-        nodeWorldRot_[objectId] = QQuaternion::fromRotationMatrix(rotM);
-        nodeWorldRot_[objectId].normalize();
-        nodeInvWorldRot_[objectId] = nodeWorldRot_[objectId].conjugated();
-
-        auto invSafe = [](float v) -> float { return (std::fabs(v) > 1e-8f) ? (1.0f / v) : 0.0f; };
-        nodeInvWorldScale_[objectId] = QVector3D(invSafe(sx), invSafe(sy), invSafe(sz));
+        std::memcpy(static_cast<unsigned char*>(alloc.ptr) + r.first * stride, data + r.first * stride,
+                    (r.second - r.first) * stride);
     }
+    streamBuffer_.commit(alloc);
+    setMeshVertexSource(streamVao_, alloc.buffer, alloc.offset, packed);
+    streamPacked_ = packed;
+    streamDecode_ = packed ? frame.packedDecode : VertexPacking::Decode();
+    profiler_.current().skinnedVertices = skinned;
 }
 
-void GLModelView::invalidateBindCache()
-{
-    bindCacheSeq_ = -1;
-    invBindByNodeId_.clear();
-}
-
-void GLModelView::ensureBindCache()
+void GLModelView::setMeshVertexSource(GLuint vao, GLuint buffer, GLintptr offset, bool packed)
 {
-    if (!model_)
-        return;
-
-    int seqIndex = 0;
-    if (!model_->sequences.empty())
+    using VertexPacking::PackedVertex;
+    const std::uintptr_t base = std::uintptr_t(offset);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    if (packed)
     {
-        seqIndex = std::max(0, std::min(int(model_->sequences.size()) - 1, currentSeq_));
-    }
-
-    if (bindCacheSeq_ == seqIndex &&
-        invBindByNodeId_.size() == nodeWorldMat_.size())
-    {
-        return;
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)(base + offsetof(PackedVertex, px)));
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)(base + offsetof(PackedVertex, ox)));
+        glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)(base + offsetof(PackedVertex, u)));
     }
-
-    const std::uint32_t tBind =
-        model_->sequences.empty() ? 0u : model_->sequences[std::size_t(seqIndex)].startMs;
-
-    buildNodeWorldCached(tBind);
-
-    invBindByNodeId_.resize(nodeWorldMat_.size());
-    for (std::size_t i = 0; i < nodeWorldMat_.size(); ++i)
+    else
     {
-        bool ok = true;
-        invBindByNodeId_[i] = nodeWorldMat_[i].inverted(&ok);
-        if (!ok)
-            invBindByNodeId_[i].setToIdentity();
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ModelVertex), (void*)(base + offsetof(ModelVertex, px)));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(ModelVertex), (void*)(base + offsetof(ModelVertex, nx)));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(ModelVertex), (void*)(base + offsetof(ModelVertex, u)));
     }
-
-    bindCacheSeq_ = seqIndex;
+    glBindVertexArray(0);
 }
 
-void GLModelView::updateSkinning(std::uint32_t globalTimeMs)
+QMatrix4x4 GLModelView::viewMatrix() const
 {
-    if (!model_)
-        return;
-    if (model_->bindVertices.empty() || model_->vertexGroups.size() != model_->bindVertices.size())
-        return;
-    if (model_->skinGroups.empty() || model_->nodes.empty())
-        return;
-    if (vbo_ == 0)
-        return;
-
-    if (skinnedVertices_.size() != model_->bindVertices.size())
-        skinnedVertices_ = model_->bindVertices;
-
-    ensureBindCache();
-    buildNodeWorldCached(globalTimeMs);
-
-    std::vector<QMatrix4x4> skinMats;
-    skinMats.resize(nodeWorldMat_.size());
-    for (std::size_t i = 0; i < nodeWorldMat_.size(); ++i)
-        skinMats[i] = nodeWorldMat_[i] * invBindByNodeId_[i];
-
-
-    // Warcraft 3 classic MDX (v800) uses "matrix groups" (a jagged list of node indices) without
-    // explicit per-vertex weights. The common approach (and what the WC3 pipeline effectively
-    // supports) is to take up to 4 matrices for the vertex group, transform the vertex by each,
-    // sum the results, and divide by the number of matrices (a simple average). 
-    // See e.g. the mdx-m3-viewer shader and related discussions.
-    //
-    // This is *not* mathematically correct skinning, but it matches real-world WC3 assets better
-    // than picking a single bone for multi-matrix groups.
-
-    auto skinAverage = [&](const ModelVertex& base, const ModelData::SkinGroup& group, ModelVertex& outV) -> bool
-    {
-        // Warcraft 3 classic MDX (v800) uses matrix groups (a list of *bone indices*) without explicit weights.
-        // The common approach (used by mdx-m3-viewer and WC3-compatible pipelines) is:
-        //   - Take up to 4 bones for standard groups, or up to 8 bones for "extended vertex groups".
-        //   - Transform by each matrix, sum, then divide by the number of bones considered (simple average).
-        //
-        // NOTE: Do not de-duplicate indices. Some assets rely on repeated indices to bias the average.
-        // Also note that the division uses the *declared* bone count (min(groupSize, maxBones)),
-        // even if some indices are invalid and skipped, to mimic the shader behavior.
-
-        if (skinMats.empty())
-            return false;
-
-        const int maxBones = (group.nodeIndices.size() > 4) ? 8 : 4;
-        const int boneNumber = std::min<int>(int(group.nodeIndices.size()), maxBones);
-        if (boneNumber <= 0)
-            return false;
-
-        const QVector4D p4(base.px, base.py, base.pz, 1.0f);
-        const QVector4D n4(base.nx, base.ny, base.nz, 0.0f);
-
-        QVector4D sumP(0,0,0,0);
-        QVector4D sumN(0,0,0,0);
-
-        for (int i = 0; i < boneNumber; ++i)
-        {
-            const int boneIndex = group.nodeIndices[std::size_t(i)];
-            if (boneIndex < 0 || std::size_t(boneIndex) >= skinMats.size())
-            {
-#ifndef NDEBUG
-                if (boneIndex > model_->maxObjectId)
-                {
-                    LogSink::instance().log(QString("Skin group nodeId out of range: %1 (maxObjectId=%2)")
-                                                .arg(boneIndex)
-                                                .arg(model_->maxObjectId));
-                }
-#endif
-                continue;
-            }
-
-            const QMatrix4x4& m = skinMats[std::size_t(boneIndex)];
-            sumP += m * p4;
-            sumN += m * n4;
-        }
-
-        const float inv = 1.0f / float(boneNumber);
-        const QVector4D avgP = sumP * inv;
-
-        QVector3D nn(sumN.x(), sumN.y(), sumN.z());
-        if (nn.lengthSquared() > 0.000001f)
-            nn.normalize();
-        else
-            nn = QVector3D(0,0,1);
-
-        outV = base;
-        outV.px = avgP.x();
-        outV.py = avgP.y();
-        outV.pz = avgP.z();
-        outV.nx = nn.x();
-        outV.ny = nn.y();
-        outV.nz = nn.z();
-        return true;
-    };
-
-    for (std::size_t i = 0; i < model_->bindVertices.size(); ++i)
-    {
-        const auto& base = model_->bindVertices[i];
-        if (i >= model_->vertexGroups.size())
-        {
-            skinnedVertices_[i] = base;
-            continue;
-        }
-        const std::uint16_t gid = model_->vertexGroups[i];
-        if (gid >= model_->skinGroups.size())
-        {
-            skinnedVertices_[i] = base;
-            continue;
-        }
-        const auto& group = model_->skinGroups[gid];
-        if (group.nodeIndices.empty())
-        {
-            skinnedVertices_[i] = base;
-            continue;
-        }
-
-        ModelVertex v;
-        if (skinAverage(base, group, v))
-        {
-            skinnedVertices_[i] = v;
-        }
-        else
-        {
-            skinnedVertices_[i] = base;
-        }
-    }
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferSubData(GL_ARRAY_BUFFER,
-                    0,
-                    GLsizeiptr(skinnedVertices_.size() * sizeof(ModelVertex)),
-                    skinnedVertices_.data());
+    // Orbit around the model center.
+    QMatrix4x4 view;
+    view.setToIdentity();
+    view.translate(0, 0, -distance_);
+    view.rotate(pitch_, 1, 0, 0);
+    view.rotate(yaw_, 0, 1, 0);
+    view.rotate(roll_, 0, 0, 1);
+    view.translate(-(modelCenter_ + panOffset_));
+    return view;
 }
 
 void GLModelView::updateStatusText()
@@ -1599,7 +1399,7 @@ void GLModelView::updateStatusText()
     if (model_ && verts == 0)
         extra = model_->emitters2.empty() ? " | empty mesh" : " | particle-only";
 
-    emit statusTextChanged(QString("%1 | v:%2 t:%3 g:%4 m:%5 tex:%6 dc:%7 fps:%8%9")
+    emit statusTextChanged(QString("%1 | v:%2 t:%3 g:%4 m:%5 tex:%6 dc:%7 fps:%8 (%9)%10")
                                .arg(displayName_)
                                .arg(verts)
                                .arg(tris)
@@ -1608,9 +1408,103 @@ void GLModelView::updateStatusText()
                                .arg(textures)
                                .arg(lastDrawCalls_)
                                .arg(QString::number(fps_, 'f', 1))
+                               .arg(QString::fromLatin1(renderModeName(renderMode_)))
                                .arg(extra));
 }
 
+void GLModelView::drawHud()
+{
+    const std::size_t count = profiler_.size();
+    if (count == 0)
+        return;
+    const FrameProfiler::Frame& f = *profiler_.last();
+
+    // The newest frames are still in flight on the GPU; show the latest resolved one.
+    double gpuMs = -1.0;
+    for (std::size_t i = count; i-- > 0;)
+    {
+        if (profiler_.at(i).gpuMs >= 0.0)
+        {
+            gpuMs = profiler_.at(i).gpuMs;
+            break;
+        }
+    }
+
+    const auto ms = [](double v) { return QString::number(v, 'f', 2); };
+    const QStringList lines = {
+        QString("frame %1 ms | paint %2 ms | gpu %3 | %4")
+            .arg(ms(f.intervalMs)).arg(ms(f.paintMs)).arg(gpuMs >= 0.0 ? ms(gpuMs) + " ms" : QString("n/a"))
+            .arg(QString::fromLatin1(renderModeName(renderMode_))),
+        QString("sample %1 | skin %2 | particles %3 | tex %4 | draw %5")
+            .arg(ms(f.phaseMs[FrameProfiler::Sampling]))
+            .arg(ms(f.phaseMs[FrameProfiler::Skinning]))
+            .arg(ms(f.phaseMs[FrameProfiler::Particles]))
+            .arg(ms(f.phaseMs[FrameProfiler::Textures]))
+            .arg(ms(f.phaseMs[FrameProfiler::Draw])),
+        QString("draw calls %1 | skinned verts %2 (%3) | rigid submeshes %4/%5 | particles %6")
+            .arg(f.drawCalls).arg(f.skinnedVertices)
+            .arg(packedVertices_ ? "packed 16 B" : "float 32 B")
+            .arg(rigidSubmeshes_).arg(gpuSubmeshes_.size())
+            .arg(f.liveParticles),
+        QString("textures %1 MB | uploads this frame %2")
+            .arg(QString::number(double(f.textureBytes) / (1024.0 * 1024.0), 'f', 1)).arg(f.textureUploads),
+        QString("mesh cache %1 models, %2 MB | pool %3 MB | hits %4 misses %5")
+            .arg(meshCache_.stats().residentMeshes)
+            .arg(QString::number(double(meshCache_.stats().residentBytes) / (1024.0 * 1024.0), 'f', 1))
+            .arg(QString::number(double(meshCache_.stats().pooledBytes) / (1024.0 * 1024.0), 'f', 1))
+            .arg(meshCache_.stats().hits)
+            .arg(meshCache_.stats().misses),
+    };
+
+    const int graphW = int(profiler_.capacity());
+    const int graphH = 60;
+    const float msToPx = float(graphH) / 50.0f;
+    const QFontMetrics fm(font());
+    const int lineH = fm.height();
+    int panelW = graphW;
+    for (const QString& line : lines)
+        panelW = std::max(panelW, fm.horizontalAdvance(line));
+    const QRect panel(8, 8, panelW + 16, graphH + 16 + lineH * int(lines.size()));
+    const QPoint graphOrigin(panel.left() + 8, panel.top() + 8 + graphH);
+
+    QPainter painter(this);
+    painter.fillRect(panel, QColor(0, 0, 0, 170));
+
+    // Frame interval bars, newest on the right; 16.7 / 33.3 ms guides.
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const FrameProfiler::Frame& fr = profiler_.at(i);
+        const double frameMs = fr.intervalMs > 0.0 ? fr.intervalMs : fr.paintMs;
+        const int h = std::min(graphH, int(float(frameMs) * msToPx));
+        const QColor c = frameMs <= 17.0 ? QColor(80, 200, 80)
+                                         : (frameMs <= 34.0 ? QColor(230, 200, 60) : QColor(230, 70, 60));
+        const int x = graphOrigin.x() + graphW - int(count) + int(i);
+        painter.fillRect(QRect(x, graphOrigin.y() - h, 1, h), c);
+    }
+    painter.setPen(QColor(255, 255, 255, 90));
+    for (float guide : { 16.7f, 33.3f })
+    {
+        const int y = graphOrigin.y() - int(guide * msToPx);
+        painter.drawLine(graphOrigin.x(), y, graphOrigin.x() + graphW, y);
+    }
+
+    painter.setPen(Qt::white);
+    int y = graphOrigin.y() + 4 + fm.ascent();
+    for (const QString& line : lines)
+    {
+        painter.drawText(graphOrigin.x(), y, line);
+        y += lineH;
+    }
+    painter.end();
+
+    // QPainter leaves its own GL state behind; restore what paintGL assumes.
+    glBindVertexArray(0);
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    glDisable(GL_CULL_FACE);
+}
+
 void GLModelView::dumpCpuSkinCheck(const QString& outPath, int geosetIndex)
 {
     if (!model_)
@@ -1646,8 +1540,8 @@ void GLModelView::dumpCpuSkinCheck(const QString& outPath, int geosetIndex)
 
     std::vector<QMatrix4x4> nodeWorldBind;
     std::vector<QMatrix4x4> nodeWorldAnim;
-    computeNodeWorld(tBind, nodeWorldBind);
-    computeNodeWorld(tAnim, nodeWorldAnim);
+    ModelAnim::ComputeNodeWorld(*model_, tBind, nodeWorldBind);
+    ModelAnim::ComputeNodeWorld(*model_, tAnim, nodeWorldAnim);
 
     const std::vector<QMatrix4x4>& bindMats = nodeWorldBind;
     const std::vector<QMatrix4x4>& animMats = nodeWorldAnim;
@@ -1828,6 +1722,7 @@ void GLModelView::dumpCpuSkinCheck(const QString& outPath, int geosetIndex)
 
 void GLModelView::paintGL()
 {
+    collectGpuQueries(false);
     const float dpr = devicePixelRatioF();
     const int fbw = int(width() * dpr);
     const int fbh = int(height() * dpr);
@@ -1840,14 +1735,13 @@ void GLModelView::paintGL()
     if (!model_)
         return;
 
-    // Camera: orbit around model center
-    QMatrix4x4 view;
-    view.setToIdentity();
-    view.translate(0, 0, -distance_);
-    view.rotate(pitch_, 1, 0, 0);
-    view.rotate(yaw_, 0, 1, 0);
-    view.rotate(roll_, 0, 0, 1);
-    view.translate(-(modelCenter_ + panOffset_));
+    // Taken before beginPaint(): simulation ran off this thread, between frames.
+    const SimThread::Frame* sim = takeSimFrame();
+
+    profiler_.beginPaint();
+    beginGpuQuery();
+
+    const QMatrix4x4 view = viewMatrix();
 
     QMatrix4x4 modelM;
     modelM.setToIdentity();
@@ -1855,7 +1749,8 @@ void GLModelView::paintGL()
     const QMatrix4x4 mvp = proj_ * view * modelM;
     const QMatrix3x3 normalMat = modelM.normalMatrix();
 
-    updateSkinning(lastGlobalTimeMs_);
+    if (sim)
+        uploadSkinnedVertices(*sim);
 
     // --- Draw mesh (if any)
     if (programReady_ && vao_ != 0 && !model_->indices.empty())
@@ -1864,179 +1759,179 @@ void GLModelView::paintGL()
         if (wireframe_ && !isGles_)
             glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-        program_.bind();
-        program_.setUniformValue("uMVP", mvp);
-        program_.setUniformValue("uNormalMat", normalMat);
+        evaluateDrawStates(lastGlobalTimeMs_);
 
-        glBindVertexArray(vao_);
-
-        glDisable(GL_CULL_FACE);
+        program_.bind();
+        program_.setUniformValue(meshUniforms_.tex, 0);
 
-        // Pass 1: opaque + alpha-tested (depth write on)
-        glDepthMask(GL_TRUE);
-        glDisable(GL_BLEND);
+        glActiveTexture(GL_TEXTURE0);
 
-        auto drawSubmesh = [&](const GpuSubmesh& sm, bool transparentPass)
+        // Skinned submeshes read this frame's stream region; rigid and unskinned
+        // ones read the static buffer.
+        auto fromStream = [&](std::size_t i)
         {
-            const std::uint32_t matId = sm.materialId;
-            if (matId >= model_->materials.size())
-                return;
-
-            const auto& mat = model_->materials[matId];
-            const auto& layer = mat.layer;
-
-            const bool unshaded = (layer.shadingFlags & (LAYER_UNSHADED | LAYER_UNLIT)) != 0;
-            const bool noDepthTest = (layer.shadingFlags & LAYER_NODEPTH) != 0;
-            const bool noDepthSet  = (layer.shadingFlags & LAYER_NODEPTHSET) != 0;
-            const bool twoSided = (layer.shadingFlags & LAYER_TWOSIDED) != 0;
+            return streamValid_ && gpuSubmeshes_[i].rigidGroup < 0;
+        };
 
-            const std::uint32_t filter = layer.filterMode;
+        // Two submeshes can share a draw when their layer state, vertex source and
+        // this frame's parameters match.
+        auto sameState = [&](std::size_t a, std::size_t b)
+        {
+            const auto& la = model_->materials[gpuSubmeshes_[a].materialId].layer;
+            const auto& lb = model_->materials[gpuSubmeshes_[b].materialId].layer;
+            return fromStream(a) == fromStream(b) &&
+                   gpuSubmeshes_[a].rigidGroup == gpuSubmeshes_[b].rigidGroup &&
+                   la.filterMode == lb.filterMode &&
+                   la.shadingFlags == lb.shadingFlags &&
+                   la.textureId == lb.textureId &&
+                   drawStates_[a].sameUniforms(drawStates_[b]);
+        };
 
-            bool alphaTest = false;
-            float alphaCutoff = 0.5f;
-            if (alphaTestEnabled_)
+        // drawList_ is already in submission order: opaque + alpha-tested first, then
+        // blended by priority plane. Consecutive visible entries with identical state
+        // become one run, drawn with a single glMultiDrawElements.
+        drawRuns_.clear();
+        runCounts_.clear();
+        runOffsets_.clear();
+        for (std::size_t k = 0; k < drawList_.size();)
+        {
+            const std::size_t first = drawList_[k];
+            if (!drawStates_[first].visible)
             {
-                if (filter == 1)
-                {
-                    alphaTest = true;
-                    alphaCutoff = 0.75f;
-                }
-                else if (filter >= 5)
-                {
-                    alphaTest = true;
-                    alphaCutoff = 0.02f;
-                }
+                ++k;
+                continue;
             }
-            const bool blended   = (filter == 2 || filter == 3 || filter == 4 || filter == 5 || filter == 6);
-
-            float geosetAlpha = 1.0f;
-            QVector3D geosetColor(1.0f, 1.0f, 1.0f);
-            if (!model_->geosetAnimations.empty())
+            DrawRun run;
+            run.submesh = first;
+            run.tex = getOrCreateTexture(model_->materials[gpuSubmeshes_[first].materialId].layer.textureId);
+            run.begin = runCounts_.size();
+            for (; k < drawList_.size(); ++k)
             {
-                for (const auto& ga : model_->geosetAnimations)
-                {
-                    if (ga.geosetId == static_cast<std::int32_t>(sm.geosetIndex))
-                    {
-                        const float baseAlpha = clampf(ga.alpha, 0.0f, 1.0f);
-                        geosetAlpha = clampf(sampleTrackFloat(ga.trackAlpha, lastGlobalTimeMs_, baseAlpha, *model_), 0.0f, 1.0f);
-                        if ((ga.flags & 0x2u) != 0u || !ga.trackColor.empty())
-                        {
-                            const Vec3 defColor = ga.color;
-                            const Vec3 c = sampleTrackVec3(ga.trackColor, lastGlobalTimeMs_, defColor, *model_);
-                            geosetColor = QVector3D(c.x, c.y, c.z);
-                        }
-                        break;
-                    }
-                }
+                const std::size_t i = drawList_[k];
+                if (!drawStates_[i].visible)
+                    continue;
+                if (i != first && !sameState(first, i))
+                    break;
+                const GpuSubmesh& sm = gpuSubmeshes_[i];
+                runCounts_.push_back(GLsizei(sm.indexCount));
+                runOffsets_.push_back((const void*)(uintptr_t(sm.indexOffset * indexSize_)));
             }
-            if (geosetAlpha <= 0.001f)
-                return;
+            run.end = runCounts_.size();
+            drawRuns_.push_back(run);
+        }
 
-            QVector2D uvTrans(0.0f, 0.0f);
-            QVector2D uvRot(0.0f, 1.0f);
-            float uvScale = 1.0f;
-            if (!model_->textureAnimations.empty() && layer.textureAnimId >= 0)
-            {
-                const std::uint32_t animId = static_cast<std::uint32_t>(layer.textureAnimId);
-                if (animId < model_->textureAnimations.size())
-                {
-                    const auto& ta = model_->textureAnimations[animId];
-                    const Vec3 defT{0.0f, 0.0f, 0.0f};
-                    const Vec3 defS{1.0f, 1.0f, 1.0f};
-                    const Vec4 defR{0.0f, 0.0f, 0.0f, 1.0f};
-                    const Vec3 t = sampleTrackVec3(ta.translation, lastGlobalTimeMs_, defT, *model_);
-                    const Vec3 s = sampleTrackVec3(ta.scaling, lastGlobalTimeMs_, defS, *model_);
-                    Vec4 r = sampleTrackQuat(ta.rotation, lastGlobalTimeMs_, defR, *model_);
-                    float rl = std::sqrt(r.z * r.z + r.w * r.w);
-                    if (rl > 0.0f)
-                    {
-                        r.z /= rl;
-                        r.w /= rl;
-                    }
-                    uvTrans = QVector2D(t.x, t.y);
-                    uvRot = QVector2D(r.z, r.w);
-                    uvScale = s.x;
-                }
-            }
+        uploadMaterialBlock();
+
+        // Last state sent to GL; anything unchanged between runs is not re-issued.
+        int curCull = -1, curDepthTest = -1, curDepthMask = -1, curBlend = -1;
+        GLenum curSrc = GL_NONE, curDst = GL_NONE;
+        GLuint curTex = 0;
+        GLuint curVao = 0;
+        int curGroup = -2;
 
-            if (transparentPass != blended)
+        auto setCap = [this](GLenum cap, bool on, int& cur)
+        {
+            if (cur == int(on))
                 return;
+            if (on) glEnable(cap); else glDisable(cap);
+            cur = int(on);
+        };
+
+        for (std::size_t r = 0; r < drawRuns_.size(); ++r)
+        {
+            const DrawRun& run = drawRuns_[r];
+            const auto& layer = model_->materials[gpuSubmeshes_[run.submesh].materialId].layer;
 
-            if (twoSided) glDisable(GL_CULL_FACE); else glEnable(GL_CULL_FACE);
+            const bool noDepthTest = (layer.shadingFlags & LAYER_NODEPTH) != 0;
+            const bool noDepthSet  = (layer.shadingFlags & LAYER_NODEPTHSET) != 0;
+            const bool twoSided = (layer.shadingFlags & LAYER_TWOSIDED) != 0;
+            const bool blended = drawStates_[run.submesh].blended;
 
-            if (noDepthTest) glDisable(GL_DEPTH_TEST); else glEnable(GL_DEPTH_TEST);
-            glDepthMask(noDepthSet ? GL_FALSE : GL_TRUE);
+            setCap(GL_CULL_FACE, !twoSided, curCull);
+            setCap(GL_DEPTH_TEST, !noDepthTest, curDepthTest);
+            if (curDepthMask != int(!noDepthSet))
+            {
+                glDepthMask(noDepthSet ? GL_FALSE : GL_TRUE);
+                curDepthMask = int(!noDepthSet);
+            }
 
+            setCap(GL_BLEND, blended, curBlend);
             if (blended)
             {
-                glEnable(GL_BLEND);
-                switch (filter)
+                GLenum src = GL_SRC_ALPHA;
+                GLenum dst = GL_ONE_MINUS_SRC_ALPHA;
+                switch (layer.filterMode)
                 {
-                case 2: // Blend
-                    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-                    break;
                 case 3: // Additive
                 case 4: // Add alpha (approx)
-                    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+                    dst = GL_ONE;
                     break;
                 case 5: // Modulate
-                    glBlendFunc(GL_ZERO, GL_SRC_COLOR);
+                    src = GL_ZERO;
+                    dst = GL_SRC_COLOR;
                     break;
                 case 6: // Modulate2x (approx)
-                    glBlendFunc(GL_DST_COLOR, GL_SRC_COLOR);
+                    src = GL_DST_COLOR;
+                    dst = GL_SRC_COLOR;
                     break;
                 default: // Blend
-                    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
                     break;
                 }
+                if (src != curSrc || dst != curDst)
+                {
+                    glBlendFunc(src, dst);
+                    curSrc = src;
+                    curDst = dst;
+                }
             }
-            else
+
+            if (run.tex != curTex)
             {
-                glDisable(GL_BLEND);
+                glBindTexture(GL_TEXTURE_2D, run.tex);
+                curTex = run.tex;
             }
 
-            const GLuint tex = getOrCreateTexture(layer.textureId);
-            const bool hasTex = (tex != placeholderTex_ && tex != 0);
-
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, tex);
-
-            program_.setUniformValue("uTex", 0);
-            program_.setUniformValue("uHasTex", hasTex ? 1 : 0);
-            program_.setUniformValue("uAlphaTest", alphaTest ? 1 : 0);
-            program_.setUniformValue("uAlphaCutoff", alphaCutoff);
-            const float layerAlpha = clampf(sampleTrackFloat(layer.trackAlpha, lastGlobalTimeMs_, layer.alpha, *model_), 0.0f, 1.0f);
-            program_.setUniformValue("uMatAlpha", layerAlpha * geosetAlpha);
-            program_.setUniformValue("uMatColor", geosetColor);
-            program_.setUniformValue("uUnshaded", unshaded ? 1 : 0);
-            program_.setUniformValue("uUvTrans", uvTrans);
-            program_.setUniformValue("uUvRot", uvRot);
-            program_.setUniformValue("uUvScale", uvScale);
-
-            glDrawElements(
-                GL_TRIANGLES,
-                GLsizei(sm.indexCount),
-                GL_UNSIGNED_INT,
-                (void*)(uintptr_t(sm.indexOffset * sizeof(std::uint32_t)))
-            );
-            lastDrawCalls_ += 1;
-        };
+            const bool stream = fromStream(run.submesh);
+            const GLuint runVao = stream ? streamVao_ : vao_;
+            if (runVao != curVao)
+            {
+                const VertexPacking::Decode& dec = stream ? streamDecode_ : meshDecode_;
+                program_.setUniformValue(meshUniforms_.posScale, QVector3D(dec.posScale[0], dec.posScale[1], dec.posScale[2]));
+                program_.setUniformValue(meshUniforms_.posBias, QVector3D(dec.posBias[0], dec.posBias[1], dec.posBias[2]));
+                program_.setUniformValue(meshUniforms_.uvScaleBias,
+                                         QVector4D(dec.uvScale[0], dec.uvScale[1], dec.uvBias[0], dec.uvBias[1]));
+                program_.setUniformValue(meshUniforms_.octNormal, (stream ? streamPacked_ : meshPacked_) ? 1 : 0);
+                glBindVertexArray(runVao);
+                curVao = runVao;
+            }
 
-        for (const auto& sm : gpuSubmeshes_)
-            drawSubmesh(sm, false);
+            const int group = gpuSubmeshes_[run.submesh].rigidGroup;
+            if (group != curGroup)
+            {
+                // Normals get the same (non inverse-transposed) matrix as in CPU skinning.
+                const QMatrix4x4 bone = group >= 0 ? rigidMatrices_[std::size_t(group)] : QMatrix4x4();
+                program_.setUniformValue(meshUniforms_.mvp, mvp * bone);
+                program_.setUniformValue(meshUniforms_.normalMat, normalMat * bone.toGenericMatrix<3, 3>());
+                curGroup = group;
+            }
 
-        // Pass 2: blended materials
-        std::vector<std::size_t> order;
-        order.reserve(gpuSubmeshes_.size());
-        for (std::size_t i = 0; i < gpuSubmeshes_.size(); ++i) order.push_back(i);
-        std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b){
-            const auto& ma = model_->materials[gpuSubmeshes_[a].materialId];
-            const auto& mb = model_->materials[gpuSubmeshes_[b].materialId];
-            return ma.priorityPlane < mb.priorityPlane;
-        });
+            glBindBufferRange(GL_UNIFORM_BUFFER, kMaterialBlockBinding, materialUbo_,
+                              GLintptr(r * materialStride_), GLsizeiptr(sizeof(MaterialParams)));
 
-        for (auto idx : order)
-            drawSubmesh(gpuSubmeshes_[idx], true);
+            const GLsizei drawCount = GLsizei(run.end - run.begin);
+            if (drawCount == 1 || isGles_)
+            {
+                for (std::size_t d = run.begin; d < run.end; ++d)
+                    glDrawElements(GL_TRIANGLES, runCounts_[d], indexType_, runOffsets_[d]);
+                lastDrawCalls_ += int(drawCount);
+            }
+            else
+            {
+                glMultiDrawElements(GL_TRIANGLES, runCounts_.data() + run.begin, indexType_,
+                                    runOffsets_.data() + run.begin, drawCount);
+                lastDrawCalls_ += 1;
+            }
+        }
 
         glBindVertexArray(0);
         program_.release();
@@ -2052,12 +1947,12 @@ void GLModelView::paintGL()
     }
 
     // --- Draw particles (PRE2)
-    if (particleProgramReady_ && pVao_ != 0 && !model_->emitters2.empty())
+    if (particleProgramReady_ && pVao_ != 0 && sim && !sim->instances.empty())
     {
         setGlPhase("particles");
         particleProgram_.bind();
-        particleProgram_.setUniformValue("uMVP", mvp);
-        particleProgram_.setUniformValue("uTex", 0);
+        particleProgram_.setUniformValue(particleUniforms_.mvp, mvp);
+        particleProgram_.setUniformValue(particleUniforms_.tex, 0);
 
         // We generally don't want particles writing depth.
         glEnable(GL_BLEND);
@@ -2067,9 +1962,9 @@ void GLModelView::paintGL()
 
         // Camera basis for billboards
         const QMatrix4x4 invView = view.inverted();
-        const QVector3D camRight = invView.column(0).toVector3D().normalized();
-        const QVector3D camUp    = invView.column(1).toVector3D().normalized();
-        const QVector3D camFwd   = (-invView.column(2).toVector3D()).normalized();
+        particleProgram_.setUniformValue(particleUniforms_.camRight, invView.column(0).toVector3D().normalized());
+        particleProgram_.setUniformValue(particleUniforms_.camUp, invView.column(1).toVector3D().normalized());
+        particleProgram_.setUniformValue(particleUniforms_.camFwd, (-invView.column(2).toVector3D()).normalized());
 
         glBindVertexArray(pVao_);
 
@@ -2116,30 +2011,23 @@ void GLModelView::paintGL()
             glBindTexture(GL_TEXTURE_2D, 0);
         };
 
-        auto getCell = [&](const std::uint32_t interval[3], float factor, int totalFrames) -> int
+        // Every emitter's instances go up in one allocation; each draw points the
+        // per-instance attributes at its own slice.
+        const std::size_t instanceBytes = sim->instances.size() * sizeof(SimThread::ParticleInstance);
+        const GLStreamBuffer::Allocation instances = streamBuffer_.allocate(instanceBytes);
+        if (instances.ptr)
         {
-            const float start = float(interval[0]);
-            const float end = float(interval[1]);
-            const float repeat = float(interval[2]);
-            const float spriteCount = end - start;
-            if (spriteCount > 0.0f)
-            {
-                const float idx = std::floor(spriteCount * repeat * factor);
-                const float modv = std::fmod(idx, spriteCount);
-                const float cell = std::min(start + modv, float(totalFrames - 1));
-                return int(cell);
-            }
-            return int(start);
-        };
+            std::memcpy(instances.ptr, sim->instances.data(), instanceBytes);
+            streamBuffer_.commit(instances);
+        }
 
         for (std::size_t orderIdx = 0; orderIdx < emitterOrder.size(); ++orderIdx)
         {
             const std::size_t ei = emitterOrder[orderIdx];
             const auto& e = model_->emitters2[ei];
-            const auto& rt = (ei < runtimeEmitters2_.size()) ? runtimeEmitters2_[ei] : RuntimeEmitter2{};
-
-            if (rt.particles.empty())
+            if (!instances.ptr || ei >= sim->batches.size() || sim->batches[ei].count == 0)
                 continue;
+            const SimThread::EmitterBatch& batch = sim->batches[ei];
 
             // Resolve texture
             GLuint tex = placeholderTex_;
@@ -2163,8 +2051,8 @@ void GLModelView::paintGL()
             // Blend mode (match WC3 as closely as reasonable)
             const std::uint32_t f = e.filterMode;
             const bool alphaKey = (f == 4); // AlphaKey
-            particleProgram_.setUniformValue("uAlphaTest", alphaKey ? 1 : 0);
-            particleProgram_.setUniformValue("uAlphaCutoff", alphaKey ? 0.5f : 0.0f);
+            particleProgram_.setUniformValue(particleUniforms_.alphaTest, alphaKey ? 1 : 0);
+            particleProgram_.setUniformValue(particleUniforms_.alphaCutoff, alphaKey ? 0.5f : 0.0f);
             if (alphaKey)
             {
                 glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -2188,205 +2076,37 @@ void GLModelView::paintGL()
                 }
             }
 
-            // Build CPU vertices for this emitter (two triangles per particle)
-            particleVerts_.clear();
-            particleVerts_.reserve(rt.particles.size() * 6);
-
-            const int totalFrames = int(std::max<std::uint32_t>(1, e.rows * e.columns));
-            const float invCols = 1.0f / float(std::max<std::uint32_t>(1, e.columns));
-            const float invRows = 1.0f / float(std::max<std::uint32_t>(1, e.rows));
-
-            auto evalSegment = [&](float lifeT, Vec3& outColor, float& outAlpha, float& outScale)
-            {
-                const float mid = clampf(e.timeMiddle, 0.01f, 0.99f);
-
-                auto toAlpha = [&](std::uint8_t a){ return float(a) / 255.0f; };
-
-                if (lifeT <= mid)
-                {
-                    const float t = lifeT / mid;
-                    outColor.x = lerpf(e.segmentColor[0].x, e.segmentColor[1].x, t);
-                    outColor.y = lerpf(e.segmentColor[0].y, e.segmentColor[1].y, t);
-                    outColor.z = lerpf(e.segmentColor[0].z, e.segmentColor[1].z, t);
-                    outAlpha = lerpf(toAlpha(e.segmentAlpha[0]), toAlpha(e.segmentAlpha[1]), t);
-                    outScale = lerpf(e.segmentScaling[0], e.segmentScaling[1], t);
-                }
-                else
-                {
-                    const float t = (lifeT - mid) / (1.0f - mid);
-                    outColor.x = lerpf(e.segmentColor[1].x, e.segmentColor[2].x, t);
-                    outColor.y = lerpf(e.segmentColor[1].y, e.segmentColor[2].y, t);
-                    outColor.z = lerpf(e.segmentColor[1].z, e.segmentColor[2].z, t);
-                    outAlpha = lerpf(toAlpha(e.segmentAlpha[1]), toAlpha(e.segmentAlpha[2]), t);
-                    outScale = lerpf(e.segmentScaling[1], e.segmentScaling[2], t);
-                }
-
-                // Scaling in MDX is in percent.
-                outScale = outScale / 100.0f;
-            };
-
-            const bool modelSpace = (e.flags & PRE2_MODEL_SPACE) != 0;
             const bool xyQuad = (e.flags & PRE2_XY_QUAD) != 0;
-            QMatrix4x4 emitterWorld;
-            emitterWorld.setToIdentity();
-            QVector3D emitterScale(1, 1, 1);
-            if (modelSpace && e.objectId >= 0 && std::size_t(e.objectId) < nodeWorldMat_.size())
-            {
-                emitterWorld = nodeWorldMat_[std::size_t(e.objectId)];
-                emitterScale = nodeWorldScale_[std::size_t(e.objectId)];
-            }
 
-            for (const auto& p : rt.particles)
+            QVector4D segColor[3];
+            for (int i = 0; i < 3; ++i)
             {
-                const float tLife = clampf(p.age / std::max(0.001f, p.life), 0.0f, 1.0f);
-
-                Vec3 col;
-                float alpha;
-                float scale;
-                evalSegment(tLife, col, alpha, scale);
-
-                auto pickFrame = [&](bool tailType) -> int
-                {
-                    float factor = tLife;
-                    int intervalIndex = 0;
-                    if (factor < e.timeMiddle)
-                    {
-                        factor = factor / std::max(0.0001f, e.timeMiddle);
-                        intervalIndex = 0;
-                    }
-                    else
-                    {
-                        factor = (factor - e.timeMiddle) / std::max(0.0001f, 1.0f - e.timeMiddle);
-                        intervalIndex = 1;
-                    }
-                    factor = std::min(factor, 1.0f);
-
-                    const std::uint32_t* interval = nullptr;
-                    if (!tailType)
-                        interval = e.headIntervals[intervalIndex];
-                    else
-                        interval = e.tailIntervals[intervalIndex];
-
-                    if (e.replaceableId == 1 || e.replaceableId == 2)
-                        return 0;
-                    return getCell(interval, factor, totalFrames);
-                };
-
-                auto setupUv = [&](int frame, float& u0, float& v0, float& u1, float& v1)
-                {
-                    const int fr = frame / int(std::max<std::uint32_t>(1, e.columns));
-                    const int fc = frame % int(std::max<std::uint32_t>(1, e.columns));
-                    u0 = float(fc) * invCols;
-                    v0 = float(fr) * invRows;
-                    u1 = u0 + invCols;
-                    v1 = v0 + invRows;
-                };
-
-                QVector3D pos = p.pos;
-                QVector3D vel = p.vel;
-                if (modelSpace)
-                {
-                    pos = (emitterWorld * QVector4D(pos, 1.0f)).toVector3D();
-                }
-
-                const float sizeScale = modelSpace ? emitterScale.x() : 1.0f;
-                const float half = 0.5f * std::max(0.01f, scale) * sizeScale;
-                const float r = col.x;
-                const float g = col.y;
-                const float b = col.z;
-                const float a = alpha;
-
-                auto pushTri = [&](const QVector3D& p0, float tu0, float tv0,
-                                   const QVector3D& p1, float tu1, float tv1,
-                                   const QVector3D& p2, float tu2, float tv2)
-                {
-                    ParticleVertex v{};
-                    v.r = r; v.g = g; v.b = b; v.a = a;
-
-                    v.px = p0.x(); v.py = p0.y(); v.pz = p0.z(); v.u = tu0; v.v = tv0;
-                    particleVerts_.push_back(v);
-                    v.px = p1.x(); v.py = p1.y(); v.pz = p1.z(); v.u = tu1; v.v = tv1;
-                    particleVerts_.push_back(v);
-                    v.px = p2.x(); v.py = p2.y(); v.pz = p2.z(); v.u = tu2; v.v = tv2;
-                    particleVerts_.push_back(v);
-                };
-
-                const bool wantHead = (p.tailType == 0);
-                const bool wantTail = (p.tailType == 1);
-
-                if (wantTail && e.tailLength > 0.0001f)
-                {
-                    QVector3D dir = vel;
-                    if (dir.lengthSquared() < 1e-6f)
-                        dir = camFwd;
-                    dir.normalize();
-
-                    QVector3D side = QVector3D::crossProduct(camFwd, dir);
-                    if (side.lengthSquared() < 1e-6f)
-                        side = camRight;
-                    side.normalize();
-
-                    QVector3D p0 = pos;
-                    QVector3D p1 = pos - dir * e.tailLength;
-                    if (modelSpace)
-                    {
-                        const QVector3D tailLocal = p.pos - vel.normalized() * e.tailLength;
-                        p0 = (emitterWorld * QVector4D(p.pos, 1.0f)).toVector3D();
-                        p1 = (emitterWorld * QVector4D(tailLocal, 1.0f)).toVector3D();
-                    }
-
-                    const QVector3D a0 = p0 + side * half;
-                    const QVector3D a1 = p0 - side * half;
-                    const QVector3D b0 = p1 + side * half;
-                    const QVector3D b1 = p1 - side * half;
-
-                    float u0, v0, u1, v1;
-                    setupUv(pickFrame(true), u0, v0, u1, v1);
-
-                    // two triangles (a0,a1,b1) and (a0,b1,b0)
-                    pushTri(a0, u0, v0, a1, u1, v0, b1, u1, v1);
-                    pushTri(a0, u0, v0, b1, u1, v1, b0, u0, v1);
-                }
-                if (wantHead)
-                {
-                    QVector3D right = camRight;
-                    QVector3D up = camUp;
-                    if (xyQuad)
-                    {
-                        const float cs = std::cos(p.facing);
-                        const float sn = std::sin(p.facing);
-                        const QVector3D r2 = right * cs - up * sn;
-                        const QVector3D u2 = right * sn + up * cs;
-                        right = r2;
-                        up = u2;
-                    }
-                    right *= half;
-                    up *= half;
-
-                    const QVector3D p00 = pos - right - up;
-                    const QVector3D p10 = pos + right - up;
-                    const QVector3D p11 = pos + right + up;
-                    const QVector3D p01 = pos - right + up;
-
-                    float u0, v0, u1, v1;
-                    setupUv(pickFrame(false), u0, v0, u1, v1);
-
-                    // two triangles
-                    pushTri(p00, u0, v0, p10, u1, v0, p11, u1, v1);
-                    pushTri(p00, u0, v0, p11, u1, v1, p01, u0, v1);
-                }
+                segColor[i] = QVector4D(e.segmentColor[i].x, e.segmentColor[i].y, e.segmentColor[i].z,
+                                        float(e.segmentAlpha[i]) / 255.0f);
             }
-
-            if (particleVerts_.empty())
-                continue;
-
-            glBindBuffer(GL_ARRAY_BUFFER, pVbo_);
-            glBufferData(GL_ARRAY_BUFFER,
-                         GLsizeiptr(particleVerts_.size() * sizeof(ParticleVertex)),
-                         particleVerts_.data(),
-                         GL_DYNAMIC_DRAW);
-
-            glDrawArrays(GL_TRIANGLES, 0, GLsizei(particleVerts_.size()));
+            // Scaling in MDX is in percent.
+            const QVector3D segScale(e.segmentScaling[0] / 100.0f, e.segmentScaling[1] / 100.0f, e.segmentScaling[2] / 100.0f);
+
+            particleProgram_.setUniformValue(particleUniforms_.emitterWorld, batch.world);
+            particleProgram_.setUniformValueArray(particleUniforms_.segColor, segColor, 3);
+            particleProgram_.setUniformValue(particleUniforms_.segScale, segScale);
+            particleProgram_.setUniformValue(particleUniforms_.timeMiddle, clampf(e.timeMiddle, 0.01f, 0.99f));
+            particleProgram_.setUniformValue(particleUniforms_.sizeScale, batch.sizeScale);
+            particleProgram_.setUniformValue(particleUniforms_.tailLength, e.tailLength);
+            particleProgram_.setUniformValue(particleUniforms_.xyQuad, xyQuad ? 1 : 0);
+            particleProgram_.setUniformValue(particleUniforms_.columns, int(std::max<std::uint32_t>(1, e.columns)));
+            particleProgram_.setUniformValue(particleUniforms_.cellSize,
+                                             QVector2D(1.0f / float(std::max<std::uint32_t>(1, e.columns)),
+                                                       1.0f / float(std::max<std::uint32_t>(1, e.rows))));
+
+            using Instance = SimThread::ParticleInstance;
+            const std::uintptr_t base = std::uintptr_t(instances.offset) + batch.first * sizeof(Instance);
+            glBindBuffer(GL_ARRAY_BUFFER, instances.buffer);
+            glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(base + offsetof(Instance, px)));
+            glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(base + offsetof(Instance, vx)));
+            glVertexAttribIPointer(2, 2, GL_UNSIGNED_SHORT, sizeof(Instance), (void*)(base + offsetof(Instance, frame)));
+
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 6, GLsizei(batch.count));
             lastDrawCalls_ += 1;
         }
 
@@ -2412,7 +2132,7 @@ void GLModelView::paintGL()
 
     if (model_ && !model_->vertices.empty() && lastDrawCalls_ == 0 && !loggedBlank_)
     {
-        LogSink::instance().log(QString("Blank draw: target=%1,%2,%3 dist=%4 near=%5 far=%6 drawCalls=%7 alphaTest=%8 cull=%9 blend=%10")
+        LogSink::instance().log(LogLevel::Warning, QString("Blank draw: target=%1,%2,%3 dist=%4 near=%5 far=%6 drawCalls=%7 alphaTest=%8 cull=%9 blend=%10")
                                     .arg(modelCenter_.x()).arg(modelCenter_.y()).arg(modelCenter_.z())
                                     .arg(distance_)
                                     .arg(near_)
@@ -2424,6 +2144,24 @@ void GLModelView::paintGL()
         loggedBlank_ = true;
     }
 
+    endGpuQuery();
+    streamBuffer_.endFrame();
+    FrameProfiler::Frame& frame = profiler_.current();
+    frame.drawCalls = lastDrawCalls_;
+    frame.liveParticles = sim ? sim->liveParticles : 0;
+    frame.textureBytes = textureBytes_;
+    profiler_.endPaint();
+
+    if (firstFramePending_)
+    {
+        firstFramePending_ = false;
+        loadTiming_.firstFrameMs = TakeMs(firstFrameTimer_);
+        emit firstFrameRendered(loadTiming_);
+    }
+
+    if (hudVisible_)
+        drawHud();
+
     updateStatusText();
 }
 
@@ -2511,6 +2249,12 @@ void GLModelView::keyPressEvent(QKeyEvent* e)
         e->accept();
         return;
     }
+    if (e->key() == Qt::Key_H)
+    {
+        setHudVisible(!hudVisible_);
+        e->accept();
+        return;
+    }
     if (e->key() == Qt::Key_A)
     {
         alphaTestEnabled_ = !alphaTestEnabled_;
@@ -2524,23 +2268,30 @@ void GLModelView::keyPressEvent(QKeyEvent* e)
 
 void GLModelView::clearGpuResources()
 {
-    for (auto it = gpuCache_.begin(); it != gpuCache_.end(); ++it)
-    {
-        if (it->ibo) glDeleteBuffers(1, &it->ibo);
-        if (it->vbo) glDeleteBuffers(1, &it->vbo);
-        if (it->vao) glDeleteVertexArrays(1, &it->vao);
-    }
-    gpuCache_.clear();
+    meshCache_.destroy();
     ibo_ = 0;
     vbo_ = 0;
     vao_ = 0;
 
-    if (pVbo_) { glDeleteBuffers(1, &pVbo_); pVbo_ = 0; }
+    streamBuffer_.destroy();
+    if (materialUbo_) { glDeleteBuffers(1, &materialUbo_); materialUbo_ = 0; }
     if (pVao_) { glDeleteVertexArrays(1, &pVao_); pVao_ = 0; }
+    if (streamVao_) { glDeleteVertexArrays(1, &streamVao_); streamVao_ = 0; }
+    if (skinVbo_) { glDeleteBuffers(1, &skinVbo_); skinVbo_ = 0; }
+    skinVboBytes_ = 0;
+    streamValid_ = false;
+    streamPoseSerial_ = 0;
+    skinResident_ = false;
     if (debugVbo_) { glDeleteBuffers(1, &debugVbo_); debugVbo_ = 0; }
     if (debugVao_) { glDeleteVertexArrays(1, &debugVao_); debugVao_ = 0; }
     if (sanityVbo_) { glDeleteBuffers(1, &sanityVbo_); sanityVbo_ = 0; }
     if (sanityVao_) { glDeleteVertexArrays(1, &sanityVao_); sanityVao_ = 0; }
+    for (auto& q : gpuQueries_)
+    {
+        if (q.id) glDeleteQueries(1, &q.id);
+        q = GpuQuery();
+    }
+    activeGpuQuery_ = nullptr;
 
     for (auto& kv : textureCache_)
     {
@@ -2548,6 +2299,7 @@ void GLModelView::clearGpuResources()
             glDeleteTextures(1, &kv.second.id);
     }
     textureCache_.clear();
+    textureBytes_ = 0;
 
     if (placeholderTex_ != 0)
     {
@@ -2566,12 +2318,21 @@ void GLModelView::clearGpuResources()
     }
 
     gpuSubmeshes_.clear();
+    drawList_.clear();
 }
 
 void GLModelView::rebuildGpuBuffers()
 {
+    Trace::Scope trace("gl", "UploadBuffers");
     // Mesh buffers are tied to model geometry. Particles have their own buffers created in initializeGL.
     gpuSubmeshes_.clear();
+    drawList_.clear();
+    vao_ = vbo_ = ibo_ = 0;
+    streamValid_ = false;
+    drawStatesValid_ = false;
+    streamPoseSerial_ = 0;
+    skinResident_ = false;
+    rigidSubmeshes_ = 0;
 
     if (!model_ || model_->vertices.empty() || model_->indices.empty())
     {
@@ -2580,49 +2341,67 @@ void GLModelView::rebuildGpuBuffers()
         return;
     }
 
+    // Recently viewed meshes stay resident; switching back to one uploads nothing.
+    // The stamp catches files regenerated on disk under the same path.
+    const auto& srcVerts = model_->bindVertices.empty() ? model_->vertices : model_->bindVertices;
+    std::vector<VertexPacking::PackedVertex> packedVerts;
+    meshDecode_ = VertexPacking::Decode();
+    meshPacked_ = packedVertices_;
+    if (packedVertices_)
+    {
+        packedVerts.resize(srcVerts.size());
+        meshDecode_ = VertexPacking::Pack(srcVerts.data(), srcVerts.size(), packedVerts.data());
+    }
+    const void* vertexData = packedVertices_ ? static_cast<const void*>(packedVerts.data())
+                                             : static_cast<const void*>(srcVerts.data());
+    const std::size_t vertexBytes = srcVerts.size() *
+                                    (packedVertices_ ? sizeof(VertexPacking::PackedVertex) : sizeof(ModelVertex));
+    const bool shortIndices = model_->indices16.size() == model_->indices.size();
+    indexType_ = shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    indexSize_ = shortIndices ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+    const void* indexData = shortIndices ? static_cast<const void*>(model_->indices16.data())
+                                         : static_cast<const void*>(model_->indices.data());
+    QString stamp;
     if (!modelPath_.isEmpty())
     {
-        auto it = gpuCache_.find(modelPath_);
-        if (it != gpuCache_.end())
-        {
-            vao_ = it->vao;
-            vbo_ = it->vbo;
-            ibo_ = it->ibo;
-            gpuSubmeshes_ = it->submeshes;
-            return;
-        }
-    }
+        stamp = QString("%1:%2%3:%4x%5")
+                    .arg(QFileInfo(modelPath_).lastModified().toMSecsSinceEpoch())
+                    .arg(srcVerts.size())
+                    .arg(packedVertices_ ? "p" : "f")
+                    .arg(model_->indices.size())
+                    .arg(indexSize_);
+    }
+    bool uploaded = false;
+    const GLMeshCache::Mesh* mesh = meshCache_.acquire(modelPath_, stamp,
+                                                       vertexData, vertexBytes,
+                                                       indexData, model_->indices.size() * indexSize_,
+                                                       &uploaded);
+    if (!mesh)
+        return;
+    vao_ = mesh->vao;
+    vbo_ = mesh->vbo;
+    ibo_ = mesh->ibo;
 
-    // Upload vertex/index data
-    glGenVertexArrays(1, &vao_);
+    // Pooled VAOs may still point at another model's layout.
     glBindVertexArray(vao_);
-
-    glGenBuffers(1, &vbo_);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    const bool useSkinning = !model_->skinGroups.empty() &&
-                             model_->vertexGroups.size() == model_->vertices.size();
-    const auto& srcVerts = model_->bindVertices.empty() ? model_->vertices : model_->bindVertices;
-    glBufferData(GL_ARRAY_BUFFER,
-                 GLsizeiptr(srcVerts.size() * sizeof(ModelVertex)),
-                 srcVerts.data(),
-                 useSkinning ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
-
-    glGenBuffers(1, &ibo_);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 GLsizeiptr(model_->indices.size() * sizeof(std::uint32_t)),
-                 model_->indices.data(),
-                 GL_STATIC_DRAW);
-
-    // Attributes
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ModelVertex), (void*)offsetof(ModelVertex, px));
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(ModelVertex), (void*)offsetof(ModelVertex, nx));
     glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(ModelVertex), (void*)offsetof(ModelVertex, u));
+    glBindVertexArray(0);
+    setMeshVertexSource(vao_, vbo_, 0, meshPacked_);
 
+    // The stream VAO shares the model's indices; its attributes are set per frame.
+    glBindVertexArray(streamVao_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
     glBindVertexArray(0);
+    rigidMatrices_.assign(model_->skinGroups.size(), QMatrix4x4());
+
+    const GLMeshCache::Stats& cs = meshCache_.stats();
+    LogSink::instance().log(LogLevel::Debug, QString("Mesh cache %1: %2 resident (%3 MB), %4 MB pooled")
+                                .arg(uploaded ? "miss" : "hit")
+                                .arg(cs.residentMeshes)
+                                .arg(QString::number(double(cs.residentBytes) / (1024.0 * 1024.0), 'f', 1))
+                                .arg(QString::number(double(cs.pooledBytes) / (1024.0 * 1024.0), 'f', 1)));
 
     gpuSubmeshes_.reserve(model_->subMeshes.size());
     for (const auto& sm : model_->subMeshes)
@@ -2632,27 +2411,21 @@ void GLModelView::rebuildGpuBuffers()
         g.indexCount = sm.indexCount;
         g.materialId = sm.materialId;
         g.geosetIndex = sm.geosetIndex;
+        g.rigidGroup = sm.rigidGroup < std::int32_t(model_->skinGroups.size()) ? sm.rigidGroup : -1;
+        rigidSubmeshes_ += g.rigidGroup >= 0 ? 1 : 0;
         gpuSubmeshes_.push_back(g);
     }
+    buildDrawList();
 
     if (placeholderTex_ == 0)
         placeholderTex_ = createPlaceholderTexture();
-
-    if (!modelPath_.isEmpty())
-    {
-        GpuCacheEntry entry;
-        entry.vao = vao_;
-        entry.vbo = vbo_;
-        entry.ibo = ibo_;
-        entry.submeshes = gpuSubmeshes_;
-        gpuCache_.insert(modelPath_, entry);
-    }
 }
 
-GLModelView::TextureResolve GLModelView::resolveTexturePath(const std::string& mdxPath) const
+GLModelView::TextureResolve GLModelView::resolveTexturePath(const QString& assetRoot, const QString& modelDir,
+                                                            const std::string& mdxPath)
 {
     TextureResolve res;
-    if (assetRoot_.isEmpty())
+    if (assetRoot.isEmpty())
         return res;
 
     QString p = QString::fromStdString(mdxPath).trimmed();
@@ -2699,16 +2472,16 @@ GLModelView::TextureResolve GLModelView::resolveTexturePath(const std::string& m
         return res;
 
     // 1) Same directory as model
-    if (!modelDir_.isEmpty())
+    if (!modelDir.isEmpty())
     {
-        if (tryPath(modelDir_, p, "model-dir"))
+        if (tryPath(modelDir, p, "model-dir"))
             return res;
-        if (tryPath(modelDir_, baseName, "model-dir-basename"))
+        if (tryPath(modelDir, baseName, "model-dir-basename"))
             return res;
     }
 
     // 2) Asset root original path
-    if (tryPath(assetRoot_, p, "asset-root"))
+    if (tryPath(assetRoot, p, "asset-root"))
         return res;
     addRelCandidate(p);
 
@@ -2729,24 +2502,24 @@ GLModelView::TextureResolve GLModelView::resolveTexturePath(const std::string& m
     };
     for (const auto& dir : commonDirs)
     {
-        if (tryPath(assetRoot_, dir + "/" + baseName, "common:" + dir))
+        if (tryPath(assetRoot, dir + "/" + baseName, "common:" + dir))
             return res;
-        if (tryPath(assetRoot_, dir + "/" + p, "common:" + dir))
+        if (tryPath(assetRoot, dir + "/" + p, "common:" + dir))
             return res;
         addRelCandidate(dir + "/" + baseName);
         addRelCandidate(dir + "/" + p);
     }
 
     // 4) war3mapImported folder
-    if (tryPath(assetRoot_, "war3mapImported/" + baseName, "war3mapImported"))
+    if (tryPath(assetRoot, "war3mapImported/" + baseName, "war3mapImported"))
         return res;
-    if (tryPath(assetRoot_, "war3mapImported/" + p, "war3mapImported"))
+    if (tryPath(assetRoot, "war3mapImported/" + p, "war3mapImported"))
         return res;
     addRelCandidate("war3mapImported/" + baseName);
     addRelCandidate("war3mapImported/" + p);
 
     // 5) Basename search (first hit)
-    QDirIterator it(assetRoot_, QStringList() << baseName, QDir::Files, QDirIterator::Subdirectories);
+    QDirIterator it(assetRoot, QStringList() << baseName, QDir::Files, QDirIterator::Subdirectories);
     if (it.hasNext())
     {
         res.path = it.next();
@@ -2778,8 +2551,180 @@ GLuint GLModelView::createPlaceholderTexture()
     return tex;
 }
 
+void GLModelView::evaluateDrawStates(std::uint32_t globalTimeMs)
+{
+    // Camera-only repaints keep the previous evaluation.
+    if (drawStatesValid_ && drawStatesTimeMs_ == globalTimeMs && drawStatesAlphaTest_ == alphaTestEnabled_ &&
+        drawStates_.size() == gpuSubmeshes_.size())
+        return;
+    drawStatesValid_ = true;
+    drawStatesTimeMs_ = globalTimeMs;
+    drawStatesAlphaTest_ = alphaTestEnabled_;
+
+    FrameProfiler::Scope scope(profiler_, FrameProfiler::Sampling);
+    const ModelData& m = *model_;
+
+    // Geoset animations (KGAO / KGAC), once per geoset.
+    const std::size_t geosetCount = m.geosetAnimByGeoset.size();
+    geosetAlphas_.assign(geosetCount, 1.0f);
+    geosetColors_.assign(geosetCount, QVector3D(1.0f, 1.0f, 1.0f));
+    for (std::size_t g = 0; g < geosetCount; ++g)
+    {
+        const int animIndex = m.geosetAnimByGeoset[g];
+        if (animIndex < 0)
+            continue;
+        const auto& ga = m.geosetAnimations[std::size_t(animIndex)];
+        const float baseAlpha = clampf(ga.alpha, 0.0f, 1.0f);
+        geosetAlphas_[g] = clampf(ModelAnim::SampleTrackFloat(ga.trackAlpha, globalTimeMs, baseAlpha, m), 0.0f, 1.0f);
+        if ((ga.flags & 0x2u) != 0u || !ga.trackColor.empty())
+        {
+            const Vec3 c = ModelAnim::SampleTrackVec3(ga.trackColor, globalTimeMs, ga.color, m);
+            geosetColors_[g] = QVector3D(c.x, c.y, c.z);
+        }
+    }
+
+    // Texture animations, once per TXAN entry.
+    uvTransforms_.assign(m.textureAnimations.size(), UvTransform());
+    for (std::size_t i = 0; i < m.textureAnimations.size(); ++i)
+    {
+        const auto& ta = m.textureAnimations[i];
+        const Vec3 defT{0.0f, 0.0f, 0.0f};
+        const Vec3 defS{1.0f, 1.0f, 1.0f};
+        const Vec4 defR{0.0f, 0.0f, 0.0f, 1.0f};
+        const Vec3 t = ModelAnim::SampleTrackVec3(ta.translation, globalTimeMs, defT, m);
+        const Vec3 sc = ModelAnim::SampleTrackVec3(ta.scaling, globalTimeMs, defS, m);
+        Vec4 r = ModelAnim::SampleTrackQuat(ta.rotation, globalTimeMs, defR, m);
+        const float rl = std::sqrt(r.z * r.z + r.w * r.w);
+        if (rl > 0.0f)
+        {
+            r.z /= rl;
+            r.w /= rl;
+        }
+        uvTransforms_[i].trans = QVector2D(t.x, t.y);
+        uvTransforms_[i].rot = QVector2D(r.z, r.w);
+        uvTransforms_[i].scale = sc.x;
+    }
+
+    // Layer alpha (KMTA), once per material.
+    layerAlphas_.resize(m.materials.size());
+    for (std::size_t i = 0; i < m.materials.size(); ++i)
+    {
+        const auto& layer = m.materials[i].layer;
+        layerAlphas_[i] = clampf(ModelAnim::SampleTrackFloat(layer.trackAlpha, globalTimeMs, layer.alpha, m), 0.0f, 1.0f);
+    }
+
+    drawStates_.assign(gpuSubmeshes_.size(), SubmeshDrawState());
+    for (std::size_t i = 0; i < gpuSubmeshes_.size(); ++i)
+    {
+        const GpuSubmesh& sm = gpuSubmeshes_[i];
+        if (sm.materialId >= m.materials.size())
+            continue;
+        const float geosetAlpha = sm.geosetIndex < geosetCount ? geosetAlphas_[sm.geosetIndex] : 1.0f;
+        if (geosetAlpha <= 0.001f)
+            continue; // hidden by its geoset animation: skipped in both passes
+
+        const auto& layer = m.materials[sm.materialId].layer;
+        const std::uint32_t filter = layer.filterMode;
+        SubmeshDrawState& st = drawStates_[i];
+        st.visible = true;
+        st.blended = IsBlendedFilter(filter);
+        if (alphaTestEnabled_)
+        {
+            if (filter == 1)
+            {
+                st.alphaTest = true;
+                st.alphaCutoff = 0.75f;
+            }
+            else if (filter >= 5)
+            {
+                st.alphaTest = true;
+                st.alphaCutoff = 0.02f;
+            }
+        }
+        st.alpha = layerAlphas_[sm.materialId] * geosetAlpha;
+        if (sm.geosetIndex < geosetCount)
+            st.color = geosetColors_[sm.geosetIndex];
+        if (layer.textureAnimId >= 0 && std::size_t(layer.textureAnimId) < uvTransforms_.size())
+        {
+            const UvTransform& uv = uvTransforms_[std::size_t(layer.textureAnimId)];
+            st.uvTrans = uv.trans;
+            st.uvRot = uv.rot;
+            st.uvScale = uv.scale;
+        }
+    }
+}
+
+void GLModelView::uploadMaterialBlock()
+{
+    // One std140 slot per run, each at a UNIFORM_BUFFER_OFFSET_ALIGNMENT boundary.
+    materialStaging_.assign(drawRuns_.size() * materialStride_, 0);
+    for (std::size_t r = 0; r < drawRuns_.size(); ++r)
+    {
+        const DrawRun& run = drawRuns_[r];
+        const SubmeshDrawState& st = drawStates_[run.submesh];
+        const auto& layer = model_->materials[gpuSubmeshes_[run.submesh].materialId].layer;
+        const bool unshaded = (layer.shadingFlags & (LAYER_UNSHADED | LAYER_UNLIT)) != 0;
+        const bool hasTex = (run.tex != placeholderTex_ && run.tex != 0);
+
+        MaterialParams p = {};
+        p.color[0] = st.color.x();
+        p.color[1] = st.color.y();
+        p.color[2] = st.color.z();
+        p.color[3] = st.alpha;
+        p.uvTransRot[0] = st.uvTrans.x();
+        p.uvTransRot[1] = st.uvTrans.y();
+        p.uvTransRot[2] = st.uvRot.x();
+        p.uvTransRot[3] = st.uvRot.y();
+        p.uvParams[0] = st.uvScale;
+        p.uvParams[1] = st.alphaCutoff;
+        p.flags[0] = hasTex ? 1 : 0;
+        p.flags[1] = st.alphaTest ? 1 : 0;
+        p.flags[2] = unshaded ? 1 : 0;
+        std::memcpy(materialStaging_.data() + r * materialStride_, &p, sizeof(p));
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, materialUbo_);
+    // Re-specifying the store each frame lets the driver orphan last frame's copy.
+    glBufferData(GL_UNIFORM_BUFFER, GLsizeiptr(materialStaging_.size()), materialStaging_.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void GLModelView::buildDrawList()
+{
+    drawList_.clear();
+    if (!model_)
+        return;
+
+    const auto& mats = model_->materials;
+    drawList_.reserve(gpuSubmeshes_.size());
+    for (std::size_t i = 0; i < gpuSubmeshes_.size(); ++i)
+    {
+        if (gpuSubmeshes_[i].materialId < mats.size())
+            drawList_.push_back(i);
+    }
+
+    // Pass first (opaque before blended), then priority plane for the blended pass,
+    // then blend mode / texture / flags so identical state ends up adjacent.
+    std::stable_sort(drawList_.begin(), drawList_.end(), [&](std::size_t a, std::size_t b){
+        const auto& ma = mats[gpuSubmeshes_[a].materialId];
+        const auto& mb = mats[gpuSubmeshes_[b].materialId];
+        const bool ba = IsBlendedFilter(ma.layer.filterMode);
+        const bool bb = IsBlendedFilter(mb.layer.filterMode);
+        if (ba != bb)
+            return !ba;
+        if (ba && ma.priorityPlane != mb.priorityPlane)
+            return ma.priorityPlane < mb.priorityPlane;
+        if (ma.layer.filterMode != mb.layer.filterMode)
+            return ma.layer.filterMode < mb.layer.filterMode;
+        if (ma.layer.textureId != mb.layer.textureId)
+            return ma.layer.textureId < mb.layer.textureId;
+        return ma.layer.shadingFlags < mb.layer.shadingFlags;
+    });
+}
+
 GLuint GLModelView::getOrCreateTexture(std::uint32_t textureId)
 {
+    FrameProfiler::Scope scope(profiler_, FrameProfiler::Textures);
     if (!model_)
         return placeholderTex_;
 
@@ -2787,6 +2732,11 @@ GLuint GLModelView::getOrCreateTexture(std::uint32_t textureId)
     if (it != textureCache_.end() && it->second.valid)
         return it->second.id;
 
+    // Cache miss. Resolve and decode run on the thread pool (startTextureDecode);
+    // until the pixels are ready the placeholder is drawn and nothing is cached,
+    // so the next repaint asks again.
+    static LogSink::RateLimit missLimit(20);
+
     TextureHandle handle;
     handle.id = placeholderTex_;
     handle.valid = true;
@@ -2813,7 +2763,7 @@ GLuint GLModelView::getOrCreateTexture(std::uint32_t textureId)
             handle.path = "ReplaceableTextures/TeamColor";
             handle.source = "replaceable:TeamColor";
             textureCache_[textureId] = handle;
-            LogSink::instance().log(QString("Texture %1 replaceable TeamColor").arg(textureId));
+            LogSink::instance().log(LogLevel::Debug, QString("Texture %1 replaceable TeamColor").arg(textureId));
             return handle.id;
         }
         if (tex.replaceableId == 2)
@@ -2834,152 +2784,69 @@ GLuint GLModelView::getOrCreateTexture(std::uint32_t textureId)
             handle.path = "ReplaceableTextures/TeamGlow";
             handle.source = "replaceable:TeamGlow";
             textureCache_[textureId] = handle;
-            LogSink::instance().log(QString("Texture %1 replaceable TeamGlow").arg(textureId));
+            LogSink::instance().log(LogLevel::Debug, QString("Texture %1 replaceable TeamGlow").arg(textureId));
             return handle.id;
         }
 
-        // Replaceable textures (team color, etc.) aren't resolved here.
         if (!tex.fileName.empty())
         {
-            const auto resolved = resolveTexturePath(tex.fileName);
-            QStringList attempts = resolved.attempts;
-            if (!resolved.path.isEmpty())
+            auto pending = pendingTextures_.find(textureId);
+            if (pending == pendingTextures_.end())
+                pending = pendingTextures_.emplace(textureId, startTextureDecode(tex.fileName)).first;
+            if (!pending->second.isFinished())
             {
-                QImage img;
-                QString err;
-                const QString ext = QFileInfo(resolved.path).suffix().toLower();
-                bool ok = false;
-
-                if (ext == "blp")
-                {
-                    ok = BlpLoader::LoadBlpToImageCached(resolved.path, &img, &err);
-                }
-                else if (ext == "tga")
-                {
-                    QFile tf(resolved.path);
-                    if (tf.open(QIODevice::ReadOnly))
-                    {
-                        const QByteArray tgaBytes = tf.readAll();
-                        ok = LoadTgaFromBytes(tgaBytes, &img, &err);
-                    }
-                    else
-                    {
-                        ok = false;
-                        err = "Qt failed to open TGA.";
-                    }
-                }
-                else
-                {
-                    ok = img.load(resolved.path);
-                    if (!ok) err = "Qt failed to load image.";
-                    if (ok && img.format() != QImage::Format_RGBA8888)
-                        img = img.convertToFormat(QImage::Format_RGBA8888);
-                }
-
-                if (ok && !img.isNull())
-                {
-                      GLuint gltex = 0;
-                    glGenTextures(1, &gltex);
-                    glBindTexture(GL_TEXTURE_2D, gltex);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, img.width(), img.height(), 0,
-                                 GL_RGBA, GL_UNSIGNED_BYTE, img.constBits());
-                    glGenerateMipmap(GL_TEXTURE_2D);
-
-                    glBindTexture(GL_TEXTURE_2D, 0);
-
-                    handle.id = gltex;
-                    handle.path = resolved.path;
-                    handle.source = resolved.source;
-                    LogSink::instance().log(QString("Texture %1 hit %2 -> %3")
-                                                .arg(textureId)
-                                                .arg(handle.source)
-                                                .arg(handle.path));
-                }
-                else
-                {
-                    LogSink::instance().log(QString("Texture %1 failed to load %2 | %3")
-                                                .arg(textureId)
-                                                .arg(resolved.path)
-                                                .arg(err));
-                    recordMissingTexture(QString::fromStdString(tex.fileName), attempts);
-                }
+                if (!deterministic_)
+                    return placeholderTex_;
+                pending->second.waitForFinished(); // benchmarks draw every texture in the first frame
             }
-            else if (vfs_)
+            const DecodedTexture decoded = pending->second.result();
+            pendingTextures_.erase(pending);
+            loadTiming_.textureResolveMs += decoded.resolveMs;
+            loadTiming_.textureDecodeMs += decoded.decodeMs;
+
+            Trace::Scope trace("gl", "UploadTexture", QString::fromStdString(tex.fileName));
+            if (!decoded.image.isNull())
             {
-                QImage img;
-                QString err;
-                bool ok = false;
-                QString source;
-                QString foundPath;
+                QElapsedTimer uploadTimer;
+                uploadTimer.start();
+                const QImage& img = decoded.image;
+                GLuint gltex = 0;
+                glGenTextures(1, &gltex);
+                glBindTexture(GL_TEXTURE_2D, gltex);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, img.width(), img.height(), 0,
+                             GL_RGBA, GL_UNSIGNED_BYTE, img.constBits());
+                glGenerateMipmap(GL_TEXTURE_2D);
+                noteTextureUpload(img.width(), img.height());
+                loadTiming_.textureUploadMs += TakeMs(uploadTimer);
+                loadTiming_.textures += 1;
 
-                for (const auto& candidate : resolved.vfsCandidates)
-                {
-                    const QString attempt = QString("mpq:%1").arg(candidate);
-                    attempts.append(attempt);
-
-                    const QByteArray bytes = vfs_->readAll(candidate);
-                    if (bytes.isEmpty())
-                        continue;
-
-                    source = vfs_->resolveDebugInfo(candidate);
-                    foundPath = candidate;
-                    const QString ext = QFileInfo(candidate).suffix().toLower();
-                    if (ext == "blp" || ext.isEmpty())
-                        ok = BlpLoader::LoadBlpToImageFromBytes(bytes, &img, &err);
-                    else
-                    {
-                        ok = img.loadFromData(bytes);
-                        if (!ok) err = "Qt failed to load image bytes.";
-                        if (ok && img.format() != QImage::Format_RGBA8888)
-                            img = img.convertToFormat(QImage::Format_RGBA8888);
-                    }
-                    if (ok)
-                        break;
-                }
+                glBindTexture(GL_TEXTURE_2D, 0);
 
-                if (ok && !img.isNull())
-                {
-                      GLuint gltex = 0;
-                    glGenTextures(1, &gltex);
-                    glBindTexture(GL_TEXTURE_2D, gltex);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, img.width(), img.height(), 0,
-                                 GL_RGBA, GL_UNSIGNED_BYTE, img.constBits());
-                    glGenerateMipmap(GL_TEXTURE_2D);
-
-                    glBindTexture(GL_TEXTURE_2D, 0);
-
-                    handle.id = gltex;
-                    handle.path = foundPath;
-                    handle.source = source.isEmpty() ? "mpq" : source;
-                    LogSink::instance().log(QString("Texture %1 hit %2 -> %3")
-                                                .arg(textureId)
-                                                .arg(handle.source)
-                                                .arg(handle.path));
-                }
-                else
-                {
-                    LogSink::instance().log(QString("Texture %1 not found in MPQ: %2")
-                                                .arg(textureId)
-                                                .arg(QString::fromStdString(tex.fileName)));
-                    recordMissingTexture(QString::fromStdString(tex.fileName), attempts);
-                }
+                handle.id = gltex;
+                handle.path = decoded.path;
+                handle.source = decoded.source;
+                LogSink::instance().log(LogLevel::Debug, QString("Texture %1 hit %2 -> %3")
+                                            .arg(textureId)
+                                            .arg(handle.source)
+                                            .arg(handle.path));
             }
             else
             {
-                LogSink::instance().log(QString("Texture %1 not found: %2")
-                                            .arg(textureId)
-                                            .arg(QString::fromStdString(tex.fileName)));
-                recordMissingTexture(QString::fromStdString(tex.fileName), attempts);
+                const QString name = QString::fromStdString(tex.fileName);
+                QString line;
+                if (!decoded.path.isEmpty())
+                    line = QString("Texture %1 failed to load %2 | %3").arg(textureId).arg(decoded.path).arg(decoded.error);
+                else if (decoded.searchedVfs)
+                    line = QString("Texture %1 not found in MPQ: %2").arg(textureId).arg(name);
+                else
+                    line = QString("Texture %1 not found: %2").arg(textureId).arg(name);
+                LogSink::instance().log(LogLevel::Warning, line, &missLimit);
+                recordMissingTexture(name, decoded.attempts);
             }
         }
     }
@@ -2987,3 +2854,117 @@ GLuint GLModelView::getOrCreateTexture(std::uint32_t textureId)
     textureCache_[textureId] = handle;
     return handle.id;
 }
+
+QFuture<GLModelView::DecodedTexture> GLModelView::startTextureDecode(const std::string& fileName)
+{
+    // The job works on copies; the view may switch models before it runs.
+    QFuture<DecodedTexture> future = QtConcurrent::run(&GLModelView::decodeTexture, assetRoot_, modelDir_, vfs_, fileName);
+    auto* watcher = new QFutureWatcher<DecodedTexture>(this);
+    connect(watcher, &QFutureWatcher<DecodedTexture>::finished, this, [this, watcher]
+    {
+        watcher->deleteLater();
+        update();
+    });
+    watcher->setFuture(future);
+    return future;
+}
+
+void GLModelView::startTextureDecodes()
+{
+    pendingTextures_.clear(); // jobs of the previous model finish unobserved
+    if (!model_)
+        return;
+    for (std::uint32_t i = 0; i < model_->textures.size(); ++i)
+    {
+        const auto& tex = model_->textures[i];
+        if (tex.replaceableId != 1 && tex.replaceableId != 2 && !tex.fileName.empty())
+            pendingTextures_.emplace(i, startTextureDecode(tex.fileName));
+    }
+}
+
+GLModelView::DecodedTexture GLModelView::decodeTexture(QString assetRoot, QString modelDir,
+                                                       std::shared_ptr<IVfs> vfs, std::string fileName)
+{
+    Trace::Scope trace("texture", "DecodeTexture", QString::fromStdString(fileName));
+    DecodedTexture out;
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+
+    const auto resolved = resolveTexturePath(assetRoot, modelDir, fileName);
+    out.attempts = resolved.attempts;
+    out.resolveMs += TakeMs(stageTimer);
+
+    QImage img;
+    if (!resolved.path.isEmpty())
+    {
+        out.path = resolved.path;
+        out.source = resolved.source;
+        const QString ext = QFileInfo(resolved.path).suffix().toLower();
+        bool ok = false;
+
+        if (ext == "blp")
+        {
+            ok = BlpLoader::LoadBlpToImageCached(resolved.path, &img, &out.error);
+        }
+        else if (ext == "tga")
+        {
+            QFile tf(resolved.path);
+            if (tf.open(QIODevice::ReadOnly))
+            {
+                const QByteArray tgaBytes = tf.readAll();
+                ok = LoadTgaFromBytes(tgaBytes, &img, &out.error);
+            }
+            else
+            {
+                ok = false;
+                out.error = "Qt failed to open TGA.";
+            }
+        }
+        else
+        {
+            ok = img.load(resolved.path);
+            if (!ok) out.error = "Qt failed to load image.";
+            if (ok && img.format() != QImage::Format_RGBA8888)
+                img = img.convertToFormat(QImage::Format_RGBA8888);
+        }
+        out.decodeMs += TakeMs(stageTimer);
+        if (ok)
+            out.image = img;
+    }
+    else if (vfs)
+    {
+        out.searchedVfs = true;
+        for (const auto& candidate : resolved.vfsCandidates)
+        {
+            out.attempts.append(QString("mpq:%1").arg(candidate));
+
+            const QByteArray bytes = vfs->readAll(candidate);
+            out.resolveMs += TakeMs(stageTimer);
+            if (bytes.isEmpty())
+                continue;
+
+            const QString ext = QFileInfo(candidate).suffix().toLower();
+            bool ok = false;
+            QString err;
+            if (ext == "blp" || ext.isEmpty())
+                ok = BlpLoader::LoadBlpToImageFromBytes(bytes, &img, &err);
+            else
+            {
+                ok = img.loadFromData(bytes);
+                if (!ok) err = "Qt failed to load image bytes.";
+                if (ok && img.format() != QImage::Format_RGBA8888)
+                    img = img.convertToFormat(QImage::Format_RGBA8888);
+            }
+            out.decodeMs += TakeMs(stageTimer);
+            if (ok)
+            {
+                const QString source = vfs->resolveDebugInfo(candidate);
+                out.image = img;
+                out.path = candidate;
+                out.source = source.isEmpty() ? "mpq" : source;
+                break;
+            }
+        }
+    }
+    return out;
+}
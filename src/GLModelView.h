@@ -4,18 +4,29 @@
 #include <QOpenGLFunctions_3_3_Core>
 #include <QOpenGLDebugLogger>
 #include <QOpenGLShaderProgram>
+#include <QVector2D>
 #include <QVector3D>
 #include <QMatrix4x4>
 #include <QRandomGenerator>
 #include <QTimer>
 #include <QElapsedTimer>
+#include <QFuture>
+#include <QImage>
 #include <QHash>
 #include <QSet>
+#include <array>
 #include <memory>
 #include <optional>
+#include <random>
 #include <unordered_map>
 
+#include "FrameProfiler.h"
+#include "GLMeshCache.h"
+#include "GLStreamBuffer.h"
+#include "LoadTiming.h"
 #include "ModelData.h"
+#include "SimThread.h"
+#include "VertexPacking.h"
 
 class GLModelView final : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
 {
@@ -39,11 +50,32 @@ public:
     // Default = 1.0; clamped to [0.05, 10.0]
     void setPlaybackSpeed(float speed);
 
+    // Benchmark mode: stops the frame timer and reseeds the particle RNG on every setModel().
+    void setDeterministic(bool enabled, std::uint32_t particleSeed = 1337u);
+    // Advances by a fixed step and renders one frame synchronously into the widget FBO,
+    // then waits for that frame's GPU timer query. Requires an initialized context.
+    FrameProfiler::Frame renderFixedFrame(float dtSeconds);
+    const FrameProfiler& profiler() const { return profiler_; }
+    // Perf overlay (frame-time graph + counters); also toggled with H.
+    void setHudVisible(bool visible);
+    bool hudVisible() const { return hudVisible_; }
+    QString glInfo() const { return glInfo_; }
+    // Uploads mesh and skinned vertices in the 16-byte VertexPacking format
+    // instead of float ModelVertex. Default off; W3PREVIEW_PACKED_VERTICES=1 turns it on.
+    void setPackedVertices(bool enabled);
+    bool packedVertices() const { return packedVertices_; }
+    // Largest distance, in pixels at the current camera and viewport, between a
+    // vertex as drawn by the last frame and its unpacked value; skinned vertices
+    // are checked against the simulation frame that was uploaded. 0 without a mesh.
+    double packedVertexErrorPixels() const;
+
 signals:
     void statusTextChanged(const QString& text);
     void missingTexturesChanged(const QStringList& missing);
     void anglesChanged(float yaw, float pitch, float roll);
     void panChanged(float x, float y, float z);
+    // Once per setModel(): GPU upload, texture stages and first-frame time of the new model.
+    void firstFrameRendered(const LoadTiming& timing);
 
 protected:
     void initializeGL() override;
@@ -55,6 +87,9 @@ protected:
     void wheelEvent(QWheelEvent* e) override;
     void mouseDoubleClickEvent(QMouseEvent* e) override;
     void keyPressEvent(QKeyEvent* e) override;
+    void showEvent(QShowEvent* e) override;
+    void hideEvent(QHideEvent* e) override;
+    void changeEvent(QEvent* e) override;
 
 private:
     void rebuildGpuBuffers();
@@ -66,11 +101,9 @@ private:
     void recordMissingTexture(const QString& ref, const QStringList& attempts);
     void drawDebug(const QMatrix4x4& mvp);
     void setGlPhase(const char* phase);
-    void updateSkinning(std::uint32_t globalTimeMs);
-    void computeNodeWorld(std::uint32_t globalTimeMs, std::vector<QMatrix4x4>& outWorld) const;
-    void buildNodeWorldCached(std::uint32_t globalTimeMs);
-    void invalidateBindCache();
-    void ensureBindCache();
+    // Newest simulation frame of the current model, or null before the first one arrives.
+    const SimThread::Frame* takeSimFrame();
+    void uploadSkinnedVertices(const SimThread::Frame& frame);
 
     GLuint getOrCreateTexture(std::uint32_t textureId);
     struct TextureResolve
@@ -80,7 +113,26 @@ private:
         QStringList attempts;
         QStringList vfsCandidates;
     };
-    TextureResolve resolveTexturePath(const std::string& mdxPath) const;
+    static TextureResolve resolveTexturePath(const QString& assetRoot, const QString& modelDir, const std::string& mdxPath);
+
+    // Result of a pool-thread texture job: file lookup and decode to RGBA8888.
+    // paintGL only uploads it (getOrCreateTexture).
+    struct DecodedTexture
+    {
+        QImage image; // null on failure
+        QString path;
+        QString source;
+        QString error;
+        QStringList attempts;
+        bool searchedVfs = false;
+        double resolveMs = 0.0;
+        double decodeMs = 0.0;
+    };
+    static DecodedTexture decodeTexture(QString assetRoot, QString modelDir,
+                                        std::shared_ptr<class IVfs> vfs, std::string fileName);
+    QFuture<DecodedTexture> startTextureDecode(const std::string& fileName);
+    // Queues every file texture of the current model; drops jobs of the previous one.
+    void startTextureDecodes();
     GLuint createPlaceholderTexture();
 
     struct GpuSubmesh
@@ -89,15 +141,78 @@ private:
         std::uint32_t indexCount = 0;
         std::uint32_t materialId = 0;
         std::uint32_t geosetIndex = 0;
+        std::int32_t rigidGroup = -1; // drawn from vao_ with rigidMatrices_[rigidGroup]
     };
 
-    struct GpuCacheEntry
+    // Per-frame material / geoset-animation state, evaluated once before both draw passes.
+    struct SubmeshDrawState
+    {
+        float alpha = 1.0f; // layer alpha * geoset alpha
+        QVector3D color{1.0f, 1.0f, 1.0f};
+        QVector2D uvTrans{0.0f, 0.0f};
+        QVector2D uvRot{0.0f, 1.0f};
+        float uvScale = 1.0f;
+        float alphaCutoff = 0.5f;
+        bool visible = false;
+        bool blended = false;
+        bool alphaTest = false;
+
+        bool sameUniforms(const SubmeshDrawState& o) const
+        {
+            return alpha == o.alpha && color == o.color && uvTrans == o.uvTrans && uvRot == o.uvRot &&
+                   uvScale == o.uvScale && alphaTest == o.alphaTest && alphaCutoff == o.alphaCutoff;
+        }
+    };
+    struct UvTransform
+    {
+        QVector2D trans{0.0f, 0.0f};
+        QVector2D rot{0.0f, 1.0f};
+        float scale = 1.0f;
+    };
+    struct MeshUniforms
+    {
+        GLint mvp = -1;
+        GLint normalMat = -1;
+        GLint tex = -1;
+        GLint posScale = -1;
+        GLint posBias = -1;
+        GLint uvScaleBias = -1;
+        GLint octNormal = -1;
+    };
+    // Particle program uniforms, set per emitter batch.
+    struct ParticleUniforms
+    {
+        GLint mvp = -1;
+        GLint tex = -1;
+        GLint camRight = -1;
+        GLint camUp = -1;
+        GLint camFwd = -1;
+        GLint alphaTest = -1;
+        GLint alphaCutoff = -1;
+        GLint emitterWorld = -1;
+        GLint segColor = -1;
+        GLint segScale = -1;
+        GLint timeMiddle = -1;
+        GLint sizeScale = -1;
+        GLint tailLength = -1;
+        GLint xyQuad = -1;
+        GLint columns = -1;
+        GLint cellSize = -1;
+    };
+    // Consecutive draw-list entries sharing all state; [begin, end) into runCounts_/runOffsets_.
+    struct DrawRun
     {
-        GLuint vao = 0;
-        GLuint vbo = 0;
-        GLuint ibo = 0;
-        std::vector<GpuSubmesh> submeshes;
+        std::size_t submesh = 0; // first submesh, source of the run's state
+        GLuint tex = 0;
+        std::size_t begin = 0;
+        std::size_t end = 0;
     };
+    void evaluateDrawStates(std::uint32_t globalTimeMs);
+    void buildDrawList();
+    // Points `vao`'s position/normal/uv attributes at `buffer` + `offset`.
+    void setMeshVertexSource(GLuint vao, GLuint buffer, GLintptr offset, bool packed);
+    QMatrix4x4 viewMatrix() const;
+    void uploadMaterialBlock();
 
     struct TextureHandle
     {
@@ -107,7 +222,7 @@ private:
         QString source;
     };
 
-    std::optional<ModelData> model_;
+    std::shared_ptr<const ModelData> model_; // shared with the simulation thread
     QString displayName_;
     QString modelPath_;
     QString modelDir_;
@@ -118,15 +233,48 @@ private:
     GLuint vao_ = 0;
     GLuint vbo_ = 0;
     GLuint ibo_ = 0;
+    GLenum indexType_ = GL_UNSIGNED_INT; // GL_UNSIGNED_SHORT when the model has indices16
+    std::size_t indexSize_ = sizeof(std::uint32_t);
     std::vector<GpuSubmesh> gpuSubmeshes_;
-    QHash<QString, GpuCacheEntry> gpuCache_;
-    std::vector<ModelVertex> skinnedVertices_;
+    std::vector<SubmeshDrawState> drawStates_; // parallel to gpuSubmeshes_
+    bool drawStatesValid_ = false; // drawStates_ match drawStatesTimeMs_ / drawStatesAlphaTest_
+    std::uint32_t drawStatesTimeMs_ = 0;
+    bool drawStatesAlphaTest_ = false;
+    std::vector<std::size_t> drawList_;        // submission order, built once per model
+    std::vector<GLsizei> runCounts_;           // glMultiDrawElements scratch
+    std::vector<const void*> runOffsets_;
+    std::vector<DrawRun> drawRuns_;            // this frame
+    GLuint materialUbo_ = 0;                   // MaterialBlock, one aligned slot per run
+    std::size_t materialStride_ = 256;
+    std::vector<unsigned char> materialStaging_;
+    std::vector<float> geosetAlphas_;          // per geoset, this frame
+    std::vector<QVector3D> geosetColors_;
+    std::vector<UvTransform> uvTransforms_;    // per texture animation, this frame
+    std::vector<float> layerAlphas_;           // per material, this frame
+    GLMeshCache meshCache_; // owns vao_ / vbo_ / ibo_
+    bool packedVertices_ = false;
+    bool meshPacked_ = false;            // format of vbo_
+    VertexPacking::Decode meshDecode_;
+    // Skinned submeshes draw through streamVao_: vao_'s IBO with attributes in
+    // this frame's stream region. Rigid ones stay on vao_ with a group matrix.
+    GLuint streamVao_ = 0;
+    bool streamValid_ = false;
+    bool streamPacked_ = false;
+    VertexPacking::Decode streamDecode_;
+    std::vector<QMatrix4x4> rigidMatrices_; // per skin group, from the newest sim frame
+    std::uint64_t streamPoseSerial_ = 0; // SimThread::Frame::poseSerial last uploaded
+    bool skinResident_ = false;          // that pose is in skinVbo_ (or fully rigid); nothing to upload
+    GLuint skinVbo_ = 0;
+    std::size_t skinVboBytes_ = 0;
+    int rigidSubmeshes_ = 0;
 
     QOpenGLShaderProgram program_;
     bool programReady_ = false;
+    MeshUniforms meshUniforms_;
     QOpenGLDebugLogger glLogger_;
     bool glLoggerReady_ = false;
     QString glPhase_;
+    QString glInfo_;
     QOpenGLShaderProgram debugProgram_;
     bool debugProgramReady_ = false;
     GLuint debugVao_ = 0;
@@ -141,6 +289,7 @@ private:
     std::vector<DebugVertex> debugVerts_;
 
     std::unordered_map<std::uint32_t, TextureHandle> textureCache_;
+    std::unordered_map<std::uint32_t, QFuture<DecodedTexture>> pendingTextures_;
     GLuint placeholderTex_ = 0;
     GLuint teamColorTex_ = 0;
     GLuint teamGlowTex_ = 0;
@@ -174,26 +323,28 @@ private:
     int viewportW_ = 1;
     int viewportH_ = 1;
 
-    // Persistent node transforms (for DontInheritTranslation logic)
-    std::vector<QMatrix4x4> nodeWorldMat_;
-    std::vector<QVector3D> nodeWorldLoc_;
-    std::vector<QQuaternion> nodeWorldRot_;
-    std::vector<QVector3D> nodeWorldScale_;
-    std::vector<QVector3D> nodeInvWorldLoc_;
-    std::vector<QQuaternion> nodeInvWorldRot_;
-    std::vector<QVector3D> nodeInvWorldScale_;
-
-    // --- Skinning bind-pose cache (invBind) ---
-    int bindCacheSeq_ = -1;
-    std::vector<QMatrix4x4> invBindByNodeId_; // size = maxObjectId+1
-
     // ---- Animation state ----
+    // Poses, skinning and particles live on sim_; ticks post steps and paintGL
+    // draws whatever frame was published last.
+    std::unique_ptr<SimThread> sim_;
+    std::uint64_t modelGeneration_ = 0;
+    bool simFrameFresh_ = false;
     float playbackSpeed_ = 1.0f;
-    std::uint32_t localTimeMs_ = 0;
-    std::uint32_t lastGlobalTimeMs_ = 0;
+    std::uint32_t lastGlobalTimeMs_ = 0; // of the frame being drawn
     int currentSeq_ = 0; // auto-play sequences[0]
 
-    QTimer frameTick_;
+    // Idle: no ticks, repaint on input only. Animating: one tick per presented frame
+    // (vsync-paced). Throttled: inactive / unfocused window, ~10 Hz. Paused: hidden,
+    // minimized or not exposed; nothing is rendered.
+    enum class RenderMode
+    {
+        Idle,
+        Animating,
+        Throttled,
+        Paused
+    };
+    RenderMode renderMode_ = RenderMode::Idle;
+    QTimer frameTick_; // single-shot, re-armed by requestTick()
     QElapsedTimer frameTimer_;
     QElapsedTimer fpsTimer_;
     int fpsFrames_ = 0;
@@ -201,41 +352,43 @@ private:
     QElapsedTimer statusTimer_;
     int lastDrawCalls_ = 0;
     bool loggedBlank_ = false;
+    bool deterministic_ = false;
+    std::uint32_t particleSeed_ = 1337u;
 
-    void tickAnimation();
-    void updateEmitters(float dtSeconds);
-
-    // ---- Particle runtime ----
-    struct Particle
-    {
-        QVector3D pos;
-        QVector3D vel;
-        float gravity = 0.0f;
-        float facing = 0.0f;
-        int tailType = 0; // 0=head, 1=tail
-        float age = 0.0f;
-        float life = 1.0f;
-    };
-
-    struct RuntimeEmitter2
+    // ---- Profiling / HUD ----
+    struct GpuQuery
     {
-        double spawnAccum = 0.0;
-        std::vector<Particle> particles;
-        bool loggedNoSpawn = false;
+        GLuint id = 0;
+        std::uint64_t frameIndex = 0;
+        bool pending = false;
     };
+    FrameProfiler profiler_;
+    std::array<GpuQuery, 4> gpuQueries_{}; // GL_TIME_ELAPSED ring, read back a few frames late
+    GpuQuery* activeGpuQuery_ = nullptr;
+    bool hudVisible_ = false;
+    std::size_t textureBytes_ = 0;
+    LoadTiming loadTiming_; // view-side stages only
+    QElapsedTimer firstFrameTimer_;
+    bool firstFramePending_ = false;
 
-    std::vector<RuntimeEmitter2> runtimeEmitters2_;
+    void beginGpuQuery();
+    void endGpuQuery();
+    void collectGpuQueries(bool wait);
+    void noteTextureUpload(int w, int h);
+    void drawHud();
 
-    struct ParticleVertex
-    {
-        float px, py, pz;
-        float u, v;
-        float r, g, b, a;
-    };
-    std::vector<ParticleVertex> particleVerts_;
+    void tickAnimation();
+    void requestTick();
+    bool hasAnimation() const;
+    RenderMode evaluateRenderMode() const;
+    void setRenderMode(RenderMode mode);
+    static const char* renderModeName(RenderMode mode);
 
     QOpenGLShaderProgram particleProgram_;
     bool particleProgramReady_ = false;
+    ParticleUniforms particleUniforms_;
     GLuint pVao_ = 0;
-    GLuint pVbo_ = 0;
+
+    // Per-frame dynamic geometry (skinned vertices, particle instances).
+    GLStreamBuffer streamBuffer_;
 };
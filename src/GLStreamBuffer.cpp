@@ -0,0 +1,192 @@
+#include "GLStreamBuffer.h"
+
+#include <QOpenGLContext>
+
+#include <algorithm>
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+namespace
+{
+    constexpr GLbitfield kPersistentFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    constexpr std::size_t kGrowQuantum = 64 * 1024;
+}
+
+void GLStreamBuffer::init(QOpenGLFunctions_3_3_Core* gl, std::size_t regionBytes)
+{
+    destroy();
+    gl_ = gl;
+
+    QOpenGLContext* ctx = QOpenGLContext::currentContext();
+    bufferStorage_ = nullptr;
+    if (ctx && !ctx->isOpenGLES() &&
+        (ctx->format().version() >= qMakePair(4, 4) || ctx->hasExtension("GL_ARB_buffer_storage")))
+    {
+        bufferStorage_ = reinterpret_cast<BufferStorageFn>(ctx->getProcAddress("glBufferStorage"));
+    }
+    persistent_ = bufferStorage_ != nullptr;
+
+    createStore(std::max(regionBytes, kGrowQuantum));
+}
+
+void GLStreamBuffer::destroy()
+{
+    if (!gl_)
+        return;
+    for (GLsync& f : fences_)
+    {
+        if (f)
+            gl_->glDeleteSync(f);
+        f = nullptr;
+    }
+    if (buffer_)
+    {
+        if (mapped_)
+        {
+            gl_->glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+            gl_->glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            gl_->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        gl_->glDeleteBuffers(1, &buffer_);
+    }
+    buffer_ = 0;
+    mapped_ = nullptr;
+    regionBytes_ = 0;
+    region_ = 0;
+    cursor_ = 0;
+    regionReady_ = false;
+    gl_ = nullptr;
+}
+
+void GLStreamBuffer::createStore(std::size_t regionBytes)
+{
+    // The new store has no GPU work pending, so old fences no longer apply.
+    for (GLsync& f : fences_)
+    {
+        if (f)
+            gl_->glDeleteSync(f);
+        f = nullptr;
+    }
+
+    regionBytes_ = (regionBytes + kGrowQuantum - 1) / kGrowQuantum * kGrowQuantum;
+    const GLsizeiptr total = GLsizeiptr(regionBytes_ * kFrames);
+
+    if (persistent_)
+    {
+        // Immutable storage cannot be resized: replace the buffer. Draws already
+        // issued keep the old one alive until they complete.
+        if (buffer_)
+        {
+            gl_->glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+            gl_->glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            gl_->glDeleteBuffers(1, &buffer_);
+            buffer_ = 0;
+            mapped_ = nullptr;
+        }
+        gl_->glGenBuffers(1, &buffer_);
+        gl_->glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+        bufferStorage_(GL_COPY_WRITE_BUFFER, total, nullptr, kPersistentFlags);
+        mapped_ = static_cast<unsigned char*>(gl_->glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total, kPersistentFlags));
+        if (!mapped_)
+        {
+            // Driver advertised buffer storage but refused the mapping: use the map/unmap path.
+            gl_->glDeleteBuffers(1, &buffer_);
+            buffer_ = 0;
+            persistent_ = false;
+        }
+    }
+
+    if (!persistent_)
+    {
+        if (!buffer_)
+            gl_->glGenBuffers(1, &buffer_);
+        gl_->glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+        gl_->glBufferData(GL_COPY_WRITE_BUFFER, total, nullptr, GL_STREAM_DRAW); // orphans the old store
+    }
+    gl_->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    cursor_ = 0;
+    regionReady_ = true;
+}
+
+void GLStreamBuffer::waitRegion(int region)
+{
+    GLsync& fence = fences_[region];
+    if (!fence)
+        return;
+    for (;;)
+    {
+        const GLenum r = gl_->glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+        if (r != GL_TIMEOUT_EXPIRED)
+            break;
+    }
+    gl_->glDeleteSync(fence);
+    fence = nullptr;
+}
+
+GLStreamBuffer::Allocation GLStreamBuffer::allocate(std::size_t bytes, std::size_t alignment)
+{
+    Allocation a;
+    if (!gl_ || !buffer_ || bytes == 0)
+        return a;
+
+    if (!regionReady_)
+    {
+        waitRegion(region_);
+        regionReady_ = true;
+    }
+
+    alignment = std::max<std::size_t>(alignment, 1);
+    std::size_t start = (cursor_ + alignment - 1) / alignment * alignment;
+    if (start + bytes > regionBytes_)
+    {
+        createStore(std::max(regionBytes_ * 2, bytes));
+        start = 0;
+    }
+
+    a.buffer = buffer_;
+    a.offset = GLintptr(std::size_t(region_) * regionBytes_ + start);
+    a.bytes = bytes;
+    if (persistent_)
+    {
+        a.ptr = mapped_ + a.offset;
+    }
+    else
+    {
+        // The region's fence has already passed, so nothing in flight reads this range.
+        gl_->glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+        a.ptr = gl_->glMapBufferRange(GL_COPY_WRITE_BUFFER, a.offset, GLsizeiptr(bytes),
+                                      GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        gl_->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        if (!a.ptr)
+            return Allocation();
+    }
+    cursor_ = start + bytes;
+    return a;
+}
+
+void GLStreamBuffer::commit(const Allocation& alloc)
+{
+    if (persistent_ || !alloc.ptr || !gl_)
+        return; // coherent mapping: writes are visible to commands issued afterwards
+    gl_->glBindBuffer(GL_COPY_WRITE_BUFFER, alloc.buffer);
+    gl_->glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    gl_->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void GLStreamBuffer::endFrame()
+{
+    if (!gl_ || !regionReady_)
+        return; // nothing allocated this frame
+    if (fences_[region_])
+        gl_->glDeleteSync(fences_[region_]);
+    fences_[region_] = gl_->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region_ = (region_ + 1) % kFrames;
+    cursor_ = 0;
+    regionReady_ = false;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QOpenGLFunctions_3_3_Core>
+
+#include <cstddef>
+
+// Ring of per-frame regions for geometry rewritten every frame (skinned
+// vertices, particle instances). The buffer is split into kFrames regions;
+// each frame sub-allocates from its own region, and a fence placed at
+// endFrame() guards the region until the GPU is done with it, so writes never
+// stall on in-flight draws.
+//
+// With ARB_buffer_storage the buffer is mapped once, persistently and
+// coherently, and allocate() hands out pointers into that mapping. Without it
+// each allocation maps its range with MAP_UNSYNCHRONIZED_BIT (the fence
+// already guarantees the range is free) and commit() unmaps it; growing the
+// buffer orphans the old store.
+
+class GLStreamBuffer
+{
+public:
+    static constexpr int kFrames = 3;
+
+    struct Allocation
+    {
+        void* ptr = nullptr;
+        GLuint buffer = 0;
+        GLintptr offset = 0;
+        std::size_t bytes = 0;
+    };
+
+    // Needs a current context. `regionBytes` is the initial per-frame size;
+    // regions grow on demand.
+    void init(QOpenGLFunctions_3_3_Core* gl, std::size_t regionBytes);
+    void destroy();
+
+    // `ptr` is valid until commit(). Returns an empty allocation on failure.
+    Allocation allocate(std::size_t bytes, std::size_t alignment = 16);
+    void commit(const Allocation& alloc);
+
+    // Fences everything allocated since the previous endFrame() and moves to the next region.
+    void endFrame();
+
+    bool persistent() const { return persistent_; }
+    std::size_t regionBytes() const { return regionBytes_; }
+
+private:
+    typedef void (QOPENGLF_APIENTRYP BufferStorageFn)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+    void createStore(std::size_t regionBytes);
+    void waitRegion(int region);
+
+    QOpenGLFunctions_3_3_Core* gl_ = nullptr;
+    BufferStorageFn bufferStorage_ = nullptr;
+    bool persistent_ = false;
+
+    GLuint buffer_ = 0;
+    unsigned char* mapped_ = nullptr; // persistent mode only
+    std::size_t regionBytes_ = 0;
+    int region_ = 0;
+    std::size_t cursor_ = 0; // within the current region
+    bool regionReady_ = false;
+    GLsync fences_[kFrames] = {};
+};
@@ -0,0 +1,157 @@
+#include "LoadTiming.h"
+
+#include <QStringList>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    static QString Ms(double ms)
+    {
+        return QString::number(ms, 'f', ms < 10.0 ? 2 : 1);
+    }
+
+    static QString CsvField(const QString& s)
+    {
+        if (!s.contains(',') && !s.contains('"') && !s.contains('\n'))
+            return s;
+        QString q = s;
+        q.replace("\"", "\"\"");
+        return "\"" + q + "\"";
+    }
+
+    // The slowest chunk tags first, e.g. "GEOS 3.1, BONE 0.6".
+    static QString TopChunks(const LoadTiming& t, int maxChunks, const QString& sep)
+    {
+        std::vector<LoadTiming::Chunk> sorted = t.chunks;
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const LoadTiming::Chunk& a, const LoadTiming::Chunk& b) { return a.ms > b.ms; });
+        QStringList parts;
+        for (int i = 0; i < int(sorted.size()) && i < maxChunks; ++i)
+            parts << QString("%1 %2").arg(QString::fromLatin1(sorted[std::size_t(i)].tag), Ms(sorted[std::size_t(i)].ms));
+        return parts.join(sep);
+    }
+}
+
+void LoadTiming::addChunk(const char tag[4], double ms)
+{
+    // Repeated tags (rare, but legal) are folded into one entry.
+    for (auto& c : chunks)
+    {
+        if (std::memcmp(c.tag, tag, 4) == 0)
+        {
+            c.ms += ms;
+            return;
+        }
+    }
+    Chunk c;
+    std::memcpy(c.tag, tag, 4);
+    c.ms = ms;
+    chunks.push_back(c);
+}
+
+QString LoadTiming::summary(int maxChunks) const
+{
+    QStringList parts;
+    parts << QString("read %1").arg(Ms(readMs));
+    const QString top = TopChunks(*this, maxChunks, ", ");
+    parts << (top.isEmpty() ? QString("parse %1").arg(Ms(parseMs))
+                            : QString("parse %1 (%2)").arg(Ms(parseMs), top));
+    parts << QString("post %1").arg(Ms(postMs));
+    if (acmrBefore > 0.0)
+        parts << QString("opt %1 (ACMR %2 -> %3)")
+                     .arg(Ms(optimizeMs), QString::number(acmrBefore, 'f', 2), QString::number(acmrAfter, 'f', 2));
+    parts << QString("gpu %1").arg(Ms(gpuUploadMs));
+    if (textures > 0)
+        parts << QString("tex[%1] %2 (resolve %3, decode %4, upload %5)")
+                     .arg(textures)
+                     .arg(Ms(textureMs()), Ms(textureResolveMs), Ms(textureDecodeMs), Ms(textureUploadMs));
+    if (firstFrameMs >= 0.0)
+        parts << QString("first frame %1").arg(Ms(firstFrameMs));
+    if (totalMs > 0.0)
+        parts << QString("total %1").arg(Ms(totalMs));
+    return parts.join(" | ") + " ms";
+}
+
+void LoadTimingReport::add(const QString& path, const LoadTiming& timing)
+{
+    Entry& e = entries_[path];
+    e.path = path;
+    e.timing = timing;
+    e.loads += 1;
+}
+
+std::vector<const LoadTimingReport::Entry*> LoadTimingReport::sortedByTotal() const
+{
+    std::vector<const Entry*> out;
+    out.reserve(std::size_t(entries_.size()));
+    for (auto it = entries_.cbegin(); it != entries_.cend(); ++it)
+        out.push_back(&it.value());
+    std::sort(out.begin(), out.end(), [](const Entry* a, const Entry* b) {
+        if (a->timing.totalMs != b->timing.totalMs)
+            return a->timing.totalMs > b->timing.totalMs;
+        return a->path < b->path;
+    });
+    return out;
+}
+
+QString LoadTimingReport::formatSlowest(int topN) const
+{
+    const auto sorted = sortedByTotal();
+    QString out;
+    QTextStream ts(&out);
+    ts << QString("Slowest model loads (%1 of %2, ms):\n").arg(std::min<int>(topN, int(sorted.size()))).arg(int(sorted.size()));
+    for (int i = 0; i < int(sorted.size()) && i < topN; ++i)
+    {
+        const Entry* e = sorted[std::size_t(i)];
+        const LoadTiming& t = e->timing;
+        ts << QString("%1. %2 total %3 | read %4 | parse %5 [%6] | post %7 | opt %8 | gpu %9 | tex %10 | first frame %11\n")
+                  .arg(i + 1)
+                  .arg(e->path)
+                  .arg(Ms(t.totalMs))
+                  .arg(Ms(t.readMs))
+                  .arg(Ms(t.parseMs))
+                  .arg(TopChunks(t, 3, " "))
+                  .arg(Ms(t.postMs))
+                  .arg(Ms(t.optimizeMs))
+                  .arg(Ms(t.gpuUploadMs))
+                  .arg(Ms(t.textureMs()))
+                  .arg(Ms(std::max(0.0, t.firstFrameMs)));
+    }
+    ts.flush();
+    return out;
+}
+
+QByteArray LoadTimingReport::toCsv() const
+{
+    QString out;
+    QTextStream ts(&out);
+    ts << "path,loads,total_ms,read_ms,parse_ms,post_ms,optimize_ms,acmr_before,acmr_after,gpu_upload_ms,texture_resolve_ms,texture_decode_ms,"
+          "texture_upload_ms,textures,first_frame_ms,chunks\n";
+    for (const Entry* e : sortedByTotal())
+    {
+        const LoadTiming& t = e->timing;
+        QStringList chunks;
+        for (const auto& c : t.chunks)
+            chunks << QString("%1=%2").arg(QString::fromLatin1(c.tag), QString::number(c.ms, 'f', 3));
+        ts << CsvField(e->path) << ',' << e->loads << ','
+           << QString::number(t.totalMs, 'f', 3) << ','
+           << QString::number(t.readMs, 'f', 3) << ','
+           << QString::number(t.parseMs, 'f', 3) << ','
+           << QString::number(t.postMs, 'f', 3) << ','
+           << QString::number(t.optimizeMs, 'f', 3) << ','
+           << QString::number(t.acmrBefore, 'f', 3) << ','
+           << QString::number(t.acmrAfter, 'f', 3) << ','
+           << QString::number(t.gpuUploadMs, 'f', 3) << ','
+           << QString::number(t.textureResolveMs, 'f', 3) << ','
+           << QString::number(t.textureDecodeMs, 'f', 3) << ','
+           << QString::number(t.textureUploadMs, 'f', 3) << ','
+           << t.textures << ','
+           << QString::number(t.firstFrameMs, 'f', 3) << ','
+           << CsvField(chunks.join(' ')) << '\n';
+    }
+    ts.flush();
+    return out.toUtf8();
+}
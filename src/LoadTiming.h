@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <vector>
+
+// Per-stage timing of one model load, from file read to the first rendered
+// frame. The loader fills the read / parse / post fields, MeshOptimizer the
+// optimize stage; the viewer fills the GPU and texture stages once the first
+// frame has been drawn.
+
+struct LoadTiming
+{
+    struct Chunk
+    {
+        char tag[5] = {};
+        double ms = 0.0;
+    };
+
+    double readMs = 0.0;
+    double parseMs = 0.0; // whole chunk loop, including chunks not listed separately
+    std::vector<Chunk> chunks; // file order
+    double postMs = 0.0;
+    double optimizeMs = 0.0; // MeshOptimizer, still on the load thread
+    double acmrBefore = 0.0;
+    double acmrAfter = 0.0;
+
+    double gpuUploadMs = 0.0; // VAO/VBO build in setModel
+    double textureResolveMs = 0.0; // path lookup + disk/MPQ reads
+    double textureDecodeMs = 0.0;
+    double textureUploadMs = 0.0; // glTexImage2D + mipmaps
+    int textures = 0;
+    double firstFrameMs = -1.0; // setModel() to end of the first painted frame; -1 until drawn
+
+    double totalMs = 0.0; // request to first frame, wall clock (includes queueing)
+
+    void addChunk(const char tag[4], double ms);
+    double textureMs() const { return textureResolveMs + textureDecodeMs + textureUploadMs; }
+
+    // "read 1.2 | parse 4.5 (GEOS 3.1, BONE 0.6) | post 0.3 | opt 0.2 (ACMR 1.41 -> 0.72) | ..." in ms; slowest chunks first.
+    QString summary(int maxChunks = 3) const;
+};
+
+// Session-wide aggregate: the latest full load per model, reported slowest first.
+class LoadTimingReport
+{
+public:
+    void add(const QString& path, const LoadTiming& timing);
+    void clear() { entries_.clear(); }
+    int size() const { return int(entries_.size()); }
+
+    // Plain-text table of the `topN` slowest models by total time.
+    QString formatSlowest(int topN) const;
+    // Every model, slowest first, one column per stage.
+    QByteArray toCsv() const;
+
+private:
+    struct Entry
+    {
+        QString path;
+        LoadTiming timing;
+        int loads = 0;
+    };
+    std::vector<const Entry*> sortedByTotal() const;
+
+    QHash<QString, Entry> entries_;
+};
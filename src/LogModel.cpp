@@ -0,0 +1,198 @@
+#include "LogModel.h"
+
+#include <QColor>
+
+#include <algorithm>
+
+namespace
+{
+    constexpr int kDefaultHistory = 20000;
+    constexpr int kApplyIntervalMs = 100;
+}
+
+LogModel::LogModel(QObject* parent)
+    : QAbstractListModel(parent), ring_(std::size_t(kDefaultHistory))
+{
+    applyTimer_.setSingleShot(true);
+    applyTimer_.setInterval(kApplyIntervalMs);
+    connect(&applyTimer_, &QTimer::timeout, this, &LogModel::applyPending);
+}
+
+int LogModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : int(visible_.size());
+}
+
+QVariant LogModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || std::size_t(index.row()) >= visible_.size())
+        return {};
+
+    const LogRecord& rec = recordAt(visible_[std::size_t(index.row())]);
+    switch (role)
+    {
+    case Qt::DisplayRole:
+        return rec.line;
+    case Qt::ForegroundRole:
+        switch (rec.level)
+        {
+        case LogLevel::Debug: return QColor(140, 140, 140);
+        case LogLevel::Warning: return QColor(220, 150, 40);
+        case LogLevel::Error: return QColor(230, 70, 70);
+        case LogLevel::Info: break;
+        }
+        return {};
+    case LevelRole:
+        return int(rec.level);
+    case CategoryRole:
+        return rec.category;
+    default:
+        return {};
+    }
+}
+
+void LogModel::append(const QVector<LogRecord>& records)
+{
+    pending_ += records;
+    if (!applyTimer_.isActive())
+        applyTimer_.start();
+}
+
+void LogModel::applyPending()
+{
+    if (pending_.isEmpty())
+        return;
+
+    QVector<LogRecord> incoming;
+    incoming.swap(pending_);
+
+    const std::uint64_t cap = ring_.size();
+    const std::uint64_t finalNext = nextSeq_ + std::uint64_t(incoming.size());
+    const std::uint64_t finalFirst = std::max(firstSeq_, finalNext > cap ? finalNext - cap : 0);
+
+    // Rows whose records are about to be overwritten leave the view first.
+    std::size_t gone = 0;
+    while (gone < visible_.size() && visible_[gone] < finalFirst)
+        ++gone;
+    if (gone > 0)
+    {
+        beginRemoveRows(QModelIndex(), 0, int(gone) - 1);
+        visible_.erase(visible_.begin(), visible_.begin() + std::ptrdiff_t(gone));
+        endRemoveRows();
+    }
+
+    std::vector<std::uint64_t> added;
+    QStringList newCategories;
+    for (int i = 0; i < incoming.size(); ++i)
+    {
+        const std::uint64_t seq = nextSeq_ + std::uint64_t(i);
+        if (seq < finalFirst)
+            continue; // already older than the history limit
+        LogRecord& slot = ring_[std::size_t(seq % cap)];
+        slot = std::move(incoming[i]);
+        if (!categories_.contains(slot.category))
+        {
+            categories_.insert(slot.category);
+            newCategories << slot.category;
+        }
+        if (accepts(slot))
+            added.push_back(seq);
+    }
+    nextSeq_ = finalNext;
+    firstSeq_ = finalFirst;
+
+    if (!added.empty())
+    {
+        const int first = int(visible_.size());
+        beginInsertRows(QModelIndex(), first, first + int(added.size()) - 1);
+        visible_.insert(visible_.end(), added.begin(), added.end());
+        endInsertRows();
+    }
+
+    for (const QString& c : newCategories)
+        emit categoryAdded(c);
+}
+
+void LogModel::setMaxHistory(int lines)
+{
+    lines = std::clamp(lines, 100, 1000000);
+    if (std::size_t(lines) == ring_.size())
+        return;
+
+    applyPending();
+    beginResetModel();
+    const std::uint64_t keepFrom = std::max(firstSeq_, nextSeq_ > std::uint64_t(lines) ? nextSeq_ - std::uint64_t(lines) : 0);
+    std::vector<LogRecord> next(std::size_t(lines));
+    std::size_t n = 0;
+    for (std::uint64_t seq = keepFrom; seq < nextSeq_; ++seq)
+        next[n++] = std::move(ring_[std::size_t(seq % ring_.size())]);
+    ring_.swap(next);
+    firstSeq_ = 0;
+    nextSeq_ = n;
+    rebuildVisible();
+    endResetModel();
+}
+
+void LogModel::setMinLevel(LogLevel level)
+{
+    if (level == minLevel_)
+        return;
+    applyPending();
+    beginResetModel();
+    minLevel_ = level;
+    rebuildVisible();
+    endResetModel();
+}
+
+void LogModel::setCategory(const QString& category)
+{
+    if (category == category_)
+        return;
+    applyPending();
+    beginResetModel();
+    category_ = category;
+    rebuildVisible();
+    endResetModel();
+}
+
+QStringList LogModel::categories() const
+{
+    QStringList out = categories_.values();
+    out.sort(Qt::CaseInsensitive);
+    return out;
+}
+
+void LogModel::clear()
+{
+    applyTimer_.stop();
+    beginResetModel();
+    pending_.clear();
+    visible_.clear();
+    std::fill(ring_.begin(), ring_.end(), LogRecord());
+    firstSeq_ = nextSeq_;
+    endResetModel();
+}
+
+QString LogModel::lineAt(int row) const
+{
+    if (row < 0 || std::size_t(row) >= visible_.size())
+        return {};
+    return recordAt(visible_[std::size_t(row)]).line;
+}
+
+void LogModel::rebuildVisible()
+{
+    visible_.clear();
+    for (std::uint64_t seq = firstSeq_; seq < nextSeq_; ++seq)
+    {
+        if (accepts(recordAt(seq)))
+            visible_.push_back(seq);
+    }
+}
+
+bool LogModel::accepts(const LogRecord& rec) const
+{
+    if (int(rec.level) < int(minLevel_))
+        return false;
+    return category_.isEmpty() || rec.category == category_;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "LogSink.h"
+
+// Backing model for the log dock. Incoming records are buffered and applied
+// on a timer as one insert per tick; history lives in a fixed-capacity ring,
+// so the oldest lines fall off the front. Level / category filtering keeps an
+// index of visible sequence numbers and never touches the stored records.
+class LogModel final : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Roles
+    {
+        LevelRole = Qt::UserRole + 1,
+        CategoryRole
+    };
+
+    explicit LogModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    void setMaxHistory(int lines);
+    int maxHistory() const { return int(ring_.size()); }
+    int storedCount() const { return int(nextSeq_ - firstSeq_); }
+
+    void setMinLevel(LogLevel level);
+    // Empty shows every category.
+    void setCategory(const QString& category);
+    QStringList categories() const;
+
+    void clear();
+    QString lineAt(int row) const;
+
+public slots:
+    void append(const QVector<LogRecord>& records);
+
+signals:
+    void categoryAdded(const QString& category);
+
+private:
+    void applyPending();
+    void rebuildVisible();
+    bool accepts(const LogRecord& rec) const;
+    const LogRecord& recordAt(std::uint64_t seq) const { return ring_[std::size_t(seq % ring_.size())]; }
+
+    std::vector<LogRecord> ring_;
+    std::uint64_t firstSeq_ = 0; // oldest stored
+    std::uint64_t nextSeq_ = 0;  // one past newest
+    std::deque<std::uint64_t> visible_;
+    QVector<LogRecord> pending_;
+    QTimer applyTimer_;
+    QSet<QString> categories_;
+
+    LogLevel minLevel_ = LogLevel::Debug;
+    QString category_;
+};
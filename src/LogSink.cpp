@@ -1,7 +1,42 @@
 #include "LogSink.h"
 
 #include <QDateTime>
-#include <QDir>
+
+#include <chrono>
+
+namespace
+{
+    constexpr std::size_t kMaxBatch = 1024;
+    constexpr auto kBatchInterval = std::chrono::milliseconds(50);
+
+    static const char* LevelPrefix(LogLevel level)
+    {
+        switch (level)
+        {
+        case LogLevel::Debug: return "[debug] ";
+        case LogLevel::Info: return "";
+        case LogLevel::Warning: return "[warn] ";
+        case LogLevel::Error: return "[error] ";
+        }
+        return "";
+    }
+}
+
+bool LogSink::RateLimit::allow(std::int64_t nowMs, int* outSuppressed)
+{
+    // Fixed one-second windows; races at a window edge only blur the budget slightly.
+    std::int64_t start = windowStartMs_.load(std::memory_order_relaxed);
+    if (nowMs - start >= 1000 && windowStartMs_.compare_exchange_strong(start, nowMs, std::memory_order_relaxed))
+        used_.store(0, std::memory_order_relaxed);
+
+    if (used_.fetch_add(1, std::memory_order_relaxed) < perSecond_)
+    {
+        *outSuppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
 
 LogSink& LogSink::instance()
 {
@@ -10,13 +45,54 @@ LogSink& LogSink::instance()
 }
 
 LogSink::LogSink(QObject* parent)
-    : QObject(parent)
+    : QObject(parent), ring_(new Slot[kCapacity])
 {
+    for (std::size_t i = 0; i < kCapacity; ++i)
+        ring_[i].seq.store(i, std::memory_order_relaxed);
+    qRegisterMetaType<LogRecord>();
+    qRegisterMetaType<QVector<LogRecord>>();
+
+    // W3PREVIEW_LOG_LEVEL=debug|info|warn|error (default info).
+    LogLevel level = LogLevel::Info;
+    if (ParseLevel(qEnvironmentVariable("W3PREVIEW_LOG_LEVEL"), &level))
+        setMinLevel(level);
+
+    writer_ = std::thread(&LogSink::writerLoop, this);
+}
+
+LogSink::~LogSink()
+{
+    shutdown();
+}
+
+bool LogSink::ParseLevel(const QString& name, LogLevel* outLevel)
+{
+    const QString n = name.trimmed().toLower();
+    if (n == "debug")
+        *outLevel = LogLevel::Debug;
+    else if (n == "info")
+        *outLevel = LogLevel::Info;
+    else if (n == "warn" || n == "warning")
+        *outLevel = LogLevel::Warning;
+    else if (n == "error")
+        *outLevel = LogLevel::Error;
+    else
+        return false;
+    return true;
+}
+
+QString LogSink::CategoryOf(const QString& message)
+{
+    int end = 0;
+    while (end < message.size() && end < 24 && message[end] != ' ' && message[end] != ':')
+        ++end;
+    return end > 0 ? message.left(end) : QString("Other");
 }
 
 void LogSink::init(const QString& logPath)
 {
-    QMutexLocker lock(&mutex_);
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    stream_.setDevice(nullptr);
     if (file_.isOpen())
         file_.close();
 
@@ -25,18 +101,168 @@ void LogSink::init(const QString& logPath)
         stream_.setDevice(&file_);
 }
 
-void LogSink::log(const QString& message)
+void LogSink::log(LogLevel level, const QString& message, RateLimit* limit)
+{
+    if (!isEnabled(level) || stopped_.load(std::memory_order_relaxed))
+        return;
+
+    Message m;
+    m.level = level;
+    m.timeMs = QDateTime::currentMSecsSinceEpoch();
+    if (limit && !limit->allow(m.timeMs, &m.suppressed))
+        return;
+    m.text = message;
+    push(std::move(m));
+}
+
+bool LogSink::push(Message&& message)
 {
-    const QString line = QString("[%1] %2")
-                             .arg(QDateTime::currentDateTime().toString("HH:mm:ss"))
-                             .arg(message);
+    // Bounded MPMC ring (Vyukov); only the writer thread consumes.
+    std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    for (;;)
     {
-        QMutexLocker lock(&mutex_);
-        if (stream_.device())
+        slot = &ring_[pos & (kCapacity - 1)];
+        const std::size_t seq = slot->seq.load(std::memory_order_acquire);
+        const std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+        if (diff == 0)
+        {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
         {
-            stream_ << line << "\n";
-            stream_.flush();
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
         }
+        else
+        {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    const bool urgent = message.level == LogLevel::Error;
+    slot->message = std::move(message);
+    slot->seq.store(pos + 1, std::memory_order_release);
+
+    // The writer wakes on its own every batch interval; only hurry it for errors
+    // or when the ring is filling up.
+    if (urgent || (pos & (kCapacity / 2 - 1)) == 0)
+        wake();
+    return true;
+}
+
+bool LogSink::pop(Message& out)
+{
+    Slot& slot = ring_[dequeuePos_ & (kCapacity - 1)];
+    if (slot.seq.load(std::memory_order_acquire) != dequeuePos_ + 1)
+        return false;
+    out = std::move(slot.message);
+    slot.message.text = QString();
+    slot.seq.store(dequeuePos_ + kCapacity, std::memory_order_release);
+    ++dequeuePos_;
+    return true;
+}
+
+void LogSink::wake()
+{
+    wakeRequested_.store(true, std::memory_order_relaxed);
+    wakeCv_.notify_one();
+}
+
+void LogSink::writerLoop()
+{
+    std::uint64_t reportedDropped = 0;
+    std::int64_t stampSecond = -1;
+    QString stamp;
+
+    for (;;)
+    {
+        QVector<LogRecord> records;
+        Message m;
+        std::size_t n = 0;
+        while (n < kMaxBatch && pop(m))
+        {
+            // Local-time formatting is the slow part; do it once per second.
+            if (m.timeMs / 1000 != stampSecond)
+            {
+                stampSecond = m.timeMs / 1000;
+                stamp = QDateTime::fromMSecsSinceEpoch(m.timeMs).toString("HH:mm:ss");
+            }
+            LogRecord rec;
+            rec.timeMs = m.timeMs;
+            rec.level = m.level;
+            rec.category = CategoryOf(m.text);
+            rec.line = QString("[%1] %2%3").arg(stamp, QString::fromLatin1(LevelPrefix(m.level)), m.text);
+            if (m.suppressed > 0)
+                rec.line += QString(" (+%1 similar suppressed)").arg(m.suppressed);
+            records.push_back(std::move(rec));
+            ++n;
+        }
+
+        const std::uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped != reportedDropped)
+        {
+            LogRecord rec;
+            rec.timeMs = QDateTime::currentMSecsSinceEpoch();
+            rec.level = LogLevel::Warning;
+            rec.category = "Log";
+            rec.line = QString("[%1] [warn] %2 log messages dropped (queue full)")
+                           .arg(QDateTime::fromMSecsSinceEpoch(rec.timeMs).toString("HH:mm:ss"))
+                           .arg(qulonglong(dropped - reportedDropped));
+            records.push_back(std::move(rec));
+            reportedDropped = dropped;
+        }
+
+        if (!records.isEmpty())
+        {
+            {
+                std::lock_guard<std::mutex> lock(fileMutex_);
+                if (stream_.device())
+                {
+                    for (const LogRecord& rec : records)
+                        stream_ << rec.line << "\n";
+                    stream_.flush();
+                }
+            }
+            emit recordsAdded(records);
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        writtenPos_ = dequeuePos_;
+        flushedCv_.notify_all();
+        if (n == kMaxBatch)
+            continue;
+        if (stop_ && n == 0)
+            break;
+        wakeCv_.wait_for(lock, kBatchInterval, [this] {
+            return stop_ || wakeRequested_.load(std::memory_order_relaxed);
+        });
+        wakeRequested_.store(false, std::memory_order_relaxed);
+    }
+}
+
+void LogSink::flush()
+{
+    if (stopped_.load(std::memory_order_relaxed))
+        return;
+    const std::size_t target = enqueuePos_.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(wakeMutex_);
+    wakeRequested_.store(true, std::memory_order_relaxed);
+    wakeCv_.notify_one();
+    // Bounded wait: a producer that claimed a slot but has not published it yet holds the writer back.
+    flushedCv_.wait_for(lock, std::chrono::seconds(2), [&] { return writtenPos_ >= target; });
+}
+
+void LogSink::shutdown()
+{
+    if (stopped_.exchange(true))
+        return;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        stop_ = true;
     }
-    emit messageAdded(line);
+    wakeCv_.notify_one();
+    if (writer_.joinable())
+        writer_.join();
 }
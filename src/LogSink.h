@@ -1,27 +1,126 @@
 #pragma once
 
 #include <QFile>
-#include <QMutex>
+#include <QMetaType>
 #include <QObject>
 #include <QTextStream>
+#include <QVector>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+enum class LogLevel
+{
+    Debug,
+    Info,
+    Warning,
+    Error
+};
+
+struct LogRecord
+{
+    std::int64_t timeMs = 0;
+    LogLevel level = LogLevel::Info;
+    QString category; // leading word of the message: "Texture", "MPQ", "GL", ...
+    QString line;     // formatted as written to the log file
+};
+Q_DECLARE_METATYPE(LogRecord)
+
+// Asynchronous application log. log() never blocks: messages go into a
+// bounded multi-producer ring and a background writer thread timestamps
+// them, appends to the log file with one flush per batch, and forwards each
+// batch to the GUI as a single recordsAdded() signal. When the ring is full
+// new messages are dropped and counted.
 
 class LogSink final : public QObject
 {
     Q_OBJECT
 public:
+    // Per-call-site budget, declared static next to the log call:
+    //     static LogSink::RateLimit limit(10); // lines per second
+    //     LogSink::instance().log(LogLevel::Warning, msg, &limit);
+    // Over-budget calls are counted and reported on the next line that gets through.
+    class RateLimit
+    {
+    public:
+        explicit RateLimit(int perSecond) : perSecond_(perSecond) {}
+        bool allow(std::int64_t nowMs, int* outSuppressed);
+
+    private:
+        const int perSecond_;
+        std::atomic<std::int64_t> windowStartMs_{0};
+        std::atomic<int> used_{0};
+        std::atomic<int> suppressed_{0};
+    };
+
     static LogSink& instance();
 
     void init(const QString& logPath);
-    void log(const QString& message);
+    void log(const QString& message) { log(LogLevel::Info, message); }
+    void log(LogLevel level, const QString& message, RateLimit* limit = nullptr);
+
+    // Lets hot call sites skip building messages that would be filtered anyway.
+    bool isEnabled(LogLevel level) const { return int(level) >= minLevel_.load(std::memory_order_relaxed); }
+    void setMinLevel(LogLevel level) { minLevel_.store(int(level), std::memory_order_relaxed); }
+    static bool ParseLevel(const QString& name, LogLevel* outLevel);
+    static QString CategoryOf(const QString& message);
+
+    // Blocks (briefly) until everything logged before the call is on disk.
+    void flush();
+    // Drains the ring and stops the writer; later messages are discarded.
+    void shutdown();
+
+    std::uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
 
 signals:
-    void messageAdded(const QString& message);
+    // Coalesced: one emission per writer batch, from the writer thread.
+    void recordsAdded(const QVector<LogRecord>& records);
 
 private:
     explicit LogSink(QObject* parent = nullptr);
+    ~LogSink() override;
     Q_DISABLE_COPY_MOVE(LogSink)
 
+    struct Message
+    {
+        LogLevel level = LogLevel::Info;
+        std::int64_t timeMs = 0;
+        int suppressed = 0;
+        QString text;
+    };
+    struct Slot
+    {
+        std::atomic<std::size_t> seq{0};
+        Message message;
+    };
+
+    bool push(Message&& message);
+    bool pop(Message& out);
+    void writerLoop();
+    void wake();
+
+    static constexpr std::size_t kCapacity = 8192; // power of two
+    std::unique_ptr<Slot[]> ring_;
+    std::atomic<std::size_t> enqueuePos_{0};
+    std::size_t dequeuePos_ = 0; // writer thread only
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<int> minLevel_{int(LogLevel::Info)};
+
+    // Writer side. Producers only ever notify; they never take these locks.
+    std::mutex fileMutex_; // init() vs writer
     QFile file_;
     QTextStream stream_;
-    QMutex mutex_;
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCv_;
+    std::condition_variable flushedCv_;
+    std::size_t writtenPos_ = 0; // guarded by wakeMutex_
+    bool stop_ = false;          // guarded by wakeMutex_
+    std::atomic<bool> wakeRequested_{false};
+    std::atomic<bool> stopped_{false};
+    std::thread writer_;
 };
@@ -28,35 +28,67 @@
 #include <QGroupBox>
 #include <QFrame>
 #include <QDoubleSpinBox>
+#include <QSpinBox>
+#include <QScrollBar>
+#include <QAction>
+#include <QClipboard>
 #include <QCheckBox>
 #include <QFormLayout>
 #include <QSignalBlocker>
 #include <QTextStream>
 #include <QtConcurrent/QtConcurrent>
 
+#include <algorithm>
+
+#include "FilterIndex.h"
 #include "GLModelView.h"
+#include "LogModel.h"
 #include "MdxLoader.h"
 #include "LogSink.h"
+#include "MdlWriter.h"
+#include "MeshOptimizer.h"
+#include "RowFilterProxyModel.h"
+#include "Trace.h"
 #include "Vfs.h"
 
 namespace
 {
-    static QStringList ScanMdxFiles(const QString& folder)
+    static QString DisplayNameFromPath(const QString& baseFolder, const QString& path)
+    {
+        QDir base(baseFolder);
+        const QString rel = base.relativeFilePath(path);
+        return rel.isEmpty() ? QFileInfo(path).fileName() : rel;
+    }
+
+    static FolderScanResult ScanMdxFiles(const QString& folder)
     {
-        QStringList out;
+        Trace::Scope trace("scan", "ScanMdxFiles", folder);
+        FolderScanResult result;
         QDirIterator it(folder, QStringList() << "*.mdx" << "*.MDX",
                         QDir::Files, QDirIterator::Subdirectories);
         while (it.hasNext())
-            out << it.next();
-        out.sort(Qt::CaseInsensitive);
-        return out;
+            result.files << it.next();
+        result.files.sort(Qt::CaseInsensitive);
+
+        // Display names and the filter index are built here so the GUI thread only creates items.
+        result.displayNames.reserve(result.files.size());
+        for (const auto& p : result.files)
+            result.displayNames << DisplayNameFromPath(folder, p);
+        auto index = std::make_shared<FilterIndex>();
+        index->build(result.displayNames);
+        result.index = std::move(index);
+        return result;
     }
 
-    static QString DisplayNameFromPath(const QString& baseFolder, const QString& path)
+    static FilterResult RunFilter(std::shared_ptr<const FilterIndex> index, QString query,
+                                  std::vector<int> scope, bool refine, int token)
     {
-        QDir base(baseFolder);
-        const QString rel = base.relativeFilePath(path);
-        return rel.isEmpty() ? QFileInfo(path).fileName() : rel;
+        FilterResult result;
+        result.query = query;
+        result.token = token;
+        if (index)
+            result.rows = index->match(query, refine ? &scope : nullptr, &result.complete);
+        return result;
     }
 
     static QIcon MakePlaceholderThumb(const QString& text, int size)
@@ -81,240 +113,17 @@ namespace
 
     static ModelLoadResult LoadModelFile(const QString& filePath, int token)
     {
+        Trace::Scope trace("load", "LoadModelFile", filePath);
         ModelLoadResult result;
         result.path = filePath;
         result.token = token;
         QString err;
-        result.model = MdxLoader::LoadFromFile(filePath, &err);
+        result.model = MdxLoader::LoadFromFile(filePath, &err, &result.timing);
+        if (result.model)
+            MeshOptimizer::OptimizeModel(*result.model, &result.timing);
         result.error = err;
         return result;
     }
-
-    static QString filterModeName(std::uint32_t mode)
-    {
-        switch (mode)
-        {
-        case 0: return "None";
-        case 1: return "Transparent";
-        case 2: return "Blend";
-        case 3: return "Additive";
-        case 4: return "AddAlpha";
-        case 5: return "Modulate";
-        case 6: return "Modulate2x";
-        default: return "Blend";
-        }
-    }
-
-    static void writeMdxAsMdl(const ModelData& model, const QString& path, const QString& name)
-    {
-        QFile f(path);
-        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
-            return;
-
-        QTextStream ts(&f);
-        const int formatVersion = (model.mdxVersion >= 1000) ? 1000 : 800;
-        ts << "Version {\n\tFormatVersion " << formatVersion << ",\n}\n";
-        ts << "Model \"" << name << "\" {\n";
-        ts << "\tNumGeosets " << model.geosetDiagnostics.size() << ",\n";
-        ts << "\tNumGeosetAnims 0,\n";
-
-        int bones = 0, helpers = 0, attachments = 0;
-        for (const auto& n : model.nodes)
-        {
-            if (n.type == "BONE")
-                bones++;
-            else if (n.type == "HELP")
-                helpers++;
-            else if (n.type == "ATCH")
-                attachments++;
-            else
-                helpers++;
-        }
-        if (bones > 0) ts << "\tNumBones " << bones << ",\n";
-        if (helpers > 0) ts << "\tNumHelpers " << helpers << ",\n";
-        if (attachments > 0) ts << "\tNumAttachments " << attachments << ",\n";
-
-        if (model.hasBounds)
-        {
-            ts << "\tMinimumExtent { " << model.boundsMin[0] << ", " << model.boundsMin[1] << ", " << model.boundsMin[2] << " },\n";
-            ts << "\tMaximumExtent { " << model.boundsMax[0] << ", " << model.boundsMax[1] << ", " << model.boundsMax[2] << " },\n";
-        }
-        ts << "}\n";
-
-        if (!model.sequences.empty())
-        {
-            ts << "Sequences " << model.sequences.size() << " {\n";
-            for (const auto& s : model.sequences)
-            {
-                ts << "\tAnim \"" << QString::fromStdString(s.name) << "\" {\n";
-                ts << "\t\tInterval { " << s.startMs << ", " << s.endMs << " },\n";
-                if (s.flags & 1)
-                    ts << "\t\tNonLooping,\n";
-                ts << "\t}\n";
-            }
-            ts << "}\n";
-        }
-
-        if (!model.textures.empty())
-        {
-            ts << "Textures " << model.textures.size() << " {\n";
-            for (const auto& t : model.textures)
-            {
-                ts << "\tBitmap {\n";
-                if (!t.fileName.empty())
-                    ts << "\t\tImage \"" << QString::fromStdString(t.fileName) << "\",\n";
-                if (t.replaceableId != 0)
-                    ts << "\t\tReplaceableId " << t.replaceableId << ",\n";
-                ts << "\t\tWrapWidth,\n\t\tWrapHeight,\n";
-                ts << "\t}\n";
-            }
-            ts << "}\n";
-        }
-
-        if (!model.materials.empty())
-        {
-            ts << "Materials " << model.materials.size() << " {\n";
-            for (const auto& m : model.materials)
-            {
-                ts << "\tMaterial {\n";
-                ts << "\t\tLayer {\n";
-                ts << "\t\t\tFilterMode " << filterModeName(m.layer.filterMode) << ",\n";
-                ts << "\t\t\tstatic TextureID " << m.layer.textureId << ",\n";
-                ts << "\t\t\tAlpha " << m.layer.alpha << ",\n";
-                ts << "\t\t}\n";
-                ts << "\t}\n";
-            }
-            ts << "}\n";
-        }
-
-        for (std::size_t gi = 0; gi < model.geosetDiagnostics.size(); ++gi)
-        {
-            const auto& gd = model.geosetDiagnostics[gi];
-            ts << "Geoset {\n";
-            ts << "\tVertices " << gd.vertexCount << " {\n";
-            for (std::uint32_t i = 0; i < gd.vertexCount; ++i)
-            {
-                const auto& v = model.vertices[gd.baseVertex + i];
-                ts << "\t\t{ " << v.px << ", " << v.py << ", " << v.pz << " },\n";
-            }
-            ts << "\t}\n";
-            ts << "\tNormals " << gd.vertexCount << " {\n";
-            for (std::uint32_t i = 0; i < gd.vertexCount; ++i)
-            {
-                const auto& v = model.vertices[gd.baseVertex + i];
-                ts << "\t\t{ " << v.nx << ", " << v.ny << ", " << v.nz << " },\n";
-            }
-            ts << "\t}\n";
-            ts << "\tTVertices " << gd.vertexCount << " {\n";
-            for (std::uint32_t i = 0; i < gd.vertexCount; ++i)
-            {
-                const auto& v = model.vertices[gd.baseVertex + i];
-                ts << "\t\t{ " << v.u << ", " << v.v << " },\n";
-            }
-            ts << "\t}\n";
-
-            ts << "\tVertexGroup {\n";
-            for (std::uint8_t vg : gd.gndx)
-                ts << "\t\t" << int(vg) << ",\n";
-            ts << "\t}\n";
-
-            ts << "\tFaces 1 " << gd.indexCount << " {\n\t\tTriangles {\n\t\t\t{ ";
-            for (std::uint32_t i = 0; i < gd.indexCount; ++i)
-            {
-                const std::uint32_t idx = model.indices[gd.indexOffset + i] - gd.baseVertex;
-                ts << idx;
-                if (i + 1 < gd.indexCount)
-                    ts << ", ";
-            }
-            ts << " },\n\t\t}\n\t}\n";
-
-            ts << "\tGroups " << gd.mtgc.size() << " " << gd.mats.size() << " {\n";
-            if (!gd.expandedGroups.empty())
-            {
-                for (const auto& group : gd.expandedGroups)
-                {
-                    ts << "\t\tMatrices { ";
-                    for (int i = 0; i < int(group.size()); ++i)
-                    {
-                        ts << group[std::size_t(i)];
-                        if (i + 1 < int(group.size()))
-                            ts << ", ";
-                    }
-                    ts << " },\n";
-                }
-            }
-            else
-            {
-                std::size_t offset = 0;
-                for (std::uint32_t sz : gd.mtgc)
-                {
-                    ts << "\t\tMatrices { ";
-                    for (std::uint32_t k = 0; k < sz && offset < gd.mats.size(); ++k, ++offset)
-                    {
-                        ts << gd.mats[offset];
-                        if (k + 1 < sz && offset + 1 < gd.mats.size())
-                            ts << ", ";
-                    }
-                    ts << " },\n";
-                }
-            }
-            ts << "\t}\n";
-            ts << "\tMaterialID " << gd.materialId << ",\n";
-            ts << "\tSelectionGroup 0,\n";
-            ts << "}\n";
-        }
-
-        if (!model.nodes.empty())
-        {
-            for (const auto& n : model.nodes)
-            {
-                QString type = QString::fromStdString(n.type);
-                if (type.isEmpty())
-                    type = "Helper";
-                if (type == "BONE")
-                    type = "Bone";
-                else if (type == "HELP")
-                    type = "Helper";
-                else if (type == "ATCH")
-                    type = "Attachment";
-                else
-                    type = "Helper";
-
-                const QString nodeName = QString::fromStdString(n.name);
-                ts << type << " \"" << nodeName << "\" {\n";
-                ts << "\tObjectId " << n.objectId << ",\n";
-                if (n.parentId >= 0)
-                    ts << "\tParent " << n.parentId << ",\n";
-                ts << "\tPivotPoint { " << n.pivot.x << ", " << n.pivot.y << ", " << n.pivot.z << " },\n";
-                if (type == "Bone")
-                {
-                    ts << "\tGeosetId -1,\n";
-                    ts << "\tGeosetAnimId -1,\n";
-                }
-                if (type == "Attachment")
-                {
-                    ts << "\tPath \"\",\n";
-                    ts << "\tAttachmentID 0,\n";
-                }
-                ts << "}\n";
-            }
-        }
-
-        if (!model.pivots.empty())
-        {
-            ts << "PivotPoints " << model.pivots.size() << " {\n";
-            for (const auto& p : model.pivots)
-                ts << "\t{ " << p.x << ", " << p.y << ", " << p.z << " },\n";
-            ts << "}\n";
-        }
-        else if (!model.nodes.empty())
-        {
-            ts << "PivotPoints " << model.nodes.size() << " {\n";
-            for (const auto& n : model.nodes)
-                ts << "\t{ " << n.pivot.x << ", " << n.pivot.y << ", " << n.pivot.z << " },\n";
-            ts << "}\n";
-        }
-    }
 }
 
 MainWindow::MainWindow(QWidget* parent)
@@ -322,10 +131,17 @@ MainWindow::MainWindow(QWidget* parent)
 {
     buildUi();
 
-    connect(&scanWatcher_, &QFutureWatcher<QStringList>::finished,
+    connect(&scanWatcher_, &QFutureWatcher<FolderScanResult>::finished,
             this, &MainWindow::onFolderScanFinished);
     connect(&modelWatcher_, &QFutureWatcher<ModelLoadResult>::finished,
             this, &MainWindow::onModelLoadFinished);
+    connect(&filterWatcher_, &QFutureWatcher<FilterResult>::finished,
+            this, &MainWindow::onFilterFinished);
+
+    // Debounce keystrokes so a burst of typing runs one filter pass.
+    filterTimer_.setSingleShot(true);
+    filterTimer_.setInterval(150);
+    connect(&filterTimer_, &QTimer::timeout, this, &MainWindow::startFilter);
 
     diskVfs_ = std::make_shared<DiskVfs>(QString());
     mpqVfs_ = std::make_shared<MpqVfs>();
@@ -344,6 +160,10 @@ MainWindow::~MainWindow()
 {
     scanWatcher_.cancel();
     scanWatcher_.waitForFinished();
+    filterWatcher_.waitForFinished();
+
+    if (loadReport_.size() > 0)
+        LogSink::instance().log(loadReport_.formatSlowest(10).trimmed());
 }
 
 void MainWindow::buildUi()
@@ -362,12 +182,16 @@ void MainWindow::buildUi()
     btnFolder_ = new QPushButton("Open Folder...");
     btnResetView_ = new QPushButton("Reset View");
     btnExportDiag_ = new QPushButton("Export Diagnostics...");
+    btnSaveTrace_ = new QPushButton("Save Trace...");
+    btnLoadReport_ = new QPushButton("Load Report...");
     lblFolder_ = new QLabel("<no folder>");
     lblFolder_->setTextInteractionFlags(Qt::TextSelectableByMouse);
 
     top->addWidget(btnFolder_, 0);
     top->addWidget(btnResetView_, 0);
     top->addWidget(btnExportDiag_, 0);
+    top->addWidget(btnSaveTrace_, 0);
+    top->addWidget(btnLoadReport_, 0);
     top->addWidget(lblFolder_, 1);
     root->addLayout(top);
 
@@ -581,14 +405,94 @@ void MainWindow::buildUi()
     statusBar()->addWidget(statusLabel_, 1);
     mpqStatusLabel_ = new QLabel("MPQ mounted: 0");
     statusBar()->addPermanentWidget(mpqStatusLabel_);
+    loadTimingLabel_ = new QLabel();
+    loadTimingLabel_->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    statusBar()->addPermanentWidget(loadTimingLabel_);
 
     // Log dock
     logDock_ = new QDockWidget("Log", this);
     logDock_->setAllowedAreas(Qt::BottomDockWidgetArea | Qt::TopDockWidgetArea);
-    logView_ = new QPlainTextEdit();
-    logView_->setReadOnly(true);
-    logView_->setLineWrapMode(QPlainTextEdit::NoWrap);
-    logDock_->setWidget(logView_);
+    {
+        auto* logPanel = new QWidget();
+        auto* logLayout = new QVBoxLayout(logPanel);
+        logLayout->setContentsMargins(4, 4, 4, 4);
+        logLayout->setSpacing(4);
+
+        auto* logBar = new QHBoxLayout();
+        logLevelCombo_ = new QComboBox();
+        logLevelCombo_->addItem("Debug", int(LogLevel::Debug));
+        logLevelCombo_->addItem("Info", int(LogLevel::Info));
+        logLevelCombo_->addItem("Warning", int(LogLevel::Warning));
+        logLevelCombo_->addItem("Error", int(LogLevel::Error));
+        logCategoryCombo_ = new QComboBox();
+        logCategoryCombo_->addItem("All categories", QString());
+        logCategoryCombo_->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+        logHistorySpin_ = new QSpinBox();
+        logHistorySpin_->setRange(1000, 1000000);
+        logHistorySpin_->setSingleStep(5000);
+        logHistorySpin_->setSuffix(" lines");
+        auto* btnClearLog = new QPushButton("Clear");
+        logBar->addWidget(new QLabel("Level"));
+        logBar->addWidget(logLevelCombo_);
+        logBar->addWidget(logCategoryCombo_);
+        logBar->addWidget(new QLabel("History"));
+        logBar->addWidget(logHistorySpin_);
+        logBar->addStretch(1);
+        logBar->addWidget(btnClearLog);
+        logLayout->addLayout(logBar);
+
+        logModel_ = new LogModel(this);
+        logHistorySpin_->setValue(logModel_->maxHistory());
+        logView_ = new QListView();
+        logView_->setModel(logModel_);
+        logView_->setUniformItemSizes(true);
+        logView_->setSelectionMode(QAbstractItemView::ExtendedSelection);
+        logView_->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+        logLayout->addWidget(logView_, 1);
+
+        auto* copyLog = new QAction("Copy", logView_);
+        copyLog->setShortcut(QKeySequence::Copy);
+        copyLog->setShortcutContext(Qt::WidgetShortcut);
+        logView_->addAction(copyLog);
+        logView_->setContextMenuPolicy(Qt::ActionsContextMenu);
+        connect(copyLog, &QAction::triggered, this, [this](){
+            QModelIndexList rows = logView_->selectionModel()->selectedRows();
+            std::sort(rows.begin(), rows.end());
+            QStringList lines;
+            for (const QModelIndex& idx : rows)
+                lines << logModel_->lineAt(idx.row());
+            QApplication::clipboard()->setText(lines.join('\n'));
+        });
+
+        connect(logLevelCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int){
+            logModel_->setMinLevel(LogLevel(logLevelCombo_->currentData().toInt()));
+        });
+        connect(logCategoryCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int){
+            logModel_->setCategory(logCategoryCombo_->currentData().toString());
+        });
+        connect(logHistorySpin_, QOverload<int>::of(&QSpinBox::valueChanged), logModel_, &LogModel::setMaxHistory);
+        connect(btnClearLog, &QPushButton::clicked, logModel_, &LogModel::clear);
+        connect(logModel_, &LogModel::categoryAdded, this, [this](const QString& category){
+            // Keep "All categories" first and the rest sorted.
+            int at = 1;
+            while (at < logCategoryCombo_->count() &&
+                   QString::compare(logCategoryCombo_->itemText(at), category, Qt::CaseInsensitive) < 0)
+                ++at;
+            logCategoryCombo_->insertItem(at, category, category);
+        });
+
+        // Follow the tail only while the view is scrolled to the bottom.
+        connect(logModel_, &QAbstractItemModel::rowsAboutToBeInserted, this, [this](){
+            const QScrollBar* bar = logView_->verticalScrollBar();
+            logFollowTail_ = bar->value() >= bar->maximum();
+        });
+        connect(logModel_, &QAbstractItemModel::rowsInserted, this, [this](){
+            if (logFollowTail_)
+                logView_->scrollToBottom();
+        });
+
+        logDock_->setWidget(logPanel);
+    }
     addDockWidget(Qt::BottomDockWidgetArea, logDock_);
 
     // Missing textures dock
@@ -602,12 +506,8 @@ void MainWindow::buildUi()
 
     // Models
     listModel_ = new QStandardItemModel(this);
-    proxyModel_ = new QSortFilterProxyModel(this);
+    proxyModel_ = new RowFilterProxyModel(this);
     proxyModel_->setSourceModel(listModel_);
-    proxyModel_->setFilterCaseSensitivity(Qt::CaseInsensitive);
-    proxyModel_->setSortCaseSensitivity(Qt::CaseInsensitive);
-    proxyModel_->setDynamicSortFilter(true);
-    proxyModel_->sort(0);
 
     list_->setModel(proxyModel_);
     grid_->setModel(proxyModel_);
@@ -619,6 +519,8 @@ void MainWindow::buildUi()
             viewer_->resetView();
     });
     connect(btnExportDiag_, &QPushButton::clicked, this, &MainWindow::exportDiagnostics);
+    connect(btnSaveTrace_, &QPushButton::clicked, this, &MainWindow::saveTrace);
+    connect(btnLoadReport_, &QPushButton::clicked, this, &MainWindow::saveLoadReport);
     connect(btnWar3Browse_, &QPushButton::clicked, this, [this](){
         const QString folder = QFileDialog::getExistingDirectory(this, "Choose Warcraft III Root", editWar3Root_->text());
         if (!folder.isEmpty())
@@ -633,15 +535,13 @@ void MainWindow::buildUi()
     connect(viewer_, &GLModelView::statusTextChanged, this, [this](const QString& t){
         statusLabel_->setText(t);
     });
+    connect(viewer_, &GLModelView::firstFrameRendered, this, &MainWindow::onFirstFrameRendered);
     connect(viewer_, &GLModelView::missingTexturesChanged, this, [this](const QStringList& list){
         if (!missingView_)
             return;
         missingView_->setPlainText(list.join("\n\n"));
     });
-    connect(&LogSink::instance(), &LogSink::messageAdded, this, [this](const QString& line){
-        if (logView_)
-            logView_->appendPlainText(line);
-    });
+    connect(&LogSink::instance(), &LogSink::recordsAdded, logModel_, &LogModel::append);
 
     connect(speedSlider_, &QSlider::valueChanged, this, [this](int v){
         const float s = float(v) / 100.0f;
@@ -727,6 +627,11 @@ void MainWindow::startScanFolder(const QString& folder)
     statusLabel_->setText("Scanning for .mdx files...");
 
     files_.clear();
+    filterIndex_.reset();
+    ++filterToken_;
+    lastFilterQuery_.clear();
+    lastFilterRows_.clear();
+    currentModelPath_.clear();
     listModel_->clear();
     viewer_->setModel(std::nullopt, "No model loaded", QString());
 
@@ -735,21 +640,34 @@ void MainWindow::startScanFolder(const QString& folder)
 
 void MainWindow::onFolderScanFinished()
 {
-    files_ = scanWatcher_.result();
+    const FolderScanResult result = scanWatcher_.result();
+    files_ = result.files;
+    filterIndex_ = result.index;
 
     listModel_->clear();
     listModel_->setColumnCount(1);
-    for (const auto& p : files_)
+    QList<QStandardItem*> items;
+    items.reserve(files_.size());
+    for (int i = 0; i < files_.size(); ++i)
     {
-        const QString display = DisplayNameFromPath(currentFolder_, p);
+        const QString& display = result.displayNames[i];
         auto* item = new QStandardItem(display);
-        item->setData(p, Qt::UserRole);
+        item->setData(files_[i], Qt::UserRole);
         item->setEditable(false);
         item->setIcon(MakePlaceholderThumb(display, 128));
-        listModel_->appendRow(item);
+        items << item;
     }
+    // One insertion instead of a rowsInserted per file.
+    listModel_->invisibleRootItem()->appendRows(items);
     statusLabel_->setText(QString("Found %1 .mdx files. Select one to preview.").arg(files_.size()));
 
+    if (!editFilter_->text().trimmed().isEmpty())
+    {
+        filterTimer_.stop();
+        startFilter();
+        return;
+    }
+
     if (!files_.isEmpty())
     {
         const QModelIndex first = proxyModel_->index(0, 0);
@@ -759,10 +677,72 @@ void MainWindow::onFolderScanFinished()
 
 void MainWindow::onFilterTextChanged(const QString& text)
 {
-    proxyModel_->setFilterFixedString(text);
+    if (text.trimmed().isEmpty())
+    {
+        // Clearing the filter is cheap; apply it right away.
+        filterTimer_.stop();
+        ++filterToken_;
+        applyFilterRows(QString(), {});
+        return;
+    }
+    filterTimer_.start();
+}
 
-    if (proxyModel_->rowCount() > 0)
-        list_->setCurrentIndex(proxyModel_->index(0, 0));
+void MainWindow::startFilter()
+{
+    const QString query = editFilter_->text().trimmed();
+    if (query.isEmpty() || !filterIndex_)
+        return;
+
+    // A query that extends the last applied one only needs to re-check its matches.
+    const bool refine = !lastFilterQuery_.isEmpty() &&
+                        query.startsWith(lastFilterQuery_, Qt::CaseInsensitive);
+    const int token = ++filterToken_;
+    filterWatcher_.setFuture(QtConcurrent::run(RunFilter, filterIndex_, query,
+                                               refine ? lastFilterRows_ : std::vector<int>(),
+                                               refine, token));
+}
+
+void MainWindow::onFilterFinished()
+{
+    FilterResult result = filterWatcher_.result();
+    if (result.token != filterToken_)
+        return;
+    applyFilterRows(result.query, std::move(result.rows), result.complete);
+}
+
+void MainWindow::applyFilterRows(const QString& query, std::vector<int> rows, bool complete)
+{
+    int currentSourceRow = -1;
+    const QModelIndex current = list_->currentIndex();
+    if (current.isValid())
+        currentSourceRow = proxyModel_->mapToSource(current).row();
+
+    // Only a full result can scope the next, longer query; a capped one
+    // would drop rows that only match it fuzzily.
+    lastFilterQuery_ = complete ? query : QString();
+    if (query.isEmpty())
+    {
+        lastFilterRows_.clear();
+        proxyModel_->clearRows();
+    }
+    else
+    {
+        lastFilterRows_ = complete ? rows : std::vector<int>();
+        proxyModel_->setRows(std::move(rows));
+    }
+
+    if (!query.isEmpty())
+        statusLabel_->setText(QString("Filter \"%1\": %2 of %3 files").arg(query).arg(proxyModel_->rowCount()).arg(files_.size()));
+
+    // Keep the current model selected if it survived the filter.
+    QModelIndex next;
+    if (currentSourceRow >= 0)
+        next = proxyModel_->mapFromSource(listModel_->index(currentSourceRow, 0));
+    if (!next.isValid() && proxyModel_->rowCount() > 0)
+        next = proxyModel_->index(0, 0);
+    if (next.isValid())
+        list_->setCurrentIndex(next);
 }
 
 void MainWindow::onSelectionChanged(const QModelIndex& current, const QModelIndex& /*previous*/)
@@ -772,7 +752,7 @@ void MainWindow::onSelectionChanged(const QModelIndex& current, const QModelInde
 
     const QModelIndex src = proxyModel_->mapToSource(current);
     const QString filePath = src.data(Qt::UserRole).toString();
-    if (filePath.isEmpty())
+    if (filePath.isEmpty() || filePath == currentModelPath_)
         return;
 
     loadSelectedModel(filePath);
@@ -783,6 +763,7 @@ void MainWindow::onModelLoadFinished()
     const ModelLoadResult result = modelWatcher_.result();
     if (result.token != loadToken_)
         return;
+    Trace::Scope trace("gui", "ModelLoadFinished", result.path);
 
     const QString displayName = QFileInfo(result.path).fileName();
     if (lblModelName_)
@@ -790,11 +771,12 @@ void MainWindow::onModelLoadFinished()
 
     if (!result.model)
     {
+        pendingTimingPath_.clear();
         viewer_->setModel(std::nullopt, displayName, result.path);
         statusLabel_->setText(QString("%1 | load failed: %2")
                                   .arg(displayName)
                                   .arg(result.error));
-        LogSink::instance().log(QString("Load failed: %1 | %2").arg(result.path, result.error));
+        LogSink::instance().log(LogLevel::Warning, QString("Load failed: %1 | %2").arg(result.path, result.error));
         if (animCombo_)
         {
             const QSignalBlocker block(*animCombo_);
@@ -808,6 +790,9 @@ void MainWindow::onModelLoadFinished()
     auto shared = std::make_shared<ModelData>(std::move(*result.model));
     modelCache_.insert(result.path, shared);
 
+    pendingTiming_ = result.timing;
+    pendingTimingPath_ = result.path;
+
     viewer_->setModel(std::optional<ModelData>(*shared), displayName, result.path);
     LogSink::instance().log(QString("Loaded model: %1 | verts %2 | tris %3")
                                 .arg(result.path)
@@ -847,7 +832,7 @@ void MainWindow::onWar3RootChanged()
     {
         if (mpqStatusLabel_)
             mpqStatusLabel_->setText("MPQ mounted: 0");
-        LogSink::instance().log(QString("War3 root not found: %1").arg(root));
+        LogSink::instance().log(LogLevel::Warning, QString("War3 root not found: %1").arg(root));
         return;
     }
 
@@ -856,7 +841,76 @@ void MainWindow::onWar3RootChanged()
     if (mpqStatusLabel_)
         mpqStatusLabel_->setText(QString("MPQ mounted: %1").arg(count));
     if (!mounted)
-        LogSink::instance().log(QString("No MPQ archives mounted from: %1").arg(root));
+        LogSink::instance().log(LogLevel::Warning, QString("No MPQ archives mounted from: %1").arg(root));
+}
+
+void MainWindow::saveTrace()
+{
+    const QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
+    const QString defaultPath = QDir(QDir::current()).filePath(QString("logs/trace_%1.json").arg(timestamp));
+    const QString path = QFileDialog::getSaveFileName(this, "Save Trace", defaultPath, "Chrome trace (*.json)");
+    if (path.isEmpty())
+        return;
+
+    QString err;
+    if (!Trace::WriteChromeJson(path, &err))
+    {
+        QMessageBox::warning(this, "Save Trace", err);
+        return;
+    }
+    LogSink::instance().log(QString("Trace saved: %1").arg(path));
+}
+
+void MainWindow::onFirstFrameRendered(const LoadTiming& viewTiming)
+{
+    // Cache hits and stale loads carry no loader stages; only full loads are reported.
+    if (pendingTimingPath_.isEmpty() || pendingTimingPath_ != currentModelPath_)
+        return;
+
+    LoadTiming timing = pendingTiming_;
+    timing.gpuUploadMs = viewTiming.gpuUploadMs;
+    timing.textureResolveMs = viewTiming.textureResolveMs;
+    timing.textureDecodeMs = viewTiming.textureDecodeMs;
+    timing.textureUploadMs = viewTiming.textureUploadMs;
+    timing.textures = viewTiming.textures;
+    timing.firstFrameMs = viewTiming.firstFrameMs;
+    timing.totalMs = double(loadRequestTimer_.nsecsElapsed()) / 1.0e6;
+    loadReport_.add(pendingTimingPath_, timing);
+
+    const QString summary = timing.summary();
+    if (loadTimingLabel_)
+    {
+        loadTimingLabel_->setText(QString("Load %1 ms").arg(timing.totalMs, 0, 'f', 1));
+        loadTimingLabel_->setToolTip(summary);
+    }
+    statusBar()->showMessage(summary, 8000);
+    LogSink::instance().log(QString("Load timing: %1 | %2").arg(pendingTimingPath_, summary));
+    pendingTimingPath_.clear();
+}
+
+void MainWindow::saveLoadReport()
+{
+    if (loadReport_.size() == 0)
+    {
+        QMessageBox::information(this, "Load Report", "No models have been loaded in this session yet.");
+        return;
+    }
+
+    const QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
+    const QString defaultPath = QDir(QDir::current()).filePath(QString("logs/load_report_%1.csv").arg(timestamp));
+    const QString path = QFileDialog::getSaveFileName(this, "Save Load Report", defaultPath, "CSV (*.csv)");
+    if (path.isEmpty())
+        return;
+
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        QMessageBox::warning(this, "Load Report", QString("Cannot write: %1").arg(path));
+        return;
+    }
+    f.write(loadReport_.toCsv());
+    LogSink::instance().log(loadReport_.formatSlowest(20).trimmed());
+    LogSink::instance().log(QString("Load report saved: %1").arg(path));
 }
 
 void MainWindow::exportDiagnostics()
@@ -882,6 +936,7 @@ void MainWindow::exportDiagnostics()
             QFile::copy(src, dst);
     };
 
+    LogSink::instance().flush();
     copyFile(QDir(QDir::current()).filePath("logs/latest.log"), "logs/latest.log");
     copyFile(QDir(QDir::current()).filePath("out/mdx_debug.log"), "logs/mdx_debug.log");
     copyFile(QDir(QDir::current()).filePath("README.md"), "README.md");
@@ -1039,7 +1094,7 @@ void MainWindow::exportDiagnostics()
 
                 const QString mdlOut = QDir(diagDir).filePath(QString("%1_from_mdx.mdl")
                                                                   .arg(QFileInfo(selectedPath).completeBaseName()));
-                writeMdxAsMdl(*model, mdlOut, QFileInfo(selectedPath).fileName());
+                MdlWriter::WriteModel(*model, mdlOut, QFileInfo(selectedPath).fileName());
 
                 if (viewer_)
                 {
@@ -1051,6 +1106,15 @@ void MainWindow::exportDiagnostics()
         }
     }
 
+    // Load / render timeline (open in ui.perfetto.dev or chrome://tracing).
+    QDir().mkpath(QDir(stagingRoot).filePath("diagnostics"));
+    Trace::WriteChromeJson(QDir(stagingRoot).filePath("diagnostics/trace.json"));
+    {
+        QFile reportFile(QDir(stagingRoot).filePath("diagnostics/load_report.csv"));
+        if (reportFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            reportFile.write(loadReport_.toCsv());
+    }
+
     const QString cmd = QString("Compress-Archive -Force -Path \"%1\\*\" -DestinationPath \"%2\"")
                             .arg(stagingRoot)
                             .arg(zipPath);
@@ -1058,7 +1122,7 @@ void MainWindow::exportDiagnostics()
     if (code != 0)
     {
         QMessageBox::warning(this, "Export Diagnostics", "Failed to create diagnostics zip.");
-        LogSink::instance().log(QString("Diagnostics export failed: %1").arg(zipPath));
+        LogSink::instance().log(LogLevel::Error, QString("Diagnostics export failed: %1").arg(zipPath));
         return;
     }
 
@@ -1068,6 +1132,9 @@ void MainWindow::exportDiagnostics()
 
 void MainWindow::loadSelectedModel(const QString& filePath)
 {
+    currentModelPath_ = filePath;
+    pendingTimingPath_.clear();
+    loadRequestTimer_.start();
     const QString displayName = QFileInfo(filePath).fileName();
     if (lblModelName_)
         lblModelName_->setText(displayName);
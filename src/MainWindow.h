@@ -3,11 +3,14 @@
 #include <QFutureWatcher>
 #include <QStandardItemModel>
 #include <QModelIndex>
-#include <QSortFilterProxyModel>
+#include <QTimer>
+#include <QElapsedTimer>
 #include <optional>
 #include <memory>
+#include <vector>
 #include <QHash>
 
+#include "LoadTiming.h"
 #include "ModelData.h"
 
 class QListView;
@@ -20,17 +23,37 @@ class QComboBox;
 class QCheckBox;
 class QDockWidget;
 class QPlainTextEdit;
+class QSpinBox;
 class QTabWidget;
 class GLModelView;
 class CompositeVfs;
 class DiskVfs;
 class MpqVfs;
+class FilterIndex;
+class RowFilterProxyModel;
+class LogModel;
 struct ModelLoadResult
 {
     QString path;
     std::optional<ModelData> model;
     QString error;
     int token = 0;
+    LoadTiming timing; // read / parse / post; the viewer adds the rest
+};
+
+struct FolderScanResult
+{
+    QStringList files;
+    QStringList displayNames;
+    std::shared_ptr<const FilterIndex> index;
+};
+
+struct FilterResult
+{
+    QString query;
+    std::vector<int> rows;
+    bool complete = true; // see FilterIndex::match
+    int token = 0;
 };
 
 class MainWindow final : public QMainWindow
@@ -45,14 +68,20 @@ private slots:
     void onFolderScanFinished();
     void onSelectionChanged(const QModelIndex& current, const QModelIndex& previous);
     void onFilterTextChanged(const QString& text);
+    void onFilterFinished();
     void onModelLoadFinished();
     void exportDiagnostics();
+    void saveTrace();
+    void saveLoadReport();
+    void onFirstFrameRendered(const LoadTiming& viewTiming);
     void onWar3RootChanged();
 
 private:
     void buildUi();
     void startScanFolder(const QString& folder);
     void loadSelectedModel(const QString& filePath);
+    void startFilter();
+    void applyFilterRows(const QString& query, std::vector<int> rows, bool complete = true);
 
     QString currentFolder_;
     QStringList files_;
@@ -62,6 +91,8 @@ private:
     QPushButton* btnFolder_ = nullptr;
     QPushButton* btnResetView_ = nullptr;
     QPushButton* btnExportDiag_ = nullptr;
+    QPushButton* btnSaveTrace_ = nullptr;
+    QPushButton* btnLoadReport_ = nullptr;
     QLabel* lblWar3Root_ = nullptr;
     QLineEdit* editWar3Root_ = nullptr;
     QPushButton* btnWar3Browse_ = nullptr;
@@ -82,22 +113,43 @@ private:
     QDoubleSpinBox* panYSpin_ = nullptr;
     QDoubleSpinBox* panZSpin_ = nullptr;
     QLabel* mpqStatusLabel_ = nullptr;
+    QLabel* loadTimingLabel_ = nullptr;
     GLModelView* viewer_ = nullptr;
     QDockWidget* logDock_ = nullptr;
-    QPlainTextEdit* logView_ = nullptr;
+    QListView* logView_ = nullptr;
+    LogModel* logModel_ = nullptr;
+    QComboBox* logLevelCombo_ = nullptr;
+    QComboBox* logCategoryCombo_ = nullptr;
+    QSpinBox* logHistorySpin_ = nullptr;
+    bool logFollowTail_ = true;
     QDockWidget* missingDock_ = nullptr;
     QPlainTextEdit* missingView_ = nullptr;
     QTabWidget* viewTabs_ = nullptr;
 
     // Models
     QStandardItemModel* listModel_ = nullptr;
-    QSortFilterProxyModel* proxyModel_ = nullptr;
+    RowFilterProxyModel* proxyModel_ = nullptr;
     QHash<QString, std::shared_ptr<ModelData>> modelCache_;
     std::shared_ptr<CompositeVfs> vfs_;
     std::shared_ptr<DiskVfs> diskVfs_;
     std::shared_ptr<MpqVfs> mpqVfs_;
 
-    QFutureWatcher<QStringList> scanWatcher_;
+    QFutureWatcher<FolderScanResult> scanWatcher_;
     QFutureWatcher<struct ModelLoadResult> modelWatcher_;
     int loadToken_ = 0;
+    QString currentModelPath_;
+
+    // Load timing: loader stages wait here until the viewer reports the first frame.
+    QElapsedTimer loadRequestTimer_;
+    QString pendingTimingPath_;
+    LoadTiming pendingTiming_;
+    LoadTimingReport loadReport_;
+
+    // Name filtering (debounced, evaluated off the GUI thread)
+    std::shared_ptr<const FilterIndex> filterIndex_;
+    QTimer filterTimer_;
+    QFutureWatcher<FilterResult> filterWatcher_;
+    int filterToken_ = 0;
+    QString lastFilterQuery_;
+    std::vector<int> lastFilterRows_;
 };
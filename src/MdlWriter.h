@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QString>
+#include "ModelData.h"
+
+// Writes a loaded model back out as text MDL (geosets, groups, nodes, pivots).
+// Used for diagnostics and batch conversion; not a lossless round trip.
+
+namespace MdlWriter
+{
+    bool WriteModel(const ModelData& model, const QString& path, const QString& name, QString* outError = nullptr);
+}
@@ -0,0 +1,245 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "MdxGenerator.h"
+#include "MdxLoader.h"
+#include "MdxValidator.h"
+
+// w3preview-mdxgen: writes deterministic synthetic .mdx files for scaling tests.
+// Every numeric / enum option accepts a comma list; the tool writes the cartesian product.
+
+namespace
+{
+    static bool ParseIntList(const QString& text, int minValue, std::vector<int>* out, QString* outError)
+    {
+        out->clear();
+        for (const QString& part : text.split(',', Qt::SkipEmptyParts))
+        {
+            bool ok = false;
+            const int v = part.trimmed().toInt(&ok);
+            if (!ok || v < minValue)
+            {
+                if (outError) *outError = QString("Invalid value '%1' (expected an integer >= %2).").arg(part).arg(minValue);
+                return false;
+            }
+            out->push_back(v);
+        }
+        if (out->empty())
+        {
+            if (outError) *outError = "Empty list.";
+            return false;
+        }
+        return true;
+    }
+
+    // Loads the bytes back through MdxLoader and checks counts + MdxValidator.
+    static bool Verify(const MdxGenerator::Params& p, const QByteArray& bytes, QString* outError)
+    {
+        QString err;
+        auto model = MdxLoader::LoadFromBytes(bytes, &err);
+        if (!model)
+        {
+            *outError = "load failed: " + err;
+            return false;
+        }
+        const std::size_t expectedVertices = std::size_t(p.geosets) * std::size_t(std::clamp(p.verticesPerGeoset, 4, 65535));
+        if (model->geosetDiagnostics.size() != std::size_t(p.geosets) || model->vertices.size() != expectedVertices)
+        {
+            *outError = QString("expected %1 geosets / %2 vertices, loaded %3 / %4")
+                            .arg(p.geosets).arg(qulonglong(expectedVertices))
+                            .arg(qulonglong(model->geosetDiagnostics.size())).arg(qulonglong(model->vertices.size()));
+            return false;
+        }
+        if (model->boneNodeIds.size() != std::size_t(p.bones) || model->emitters2.size() != std::size_t(p.emitters))
+        {
+            *outError = QString("expected %1 bones / %2 emitters, loaded %3 / %4")
+                            .arg(p.bones).arg(p.emitters)
+                            .arg(qulonglong(model->boneNodeIds.size())).arg(qulonglong(model->emitters2.size()));
+            return false;
+        }
+        const auto issues = MdxValidator::ValidateModel(*model);
+        if (!issues.empty())
+        {
+            *outError = QString("%1 validator issue(s), first: %2: %3")
+                            .arg(qulonglong(issues.size())).arg(issues.front().check, issues.front().message);
+            return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("w3preview-mdxgen");
+    QCoreApplication::setApplicationVersion("0.1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generate deterministic synthetic Warcraft III .mdx models for scaling tests.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    const QCommandLineOption outOpt(QStringList() << "o" << "out", "Output .mdx file, or a folder when sweeping.", "path");
+    const QCommandLineOption seedOpt(QStringList() << "s" << "seed", "RNG seed(s).", "list", "1");
+    const QCommandLineOption geosetsOpt(QStringList() << "g" << "geosets", "Geoset count(s).", "list", "1");
+    const QCommandLineOption verticesOpt(QStringList() << "v" << "vertices", "Vertices per geoset (4..65535).", "list", "1024");
+    const QCommandLineOption bonesOpt(QStringList() << "b" << "bones", "Bone count(s).", "list", "16");
+    const QCommandLineOption hierarchyOpt("hierarchy", "Bone hierarchy: chain | wide | balanced.", "list", "balanced");
+    const QCommandLineOption groupOpt("bones-per-group", "Matrices per vertex group (1..4).", "n", "2");
+    const QCommandLineOption emittersOpt(QStringList() << "e" << "emitters", "PRE2 emitter count(s).", "list", "0");
+    const QCommandLineOption keysOpt(QStringList() << "k" << "keys", "Keys per animation track.", "list", "16");
+    const QCommandLineOption interpOpt("interp", "Track interpolation: none | linear | hermite | bezier | mixed.", "list", "linear");
+    const QCommandLineOption sequencesOpt("sequences", "Sequence count.", "n", "1");
+    const QCommandLineOption sequenceMsOpt("sequence-ms", "Length of each sequence in ms.", "ms", "2000");
+    const QCommandLineOption globalSeqOpt("global-sequence", "Drive emitter tracks from a global sequence.");
+    const QCommandLineOption verifyOpt("verify", "Reload every file through MdxLoader and run MdxValidator.");
+    parser.addOption(outOpt);
+    parser.addOption(seedOpt);
+    parser.addOption(geosetsOpt);
+    parser.addOption(verticesOpt);
+    parser.addOption(bonesOpt);
+    parser.addOption(hierarchyOpt);
+    parser.addOption(groupOpt);
+    parser.addOption(emittersOpt);
+    parser.addOption(keysOpt);
+    parser.addOption(interpOpt);
+    parser.addOption(sequencesOpt);
+    parser.addOption(sequenceMsOpt);
+    parser.addOption(globalSeqOpt);
+    parser.addOption(verifyOpt);
+    parser.process(app);
+
+    if (!parser.isSet(outOpt))
+    {
+        std::fprintf(stderr, "%s\n", qPrintable(parser.helpText()));
+        return 2;
+    }
+
+    std::vector<int> seeds, geosets, vertices, bones, emitters, keys;
+    QString err;
+    struct IntList { const QCommandLineOption* opt; int minValue; std::vector<int>* out; };
+    const IntList lists[] = {
+        { &seedOpt, 0, &seeds },
+        { &geosetsOpt, 0, &geosets },
+        { &verticesOpt, 4, &vertices },
+        { &bonesOpt, 1, &bones },
+        { &emittersOpt, 0, &emitters },
+        { &keysOpt, 0, &keys },
+    };
+    for (const IntList& l : lists)
+    {
+        if (!ParseIntList(parser.value(*l.opt), l.minValue, l.out, &err))
+        {
+            std::fprintf(stderr, "--%s: %s\n", qPrintable(l.opt->names().last()), qPrintable(err));
+            return 2;
+        }
+    }
+
+    std::vector<MdxGenerator::Hierarchy> hierarchies;
+    for (const QString& h : parser.value(hierarchyOpt).split(',', Qt::SkipEmptyParts))
+    {
+        MdxGenerator::Hierarchy v;
+        if (!MdxGenerator::ParseHierarchy(h, &v))
+        {
+            std::fprintf(stderr, "Unknown --hierarchy: %s\n", qPrintable(h));
+            return 2;
+        }
+        hierarchies.push_back(v);
+    }
+    std::vector<MdxGenerator::InterpMode> interps;
+    for (const QString& m : parser.value(interpOpt).split(',', Qt::SkipEmptyParts))
+    {
+        MdxGenerator::InterpMode v;
+        if (!MdxGenerator::ParseInterp(m, &v))
+        {
+            std::fprintf(stderr, "Unknown --interp: %s\n", qPrintable(m));
+            return 2;
+        }
+        interps.push_back(v);
+    }
+    if (hierarchies.empty() || interps.empty())
+    {
+        std::fprintf(stderr, "--hierarchy and --interp need at least one value\n");
+        return 2;
+    }
+
+    MdxGenerator::Params base;
+    base.bonesPerGroup = parser.value(groupOpt).toInt();
+    base.sequences = parser.value(sequencesOpt).toInt();
+    base.sequenceMs = parser.value(sequenceMsOpt).toUInt();
+    base.globalSequence = parser.isSet(globalSeqOpt);
+
+    std::vector<MdxGenerator::Params> sweep;
+    for (int s : seeds)
+        for (int g : geosets)
+            for (int v : vertices)
+                for (int b : bones)
+                    for (MdxGenerator::Hierarchy h : hierarchies)
+                        for (int e : emitters)
+                            for (int k : keys)
+                                for (MdxGenerator::InterpMode m : interps)
+                                {
+                                    MdxGenerator::Params p = base;
+                                    p.seed = std::uint32_t(s);
+                                    p.geosets = g;
+                                    p.verticesPerGeoset = v;
+                                    p.bones = b;
+                                    p.hierarchy = h;
+                                    p.emitters = e;
+                                    p.keysPerTrack = k;
+                                    p.interp = m;
+                                    sweep.push_back(p);
+                                }
+
+    // A single combination with a *.mdx target writes exactly that file; anything else is a folder.
+    const QString out = parser.value(outOpt);
+    const bool singleFile = sweep.size() == 1 && out.endsWith(".mdx", Qt::CaseInsensitive);
+    if (!singleFile && !QDir().mkpath(out))
+    {
+        std::fprintf(stderr, "Cannot create folder: %s\n", qPrintable(out));
+        return 1;
+    }
+
+    const bool verify = parser.isSet(verifyOpt);
+    int failed = 0;
+    for (const MdxGenerator::Params& p : sweep)
+    {
+        const QString path = singleFile ? out : QDir(out).filePath(MdxGenerator::Describe(p) + ".mdx");
+        const QByteArray bytes = MdxGenerator::Generate(p);
+
+        QFile f(path);
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate) || f.write(bytes) != bytes.size())
+        {
+            std::fprintf(stderr, "Cannot write: %s\n", qPrintable(path));
+            ++failed;
+            continue;
+        }
+        f.close();
+
+        QString status = "written";
+        if (verify)
+        {
+            QString verr;
+            if (Verify(p, bytes, &verr))
+            {
+                status = "verified";
+            }
+            else
+            {
+                status = "FAILED: " + verr;
+                ++failed;
+            }
+        }
+        std::printf("%s  %lld bytes  %s\n", qPrintable(QFileInfo(path).fileName()), qlonglong(bytes.size()), qPrintable(status));
+    }
+
+    std::fprintf(stderr, "%zu file(s), %d failed\n", sweep.size(), failed);
+    return failed > 0 ? 1 : 0;
+}
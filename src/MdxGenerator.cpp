@@ -0,0 +1,721 @@
+#include "MdxGenerator.h"
+
+#include <QFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr float kPi = 3.14159265358979f;
+    constexpr std::uint32_t kBoneFlag = 0x100;
+    constexpr std::uint32_t kEmitterFlag = 0x1000;
+    constexpr std::uint32_t kPre2ModelSpace = 0x80000;
+
+    static void setErr(QString* outError, const QString& msg)
+    {
+        if (outError) *outError = msg;
+    }
+
+    // Little-endian writer with back-patched size fields.
+    struct Writer
+    {
+        QByteArray bytes;
+
+        void u8(std::uint8_t v) { bytes.append(char(v)); }
+
+        void u16(std::uint16_t v)
+        {
+            const std::uint16_t le = qToLittleEndian(v);
+            bytes.append(reinterpret_cast<const char*>(&le), 2);
+        }
+
+        void u32(std::uint32_t v)
+        {
+            const std::uint32_t le = qToLittleEndian(v);
+            bytes.append(reinterpret_cast<const char*>(&le), 4);
+        }
+
+        void i32(std::int32_t v) { u32(std::uint32_t(v)); }
+
+        void f32(float v)
+        {
+            std::uint32_t bits = 0;
+            std::memcpy(&bits, &v, 4);
+            u32(bits);
+        }
+
+        void vec3(const Vec3& v) { f32(v.x); f32(v.y); f32(v.z); }
+        void vec4(const Vec4& v) { f32(v.x); f32(v.y); f32(v.z); f32(v.w); }
+        void tag(const char* t) { bytes.append(t, 4); }
+
+        void fixedString(const std::string& s, int n)
+        {
+            const int len = std::min<int>(int(s.size()), n);
+            bytes.append(s.data(), len);
+            bytes.append(QByteArray(n - len, '\0'));
+        }
+
+        // Size field that counts itself (geosets, materials, layers, nodes, objects).
+        int beginInclusive()
+        {
+            const int pos = int(bytes.size());
+            u32(0);
+            return pos;
+        }
+
+        void endInclusive(int pos) { patch(pos, std::uint32_t(bytes.size() - pos)); }
+
+        // Top-level chunk: tag + size of the payload that follows.
+        int beginChunk(const char* t)
+        {
+            tag(t);
+            return beginInclusive();
+        }
+
+        void endChunk(int pos) { patch(pos, std::uint32_t(bytes.size() - pos - 4)); }
+
+        void patch(int pos, std::uint32_t v)
+        {
+            const std::uint32_t le = qToLittleEndian(v);
+            std::memcpy(bytes.data() + pos, &le, 4);
+        }
+    };
+
+    struct Bounds
+    {
+        float min[3] = { 1e30f, 1e30f, 1e30f };
+        float max[3] = { -1e30f, -1e30f, -1e30f };
+
+        void add(float x, float y, float z)
+        {
+            const float p[3] = { x, y, z };
+            for (int i = 0; i < 3; ++i)
+            {
+                min[i] = std::min(min[i], p[i]);
+                max[i] = std::max(max[i], p[i]);
+            }
+        }
+
+        float radius() const
+        {
+            const float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+            return 0.5f * std::sqrt(dx * dx + dy * dy + dz * dz);
+        }
+    };
+
+    // Extent = radius + min + max (28 bytes).
+    static void writeExtent(Writer& w, const Bounds& b)
+    {
+        w.f32(b.radius());
+        w.f32(b.min[0]); w.f32(b.min[1]); w.f32(b.min[2]);
+        w.f32(b.max[0]); w.f32(b.max[1]); w.f32(b.max[2]);
+    }
+
+    static float mix(float a, float b, float t) { return a + (b - a) * t; }
+    static Vec3 mix(const Vec3& a, const Vec3& b, float t) { return { mix(a.x, b.x, t), mix(a.y, b.y, t), mix(a.z, b.z, t) }; }
+    static float delta(float from, float to, float scale) { return (to - from) * scale; }
+    static Vec3 delta(const Vec3& from, const Vec3& to, float scale)
+    {
+        return { delta(from.x, to.x, scale), delta(from.y, to.y, scale), delta(from.z, to.z, scale) };
+    }
+
+    // Tangents that follow the keys. The sampler reads Hermite tangents as derivatives per
+    // segment, so keys get Catmull-Rom slopes (times are evenly spaced); Bezier tangents are
+    // control points, placed a third of the way along the neighbouring segments.
+    template<typename T>
+    static void setTangents(MdxTrack<T>& tr)
+    {
+        auto& keys = tr.keys;
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            const bool interior = i > 0 && i + 1 < keys.size();
+            const T& prev = keys[i > 0 ? i - 1 : i].value;
+            const T& next = keys[i + 1 < keys.size() ? i + 1 : i].value;
+            auto& k = keys[i];
+            if (tr.interp == MdxInterp::Hermite)
+            {
+                k.inTan = delta(prev, next, interior ? 0.5f : 1.0f);
+                k.outTan = k.inTan;
+            }
+            else
+            {
+                k.inTan = mix(k.value, prev, 1.0f / 3.0f);
+                k.outTan = mix(k.value, next, 1.0f / 3.0f);
+            }
+        }
+    }
+
+    struct Timeline
+    {
+        std::uint32_t endMs = 0; // last sequence end
+        std::uint32_t globalMs = 0;
+    };
+
+    class TrackMaker
+    {
+    public:
+        TrackMaker(const MdxGenerator::Params& p, const Timeline& tl, std::mt19937& rng)
+            : params_(p), timeline_(tl), rng_(rng)
+        {
+        }
+
+        MdxInterp nextInterp()
+        {
+            switch (params_.interp)
+            {
+            case MdxGenerator::InterpMode::None: return MdxInterp::None;
+            case MdxGenerator::InterpMode::Linear: return MdxInterp::Linear;
+            case MdxGenerator::InterpMode::Hermite: return MdxInterp::Hermite;
+            case MdxGenerator::InterpMode::Bezier: return MdxInterp::Bezier;
+            case MdxGenerator::InterpMode::Mixed: break;
+            }
+            return MdxInterp(std::int32_t(trackIndex_++ % 4));
+        }
+
+        // Evenly spaced, strictly increasing key times over [0, lengthMs].
+        std::vector<std::uint32_t> keyTimes(std::uint32_t lengthMs) const
+        {
+            const int count = std::min<int>(params_.keysPerTrack, int(std::min<std::uint32_t>(lengthMs, 1u << 20)) + 1);
+            std::vector<std::uint32_t> times;
+            times.reserve(std::size_t(std::max(0, count)));
+            for (int i = 0; i < count; ++i)
+            {
+                times.push_back(count > 1 ? std::uint32_t(std::uint64_t(lengthMs) * std::uint64_t(i) / std::uint64_t(count - 1))
+                                          : 0u);
+            }
+            return times;
+        }
+
+        float uniform(float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(rng_); }
+
+        MdxTrack<Vec3> translation(float amplitude)
+        {
+            MdxTrack<Vec3> tr;
+            tr.interp = nextInterp();
+            const float phase = uniform(0.0f, 2.0f * kPi);
+            const auto times = keyTimes(timeline_.endMs);
+            for (std::size_t i = 0; i < times.size(); ++i)
+            {
+                const float a = phase + 2.0f * kPi * float(i) / float(std::max<std::size_t>(1, times.size()));
+                MdxTrackKey<Vec3> k;
+                k.timeMs = times[i];
+                k.value = { amplitude * std::cos(a), amplitude * std::sin(a), 0.5f * amplitude * std::sin(2.0f * a) };
+                tr.keys.push_back(k);
+            }
+            setTangents(tr);
+            return tr;
+        }
+
+        MdxTrack<Vec3> scaling()
+        {
+            MdxTrack<Vec3> tr;
+            tr.interp = nextInterp();
+            for (std::uint32_t t : keyTimes(timeline_.endMs))
+            {
+                const float s = uniform(0.9f, 1.1f);
+                MdxTrackKey<Vec3> k;
+                k.timeMs = t;
+                k.value = { s, s, s };
+                tr.keys.push_back(k);
+            }
+            setTangents(tr);
+            return tr;
+        }
+
+        MdxTrack<Vec4> rotation(float maxAngle)
+        {
+            MdxTrack<Vec4> tr;
+            tr.interp = nextInterp();
+            Vec3 axis{ uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f) };
+            const float len = std::sqrt(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+            axis = (len > 1e-4f) ? Vec3{ axis.x / len, axis.y / len, axis.z / len } : Vec3{ 0, 0, 1 };
+            auto quat = [&](float angle)
+            {
+                const float s = std::sin(angle * 0.5f);
+                return Vec4{ axis.x * s, axis.y * s, axis.z * s, std::cos(angle * 0.5f) };
+            };
+            const auto times = keyTimes(timeline_.endMs);
+            std::vector<float> angles(times.size());
+            for (std::size_t i = 0; i < times.size(); ++i)
+                angles[i] = maxAngle * std::sin(2.0f * kPi * float(i) / float(std::max<std::size_t>(1, times.size())));
+            // Both quaternion splines slerp toward the tangents, so they are rotations a third of
+            // the way to the neighbouring keys about the same axis.
+            for (std::size_t i = 0; i < times.size(); ++i)
+            {
+                const float prev = angles[i > 0 ? i - 1 : i];
+                const float next = angles[i + 1 < times.size() ? i + 1 : i];
+                MdxTrackKey<Vec4> k;
+                k.timeMs = times[i];
+                k.value = quat(angles[i]);
+                k.inTan = quat(mix(angles[i], prev, 1.0f / 3.0f));
+                k.outTan = quat(mix(angles[i], next, 1.0f / 3.0f));
+                tr.keys.push_back(k);
+            }
+            return tr;
+        }
+
+        MdxTrack<float> scalar(float lo, float hi, bool global)
+        {
+            MdxTrack<float> tr;
+            tr.interp = nextInterp();
+            tr.globalSeqId = global ? 0 : -1;
+            for (std::uint32_t t : keyTimes(global ? timeline_.globalMs : timeline_.endMs))
+            {
+                MdxTrackKey<float> k;
+                k.timeMs = t;
+                k.value = uniform(lo, hi);
+                tr.keys.push_back(k);
+            }
+            setTangents(tr);
+            return tr;
+        }
+
+    private:
+        const MdxGenerator::Params& params_;
+        const Timeline& timeline_;
+        std::mt19937& rng_;
+        int trackIndex_ = 0;
+    };
+
+    template<typename T, typename PutFn>
+    static void writeTrack(Writer& w, const char* tag, const MdxTrack<T>& tr, PutFn put)
+    {
+        if (tr.keys.empty())
+            return;
+        w.tag(tag);
+        w.u32(std::uint32_t(tr.keys.size()));
+        w.u32(std::uint32_t(tr.interp));
+        w.i32(tr.globalSeqId);
+        const bool tangents = tr.interp == MdxInterp::Hermite || tr.interp == MdxInterp::Bezier;
+        for (const auto& k : tr.keys)
+        {
+            w.u32(k.timeMs);
+            put(k.value);
+            if (tangents)
+            {
+                put(k.inTan);
+                put(k.outTan);
+            }
+        }
+    }
+
+    static void writeNode(Writer& w, const std::string& name, int objectId, int parentId, std::uint32_t flags,
+                          const MdxTrack<Vec3>* translation, const MdxTrack<Vec4>* rotation, const MdxTrack<Vec3>* scaling)
+    {
+        const int start = w.beginInclusive();
+        w.fixedString(name, 80);
+        w.i32(objectId);
+        w.i32(parentId);
+        w.u32(flags);
+        if (translation)
+            writeTrack(w, "KGTR", *translation, [&](const Vec3& v) { w.vec3(v); });
+        if (rotation)
+            writeTrack(w, "KGRT", *rotation, [&](const Vec4& v) { w.vec4(v); });
+        if (scaling)
+            writeTrack(w, "KGSC", *scaling, [&](const Vec3& v) { w.vec3(v); });
+        w.endInclusive(start);
+    }
+
+    static int parentOf(MdxGenerator::Hierarchy h, int bone)
+    {
+        if (bone == 0)
+            return -1;
+        switch (h)
+        {
+        case MdxGenerator::Hierarchy::Chain: return bone - 1;
+        case MdxGenerator::Hierarchy::Wide: return 0;
+        case MdxGenerator::Hierarchy::Balanced: return (bone - 1) / 2;
+        }
+        return -1;
+    }
+
+    static QString hierarchyName(MdxGenerator::Hierarchy h)
+    {
+        switch (h)
+        {
+        case MdxGenerator::Hierarchy::Chain: return "chain";
+        case MdxGenerator::Hierarchy::Wide: return "wide";
+        case MdxGenerator::Hierarchy::Balanced: return "balanced";
+        }
+        return "balanced";
+    }
+
+    static QString interpName(MdxGenerator::InterpMode m)
+    {
+        switch (m)
+        {
+        case MdxGenerator::InterpMode::None: return "none";
+        case MdxGenerator::InterpMode::Linear: return "linear";
+        case MdxGenerator::InterpMode::Hermite: return "hermite";
+        case MdxGenerator::InterpMode::Bezier: return "bezier";
+        case MdxGenerator::InterpMode::Mixed: return "mixed";
+        }
+        return "linear";
+    }
+}
+
+namespace MdxGenerator
+{
+    QByteArray Generate(const Params& in)
+    {
+        Params p = in;
+        p.geosets = std::max(0, p.geosets);
+        p.verticesPerGeoset = std::clamp(p.verticesPerGeoset, 4, 65535);
+        p.bones = std::max(1, p.bones);
+        p.bonesPerGroup = std::clamp(p.bonesPerGroup, 1, 4);
+        p.emitters = std::max(0, p.emitters);
+        p.keysPerTrack = std::max(0, p.keysPerTrack);
+        p.sequences = std::max(1, p.sequences);
+        p.sequenceMs = std::max<std::uint32_t>(1, p.sequenceMs);
+
+        std::mt19937 rng(p.seed);
+
+        Timeline tl;
+        tl.endMs = std::uint32_t(p.sequences) * (p.sequenceMs + 100) - 100;
+        tl.globalMs = p.sequenceMs;
+        TrackMaker tracks(p, tl, rng);
+
+        const int materialCount = std::clamp(p.geosets, 1, 8);
+        const float height = 100.0f;
+
+        // Mesh first so extents are known for MODL/SEQS/GEOS.
+        struct Geoset
+        {
+            std::vector<Vec3> pos;
+            std::vector<Vec3> nrm;
+            std::vector<float> uv;
+            std::vector<std::uint16_t> faces;
+            std::vector<std::uint8_t> groups;
+            std::vector<std::vector<std::int32_t>> matrices;
+            Bounds bounds;
+        };
+        std::vector<Geoset> geosets(std::size_t(p.geosets));
+        Bounds modelBounds;
+        for (int g = 0; g < p.geosets; ++g)
+        {
+            Geoset& gs = geosets[std::size_t(g)];
+            const int v = p.verticesPerGeoset;
+            const int cols = std::max(2, int(std::sqrt(double(v))));
+            const int rows = (v + cols - 1) / cols;
+            const float radius = 20.0f + 10.0f * float(g);
+
+            gs.pos.reserve(std::size_t(v));
+            for (int i = 0; i < v; ++i)
+            {
+                const int r = i / cols;
+                const int c = i % cols;
+                const float a = 2.0f * kPi * float(c) / float(cols);
+                const float z = height * float(r) / float(std::max(1, rows - 1));
+                gs.pos.push_back({ radius * std::cos(a), radius * std::sin(a), z });
+                gs.nrm.push_back({ std::cos(a), std::sin(a), 0.0f });
+                gs.uv.push_back(float(c) / float(cols - 1));
+                gs.uv.push_back(float(r) / float(std::max(1, rows - 1)));
+                gs.bounds.add(gs.pos.back().x, gs.pos.back().y, gs.pos.back().z);
+            }
+            for (int r = 0; r + 1 < rows; ++r)
+            {
+                for (int c = 0; c + 1 < cols; ++c)
+                {
+                    const int a = r * cols + c;
+                    const int d = a + cols + 1;
+                    if (d >= v)
+                        continue;
+                    const std::uint16_t ia = std::uint16_t(a), ib = std::uint16_t(a + 1);
+                    const std::uint16_t ic = std::uint16_t(a + cols), id = std::uint16_t(d);
+                    gs.faces.insert(gs.faces.end(), { ia, ic, ib, ib, ic, id });
+                }
+            }
+
+            // One matrix group per row band; bones follow the cylinder height.
+            const int groupCount = std::clamp(rows, 1, 256);
+            for (int gi = 0; gi < groupCount; ++gi)
+            {
+                std::vector<std::int32_t> mats;
+                const int base = gi * p.bones / groupCount;
+                for (int k = 0; k < std::min(p.bonesPerGroup, p.bones); ++k)
+                    mats.push_back(std::int32_t((base + k) % p.bones));
+                gs.matrices.push_back(std::move(mats));
+            }
+            for (int i = 0; i < v; ++i)
+                gs.groups.push_back(std::uint8_t((i / cols) * groupCount / std::max(1, rows)));
+
+            modelBounds.add(gs.bounds.min[0], gs.bounds.min[1], gs.bounds.min[2]);
+            modelBounds.add(gs.bounds.max[0], gs.bounds.max[1], gs.bounds.max[2]);
+        }
+        if (p.geosets == 0)
+        {
+            modelBounds.add(-1, -1, 0);
+            modelBounds.add(1, 1, height);
+        }
+
+        Writer w;
+        w.tag("MDLX");
+
+        int chunk = w.beginChunk("VERS");
+        w.u32(800);
+        w.endChunk(chunk);
+
+        chunk = w.beginChunk("MODL");
+        w.fixedString("Synthetic_" + Describe(p).toStdString(), 80);
+        w.fixedString("", 260);
+        writeExtent(w, modelBounds);
+        w.u32(150); // blend time
+        w.endChunk(chunk);
+
+        chunk = w.beginChunk("SEQS");
+        for (int s = 0; s < p.sequences; ++s)
+        {
+            const std::uint32_t start = std::uint32_t(s) * (p.sequenceMs + 100);
+            w.fixedString("Stand " + std::to_string(s + 1), 80);
+            w.u32(start);
+            w.u32(start + p.sequenceMs);
+            w.f32(0.0f); // move speed
+            w.u32(0);    // flags (looping)
+            w.f32(0.0f); // rarity
+            w.u32(0);    // sync point
+            writeExtent(w, modelBounds);
+        }
+        w.endChunk(chunk);
+
+        if (p.globalSequence)
+        {
+            chunk = w.beginChunk("GLBS");
+            w.u32(tl.globalMs);
+            w.endChunk(chunk);
+        }
+
+        chunk = w.beginChunk("MTLS");
+        for (int m = 0; m < materialCount; ++m)
+        {
+            const int mat = w.beginInclusive();
+            w.i32(0); // priority plane
+            w.u32(0); // flags
+            w.tag("LAYS");
+            w.u32(1);
+            const int layer = w.beginInclusive();
+            w.u32((m % 2 == 0) ? 0u : 2u); // none / blend
+            w.u32(0);                       // shading flags
+            w.u32(std::uint32_t(m));        // texture id
+            w.i32(-1);                      // texture animation
+            w.u32(0);                       // coord id
+            w.f32(1.0f);
+            writeTrack(w, "KMTA", tracks.scalar(0.5f, 1.0f, false), [&](float v) { w.f32(v); });
+            w.endInclusive(layer);
+            w.endInclusive(mat);
+        }
+        w.endChunk(chunk);
+
+        chunk = w.beginChunk("TEXS");
+        for (int t = 0; t < materialCount; ++t)
+        {
+            w.u32(0);
+            w.fixedString("Textures\\Synthetic" + std::to_string(t) + ".blp", 260);
+            w.u32(0);
+        }
+        w.endChunk(chunk);
+
+        if (p.geosets > 0)
+        {
+            chunk = w.beginChunk("GEOS");
+            for (int g = 0; g < p.geosets; ++g)
+            {
+                const Geoset& gs = geosets[std::size_t(g)];
+                const int geo = w.beginInclusive();
+
+                w.tag("VRTX");
+                w.u32(std::uint32_t(gs.pos.size()));
+                for (const Vec3& v : gs.pos)
+                    w.vec3(v);
+
+                w.tag("NRMS");
+                w.u32(std::uint32_t(gs.nrm.size()));
+                for (const Vec3& n : gs.nrm)
+                    w.vec3(n);
+
+                w.tag("PTYP");
+                w.u32(1);
+                w.u32(4); // triangles
+                w.tag("PCNT");
+                w.u32(1);
+                w.u32(std::uint32_t(gs.faces.size()));
+                w.tag("PVTX");
+                w.u32(std::uint32_t(gs.faces.size()));
+                for (std::uint16_t f : gs.faces)
+                    w.u16(f);
+
+                w.tag("GNDX");
+                w.u32(std::uint32_t(gs.groups.size()));
+                for (std::uint8_t vg : gs.groups)
+                    w.u8(vg);
+
+                std::uint32_t matsTotal = 0;
+                w.tag("MTGC");
+                w.u32(std::uint32_t(gs.matrices.size()));
+                for (const auto& m : gs.matrices)
+                {
+                    w.u32(std::uint32_t(m.size()));
+                    matsTotal += std::uint32_t(m.size());
+                }
+                w.tag("MATS");
+                w.u32(matsTotal);
+                for (const auto& m : gs.matrices)
+                    for (std::int32_t id : m)
+                        w.i32(id);
+
+                w.u32(std::uint32_t(g % materialCount));
+                w.u32(0); // selection flags
+                w.u32(0); // selection group
+                writeExtent(w, gs.bounds);
+                w.u32(std::uint32_t(p.sequences));
+                for (int s = 0; s < p.sequences; ++s)
+                    writeExtent(w, gs.bounds);
+
+                w.tag("UVAS");
+                w.u32(1);
+                w.tag("UVBS");
+                w.u32(std::uint32_t(gs.pos.size()));
+                for (float f : gs.uv)
+                    w.f32(f);
+
+                w.endInclusive(geo);
+            }
+            w.endChunk(chunk);
+        }
+
+        std::vector<Vec3> pivots;
+        pivots.reserve(std::size_t(p.bones + p.emitters));
+
+        chunk = w.beginChunk("BONE");
+        for (int b = 0; b < p.bones; ++b)
+        {
+            const auto t = tracks.translation(2.0f);
+            const auto r = tracks.rotation(0.6f);
+            const auto s = tracks.scaling();
+            writeNode(w, "Bone_" + std::to_string(b), b, parentOf(p.hierarchy, b), kBoneFlag, &t, &r, &s);
+            w.i32(p.geosets > 0 ? b % p.geosets : -1); // geoset id
+            w.i32(-1);                                 // geoset animation id
+            pivots.push_back({ 0.0f, 0.0f, height * float(b) / float(p.bones) });
+        }
+        w.endChunk(chunk);
+
+        if (p.emitters > 0)
+        {
+            chunk = w.beginChunk("PRE2");
+            for (int e = 0; e < p.emitters; ++e)
+            {
+                const int objectId = p.bones + e;
+                const int parent = int(rng() % std::uint32_t(p.bones));
+                const std::uint32_t flags = kEmitterFlag | ((e % 2 == 0) ? kPre2ModelSpace : 0u);
+
+                const int obj = w.beginInclusive();
+                writeNode(w, "Emitter_" + std::to_string(e), objectId, parent, flags, nullptr, nullptr, nullptr);
+                w.f32(tracks.uniform(50.0f, 200.0f)); // speed
+                w.f32(0.2f);                           // variation
+                w.f32(tracks.uniform(0.1f, 1.0f));     // latitude
+                w.f32(tracks.uniform(0.0f, 100.0f));   // gravity
+                w.f32(1.5f);                           // lifespan
+                w.f32(50.0f);                          // emission rate
+                w.f32(10.0f);                          // length
+                w.f32(10.0f);                          // width
+                w.u32(e % 2 == 0 ? 1u : 2u);           // filter mode (blend / additive)
+                w.u32(4);                              // rows
+                w.u32(4);                              // columns
+                w.u32(e % 3 == 0 ? 2u : 0u);           // head / both
+                w.f32(1.0f);                           // tail length
+                w.f32(0.5f);                           // time middle
+                for (int si = 0; si < 3; ++si)
+                    w.vec3({ 1.0f, 1.0f - 0.3f * float(si), 0.5f });
+                w.u8(255); w.u8(200); w.u8(0);
+                w.f32(100.0f); w.f32(150.0f); w.f32(50.0f);
+                // head/tail intervals: {start, end, repeat} for lifespan and decay
+                for (int i = 0; i < 4; ++i)
+                {
+                    w.u32(0);
+                    w.u32(15);
+                    w.u32(1);
+                }
+                w.i32(0); // texture id
+                w.u32(0); // squirt
+                w.i32(0); // priority plane
+                w.u32(0); // replaceable id
+                writeTrack(w, "KP2E", tracks.scalar(20.0f, 80.0f, p.globalSequence), [&](float v) { w.f32(v); });
+                writeTrack(w, "KP2S", tracks.scalar(50.0f, 200.0f, p.globalSequence), [&](float v) { w.f32(v); });
+                w.endInclusive(obj);
+
+                pivots.push_back({ tracks.uniform(-20.0f, 20.0f), tracks.uniform(-20.0f, 20.0f), tracks.uniform(0.0f, height) });
+            }
+            w.endChunk(chunk);
+        }
+
+        chunk = w.beginChunk("PIVT");
+        for (const Vec3& v : pivots)
+            w.vec3(v);
+        w.endChunk(chunk);
+
+        return w.bytes;
+    }
+
+    bool WriteFile(const Params& params, const QString& path, QString* outError)
+    {
+        QFile f(path);
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            setErr(outError, QString("Cannot open %1 for writing.").arg(path));
+            return false;
+        }
+        const QByteArray bytes = Generate(params);
+        if (f.write(bytes) != bytes.size())
+        {
+            setErr(outError, QString("Short write to %1.").arg(path));
+            return false;
+        }
+        return true;
+    }
+
+    QString Describe(const Params& p)
+    {
+        return QString("g%1_v%2_b%3%4_e%5_k%6_%7_s%8")
+            .arg(p.geosets)
+            .arg(p.verticesPerGeoset)
+            .arg(p.bones)
+            .arg(hierarchyName(p.hierarchy))
+            .arg(p.emitters)
+            .arg(p.keysPerTrack)
+            .arg(interpName(p.interp))
+            .arg(p.seed);
+    }
+
+    bool ParseHierarchy(const QString& name, Hierarchy* out)
+    {
+        const QString n = name.trimmed().toLower();
+        for (Hierarchy h : { Hierarchy::Chain, Hierarchy::Wide, Hierarchy::Balanced })
+        {
+            if (n == hierarchyName(h))
+            {
+                if (out) *out = h;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool ParseInterp(const QString& name, InterpMode* out)
+    {
+        const QString n = name.trimmed().toLower();
+        for (InterpMode m : { InterpMode::None, InterpMode::Linear, InterpMode::Hermite, InterpMode::Bezier, InterpMode::Mixed })
+        {
+            if (n == interpName(m))
+            {
+                if (out) *out = m;
+                return true;
+            }
+        }
+        return false;
+    }
+}
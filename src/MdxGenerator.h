@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <cstdint>
+
+#include "ModelData.h"
+
+// Deterministic synthetic MDX (v800) writer for scaling tests and benchmarks.
+// Output uses the chunk layout MdxLoader parses: VERS, SEQS, GLBS, MTLS, TEXS,
+// GEOS, BONE, PRE2, PIVT. The same Params + seed always produce identical bytes.
+
+namespace MdxGenerator
+{
+    enum class Hierarchy
+    {
+        Chain,    // each bone parents the next (depth = bones)
+        Wide,     // every bone is a child of bone 0 (depth = 2)
+        Balanced  // binary tree (depth = log2(bones))
+    };
+
+    enum class InterpMode
+    {
+        None,
+        Linear,
+        Hermite,
+        Bezier,
+        Mixed // cycles None/Linear/Hermite/Bezier per track
+    };
+
+    struct Params
+    {
+        std::uint32_t seed = 1;
+        int geosets = 1;
+        int verticesPerGeoset = 1024;   // clamped to [4, 65535] (PVTX is 16-bit)
+        int bones = 16;                 // >= 1
+        Hierarchy hierarchy = Hierarchy::Balanced;
+        int bonesPerGroup = 2;          // matrices per vertex group, 1..4
+        int emitters = 0;               // PRE2 emitters, parented to random bones
+        int keysPerTrack = 16;          // keys on every node / emitter track (0 = static)
+        InterpMode interp = InterpMode::Linear;
+        int sequences = 1;
+        std::uint32_t sequenceMs = 2000;
+        bool globalSequence = false;    // put emitter tracks on a global sequence
+    };
+
+    // Serialized .mdx bytes.
+    QByteArray Generate(const Params& params);
+
+    bool WriteFile(const Params& params, const QString& path, QString* outError = nullptr);
+
+    // Short stable name for file names / bench case ids, e.g. "g4_v2048_b64chain_e2_k32_hermite_s1".
+    QString Describe(const Params& params);
+
+    bool ParseHierarchy(const QString& name, Hierarchy* out);
+    bool ParseInterp(const QString& name, InterpMode* out);
+}
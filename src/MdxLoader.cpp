@@ -1,5 +1,6 @@
 #include "MdxLoader.h"
 
+#include <QElapsedTimer>
 #include <QFile>
 #include <QStringList>
 #include <QtGlobal>
@@ -11,7 +12,10 @@
 #include <string>
 #include <vector>
 
+#include "LoadTiming.h"
 #include "LogSink.h"
+#include "ModelAnim.h"
+#include "Trace.h"
 namespace
 {
     struct Reader
@@ -91,11 +95,31 @@ namespace
         if (outError) *outError = msg;
     }
 
+    static double ElapsedMs(const QElapsedTimer& t)
+    {
+        return double(t.nsecsElapsed()) / 1.0e6;
+    }
+
     static bool tagEq(const char t[4], const char* s)
     {
         return t[0] == s[0] && t[1] == s[1] && t[2] == s[2] && t[3] == s[3];
     }
 
+    // Trace names must outlive the event, so map chunk tags to literals.
+    static const char* chunkTraceName(const char t[4])
+    {
+        static const char* const known[] = {
+            "VERS", "MODL", "SEQS", "GLBS", "MTLS", "TEXS", "TXAN", "GEOS", "GEOA", "BONE", "HELP",
+            "LITE", "ATCH", "PIVT", "PREM", "PRE2", "RIBB", "EVTS", "CLID", "CAMS",
+        };
+        for (const char* k : known)
+        {
+            if (tagEq(t, k))
+                return k;
+        }
+        return "chunk";
+    }
+
     static std::string readFixedString(Reader& r, qsizetype n)
     {
         std::string out;
@@ -981,9 +1005,11 @@ namespace
             }
             else
             {
-                LogSink::instance().log(QString("Unknown node track tag: %1%2%3%4")
+                static LogSink::RateLimit unknownTagLimit(10);
+                LogSink::instance().log(LogLevel::Warning, QString("Unknown node track tag: %1%2%3%4")
                                             .arg(QChar(tag[0])).arg(QChar(tag[1]))
-                                            .arg(QChar(tag[2])).arg(QChar(tag[3])));
+                                            .arg(QChar(tag[2])).arg(QChar(tag[3])),
+                                        &unknownTagLimit);
                 break;
             }
         }
@@ -1136,9 +1162,11 @@ namespace
                 else if (tagEq(t, "KP2V")) { if (!parseFloatTrack(orr, 0, e.trackVisibility)) break; }
                 else
                 {
-                    LogSink::instance().log(QString("Unknown PRE2 track tag: %1%2%3%4")
+                    static LogSink::RateLimit unknownTagLimit(10);
+                    LogSink::instance().log(LogLevel::Warning, QString("Unknown PRE2 track tag: %1%2%3%4")
                                                 .arg(QChar(t[0])).arg(QChar(t[1]))
-                                                .arg(QChar(t[2])).arg(QChar(t[3])));
+                                                .arg(QChar(t[2])).arg(QChar(t[3])),
+                                            &unknownTagLimit);
                     break;
                 }
             }
@@ -1224,9 +1252,11 @@ namespace
                 else if (tagEq(tag, "KGAC")) { if (!parseVec3Track(gr, ga.trackColor)) break; }
                 else
                 {
-                    LogSink::instance().log(QString("Unknown GEOA track tag: %1%2%3%4")
+                    static LogSink::RateLimit unknownTagLimit(10);
+                    LogSink::instance().log(LogLevel::Warning, QString("Unknown GEOA track tag: %1%2%3%4")
                                                 .arg(QChar(tag[0])).arg(QChar(tag[1]))
-                                                .arg(QChar(tag[2])).arg(QChar(tag[3])));
+                                                .arg(QChar(tag[2])).arg(QChar(tag[3])),
+                                            &unknownTagLimit);
                     break;
                 }
             }
@@ -1269,9 +1299,11 @@ namespace
                 else if (tagEq(tag, "KTAS")) { if (!parseVec3Track(tr, ta.scaling)) break; }
                 else
                 {
-                    LogSink::instance().log(QString("Unknown TXAN track tag: %1%2%3%4")
+                    static LogSink::RateLimit unknownTagLimit(10);
+                    LogSink::instance().log(LogLevel::Warning, QString("Unknown TXAN track tag: %1%2%3%4")
                                                 .arg(QChar(tag[0])).arg(QChar(tag[1]))
-                                                .arg(QChar(tag[2])).arg(QChar(tag[3])));
+                                                .arg(QChar(tag[2])).arg(QChar(tag[3])),
+                                            &unknownTagLimit);
                     break;
                 }
             }
@@ -1287,8 +1319,9 @@ namespace
 
 namespace MdxLoader
 {
-    std::optional<ModelData> LoadFromBytes(const QByteArray& bytes, QString* outError)
+    std::optional<ModelData> LoadFromBytes(const QByteArray& bytes, QString* outError, LoadTiming* outTiming)
     {
+        Trace::Scope trace("mdx", "LoadFromBytes");
         if (bytes.size() < 8)
         {
             setErr(outError, "File too small.");
@@ -1309,6 +1342,9 @@ namespace MdxLoader
 
         ModelData model;
         QStringList chunkTags;
+        QElapsedTimer parseTimer;
+        parseTimer.start();
+        QElapsedTimer chunkTimer;
 
         while (r.canRead(8))
         {
@@ -1321,6 +1357,8 @@ namespace MdxLoader
 
             const qsizetype chunkStart = r.pos;
             chunkTags << QString::fromLatin1(tag, 4);
+            Trace::Scope chunkTrace("mdx", chunkTraceName(tag));
+            chunkTimer.start();
 
             // Subreader for this chunk
             Reader cr;
@@ -1368,7 +1406,7 @@ namespace MdxLoader
                     if (!parseGeoset(cr, inclusiveSize, model.mdxVersion, gs, outError))
                         return std::nullopt;
                     model.geosetCount += 1;
-                    LogSink::instance().log(QString("Geoset %1: verts=%2 tris=%3")
+                    LogSink::instance().log(LogLevel::Debug, QString("Geoset %1: verts=%2 tris=%3")
                                                 .arg(geosetIndex)
                                                 .arg(gs.vertices.size())
                                                 .arg(gs.triIndices.size() / 3));
@@ -1480,12 +1518,21 @@ namespace MdxLoader
                     return std::nullopt;
             }
 
+            if (outTiming)
+                outTiming->addChunk(tag, ElapsedMs(chunkTimer));
+
             // advance outer reader
             r.pos = chunkStart + qsizetype(chunkSize);
         }
+        if (outTiming)
+            outTiming->parseMs = ElapsedMs(parseTimer);
+
+        if (!chunkTags.isEmpty() && LogSink::instance().isEnabled(LogLevel::Debug))
+            LogSink::instance().log(LogLevel::Debug, QString("MDX chunks: %1").arg(chunkTags.join(", ")));
 
-        if (!chunkTags.isEmpty())
-            LogSink::instance().log(QString("MDX chunks: %1").arg(chunkTags.join(", ")));
+        Trace::Scope postTrace("mdx", "PostProcess");
+        QElapsedTimer postTimer;
+        postTimer.start();
 
         // Build nodeIdToIndex map and maxObjectId.
         model.maxObjectId = -1;
@@ -1503,12 +1550,23 @@ namespace MdxLoader
                 continue;
             if (model.nodeIdToIndex[objectId] != -1)
             {
-                LogSink::instance().log(QString("Duplicate objectId=%1 (keeping first).").arg(objectId));
+                static LogSink::RateLimit duplicateLimit(10);
+                LogSink::instance().log(LogLevel::Warning, QString("Duplicate objectId=%1 (keeping first).").arg(objectId),
+                                        &duplicateLimit);
                 continue;
             }
             model.nodeIdToIndex[objectId] = static_cast<int>(i);
         }
 
+        // geosetId -> GEOA entry (first one wins), so the renderer never scans the list per draw.
+        model.geosetAnimByGeoset.assign(model.geosetCount, -1);
+        for (std::size_t i = 0; i < model.geosetAnimations.size(); ++i)
+        {
+            const std::int32_t gid = model.geosetAnimations[i].geosetId;
+            if (gid >= 0 && std::uint32_t(gid) < model.geosetCount && model.geosetAnimByGeoset[std::size_t(gid)] < 0)
+                model.geosetAnimByGeoset[std::size_t(gid)] = static_cast<int>(i);
+        }
+
         if (!model.pivots.empty())
         {
             for (std::size_t i = 0; i < model.pivots.size(); ++i)
@@ -1525,6 +1583,17 @@ namespace MdxLoader
 
         model.bindVertices = model.vertices;
 
+        const int rigidSubMeshes = ModelAnim::ClassifyRigidSubMeshes(model);
+        if (rigidSubMeshes > 0)
+            LogSink::instance().log(LogLevel::Debug, QString("Rigid submeshes: %1 of %2")
+                                                         .arg(rigidSubMeshes)
+                                                         .arg(model.subMeshes.size()));
+        const int staticSequences = ModelAnim::ClassifyStaticSequences(model);
+        if (staticSequences > 0)
+            LogSink::instance().log(LogLevel::Debug, QString("Static-pose sequences: %1 of %2")
+                                                         .arg(staticSequences)
+                                                         .arg(model.sequences.size()));
+
         const bool hasMesh = !model.vertices.empty() && !model.indices.empty();
         const bool hasParticles = !model.emitters2.empty();
 
@@ -1605,19 +1674,29 @@ namespace MdxLoader
                 sm.materialId = 0;
         }
 
+        if (outTiming)
+            outTiming->postMs = ElapsedMs(postTimer);
         return model;
     }
 
-    std::optional<ModelData> LoadFromFile(const QString& filePath, QString* outError)
+    std::optional<ModelData> LoadFromFile(const QString& filePath, QString* outError, LoadTiming* outTiming)
     {
+        QElapsedTimer readTimer;
+        readTimer.start();
         QFile f(filePath);
         if (!f.open(QIODevice::ReadOnly))
         {
             setErr(outError, QString("Failed to open: %1").arg(filePath));
             return std::nullopt;
         }
-        const QByteArray bytes = f.readAll();
-        auto model = LoadFromBytes(bytes, outError);
+        QByteArray bytes;
+        {
+            Trace::Scope trace("io", "ReadFile", filePath);
+            bytes = f.readAll();
+        }
+        if (outTiming)
+            outTiming->readMs = ElapsedMs(readTimer);
+        auto model = LoadFromBytes(bytes, outError, outTiming);
         if (!model)
             return std::nullopt;
         return model;
@@ -5,6 +5,8 @@
 #include <QByteArray>
 #include "ModelData.h"
 
+struct LoadTiming;
+
 // Minimal Warcraft III MDX (binary) loader.
 // Focus: enough geometry/material data to render a static preview.
 
@@ -12,7 +14,10 @@ namespace MdxLoader
 {
     // Loads an .mdx file from disk.
     // On failure returns std::nullopt and (optionally) fills outError.
-    std::optional<ModelData> LoadFromFile(const QString& filePath, QString* outError = nullptr);
+    // outTiming (optional) receives read / per-chunk parse / post-processing times.
+    std::optional<ModelData> LoadFromFile(const QString& filePath, QString* outError = nullptr,
+                                          LoadTiming* outTiming = nullptr);
     // Loads an .mdx file from memory bytes.
-    std::optional<ModelData> LoadFromBytes(const QByteArray& bytes, QString* outError = nullptr);
+    std::optional<ModelData> LoadFromBytes(const QByteArray& bytes, QString* outError = nullptr,
+                                           LoadTiming* outTiming = nullptr);
 }
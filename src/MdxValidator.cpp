@@ -0,0 +1,387 @@
+#include "MdxValidator.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+#include "MdxLoader.h"
+#include "WorkStealing.h"
+
+namespace
+{
+    // Keeps reports readable on badly broken files.
+    static constexpr std::size_t kMaxIssuesPerModel = 64;
+
+    struct IssueList
+    {
+        std::vector<MdxValidator::Issue> issues;
+        std::size_t dropped = 0;
+
+        void add(const char* check, const QString& message)
+        {
+            if (issues.size() >= kMaxIssuesPerModel)
+            {
+                dropped++;
+                return;
+            }
+            issues.push_back({QString::fromLatin1(check), message});
+        }
+    };
+
+    static bool finite3(float x, float y, float z)
+    {
+        return std::isfinite(x) && std::isfinite(y) && std::isfinite(z);
+    }
+
+    static void checkIndices(const ModelData& model, IssueList& out)
+    {
+        const std::size_t vertexCount = model.vertices.size();
+        const std::uint32_t maxIndex = MdxValidator::MaxIndex(model.indices);
+        if (!model.indices.empty() && maxIndex >= vertexCount)
+        {
+            std::size_t bad = 0;
+            std::size_t first = 0;
+            for (std::size_t i = 0; i < model.indices.size(); ++i)
+            {
+                if (model.indices[i] >= vertexCount)
+                {
+                    if (bad == 0)
+                        first = i;
+                    bad++;
+                }
+            }
+            out.add("index", QString("%1 indices >= vertex count %2 (first at %3, max %4)")
+                                 .arg(bad).arg(vertexCount).arg(first).arg(maxIndex));
+        }
+        if (model.indices.size() % 3 != 0)
+            out.add("index", QString("index count %1 is not a multiple of 3").arg(model.indices.size()));
+
+        for (std::size_t i = 0; i < model.subMeshes.size(); ++i)
+        {
+            const auto& sm = model.subMeshes[i];
+            if (std::uint64_t(sm.indexOffset) + sm.indexCount > model.indices.size())
+                out.add("index", QString("submesh %1 range [%2,+%3) exceeds index buffer (%4)")
+                                     .arg(i).arg(sm.indexOffset).arg(sm.indexCount).arg(model.indices.size()));
+            if (!model.materials.empty() && sm.materialId >= model.materials.size())
+                out.add("index", QString("submesh %1 material %2 out of range (%3 materials)")
+                                     .arg(i).arg(sm.materialId).arg(model.materials.size()));
+        }
+    }
+
+    static void checkSkin(const ModelData& model, IssueList& out)
+    {
+        if (model.vertexGroups.empty())
+            return;
+
+        if (model.vertexGroups.size() != model.vertices.size())
+            out.add("skin", QString("vertex group count %1 != vertex count %2")
+                                .arg(model.vertexGroups.size()).arg(model.vertices.size()));
+
+        std::size_t badGroup = 0;
+        std::uint16_t worst = 0;
+        for (std::uint16_t g : model.vertexGroups)
+        {
+            if (g >= model.skinGroups.size())
+            {
+                badGroup++;
+                worst = std::max(worst, g);
+            }
+        }
+        if (badGroup > 0)
+            out.add("skin", QString("%1 vertices reference missing skin groups (max %2, have %3)")
+                                .arg(badGroup).arg(worst).arg(model.skinGroups.size()));
+
+        for (std::size_t gi = 0; gi < model.skinGroups.size(); ++gi)
+        {
+            const auto& group = model.skinGroups[gi];
+            if (group.nodeIndices.empty())
+            {
+                out.add("skin", QString("skin group %1 is empty").arg(gi));
+                continue;
+            }
+            for (std::int32_t id : group.nodeIndices)
+            {
+                const bool known = id >= 0 && id < std::int32_t(model.nodeIdToIndex.size()) &&
+                                   model.nodeIdToIndex[std::size_t(id)] >= 0;
+                if (!known)
+                {
+                    out.add("skin", QString("skin group %1 references missing node %2").arg(gi).arg(id));
+                    break;
+                }
+            }
+        }
+    }
+
+    static void checkHierarchy(const ModelData& model, IssueList& out)
+    {
+        const std::size_t n = model.nodes.size();
+        auto parentIndex = [&](std::size_t i) -> int
+        {
+            const std::int32_t pid = model.nodes[i].parentId;
+            if (pid < 0 || pid >= std::int32_t(model.nodeIdToIndex.size()))
+                return -1;
+            return model.nodeIdToIndex[std::size_t(pid)];
+        };
+
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const std::int32_t pid = model.nodes[i].parentId;
+            if (pid >= 0 && parentIndex(i) < 0)
+                out.add("hierarchy", QString("node %1 '%2' has missing parent %3")
+                                         .arg(model.nodes[i].objectId)
+                                         .arg(QString::fromStdString(model.nodes[i].name))
+                                         .arg(pid));
+        }
+
+        // 0 = unvisited, 1 = on current walk, 2 = known acyclic
+        std::vector<std::uint8_t> state(n, 0);
+        std::vector<std::size_t> walk;
+        for (std::size_t start = 0; start < n; ++start)
+        {
+            if (state[start] != 0)
+                continue;
+            walk.clear();
+            int cur = int(start);
+            while (cur >= 0 && state[std::size_t(cur)] == 0)
+            {
+                state[std::size_t(cur)] = 1;
+                walk.push_back(std::size_t(cur));
+                cur = parentIndex(std::size_t(cur));
+            }
+            if (cur >= 0 && state[std::size_t(cur)] == 1)
+                out.add("hierarchy", QString("parent cycle through node %1 '%2'")
+                                         .arg(model.nodes[std::size_t(cur)].objectId)
+                                         .arg(QString::fromStdString(model.nodes[std::size_t(cur)].name)));
+            for (std::size_t w : walk)
+                state[w] = 2;
+        }
+    }
+
+    template<typename T>
+    static void checkTrack(const MdxTrack<T>& track, const ModelData& model, const QString& what, IssueList& out)
+    {
+        if (track.keys.empty())
+            return;
+        if (track.globalSeqId >= 0 && std::size_t(track.globalSeqId) >= model.globalSequencesMs.size())
+            out.add("track", QString("%1: global sequence %2 out of range (%3)")
+                                 .arg(what).arg(track.globalSeqId).arg(model.globalSequencesMs.size()));
+        for (std::size_t k = 1; k < track.keys.size(); ++k)
+        {
+            if (track.keys[k].timeMs < track.keys[k - 1].timeMs)
+            {
+                out.add("track", QString("%1: key %2 at %3ms precedes previous key at %4ms")
+                                     .arg(what).arg(k).arg(track.keys[k].timeMs).arg(track.keys[k - 1].timeMs));
+                break;
+            }
+        }
+    }
+
+    static void checkTracks(const ModelData& model, IssueList& out)
+    {
+        for (std::size_t i = 0; i < model.sequences.size(); ++i)
+        {
+            const auto& s = model.sequences[i];
+            if (s.endMs < s.startMs)
+                out.add("track", QString("sequence %1 '%2' ends before it starts (%3..%4)")
+                                     .arg(i).arg(QString::fromStdString(s.name)).arg(s.startMs).arg(s.endMs));
+        }
+
+        for (const auto& n : model.nodes)
+        {
+            const QString name = QString("node %1").arg(n.objectId);
+            checkTrack(n.trackTranslation, model, name + " translation", out);
+            checkTrack(n.trackRotation, model, name + " rotation", out);
+            checkTrack(n.trackScaling, model, name + " scaling", out);
+        }
+        for (std::size_t i = 0; i < model.materials.size(); ++i)
+            checkTrack(model.materials[i].layer.trackAlpha, model, QString("material %1 alpha").arg(i), out);
+        for (std::size_t i = 0; i < model.textureAnimations.size(); ++i)
+        {
+            const auto& ta = model.textureAnimations[i];
+            const QString name = QString("texture anim %1").arg(i);
+            checkTrack(ta.translation, model, name + " translation", out);
+            checkTrack(ta.rotation, model, name + " rotation", out);
+            checkTrack(ta.scaling, model, name + " scaling", out);
+        }
+        for (std::size_t i = 0; i < model.geosetAnimations.size(); ++i)
+        {
+            const auto& ga = model.geosetAnimations[i];
+            checkTrack(ga.trackAlpha, model, QString("geoset anim %1 alpha").arg(i), out);
+            checkTrack(ga.trackColor, model, QString("geoset anim %1 color").arg(i), out);
+        }
+        for (const auto& e : model.emitters2)
+        {
+            const QString name = QString("emitter %1").arg(e.objectId);
+            checkTrack(e.trackSpeed, model, name + " speed", out);
+            checkTrack(e.trackEmissionRate, model, name + " emission", out);
+            checkTrack(e.trackGravity, model, name + " gravity", out);
+            checkTrack(e.trackLifespan, model, name + " lifespan", out);
+            checkTrack(e.trackVisibility, model, name + " visibility", out);
+            checkTrack(e.trackVariation, model, name + " variation", out);
+            checkTrack(e.trackLatitude, model, name + " latitude", out);
+            checkTrack(e.trackWidth, model, name + " width", out);
+            checkTrack(e.trackLength, model, name + " length", out);
+        }
+    }
+
+    static void checkBounds(const ModelData& model, IssueList& out)
+    {
+        // Anything beyond this is almost certainly garbage from a misparsed chunk.
+        static constexpr float kMaxExtent = 1.0e6f;
+
+        if (model.hasBounds)
+        {
+            const float* mn = model.boundsMin;
+            const float* mx = model.boundsMax;
+            if (!finite3(mn[0], mn[1], mn[2]) || !finite3(mx[0], mx[1], mx[2]))
+                out.add("bounds", "bounds are not finite");
+            else if (mn[0] > mx[0] || mn[1] > mx[1] || mn[2] > mx[2])
+                out.add("bounds", QString("bounds min > max ([%1,%2,%3]-[%4,%5,%6])")
+                                      .arg(mn[0]).arg(mn[1]).arg(mn[2]).arg(mx[0]).arg(mx[1]).arg(mx[2]));
+            else if (mx[0] - mn[0] > kMaxExtent || mx[1] - mn[1] > kMaxExtent || mx[2] - mn[2] > kMaxExtent)
+                out.add("bounds", "bounds extent exceeds 1e6");
+        }
+
+        std::size_t badPos = 0;
+        std::size_t badNrm = 0;
+        std::size_t badUv = 0;
+        for (const auto& v : model.vertices)
+        {
+            if (!finite3(v.px, v.py, v.pz))
+                badPos++;
+            if (!finite3(v.nx, v.ny, v.nz))
+                badNrm++;
+            if (!std::isfinite(v.u) || !std::isfinite(v.v))
+                badUv++;
+        }
+        if (badPos > 0)
+            out.add("bounds", QString("%1 vertices have non-finite positions").arg(badPos));
+        if (badNrm > 0)
+            out.add("bounds", QString("%1 vertices have non-finite normals").arg(badNrm));
+        if (badUv > 0)
+            out.add("bounds", QString("%1 vertices have non-finite UVs").arg(badUv));
+    }
+
+    static double elapsedMs(const QElapsedTimer& t)
+    {
+        return double(t.nsecsElapsed()) / 1.0e6;
+    }
+}
+
+namespace MdxValidator
+{
+    std::uint32_t MaxIndex(const std::vector<std::uint32_t>& indices)
+    {
+        // Independent accumulators keep the loop free of a serial dependency,
+        // which lets the compiler vectorize it.
+        const std::uint32_t* p = indices.data();
+        const std::size_t n = indices.size();
+        std::uint32_t m0 = 0, m1 = 0, m2 = 0, m3 = 0;
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            m0 = std::max(m0, p[i + 0]);
+            m1 = std::max(m1, p[i + 1]);
+            m2 = std::max(m2, p[i + 2]);
+            m3 = std::max(m3, p[i + 3]);
+        }
+        for (; i < n; ++i)
+            m0 = std::max(m0, p[i]);
+        return std::max(std::max(m0, m1), std::max(m2, m3));
+    }
+
+    std::vector<Issue> ValidateModel(const ModelData& model)
+    {
+        IssueList out;
+        checkIndices(model, out);
+        checkSkin(model, out);
+        checkHierarchy(model, out);
+        checkTracks(model, out);
+        checkBounds(model, out);
+        if (out.dropped > 0)
+            out.issues.push_back({"limit", QString("%1 more issues not listed").arg(out.dropped)});
+        return out.issues;
+    }
+
+    std::vector<FileResult> ValidateFiles(const QStringList& files, int threads, RunSummary* outSummary)
+    {
+        std::vector<FileResult> results(std::size_t(files.size()));
+        const int workerCount = WorkStealing::ResolveThreadCount(threads);
+
+        QElapsedTimer wall;
+        wall.start();
+        WorkStealing::ParallelFor(results.size(), workerCount, [&](std::size_t i)
+        {
+            FileResult& r = results[i];
+            r.path = files[int(i)];
+
+            QElapsedTimer t;
+            t.start();
+            QByteArray bytes;
+            QFile f(r.path);
+            if (f.open(QIODevice::ReadOnly))
+                bytes = f.readAll();
+            r.readMs = elapsedMs(t);
+            r.bytes = bytes.size();
+            if (bytes.isEmpty())
+            {
+                r.loadError = "Read failed or empty file.";
+                return;
+            }
+
+            t.restart();
+            const auto model = MdxLoader::LoadFromBytes(bytes, &r.loadError);
+            r.parseMs = elapsedMs(t);
+            if (!model)
+                return;
+
+            t.restart();
+            r.loaded = true;
+            r.vertexCount = std::uint32_t(model->vertices.size());
+            r.triangleCount = std::uint32_t(model->indices.size() / 3);
+            r.subMeshCount = std::uint32_t(model->subMeshes.size());
+            r.maxIndex = MaxIndex(model->indices);
+            r.indexOk = model->indices.empty() || r.maxIndex < model->vertices.size();
+            for (int k = 0; k < 3; ++k)
+            {
+                r.boundsMin[k] = model->boundsMin[k];
+                r.boundsMax[k] = model->boundsMax[k];
+            }
+            r.issues = ValidateModel(*model);
+            r.validateMs = elapsedMs(t);
+        });
+
+        if (outSummary)
+        {
+            // Aggregated after the join, in input order, so the summary never depends on scheduling.
+            RunSummary s;
+            s.threads = workerCount;
+            s.files = int(results.size());
+            s.wallMs = elapsedMs(wall);
+            std::map<QString, int> counts;
+            for (const auto& r : results)
+            {
+                s.bytes += r.bytes;
+                if (!r.loaded)
+                {
+                    s.loadFailed++;
+                    continue;
+                }
+                s.loaded++;
+                if (!r.issues.empty())
+                    s.withIssues++;
+                for (const auto& issue : r.issues)
+                    counts[issue.check]++;
+            }
+            const double secs = s.wallMs / 1000.0;
+            s.filesPerSec = secs > 0.0 ? double(s.files) / secs : 0.0;
+            s.mbPerSec = secs > 0.0 ? double(s.bytes) / (1024.0 * 1024.0) / secs : 0.0;
+            s.issueCounts.assign(counts.begin(), counts.end());
+            *outSummary = s;
+        }
+        return results;
+    }
+}
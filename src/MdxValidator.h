@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "ModelData.h"
+
+// Structural checks on loaded MDX models and a parallel corpus runner.
+// Checks: index bounds, skin group ranges, node parent cycles,
+// track key ordering / global sequence ids, and bounds sanity.
+
+namespace MdxValidator
+{
+    struct Issue
+    {
+        QString check; // index | skin | hierarchy | track | bounds
+        QString message;
+    };
+
+    struct FileResult
+    {
+        QString path;
+        bool loaded = false;
+        QString loadError;
+        qint64 bytes = 0;
+        double readMs = 0.0;
+        double parseMs = 0.0;
+        double validateMs = 0.0;
+
+        std::uint32_t vertexCount = 0;
+        std::uint32_t triangleCount = 0;
+        std::uint32_t subMeshCount = 0;
+        std::uint32_t maxIndex = 0;
+        bool indexOk = true;
+        float boundsMin[3] = {0, 0, 0};
+        float boundsMax[3] = {0, 0, 0};
+
+        std::vector<Issue> issues;
+        bool ok() const { return loaded && issues.empty(); }
+    };
+
+    struct RunSummary
+    {
+        int threads = 0;
+        int files = 0;
+        int loaded = 0;
+        int loadFailed = 0;
+        int withIssues = 0;
+        qint64 bytes = 0;
+        double wallMs = 0.0;
+        double filesPerSec = 0.0;
+        double mbPerSec = 0.0;
+        std::vector<std::pair<QString, int>> issueCounts; // per check, sorted by name
+    };
+
+    // Largest index in the buffer (vectorizable reduction).
+    std::uint32_t MaxIndex(const std::vector<std::uint32_t>& indices);
+
+    // Runs every check on an already loaded model.
+    std::vector<Issue> ValidateModel(const ModelData& model);
+
+    // Loads and validates `files` on `threads` workers (<= 0 = all cores).
+    // Results come back in input order, independent of scheduling.
+    std::vector<FileResult> ValidateFiles(const QStringList& files, int threads, RunSummary* outSummary = nullptr);
+}
@@ -0,0 +1,348 @@
+#include "MeshOptimizer.h"
+
+#include <QElapsedTimer>
+#include <QString>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "LoadTiming.h"
+#include "LogSink.h"
+#include "Trace.h"
+
+namespace
+{
+    // Forsyth's scoring cache; larger than the FIFO used for ACMR on purpose.
+    constexpr int kScoreCacheSize = 32;
+    constexpr int kValenceTableSize = 32;
+
+    struct ScoreTables
+    {
+        float cache[kScoreCacheSize];
+        float valence[kValenceTableSize];
+
+        ScoreTables()
+        {
+            for (int i = 0; i < kScoreCacheSize; ++i)
+            {
+                // The last triangle's vertices get a fixed score so its
+                // neighbours are not strongly preferred over a fresh strip.
+                cache[i] = i < 3 ? 0.75f
+                                 : std::pow(1.0f - float(i - 3) / float(kScoreCacheSize - 3), 1.5f);
+            }
+            valence[0] = 0.0f;
+            for (int i = 1; i < kValenceTableSize; ++i)
+                valence[i] = 2.0f / std::sqrt(float(i));
+        }
+    };
+
+    static const ScoreTables& Tables()
+    {
+        static const ScoreTables tables;
+        return tables;
+    }
+
+    static float VertexScore(int cachePos, std::uint32_t remaining)
+    {
+        if (remaining == 0)
+            return -1.0f; // no triangle left to draw with it
+        const ScoreTables& t = Tables();
+        float score = cachePos >= 0 ? t.cache[cachePos] : 0.0f;
+        score += remaining < kValenceTableSize ? t.valence[remaining] : 2.0f / std::sqrt(float(remaining));
+        return score;
+    }
+
+    // Re-orders the triangles of a list whose indices are all < vertexCount.
+    static void OptimizeTriangleOrder(std::uint32_t* indices, std::size_t indexCount, std::uint32_t vertexCount)
+    {
+        const std::size_t triCount = indexCount / 3;
+        if (triCount < 2)
+            return;
+
+        // Adjacency: the triangles still to be drawn with each vertex, packed
+        // per vertex in [offsets[v], offsets[v] + remaining[v]).
+        std::vector<std::uint32_t> remaining(vertexCount, 0);
+        for (std::size_t t = 0; t < triCount; ++t)
+        {
+            const std::uint32_t* tri = indices + t * 3;
+            remaining[tri[0]]++;
+            if (tri[1] != tri[0])
+                remaining[tri[1]]++;
+            if (tri[2] != tri[0] && tri[2] != tri[1])
+                remaining[tri[2]]++;
+        }
+        std::vector<std::uint32_t> offsets(std::size_t(vertexCount) + 1, 0);
+        for (std::uint32_t v = 0; v < vertexCount; ++v)
+            offsets[v + 1] = offsets[v] + remaining[v];
+        std::vector<std::uint32_t> adjacency(offsets[vertexCount]);
+        {
+            std::vector<std::uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (std::size_t t = 0; t < triCount; ++t)
+            {
+                const std::uint32_t* tri = indices + t * 3;
+                adjacency[fill[tri[0]]++] = std::uint32_t(t);
+                if (tri[1] != tri[0])
+                    adjacency[fill[tri[1]]++] = std::uint32_t(t);
+                if (tri[2] != tri[0] && tri[2] != tri[1])
+                    adjacency[fill[tri[2]]++] = std::uint32_t(t);
+            }
+        }
+
+        std::vector<int> cachePos(vertexCount, -1);
+        std::vector<float> score(vertexCount);
+        for (std::uint32_t v = 0; v < vertexCount; ++v)
+            score[v] = VertexScore(-1, remaining[v]);
+
+        auto triScore = [&](std::size_t t) {
+            const std::uint32_t* tri = indices + t * 3;
+            return score[tri[0]] + score[tri[1]] + score[tri[2]];
+        };
+
+        std::vector<std::uint8_t> emitted(triCount, 0);
+        std::vector<std::uint32_t> out;
+        out.reserve(indexCount);
+
+        std::size_t best = 0;
+        float bestScore = -std::numeric_limits<float>::infinity();
+        for (std::size_t t = 0; t < triCount; ++t)
+        {
+            const float s = triScore(t);
+            if (s > bestScore)
+            {
+                bestScore = s;
+                best = t;
+            }
+        }
+
+        std::vector<std::uint32_t> cache;
+        std::vector<std::uint32_t> nextCache;
+        cache.reserve(kScoreCacheSize + 3);
+        nextCache.reserve(kScoreCacheSize + 3);
+        std::size_t cursor = 0;
+
+        for (std::size_t drawn = 0; drawn < triCount; ++drawn)
+        {
+            if (best == triCount)
+            {
+                // Nothing in the cache touches an undrawn triangle: continue
+                // with the next one in input order.
+                while (emitted[cursor])
+                    ++cursor;
+                best = cursor;
+            }
+
+            const std::uint32_t* tri = indices + best * 3;
+            out.insert(out.end(), tri, tri + 3);
+            emitted[best] = 1;
+
+            nextCache.clear();
+            for (int k = 0; k < 3; ++k)
+            {
+                const std::uint32_t v = tri[k];
+                if (std::find(nextCache.begin(), nextCache.end(), v) != nextCache.end())
+                    continue;
+                nextCache.push_back(v);
+
+                std::uint32_t* adj = adjacency.data() + offsets[v];
+                for (std::uint32_t i = 0; i < remaining[v]; ++i)
+                {
+                    if (adj[i] == best)
+                    {
+                        adj[i] = adj[remaining[v] - 1];
+                        remaining[v]--;
+                        break;
+                    }
+                }
+            }
+            const std::size_t triVerts = nextCache.size();
+            for (std::uint32_t v : cache)
+            {
+                const auto begin = nextCache.begin();
+                if (std::find(begin, begin + std::ptrdiff_t(triVerts), v) == begin + std::ptrdiff_t(triVerts))
+                    nextCache.push_back(v);
+            }
+
+            for (std::size_t i = 0; i < nextCache.size(); ++i)
+            {
+                const std::uint32_t v = nextCache[i];
+                cachePos[v] = i < std::size_t(kScoreCacheSize) ? int(i) : -1;
+                score[v] = VertexScore(cachePos[v], remaining[v]);
+            }
+            if (nextCache.size() > std::size_t(kScoreCacheSize))
+                nextCache.resize(kScoreCacheSize);
+            cache.swap(nextCache);
+
+            best = triCount;
+            bestScore = -std::numeric_limits<float>::infinity();
+            for (std::uint32_t v : cache)
+            {
+                const std::uint32_t* adj = adjacency.data() + offsets[v];
+                for (std::uint32_t i = 0; i < remaining[v]; ++i)
+                {
+                    const float s = triScore(adj[i]);
+                    if (s > bestScore)
+                    {
+                        bestScore = s;
+                        best = adj[i];
+                    }
+                }
+            }
+        }
+
+        std::copy(out.begin(), out.end(), indices);
+    }
+
+    // True if every index of the submesh lies in its geoset's vertex range.
+    static bool InGeosetRange(const ModelData& model, const SubMesh& sm, std::uint32_t base, std::uint32_t count)
+    {
+        if (std::size_t(sm.indexOffset) + sm.indexCount > model.indices.size() ||
+            std::size_t(base) + count > model.vertices.size())
+        {
+            return false;
+        }
+        for (std::uint32_t i = 0; i < sm.indexCount; ++i)
+        {
+            const std::uint32_t idx = model.indices[sm.indexOffset + i];
+            if (idx < base || idx - base >= count)
+                return false;
+        }
+        return true;
+    }
+
+    template<typename T>
+    static void PermuteRange(std::vector<T>& values, std::size_t base, const std::vector<std::uint32_t>& newFromOld)
+    {
+        std::vector<T> old(values.begin() + std::ptrdiff_t(base),
+                           values.begin() + std::ptrdiff_t(base + newFromOld.size()));
+        for (std::size_t i = 0; i < newFromOld.size(); ++i)
+            values[base + newFromOld[i]] = old[i];
+    }
+
+    // Renumbers a geoset's vertices in the order the (already re-ordered)
+    // triangles first reference them; unreferenced vertices go last.
+    static void ReorderVertices(ModelData& model, const SubMesh& sm, ModelData::GeosetDiagnostics& gd)
+    {
+        const std::uint32_t base = gd.baseVertex;
+        const std::uint32_t count = gd.vertexCount;
+        constexpr std::uint32_t kUnassigned = std::numeric_limits<std::uint32_t>::max();
+        std::vector<std::uint32_t> newFromOld(count, kUnassigned);
+        std::uint32_t next = 0;
+        for (std::uint32_t i = 0; i < sm.indexCount; ++i)
+        {
+            std::uint32_t& idx = model.indices[sm.indexOffset + i];
+            std::uint32_t& mapped = newFromOld[idx - base];
+            if (mapped == kUnassigned)
+                mapped = next++;
+            idx = base + mapped;
+        }
+        for (std::uint32_t& mapped : newFromOld)
+        {
+            if (mapped == kUnassigned)
+                mapped = next++;
+        }
+
+        PermuteRange(model.vertices, base, newFromOld);
+        if (model.bindVertices.size() == model.vertices.size())
+            PermuteRange(model.bindVertices, base, newFromOld);
+        if (model.vertexGroups.size() == model.vertices.size())
+            PermuteRange(model.vertexGroups, base, newFromOld);
+        if (gd.gndx.size() == count)
+            PermuteRange(gd.gndx, 0, newFromOld);
+    }
+}
+
+namespace MeshOptimizer
+{
+    double ComputeAcmr(const std::uint32_t* indices, std::size_t indexCount, int cacheSize)
+    {
+        const std::size_t triCount = indexCount / 3;
+        if (triCount == 0 || cacheSize <= 0)
+            return 0.0;
+
+        std::vector<std::uint32_t> fifo(std::size_t(cacheSize), std::numeric_limits<std::uint32_t>::max());
+        std::size_t head = 0;
+        std::size_t misses = 0;
+        for (std::size_t i = 0; i < triCount * 3; ++i)
+        {
+            const std::uint32_t v = indices[i];
+            if (std::find(fifo.begin(), fifo.end(), v) != fifo.end())
+                continue;
+            fifo[head] = v;
+            head = (head + 1) % fifo.size();
+            ++misses;
+        }
+        return double(misses) / double(triCount);
+    }
+
+    Stats OptimizeModel(ModelData& model, LoadTiming* outTiming)
+    {
+        Trace::Scope trace("mesh", "Optimize");
+        QElapsedTimer timer;
+        timer.start();
+
+        Stats stats;
+        model.indices16.clear();
+        if (model.indices.empty())
+            return stats;
+
+        stats.acmrBefore = ComputeAcmr(model.indices.data(), model.indices.size());
+
+        // Vertex groups are only appended for skinned geosets; if some geoset
+        // has none, the per-vertex mapping is unknown and vertices stay put.
+        const bool canReorderVertices = model.vertexGroups.empty() || model.vertexGroups.size() == model.vertices.size();
+
+        for (const SubMesh& sm : model.subMeshes)
+        {
+            if (sm.geosetIndex >= model.geosetDiagnostics.size())
+            {
+                stats.skippedSubMeshes++;
+                continue;
+            }
+            ModelData::GeosetDiagnostics& gd = model.geosetDiagnostics[sm.geosetIndex];
+            if (!InGeosetRange(model, sm, gd.baseVertex, gd.vertexCount))
+            {
+                stats.skippedSubMeshes++;
+                continue;
+            }
+
+            std::uint32_t* idx = model.indices.data() + sm.indexOffset;
+            for (std::uint32_t i = 0; i < sm.indexCount; ++i)
+                idx[i] -= gd.baseVertex;
+            OptimizeTriangleOrder(idx, sm.indexCount, gd.vertexCount);
+            for (std::uint32_t i = 0; i < sm.indexCount; ++i)
+                idx[i] += gd.baseVertex;
+
+            if (canReorderVertices)
+                ReorderVertices(model, sm, gd);
+            stats.optimizedSubMeshes++;
+        }
+        stats.reorderedVertices = canReorderVertices && stats.optimizedSubMeshes > 0;
+
+        stats.acmrAfter = ComputeAcmr(model.indices.data(), model.indices.size());
+
+        if (model.vertices.size() <= std::size_t(std::numeric_limits<std::uint16_t>::max()) + 1)
+        {
+            model.indices16.assign(model.indices.begin(), model.indices.end());
+            stats.indices16 = true;
+        }
+
+        const double ms = double(timer.nsecsElapsed()) / 1.0e6;
+        if (outTiming)
+        {
+            outTiming->optimizeMs = ms;
+            outTiming->acmrBefore = stats.acmrBefore;
+            outTiming->acmrAfter = stats.acmrAfter;
+        }
+        LogSink::instance().log(LogLevel::Debug,
+                                QString("Mesh optimize: ACMR %1 -> %2, %3 submeshes (%4 skipped), %5-bit indices, %6 ms")
+                                    .arg(stats.acmrBefore, 0, 'f', 3)
+                                    .arg(stats.acmrAfter, 0, 'f', 3)
+                                    .arg(stats.optimizedSubMeshes)
+                                    .arg(stats.skippedSubMeshes)
+                                    .arg(stats.indices16 ? 16 : 32)
+                                    .arg(ms, 0, 'f', 2));
+        return stats;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ModelData.h"
+
+struct LoadTiming;
+
+// Post-load mesh optimization for the GPU path:
+// - triangles of each submesh are re-ordered for post-transform vertex cache
+//   locality (Tom Forsyth's linear-speed vertex cache optimization);
+// - vertices of each geoset are re-ordered by first use, so fetches walk the
+//   vertex buffer forward; per-vertex data (vertexGroups, GNDX) follows along
+//   and geoset base vertices stay valid;
+// - ModelData::indices16 is filled when every index fits in 16 bits.
+// The result renders and exports exactly like the input.
+
+namespace MeshOptimizer
+{
+    // FIFO size used for reported ACMR figures; close to what desktop GPUs of
+    // the War3 era expose and a fair proxy for current ones.
+    constexpr int kAcmrCacheSize = 16;
+
+    struct Stats
+    {
+        double acmrBefore = 0.0; // transformed vertices per triangle
+        double acmrAfter = 0.0;
+        int optimizedSubMeshes = 0;
+        int skippedSubMeshes = 0; // indices outside their geoset; left untouched
+        bool reorderedVertices = false;
+        bool indices16 = false;
+    };
+
+    // Average cache miss ratio of a triangle list through a FIFO vertex cache.
+    double ComputeAcmr(const std::uint32_t* indices, std::size_t indexCount, int cacheSize = kAcmrCacheSize);
+
+    // Optimizes in place. Meant for load threads; `outTiming` gets the time and ACMR.
+    Stats OptimizeModel(ModelData& model, LoadTiming* outTiming = nullptr);
+}
@@ -0,0 +1,702 @@
+#include "ModelAnim.h"
+
+#include <QMatrix3x3>
+#include <QVector4D>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "LogSink.h"
+
+namespace
+{
+    // Bones of a matrix group that skinning averages: up to 4, or 8 for extended groups.
+    static int GroupBoneCount(const ModelData::SkinGroup& group)
+    {
+        const int maxBones = (group.nodeIndices.size() > 4) ? 8 : 4;
+        return std::min<int>(int(group.nodeIndices.size()), maxBones);
+    }
+
+    static bool SameValue(float a, float b) { return a == b; }
+    static bool SameValue(const Vec3& a, const Vec3& b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+    static bool SameValue(const Vec4& a, const Vec4& b)
+    {
+        return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
+    }
+
+    // Whether a spline segment between keys equal to `value` stays flat. Hermite
+    // tangents are derivatives and must be zero; Bezier tangents are control points
+    // and must equal the value.
+    template<typename T>
+    static bool SplineHolds(MdxInterp interp, const MdxTrackKey<T>& key, const T& value)
+    {
+        if (interp == MdxInterp::Hermite)
+            return SameValue(key.inTan, T{}) && SameValue(key.outTan, T{});
+        if (interp == MdxInterp::Bezier)
+            return SameValue(key.inTan, value) && SameValue(key.outTan, value);
+        return true;
+    }
+
+    // SampleTrackQuat slerps toward the tangents as quaternions for both Hermite and
+    // Bezier, so a rotation only holds when they equal the key.
+    static bool SplineHolds(MdxInterp interp, const MdxTrackKey<Vec4>& key, const Vec4& value)
+    {
+        if (interp == MdxInterp::Hermite || interp == MdxInterp::Bezier)
+            return SameValue(key.inTan, value) && SameValue(key.outTan, value);
+        return true;
+    }
+
+    // Whether sampling `track` gives one value for every global time in [startMs, endMs].
+    // Only keys that can contribute are compared, and their spline tangents must hold
+    // the value too (see SplineHolds).
+    template<typename T>
+    static bool IsTrackConstant(const MdxTrack<T>& track, std::uint32_t startMs, std::uint32_t endMs, const ModelData& model)
+    {
+        const auto& keys = track.keys;
+        if (keys.size() <= 1)
+            return true;
+
+        std::size_t first = 0;
+        std::size_t last = keys.size() - 1;
+        const bool global = track.globalSeqId >= 0 && std::size_t(track.globalSeqId) < model.globalSequencesMs.size() &&
+                            model.globalSequencesMs[std::size_t(track.globalSeqId)] != 0;
+        if (!global)
+        {
+            // Exactly on a key, interpolated tracks give that key's value; stepped
+            // (None) tracks still give the previous one.
+            const bool stepped = track.interp == MdxInterp::None;
+            while (first + 1 < keys.size() &&
+                   (stepped ? keys[first + 1].timeMs < startMs : keys[first + 1].timeMs <= startMs))
+                ++first;
+            while (last > first && keys[last - 1].timeMs >= endMs)
+                --last;
+        }
+
+        const T& value = keys[first].value;
+        for (std::size_t i = first; i <= last; ++i)
+        {
+            if (!SameValue(keys[i].value, value) || !SplineHolds(track.interp, keys[i], value))
+                return false;
+        }
+        return true;
+    }
+
+    static float clampf(float v, float lo, float hi)
+    {
+        return (v < lo) ? lo : (v > hi) ? hi : v;
+    }
+
+    static float lerpf(float a, float b, float t)
+    {
+        return a + (b - a) * t;
+    }
+
+    static float hermite(float p0, float m0, float p1, float m1, float t)
+    {
+        const float t2 = t * t;
+        const float t3 = t2 * t;
+        return (2*t3 - 3*t2 + 1) * p0 +
+               (t3 - 2*t2 + t) * m0 +
+               (-2*t3 + 3*t2) * p1 +
+               (t3 - t2) * m1;
+    }
+
+    static float bezier(float p0, float c1, float c2, float p1, float t)
+    {
+        const float it = 1.0f - t;
+        return it*it*it*p0 + 3*it*it*t*c1 + 3*it*t*t*c2 + t*t*t*p1;
+    }
+
+    static Vec3 lerpVec3(const Vec3& a, const Vec3& b, float t)
+    {
+        return { lerpf(a.x, b.x, t), lerpf(a.y, b.y, t), lerpf(a.z, b.z, t) };
+    }
+
+    static Vec3 hermiteVec3(const Vec3& p0, const Vec3& m0, const Vec3& p1, const Vec3& m1, float t)
+    {
+        return {
+            hermite(p0.x, m0.x, p1.x, m1.x, t),
+            hermite(p0.y, m0.y, p1.y, m1.y, t),
+            hermite(p0.z, m0.z, p1.z, m1.z, t)
+        };
+    }
+
+    static Vec3 bezierVec3(const Vec3& p0, const Vec3& c1, const Vec3& c2, const Vec3& p1, float t)
+    {
+        return {
+            bezier(p0.x, c1.x, c2.x, p1.x, t),
+            bezier(p0.y, c1.y, c2.y, p1.y, t),
+            bezier(p0.z, c1.z, c2.z, p1.z, t)
+        };
+    }
+
+    static Vec4 lerpVec4(const Vec4& a, const Vec4& b, float t)
+    {
+        return { lerpf(a.x, b.x, t), lerpf(a.y, b.y, t), lerpf(a.z, b.z, t), lerpf(a.w, b.w, t) };
+    }
+
+    static Vec4 normalizeQuat(const Vec4& q)
+    {
+        const float len = std::sqrt(q.x*q.x + q.y*q.y + q.z*q.z + q.w*q.w);
+        if (len <= 0.000001f)
+            return {0,0,0,1};
+        const float inv = 1.0f / len;
+        return { q.x * inv, q.y * inv, q.z * inv, q.w * inv };
+    }
+
+    static float dotQuat(const Vec4& a, const Vec4& b)
+    {
+        return a.x*b.x + a.y*b.y + a.z*b.z + a.w*b.w;
+    }
+
+    static Vec4 slerpQuat(Vec4 a, Vec4 b, float t, bool invertIfNecessary)
+    {
+        float dot = dotQuat(a, b);
+        if (invertIfNecessary && dot < 0.0f)
+        {
+            dot = -dot;
+            b.x = -b.x; b.y = -b.y; b.z = -b.z; b.w = -b.w;
+        }
+
+        if (dot > 0.95f)
+        {
+            return normalizeQuat(lerpVec4(a, b, t));
+        }
+
+        dot = clampf(dot, -1.0f, 1.0f);
+        const float theta0 = std::acos(dot);
+        const float sinTheta0 = std::sin(theta0);
+        if (sinTheta0 <= 0.000001f)
+            return normalizeQuat(lerpVec4(a, b, t));
+        const float theta = theta0 * t;
+        const float sinTheta = std::sin(theta);
+        const float s0 = std::cos(theta) - dot * sinTheta / sinTheta0;
+        const float s1 = sinTheta / sinTheta0;
+        return { a.x * s0 + b.x * s1, a.y * s0 + b.y * s1, a.z * s0 + b.z * s1, a.w * s0 + b.w * s1 };
+    }
+}
+
+namespace ModelAnim
+{
+    float SampleTrackFloat(const MdxTrack<float>& tr, std::uint32_t timeMs, float def, const ModelData& model)
+    {
+        if (tr.keys.empty())
+            return def;
+
+        if (tr.globalSeqId >= 0 && std::size_t(tr.globalSeqId) < model.globalSequencesMs.size())
+        {
+            const std::uint32_t len = model.globalSequencesMs[std::size_t(tr.globalSeqId)];
+            if (len != 0)
+                timeMs = timeMs % len;
+        }
+
+        const auto& keys = tr.keys;
+        if (timeMs <= keys.front().timeMs)
+            return keys.front().value;
+        if (timeMs >= keys.back().timeMs)
+            return keys.back().value;
+
+        // find segment
+        std::size_t hi = 1;
+        while (hi < keys.size() && timeMs > keys[hi].timeMs)
+            ++hi;
+        if (hi >= keys.size())
+            return keys.back().value;
+        const std::size_t lo = hi - 1;
+
+        const auto& k0 = keys[lo];
+        const auto& k1 = keys[hi];
+        const float denom = float(k1.timeMs - k0.timeMs);
+        const float t = denom > 0.0f ? float(timeMs - k0.timeMs) / denom : 0.0f;
+
+        switch (tr.interp)
+        {
+        case MdxInterp::None:
+            return k0.value;
+        case MdxInterp::Linear:
+            return lerpf(k0.value, k1.value, t);
+        case MdxInterp::Hermite:
+            // MDX stores tangents per key; use outTan of k0 and inTan of k1.
+            return hermite(k0.value, k0.outTan, k1.value, k1.inTan, t);
+        case MdxInterp::Bezier:
+            // Treat tangents as Bezier control points.
+            return bezier(k0.value, k0.outTan, k1.inTan, k1.value, t);
+        default:
+            return k0.value;
+        }
+    }
+
+    Vec3 SampleTrackVec3(const MdxTrack<Vec3>& tr, std::uint32_t timeMs, const Vec3& def, const ModelData& model)
+    {
+        if (tr.keys.empty())
+            return def;
+
+        if (tr.globalSeqId >= 0 && std::size_t(tr.globalSeqId) < model.globalSequencesMs.size())
+        {
+            const std::uint32_t len = model.globalSequencesMs[std::size_t(tr.globalSeqId)];
+            if (len != 0)
+                timeMs = timeMs % len;
+        }
+
+        const auto& keys = tr.keys;
+        if (timeMs <= keys.front().timeMs)
+            return keys.front().value;
+        if (timeMs >= keys.back().timeMs)
+            return keys.back().value;
+
+        std::size_t hi = 1;
+        while (hi < keys.size() && timeMs > keys[hi].timeMs)
+            ++hi;
+        if (hi >= keys.size())
+            return keys.back().value;
+        const std::size_t lo = hi - 1;
+
+        const auto& k0 = keys[lo];
+        const auto& k1 = keys[hi];
+        const float denom = float(k1.timeMs - k0.timeMs);
+        const float t = denom > 0.0f ? float(timeMs - k0.timeMs) / denom : 0.0f;
+
+        switch (tr.interp)
+        {
+        case MdxInterp::None:
+            return k0.value;
+        case MdxInterp::Linear:
+            return lerpVec3(k0.value, k1.value, t);
+        case MdxInterp::Hermite:
+            return hermiteVec3(k0.value, k0.outTan, k1.value, k1.inTan, t);
+        case MdxInterp::Bezier:
+            return bezierVec3(k0.value, k0.outTan, k1.inTan, k1.value, t);
+        default:
+            return k0.value;
+        }
+    }
+
+    Vec4 SampleTrackQuat(const MdxTrack<Vec4>& tr, std::uint32_t timeMs, const Vec4& def, const ModelData& model)
+    {
+        if (tr.keys.empty())
+            return def;
+
+        if (tr.globalSeqId >= 0 && std::size_t(tr.globalSeqId) < model.globalSequencesMs.size())
+        {
+            const std::uint32_t len = model.globalSequencesMs[std::size_t(tr.globalSeqId)];
+            if (len != 0)
+                timeMs = timeMs % len;
+        }
+
+        const auto& keys = tr.keys;
+        if (timeMs <= keys.front().timeMs)
+            return normalizeQuat(keys.front().value);
+        if (timeMs >= keys.back().timeMs)
+            return normalizeQuat(keys.back().value);
+
+        std::size_t hi = 1;
+        while (hi < keys.size() && timeMs > keys[hi].timeMs)
+            ++hi;
+        if (hi >= keys.size())
+            return normalizeQuat(keys.back().value);
+        const std::size_t lo = hi - 1;
+
+        const auto& k0 = keys[lo];
+        const auto& k1 = keys[hi];
+        const float denom = float(k1.timeMs - k0.timeMs);
+        const float t = denom > 0.0f ? float(timeMs - k0.timeMs) / denom : 0.0f;
+
+        switch (tr.interp)
+        {
+        case MdxInterp::None:
+            return normalizeQuat(k0.value);
+        case MdxInterp::Linear:
+            return slerpQuat(k0.value, k1.value, t, true);
+        case MdxInterp::Hermite:
+        {
+            const Vec4 slerp = slerpQuat(k0.value, k1.value, t, false);
+            const Vec4 slerpTan = slerpQuat(k0.outTan, k1.inTan, t, false);
+            return slerpQuat(slerp, slerpTan, 2.0f * t * (1.0f - t), false);
+        }
+        case MdxInterp::Bezier:
+        {
+            const Vec4 s0 = slerpQuat(k0.value, k0.outTan, t, false);
+            const Vec4 s1 = slerpQuat(k0.outTan, k1.inTan, t, false);
+            const Vec4 s2 = slerpQuat(k1.inTan, k1.value, t, false);
+            const Vec4 s3 = slerpQuat(s0, s1, t, false);
+            const Vec4 s4 = slerpQuat(s1, s2, t, false);
+            return slerpQuat(s3, s4, t, false);
+        }
+        default:
+            return normalizeQuat(k0.value);
+        }
+    }
+
+    void NodePose::reset(std::size_t size)
+    {
+        world.assign(size, QMatrix4x4());
+        worldLoc.assign(size, QVector3D(0, 0, 0));
+        invWorldLoc.assign(size, QVector3D(0, 0, 0));
+        worldRot.assign(size, QQuaternion(1, 0, 0, 0));
+        invWorldRot.assign(size, QQuaternion(1, 0, 0, 0));
+        worldScale.assign(size, QVector3D(1, 1, 1));
+        invWorldScale.assign(size, QVector3D(1, 1, 1));
+        for (auto& m : world)
+            m.setToIdentity();
+    }
+
+    void NodePose::clear()
+    {
+        world.clear();
+        worldLoc.clear();
+        invWorldLoc.clear();
+        worldRot.clear();
+        invWorldRot.clear();
+        worldScale.clear();
+        invWorldScale.clear();
+    }
+
+    void ComputeNodeWorld(const ModelData& model, std::uint32_t globalTimeMs, std::vector<QMatrix4x4>& outWorld)
+    {
+        const int maxObjectId = model.maxObjectId;
+        const std::size_t worldSize = (maxObjectId >= 0) ? std::size_t(maxObjectId + 1) : 0;
+        outWorld.assign(worldSize, QMatrix4x4());
+        for (auto& m : outWorld)
+            m.setToIdentity();
+
+        if (worldSize == 0 || model.nodes.empty())
+            return;
+
+        std::vector<int> state(worldSize, 0);
+
+        auto buildNode = [&](auto&& self, int objectId) -> void
+        {
+            if (objectId < 0 || std::size_t(objectId) >= worldSize)
+                return;
+            if (state[std::size_t(objectId)] == 2)
+                return;
+            if (state[std::size_t(objectId)] == 1)
+            {
+                outWorld[std::size_t(objectId)].setToIdentity();
+                state[std::size_t(objectId)] = 2;
+                return;
+            }
+            state[std::size_t(objectId)] = 1;
+
+            if (objectId >= static_cast<int>(model.nodeIdToIndex.size()))
+            {
+                outWorld[std::size_t(objectId)].setToIdentity();
+                state[std::size_t(objectId)] = 2;
+                return;
+            }
+
+            const int nodeIndex = model.nodeIdToIndex[objectId];
+            if (nodeIndex < 0 || std::size_t(nodeIndex) >= model.nodes.size())
+            {
+                outWorld[std::size_t(objectId)].setToIdentity();
+                state[std::size_t(objectId)] = 2;
+                return;
+            }
+
+            const auto& n = model.nodes[std::size_t(nodeIndex)];
+
+            QMatrix4x4 parentWorld;
+            parentWorld.setToIdentity();
+            if (n.parentId >= 0)
+            {
+                if (n.parentId < static_cast<int>(model.nodeIdToIndex.size()) &&
+                    model.nodeIdToIndex[n.parentId] >= 0)
+                {
+                    self(self, n.parentId);
+                    parentWorld = outWorld[std::size_t(n.parentId)];
+                }
+                else
+                {
+#ifndef NDEBUG
+                    static LogSink::RateLimit missingParentLimit(10);
+                    LogSink::instance().log(LogLevel::Warning, QString("Missing parent nodeId=%1 parentId=%2")
+                                                .arg(n.objectId)
+                                                .arg(n.parentId),
+                                            &missingParentLimit);
+#endif
+                }
+            }
+
+            const Vec3 defT{0, 0, 0};
+            const Vec3 defS{1, 1, 1};
+            const Vec4 defR{0, 0, 0, 1};
+
+            const Vec3 t = SampleTrackVec3(n.trackTranslation, globalTimeMs, defT, model);
+            const Vec3 s = SampleTrackVec3(n.trackScaling, globalTimeMs, defS, model);
+            Vec4 r = SampleTrackQuat(n.trackRotation, globalTimeMs, defR, model);
+
+            const QVector3D pivot(n.pivot.x, n.pivot.y, n.pivot.z);
+            const QVector3D localLoc(t.x, t.y, t.z);
+            const QVector3D localScale(s.x, s.y, s.z);
+
+            QQuaternion localRot(r.w, r.x, r.y, r.z);
+            localRot.normalize();
+
+            QMatrix4x4 localM;
+            localM.setToIdentity();
+            localM.translate(localLoc);
+            localM.translate(pivot);
+            localM.rotate(localRot);
+            localM.scale(localScale);
+            localM.translate(-pivot);
+
+            outWorld[std::size_t(objectId)] = parentWorld * localM;
+            state[std::size_t(objectId)] = 2;
+        };
+
+        for (const auto& n : model.nodes)
+            buildNode(buildNode, n.objectId);
+    }
+
+    void ComputeNodePose(const ModelData& model, std::uint32_t globalTimeMs, NodePose& pose)
+    {
+        const std::size_t worldSize =
+            (model.maxObjectId >= 0) ? std::size_t(model.maxObjectId + 1) : 0;
+
+        if (pose.world.size() != worldSize || pose.worldRot.size() != worldSize)
+            pose.reset(worldSize);
+
+        ComputeNodeWorld(model, globalTimeMs, pose.world);
+
+        for (std::size_t objectId = 0; objectId < pose.world.size(); ++objectId)
+        {
+            Vec3 pivot{0, 0, 0};
+            if (objectId < model.nodeIdToIndex.size())
+            {
+                const int idx = model.nodeIdToIndex[objectId];
+                if (idx >= 0 && std::size_t(idx) < model.nodes.size())
+                    pivot = model.nodes[std::size_t(idx)].pivot;
+            }
+
+            const QMatrix4x4& worldM = pose.world[objectId];
+            const QVector4D wlp = worldM * QVector4D(pivot.x, pivot.y, pivot.z, 1.0f);
+            const QVector3D wl(wlp.x(), wlp.y(), wlp.z());
+            pose.worldLoc[objectId] = wl;
+            pose.invWorldLoc[objectId] = -wl;
+
+            QVector3D xAxis(worldM(0, 0), worldM(1, 0), worldM(2, 0));
+            QVector3D yAxis(worldM(0, 1), worldM(1, 1), worldM(2, 1));
+            QVector3D zAxis(worldM(0, 2), worldM(1, 2), worldM(2, 2));
+
+            const float sx = xAxis.length();
+            const float sy = yAxis.length();
+            const float sz = zAxis.length();
+            pose.worldScale[objectId] = QVector3D(sx, sy, sz);
+
+            if (sx > 1e-8f) xAxis /= sx;
+            if (sy > 1e-8f) yAxis /= sy;
+            if (sz > 1e-8f) zAxis /= sz;
+
+            QMatrix3x3 rotM;
+            rotM(0, 0) = xAxis.x(); rotM(1, 0) = xAxis.y(); rotM(2, 0) = xAxis.z();
+            rotM(0, 1) = yAxis.x(); rotM(1, 1) = yAxis.y(); rotM(2, 1) = yAxis.z();
+            rotM(0, 2) = zAxis.x(); rotM(1, 2) = zAxis.y(); rotM(2, 2) = zAxis.z();
+
+            pose.worldRot[objectId] = QQuaternion::fromRotationMatrix(rotM);
+            pose.worldRot[objectId].normalize();
+            pose.invWorldRot[objectId] = pose.worldRot[objectId].conjugated();
+
+            auto invSafe = [](float v) -> float { return (std::fabs(v) > 1e-8f) ? (1.0f / v) : 0.0f; };
+            pose.invWorldScale[objectId] = QVector3D(invSafe(sx), invSafe(sy), invSafe(sz));
+        }
+    }
+
+    void SkinVertices(const ModelData& model, const std::vector<QMatrix4x4>& skinMats, std::vector<ModelVertex>& outVertices)
+    {
+        SkinVertexRange(model, skinMats, 0, model.bindVertices.size(), outVertices);
+    }
+
+    void SkinVertexRange(const ModelData& model, const std::vector<QMatrix4x4>& skinMats,
+                         std::size_t first, std::size_t count, std::vector<ModelVertex>& outVertices)
+    {
+        if (outVertices.size() != model.bindVertices.size())
+            outVertices = model.bindVertices;
+        const std::size_t end = std::min(first + count, model.bindVertices.size());
+
+        // Warcraft 3 classic MDX (v800) uses matrix groups (a list of *bone indices*) without explicit weights.
+        // The common approach (used by mdx-m3-viewer and WC3-compatible pipelines) is:
+        //   - Take up to 4 bones for standard groups, or up to 8 bones for "extended vertex groups".
+        //   - Transform by each matrix, sum, then divide by the number of bones considered (simple average).
+        //
+        // This is *not* mathematically correct skinning, but it matches real-world WC3 assets better
+        // than picking a single bone for multi-matrix groups.
+        //
+        // NOTE: Do not de-duplicate indices. Some assets rely on repeated indices to bias the average.
+        // Also note that the division uses the *declared* bone count (min(groupSize, maxBones)),
+        // even if some indices are invalid and skipped, to mimic the shader behavior.
+        auto skinAverage = [&](const ModelVertex& base, const ModelData::SkinGroup& group, ModelVertex& outV) -> bool
+        {
+            if (skinMats.empty())
+                return false;
+
+            const int boneNumber = GroupBoneCount(group);
+            if (boneNumber <= 0)
+                return false;
+
+            const QVector4D p4(base.px, base.py, base.pz, 1.0f);
+            const QVector4D n4(base.nx, base.ny, base.nz, 0.0f);
+
+            QVector4D sumP(0,0,0,0);
+            QVector4D sumN(0,0,0,0);
+
+            for (int i = 0; i < boneNumber; ++i)
+            {
+                const int boneIndex = group.nodeIndices[std::size_t(i)];
+                if (boneIndex < 0 || std::size_t(boneIndex) >= skinMats.size())
+                {
+#ifndef NDEBUG
+                    if (boneIndex > model.maxObjectId)
+                    {
+                        static LogSink::RateLimit skinRangeLimit(10);
+                        LogSink::instance().log(LogLevel::Warning, QString("Skin group nodeId out of range: %1 (maxObjectId=%2)")
+                                                    .arg(boneIndex)
+                                                    .arg(model.maxObjectId),
+                                                &skinRangeLimit);
+                    }
+#endif
+                    continue;
+                }
+
+                const QMatrix4x4& m = skinMats[std::size_t(boneIndex)];
+                sumP += m * p4;
+                sumN += m * n4;
+            }
+
+            const float inv = 1.0f / float(boneNumber);
+            const QVector4D avgP = sumP * inv;
+
+            QVector3D nn(sumN.x(), sumN.y(), sumN.z());
+            if (nn.lengthSquared() > 0.000001f)
+                nn.normalize();
+            else
+                nn = QVector3D(0,0,1);
+
+            outV = base;
+            outV.px = avgP.x();
+            outV.py = avgP.y();
+            outV.pz = avgP.z();
+            outV.nx = nn.x();
+            outV.ny = nn.y();
+            outV.nz = nn.z();
+            return true;
+        };
+
+        for (std::size_t i = first; i < end; ++i)
+        {
+            const auto& base = model.bindVertices[i];
+            if (i >= model.vertexGroups.size())
+            {
+                outVertices[i] = base;
+                continue;
+            }
+            const std::uint16_t gid = model.vertexGroups[i];
+            if (gid >= model.skinGroups.size())
+            {
+                outVertices[i] = base;
+                continue;
+            }
+            const auto& group = model.skinGroups[gid];
+            if (group.nodeIndices.empty())
+            {
+                outVertices[i] = base;
+                continue;
+            }
+
+            ModelVertex v;
+            if (skinAverage(base, group, v))
+                outVertices[i] = v;
+            else
+                outVertices[i] = base;
+        }
+    }
+
+    QMatrix4x4 GroupSkinMatrix(const ModelData::SkinGroup& group, const std::vector<QMatrix4x4>& skinMats)
+    {
+        const int boneNumber = GroupBoneCount(group);
+        if (boneNumber <= 0)
+            return QMatrix4x4();
+        QMatrix4x4 sum;
+        sum.fill(0.0f);
+        for (int i = 0; i < boneNumber; ++i)
+        {
+            const int boneIndex = group.nodeIndices[std::size_t(i)];
+            if (boneIndex >= 0 && std::size_t(boneIndex) < skinMats.size())
+                sum += skinMats[std::size_t(boneIndex)];
+        }
+        return sum * (1.0f / float(boneNumber));
+    }
+
+    int ClassifyRigidSubMeshes(ModelData& model)
+    {
+        const bool skinnable = !model.bindVertices.empty() &&
+                               model.vertexGroups.size() == model.bindVertices.size() &&
+                               !model.skinGroups.empty() && !model.nodes.empty();
+
+        // A group only qualifies if SkinVertices would use every bone it lists;
+        // skipped bones make the average non-affine.
+        auto usableGroup = [&](std::uint16_t gid) {
+            if (gid >= model.skinGroups.size())
+                return false;
+            const auto& group = model.skinGroups[gid];
+            const int boneNumber = GroupBoneCount(group);
+            if (boneNumber <= 0)
+                return false;
+            for (int i = 0; i < boneNumber; ++i)
+            {
+                const int boneIndex = group.nodeIndices[std::size_t(i)];
+                if (boneIndex < 0 || boneIndex > model.maxObjectId)
+                    return false;
+            }
+            return true;
+        };
+
+        int rigid = 0;
+        for (SubMesh& sm : model.subMeshes)
+        {
+            sm.rigidGroup = -1;
+            if (!skinnable || sm.indexCount == 0 || std::size_t(sm.indexOffset) + sm.indexCount > model.indices.size())
+                continue;
+
+            const std::uint32_t firstIndex = model.indices[sm.indexOffset];
+            if (firstIndex >= model.vertexGroups.size())
+                continue;
+            const std::uint16_t gid = model.vertexGroups[firstIndex];
+            bool single = usableGroup(gid);
+            for (std::uint32_t i = 0; single && i < sm.indexCount; ++i)
+            {
+                const std::uint32_t idx = model.indices[sm.indexOffset + i];
+                single = idx < model.vertexGroups.size() && model.vertexGroups[idx] == gid;
+            }
+            if (single)
+            {
+                sm.rigidGroup = std::int32_t(gid);
+                ++rigid;
+            }
+        }
+        return rigid;
+    }
+
+    bool IsPoseConstant(const ModelData& model, std::uint32_t startMs, std::uint32_t endMs)
+    {
+        for (const auto& node : model.nodes)
+        {
+            if (!IsTrackConstant(node.trackTranslation, startMs, endMs, model) ||
+                !IsTrackConstant(node.trackRotation, startMs, endMs, model) ||
+                !IsTrackConstant(node.trackScaling, startMs, endMs, model))
+                return false;
+        }
+        return true;
+    }
+
+    int ClassifyStaticSequences(ModelData& model)
+    {
+        int count = 0;
+        for (auto& seq : model.sequences)
+        {
+            seq.staticPose = IsPoseConstant(model, seq.startMs, std::max(seq.endMs, seq.startMs));
+            count += seq.staticPose ? 1 : 0;
+        }
+        return count;
+    }
+}
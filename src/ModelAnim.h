@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QMatrix4x4>
+#include <QQuaternion>
+#include <QVector3D>
+#include <cstdint>
+#include <vector>
+
+#include "ModelData.h"
+
+// CPU animation kernels shared by the viewer and the benchmarks:
+// keyframe track sampling, node hierarchy evaluation and WC3-style skinning.
+
+namespace ModelAnim
+{
+    // Sample a track at a global time (global sequences are applied here).
+    float SampleTrackFloat(const MdxTrack<float>& track, std::uint32_t timeMs, float def, const ModelData& model);
+    Vec3 SampleTrackVec3(const MdxTrack<Vec3>& track, std::uint32_t timeMs, const Vec3& def, const ModelData& model);
+    Vec4 SampleTrackQuat(const MdxTrack<Vec4>& track, std::uint32_t timeMs, const Vec4& def, const ModelData& model);
+
+    // World transforms indexed by object id (size = maxObjectId+1), plus the
+    // pivot location / rotation / scale decomposition used by particles.
+    struct NodePose
+    {
+        std::vector<QMatrix4x4> world;
+        std::vector<QVector3D> worldLoc;
+        std::vector<QQuaternion> worldRot;
+        std::vector<QVector3D> worldScale;
+        std::vector<QVector3D> invWorldLoc;
+        std::vector<QQuaternion> invWorldRot;
+        std::vector<QVector3D> invWorldScale;
+
+        void reset(std::size_t size);
+        void clear();
+    };
+
+    // Evaluates every node at `globalTimeMs`; missing nodes and cycles get identity.
+    void ComputeNodeWorld(const ModelData& model, std::uint32_t globalTimeMs, std::vector<QMatrix4x4>& outWorld);
+
+    // ComputeNodeWorld plus the per-node decomposition.
+    void ComputeNodePose(const ModelData& model, std::uint32_t globalTimeMs, NodePose& pose);
+
+    // Skins bindVertices into `outVertices` with per-node skin matrices
+    // (world * inverse bind), averaging the matrices of each vertex group.
+    void SkinVertices(const ModelData& model, const std::vector<QMatrix4x4>& skinMats, std::vector<ModelVertex>& outVertices);
+    // SkinVertices for [first, first + count) only; other vertices are left as they are.
+    void SkinVertexRange(const ModelData& model, const std::vector<QMatrix4x4>& skinMats,
+                         std::size_t first, std::size_t count, std::vector<ModelVertex>& outVertices);
+
+    // The single matrix SkinVertices effectively applies to every vertex of `group`.
+    QMatrix4x4 GroupSkinMatrix(const ModelData::SkinGroup& group, const std::vector<QMatrix4x4>& skinMats);
+
+    // Sets SubMesh::rigidGroup for submeshes whose vertices all share one matrix
+    // group, so they move rigidly with GroupSkinMatrix. Returns how many were marked.
+    int ClassifyRigidSubMeshes(ModelData& model);
+
+    // True if every node track gives one value for all global times in
+    // [startMs, endMs]; the node pose is then the same over the whole range.
+    bool IsPoseConstant(const ModelData& model, std::uint32_t startMs, std::uint32_t endMs);
+    // Sets Sequence::staticPose with IsPoseConstant. Returns how many were marked.
+    int ClassifyStaticSequences(ModelData& model);
+}
@@ -77,6 +77,7 @@ struct SubMesh
     std::uint32_t indexCount = 0;
     std::uint32_t materialId = 0; // index into ModelData::materials
     std::uint32_t geosetIndex = 0;
+    std::int32_t rigidGroup = -1; // skin group shared by every vertex, or -1; see ModelAnim::ClassifyRigidSubMeshes
 };
 
 struct ModelData
@@ -84,6 +85,7 @@ struct ModelData
     std::vector<ModelVertex> vertices;
     std::vector<ModelVertex> bindVertices;
     std::vector<std::uint32_t> indices; // triangle list
+    std::vector<std::uint16_t> indices16; // same list for the GPU when every index fits; see MeshOptimizer
     std::vector<SubMesh> subMeshes;
     std::uint32_t geosetCount = 0;
 
@@ -112,6 +114,7 @@ struct ModelData
         std::uint32_t endMs = 0;
         std::uint32_t flags = 0;
         float moveSpeed = 0.0f;
+        bool staticPose = false; // node tracks are constant over the range; see ModelAnim::ClassifyStaticSequences
     };
 
     std::vector<Sequence> sequences;
@@ -183,6 +186,7 @@ struct ModelData
         MdxTrack<Vec3> trackColor;  // KGAC
     };
     std::vector<GeosetAnimation> geosetAnimations;
+    std::vector<int> geosetAnimByGeoset; // size = geosetCount, index into geosetAnimations or -1
 
     struct ParticleEmitter2
     {
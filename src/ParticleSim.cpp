@@ -0,0 +1,330 @@
+#include "ParticleSim.h"
+
+#include <QQuaternion>
+#include <QVector4D>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "LogSink.h"
+
+// SSE is baseline on every x86-64 target; other architectures use the scalar loops.
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define W3PREVIEW_PARTICLE_SSE 1
+#endif
+
+namespace
+{
+    static float clampf(float v, float lo, float hi)
+    {
+        return (v < lo) ? lo : (v > hi) ? hi : v;
+    }
+
+    constexpr std::uint32_t PRE2_LINE_EMITTER = 0x20000;
+    constexpr std::uint32_t PRE2_MODEL_SPACE  = 0x80000;
+    constexpr std::uint32_t PRE2_XY_QUAD      = 0x100000;
+}
+
+namespace ParticleSim
+{
+    void ParticlePool::setCapacity(std::size_t capacity)
+    {
+        if (capacity == capacity_)
+            return;
+        capacity_ = capacity;
+        count_ = std::min(count_, capacity_);
+        if (!tailType_.empty())
+            ensureStorage();
+    }
+
+    void ParticlePool::ensureStorage()
+    {
+        if (tailType_.size() == capacity_)
+            return;
+        for (auto* a : {&px_, &py_, &pz_, &vx_, &vy_, &vz_, &gravity_, &facing_, &age_, &life_})
+            a->resize(capacity_);
+        tailType_.resize(capacity_);
+    }
+
+    bool ParticlePool::spawn(const Particle& p)
+    {
+        if (count_ >= capacity_)
+            return false;
+        ensureStorage();
+        const std::size_t i = count_++;
+        px_[i] = p.pos.x();
+        py_[i] = p.pos.y();
+        pz_[i] = p.pos.z();
+        vx_[i] = p.vel.x();
+        vy_[i] = p.vel.y();
+        vz_[i] = p.vel.z();
+        gravity_[i] = p.gravity;
+        facing_[i] = p.facing;
+        age_[i] = p.age;
+        life_[i] = p.life;
+        tailType_[i] = std::uint8_t(p.tailType);
+        return true;
+    }
+
+    Particle ParticlePool::at(std::size_t i) const
+    {
+        Particle p;
+        p.pos = QVector3D(px_[i], py_[i], pz_[i]);
+        p.vel = QVector3D(vx_[i], vy_[i], vz_[i]);
+        p.gravity = gravity_[i];
+        p.facing = facing_[i];
+        p.tailType = tailType_[i];
+        p.age = age_[i];
+        p.life = life_[i];
+        return p;
+    }
+
+    void ParticlePool::moveSlot(std::size_t from, std::size_t to)
+    {
+        px_[to] = px_[from];
+        py_[to] = py_[from];
+        pz_[to] = pz_[from];
+        vx_[to] = vx_[from];
+        vy_[to] = vy_[from];
+        vz_[to] = vz_[from];
+        gravity_[to] = gravity_[from];
+        facing_[to] = facing_[from];
+        age_[to] = age_[from];
+        life_[to] = life_[from];
+        tailType_[to] = tailType_[from];
+    }
+
+    void ParticlePool::integrate(float dt)
+    {
+        float* px = px_.data();
+        float* py = py_.data();
+        float* pz = pz_.data();
+        const float* vx = vx_.data();
+        const float* vy = vy_.data();
+        float* vz = vz_.data();
+        const float* g = gravity_.data();
+        float* age = age_.data();
+
+        std::size_t i = 0;
+#ifdef W3PREVIEW_PARTICLE_SSE
+        const __m128 vdt = _mm_set1_ps(dt);
+        for (; i + 4 <= count_; i += 4)
+        {
+            _mm_storeu_ps(age + i, _mm_add_ps(_mm_loadu_ps(age + i), vdt));
+            // gravity pulls down in Z
+            const __m128 z = _mm_sub_ps(_mm_loadu_ps(vz + i), _mm_mul_ps(_mm_loadu_ps(g + i), vdt));
+            _mm_storeu_ps(vz + i, z);
+            _mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(_mm_loadu_ps(vx + i), vdt)));
+            _mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(_mm_loadu_ps(vy + i), vdt)));
+            _mm_storeu_ps(pz + i, _mm_add_ps(_mm_loadu_ps(pz + i), _mm_mul_ps(z, vdt)));
+        }
+#endif
+        for (; i < count_; ++i)
+        {
+            age[i] += dt;
+            vz[i] -= g[i] * dt;
+            px[i] += vx[i] * dt;
+            py[i] += vy[i] * dt;
+            pz[i] += vz[i] * dt;
+        }
+    }
+
+    void ParticlePool::removeDead()
+    {
+        std::size_t i = 0;
+        while (i < count_)
+        {
+#ifdef W3PREVIEW_PARTICLE_SSE
+            // Skip four live particles at a time; deaths are rare per frame.
+            if (i + 4 <= count_ &&
+                _mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(age_.data() + i), _mm_loadu_ps(life_.data() + i))) == 0)
+            {
+                i += 4;
+                continue;
+            }
+#endif
+            if (age_[i] >= life_[i])
+            {
+                --count_;
+                if (i != count_)
+                    moveSlot(count_, i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    void ResetEmitters(const ModelData& model, std::uint32_t seed, std::vector<EmitterState>& emitters)
+    {
+        emitters.clear();
+        emitters.resize(model.emitters2.size());
+        for (std::size_t i = 0; i < emitters.size(); ++i)
+        {
+            std::seed_seq seq{seed, std::uint32_t(i), 0x50524532u /* "PRE2" */};
+            emitters[i].rng.seed(seq);
+        }
+    }
+
+    void StepEmitters(const ModelData& model,
+                      const ModelAnim::NodePose& pose,
+                      const StepParams& params,
+                      std::vector<EmitterState>& emitters)
+    {
+        if (emitters.size() != model.emitters2.size())
+            ResetEmitters(model, params.seed, emitters);
+        for (std::size_t ei = 0; ei < emitters.size(); ++ei)
+            StepEmitter(model, pose, params, ei, emitters[ei]);
+    }
+
+    void StepEmitter(const ModelData& model,
+                     const ModelAnim::NodePose& pose,
+                     const StepParams& params,
+                     std::size_t ei,
+                     EmitterState& rt)
+    {
+        std::uniform_real_distribution<float> u01(0.0f, 1.0f);
+        auto randSigned = [&]() { return u01(rt.rng) * 2.0f - 1.0f; };
+
+        const auto& e = model.emitters2[ei];
+        rt.particles.setCapacity(params.maxParticlesPerEmitter);
+
+        const float vis = params.forceVisible
+                              ? 1.0f
+                              : clampf(ModelAnim::SampleTrackFloat(e.trackVisibility, params.globalTimeMs, 1.0f, model), 0.0f, 1.0f);
+        if (vis <= 0.001f)
+        {
+            // Still age existing particles so they fade out naturally.
+        }
+
+        const float speed = ModelAnim::SampleTrackFloat(e.trackSpeed, params.globalTimeMs, e.speed, model);
+        const float variation = ModelAnim::SampleTrackFloat(e.trackVariation, params.globalTimeMs, e.variation, model);
+        const float latitude = ModelAnim::SampleTrackFloat(e.trackLatitude, params.globalTimeMs, e.latitude, model);
+        const float emissionRate = std::max(0.0f, ModelAnim::SampleTrackFloat(e.trackEmissionRate, params.globalTimeMs, e.emissionRate, model)) * 2.0f;
+        const float gravity = ModelAnim::SampleTrackFloat(e.trackGravity, params.globalTimeMs, e.gravity, model);
+        const float lifespan = std::max(0.01f, ModelAnim::SampleTrackFloat(e.trackLifespan, params.globalTimeMs, e.lifespan, model));
+        const float width = ModelAnim::SampleTrackFloat(e.trackWidth, params.globalTimeMs, e.width, model);
+        const float length = ModelAnim::SampleTrackFloat(e.trackLength, params.globalTimeMs, e.length, model);
+
+        const bool modelSpace = (e.flags & PRE2_MODEL_SPACE) != 0;
+        const bool lineEmitter = (e.flags & PRE2_LINE_EMITTER) != 0;
+        const bool xyQuad = (e.flags & PRE2_XY_QUAD) != 0;
+
+        QVector3D pivot(0, 0, 0);
+        QMatrix4x4 nodeWorld;
+        nodeWorld.setToIdentity();
+        QQuaternion nodeRot(1, 0, 0, 0);
+        QVector3D nodeScale(1, 1, 1);
+
+        if (e.objectId >= 0 && e.objectId < static_cast<int>(model.nodeIdToIndex.size()))
+        {
+            const int idx = model.nodeIdToIndex[e.objectId];
+            if (idx >= 0 && std::size_t(idx) < model.nodes.size())
+            {
+                const auto& n = model.nodes[std::size_t(idx)];
+                pivot = QVector3D(n.pivot.x, n.pivot.y, n.pivot.z);
+            }
+            if (std::size_t(e.objectId) < pose.world.size())
+            {
+                nodeWorld = pose.world[std::size_t(e.objectId)];
+                nodeRot = pose.worldRot[std::size_t(e.objectId)];
+                nodeScale = pose.worldScale[std::size_t(e.objectId)];
+            }
+        }
+        else if (e.objectId >= 0 && std::size_t(e.objectId) < model.pivots.size())
+        {
+            const auto& p = model.pivots[std::size_t(e.objectId)];
+            pivot = QVector3D(p.x, p.y, p.z);
+        }
+
+        // Spawn particles
+        if (vis > 0.001f && emissionRate > 0.0f)
+        {
+            rt.spawnAccum += double(emissionRate) * double(params.dtSeconds);
+            int toSpawn = int(rt.spawnAccum);
+            if (toSpawn > 0)
+            {
+                rt.spawnAccum -= double(toSpawn);
+                toSpawn = std::min(toSpawn, 200); // safety cap
+
+                for (int i = 0; i < toSpawn; ++i)
+                {
+                    auto spawnParticle = [&](int tailType)
+                    {
+                        Particle p;
+                        p.age = 0.0f;
+                        p.life = lifespan;
+                        p.tailType = tailType;
+
+                        // Initial position: pivot + scatter in X/Y
+                        const float sx = randSigned() * width;
+                        const float sy = randSigned() * length;
+                        QVector3D localPos = pivot + QVector3D(sx, sy, 0.0f);
+
+                        // Build local rotation (match mdx-m3-viewer)
+                        const float lat = latitude;
+                        const float ay = randSigned() * lat;
+                        const float ax = randSigned() * lat;
+                        QQuaternion rot = QQuaternion::fromAxisAndAngle(0, 0, 1, 90.0f);
+                        rot *= QQuaternion::fromAxisAndAngle(0, 1, 0, ay * 57.2957795f);
+                        if (!lineEmitter)
+                            rot *= QQuaternion::fromAxisAndAngle(1, 0, 0, ax * 57.2957795f);
+
+                        if (!modelSpace)
+                            rot = nodeRot * rot;
+
+                        QVector3D dir = rot.rotatedVector(QVector3D(0, 0, 1));
+                        dir.normalize();
+
+                        const float sp = speed * (1.0f + randSigned() * variation);
+                        QVector3D vel = dir * sp;
+
+                        if (!modelSpace)
+                        {
+                            vel = QVector3D(vel.x() * nodeScale.x(),
+                                            vel.y() * nodeScale.y(),
+                                            vel.z() * nodeScale.z());
+                            localPos = (nodeWorld * QVector4D(localPos, 1.0f)).toVector3D();
+                        }
+
+                        p.pos = localPos;
+                        p.vel = vel;
+                        p.gravity = modelSpace ? gravity : (gravity * nodeScale.z());
+
+                        if (xyQuad)
+                            p.facing = std::atan2(p.vel.y(), p.vel.x()) - float(M_PI) + float(M_PI / 8.0);
+
+                        // A full pool drops the new particle; the RNG sequence stays the same.
+                        rt.particles.spawn(p);
+                    };
+
+                    const bool wantHead = (e.headOrTail == 0 || e.headOrTail == 2);
+                    const bool wantTail = (e.headOrTail == 1 || e.headOrTail == 2);
+                    if (wantHead)
+                        spawnParticle(0);
+                    if (wantTail)
+                        spawnParticle(1);
+                }
+            }
+        }
+        else if (!rt.loggedNoSpawn && params.localTimeMs > 1000)
+        {
+            rt.loggedNoSpawn = true;
+            LogSink::instance().log(LogLevel::Debug, QString("PRE2 %1 no spawn: vis=%2 rate=%3 life=%4 rows=%5 cols=%6 flags=0x%7")
+                                        .arg(ei)
+                                        .arg(vis, 0, 'f', 3)
+                                        .arg(emissionRate, 0, 'f', 3)
+                                        .arg(lifespan, 0, 'f', 3)
+                                        .arg(e.rows)
+                                        .arg(e.columns)
+                                        .arg(QString::number(e.flags, 16)));
+        }
+
+        rt.particles.integrate(params.dtSeconds);
+        rt.particles.removeDead();
+    }
+}
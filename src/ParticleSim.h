@@ -0,0 +1,106 @@
+#pragma once
+
+#include <QVector3D>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "ModelAnim.h"
+#include "ModelData.h"
+
+// CPU simulation of PRE2 (ParticleEmitter2) emitters: spawn, integrate, expire.
+// Rendering stays in GLModelView; this only owns the particle state.
+
+namespace ParticleSim
+{
+    struct Particle
+    {
+        QVector3D pos;
+        QVector3D vel;
+        float gravity = 0.0f;
+        float facing = 0.0f;
+        int tailType = 0; // 0=head, 1=tail
+        float age = 0.0f;
+        float life = 1.0f;
+    };
+
+    // Fixed-capacity structure-of-arrays storage for one emitter. Live particles
+    // are always [0, size()); a dead particle is replaced by the last live one,
+    // so order is not preserved. Storage is allocated on the first spawn.
+    class ParticlePool
+    {
+    public:
+        static constexpr std::size_t kDefaultCapacity = 5000;
+
+        explicit ParticlePool(std::size_t capacity = kDefaultCapacity) : capacity_(capacity) {}
+
+        std::size_t size() const { return count_; }
+        bool empty() const { return count_ == 0; }
+        std::size_t capacity() const { return capacity_; }
+        std::size_t freeCount() const { return capacity_ - count_; }
+
+        // Shrinking drops the particles beyond the new capacity.
+        void setCapacity(std::size_t capacity);
+        void clear() { count_ = 0; }
+
+        // False (and nothing stored) when the pool is full.
+        bool spawn(const Particle& p);
+        Particle at(std::size_t i) const;
+
+        // age += dt; vel.z -= gravity * dt; pos += vel * dt for every live particle.
+        void integrate(float dt);
+        // Swap-removes every particle with age >= life.
+        void removeDead();
+
+    private:
+        void ensureStorage();
+        void moveSlot(std::size_t from, std::size_t to);
+
+        std::size_t capacity_ = kDefaultCapacity;
+        std::size_t count_ = 0;
+        std::vector<float> px_, py_, pz_;
+        std::vector<float> vx_, vy_, vz_;
+        std::vector<float> gravity_, facing_, age_, life_;
+        std::vector<std::uint8_t> tailType_;
+    };
+
+    struct EmitterState
+    {
+        double spawnAccum = 0.0;
+        ParticlePool particles;
+        std::mt19937 rng; // this emitter's own stream, see ResetEmitters()
+        bool loggedNoSpawn = false;
+    };
+
+    struct StepParams
+    {
+        std::uint32_t globalTimeMs = 0;
+        std::uint32_t localTimeMs = 0; // only used to delay the "no spawn" diagnostic
+        float dtSeconds = 0.0f;
+        bool forceVisible = false;
+        std::size_t maxParticlesPerEmitter = ParticlePool::kDefaultCapacity;
+        std::uint32_t seed = 1337u; // only used when StepEmitters() has to reset
+    };
+
+    // One fresh state per emitter of `model`. Emitter i draws from a stream
+    // derived from (seed, i), so the result does not depend on which thread
+    // steps which emitter, or in what order.
+    void ResetEmitters(const ModelData& model, std::uint32_t seed, std::vector<EmitterState>& emitters);
+
+    // Advances emitter `index` by one step; `pose` must be evaluated at
+    // params.globalTimeMs. Only `state` is written, so different emitters can
+    // be stepped concurrently.
+    void StepEmitter(const ModelData& model,
+                     const ModelAnim::NodePose& pose,
+                     const StepParams& params,
+                     std::size_t index,
+                     EmitterState& state);
+
+    // StepEmitter() for every emitter, serially. `emitters` is reset with
+    // params.seed if its size does not match model.emitters2.
+    void StepEmitters(const ModelData& model,
+                      const ModelAnim::NodePose& pose,
+                      const StepParams& params,
+                      std::vector<EmitterState>& emitters);
+}
@@ -0,0 +1,378 @@
+#include "RenderBench.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <vector>
+
+#include "GLModelView.h"
+#include "LogSink.h"
+#include "MdxLoader.h"
+#include "MeshOptimizer.h"
+#include "VertexPacking.h"
+
+namespace
+{
+    static double Percentile(const std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty())
+            return 0.0;
+        const double rank = p * double(sorted.size() - 1);
+        const std::size_t lo = std::size_t(rank);
+        const std::size_t hi = std::min(lo + 1, sorted.size() - 1);
+        const double frac = rank - double(lo);
+        return sorted[lo] + (sorted[hi] - sorted[lo]) * frac;
+    }
+
+    // min / median / p90 / p99 / mean / max in ms.
+    static QJsonObject Stats(std::vector<double> samples)
+    {
+        QJsonObject o;
+        if (samples.empty())
+            return o;
+        std::sort(samples.begin(), samples.end());
+        double sum = 0.0;
+        for (double s : samples)
+            sum += s;
+        o["min"] = samples.front();
+        o["median"] = Percentile(samples, 0.50);
+        o["p90"] = Percentile(samples, 0.90);
+        o["p99"] = Percentile(samples, 0.99);
+        o["mean"] = sum / double(samples.size());
+        o["max"] = samples.back();
+        return o;
+    }
+
+    static bool WriteReport(const QJsonObject& root, const QString& outPath)
+    {
+        const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+        if (outPath.isEmpty())
+        {
+            std::fwrite(json.constData(), 1, std::size_t(json.size()), stdout);
+            return true;
+        }
+        QFile f(outPath);
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            std::fprintf(stderr, "Cannot write report: %s\n", qPrintable(outPath));
+            return false;
+        }
+        f.write(json);
+        return true;
+    }
+
+    struct ImageDiff
+    {
+        int maxChannel = 0;          // 0..255
+        double meanChannel = 0.0;
+        double changedPercent = 0.0; // pixels with any channel off by more than kChangedThreshold
+        QImage visual;               // |a - b| * 8, opaque
+    };
+
+    constexpr int kChangedThreshold = 8;
+
+    static ImageDiff CompareImages(const QImage& a, const QImage& b)
+    {
+        ImageDiff d;
+        const QImage ia = a.convertToFormat(QImage::Format_RGBA8888);
+        const QImage ib = b.convertToFormat(QImage::Format_RGBA8888);
+        if (ia.size() != ib.size() || ia.isNull())
+            return d;
+
+        d.visual = QImage(ia.size(), QImage::Format_RGBA8888);
+        std::uint64_t sum = 0;
+        std::uint64_t changed = 0;
+        for (int y = 0; y < ia.height(); ++y)
+        {
+            const uchar* pa = ia.constScanLine(y);
+            const uchar* pb = ib.constScanLine(y);
+            uchar* pv = d.visual.scanLine(y);
+            for (int x = 0; x < ia.width(); ++x)
+            {
+                int pixelMax = 0;
+                for (int c = 0; c < 4; ++c)
+                {
+                    const int diff = std::abs(int(pa[x * 4 + c]) - int(pb[x * 4 + c]));
+                    pixelMax = std::max(pixelMax, diff);
+                    sum += std::uint64_t(diff);
+                    if (c < 3)
+                        pv[x * 4 + c] = uchar(std::min(255, diff * 8));
+                }
+                pv[x * 4 + 3] = 255;
+                d.maxChannel = std::max(d.maxChannel, pixelMax);
+                if (pixelMax > kChangedThreshold)
+                    ++changed;
+            }
+        }
+        const double pixels = double(ia.width()) * double(ia.height());
+        d.meanChannel = double(sum) / (pixels * 4.0);
+        d.changedPercent = 100.0 * double(changed) / pixels;
+        return d;
+    }
+
+}
+
+namespace RenderBench
+{
+    QStringList CollectModels(const QString& input)
+    {
+        QStringList files;
+        const QFileInfo fi(input);
+        if (fi.isDir())
+        {
+            QDirIterator it(fi.absoluteFilePath(), QStringList() << "*.mdx" << "*.MDX", QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext())
+                files << it.next();
+            files.sort(Qt::CaseInsensitive);
+        }
+        else if (fi.suffix().compare("mdx", Qt::CaseInsensitive) == 0)
+        {
+            files << fi.absoluteFilePath();
+        }
+        else
+        {
+            // List file: one path per line, relative to the list; '#' starts a comment.
+            QFile f(fi.absoluteFilePath());
+            if (f.open(QIODevice::ReadOnly | QIODevice::Text))
+            {
+                QTextStream ts(&f);
+                while (!ts.atEnd())
+                {
+                    const QString line = ts.readLine().trimmed();
+                    if (line.isEmpty() || line.startsWith('#'))
+                        continue;
+                    files << QFileInfo(fi.absoluteDir(), line).absoluteFilePath();
+                }
+            }
+        }
+        return files;
+    }
+
+    int Run(const Options& opt)
+    {
+        GLModelView view;
+        view.setAttribute(Qt::WA_DontShowOnScreen);
+        view.resize(opt.width, opt.height);
+        view.setDeterministic(true, opt.seed);
+        view.setPackedVertices(opt.packedVertices);
+        view.show();
+        view.grabFramebuffer(); // forces initializeGL before the first timed frame
+        QCoreApplication::processEvents();
+
+        const float dt = float(opt.stepMs / 1000.0);
+
+        QJsonArray results;
+        int failed = 0;
+        for (const QString& path : opt.models)
+        {
+            std::fprintf(stderr, "%s\n", qPrintable(QFileInfo(path).fileName()));
+
+            QJsonObject entry;
+            entry["path"] = path;
+
+            QElapsedTimer loadTimer;
+            loadTimer.start();
+            QString err;
+            auto model = MdxLoader::LoadFromFile(path, &err);
+            const double loadMs = double(loadTimer.nsecsElapsed()) / 1.0e6;
+            if (!model)
+            {
+                entry["ok"] = false;
+                entry["error"] = err;
+                results.append(entry);
+                failed++;
+                continue;
+            }
+            const MeshOptimizer::Stats meshStats = MeshOptimizer::OptimizeModel(*model);
+            entry["ok"] = true;
+            entry["loadMs"] = loadMs;
+            entry["acmrBefore"] = meshStats.acmrBefore;
+            entry["acmrAfter"] = meshStats.acmrAfter;
+            entry["indices16"] = meshStats.indices16;
+            entry["vertices"] = double(model->vertices.size());
+            entry["triangles"] = double(model->indices.size() / 3);
+            entry["emitters"] = double(model->emitters2.size());
+
+            QElapsedTimer uploadTimer;
+            uploadTimer.start();
+            view.setModel(std::move(model), QFileInfo(path).fileName(), path);
+            entry["setModelMs"] = double(uploadTimer.nsecsElapsed()) / 1.0e6;
+
+            for (int i = 0; i < opt.warmup; ++i)
+                view.renderFixedFrame(dt);
+
+            // One series per profiler phase, then gpu and whole frame.
+            constexpr std::size_t kGpu = FrameProfiler::PhaseCount;
+            constexpr std::size_t kFrame = FrameProfiler::PhaseCount + 1;
+            std::vector<std::vector<double>> samples(FrameProfiler::PhaseCount + 2);
+            int maxDrawCalls = 0;
+            std::size_t maxParticles = 0;
+            std::size_t skinned = 0;
+            bool gpu = true;
+            QElapsedTimer frameTimer;
+            for (int i = 0; i < opt.frames; ++i)
+            {
+                frameTimer.start();
+                const FrameProfiler::Frame t = view.renderFixedFrame(dt);
+                samples[kFrame].push_back(double(frameTimer.nsecsElapsed()) / 1.0e6);
+                for (int p = 0; p < FrameProfiler::PhaseCount; ++p)
+                    samples[std::size_t(p)].push_back(t.phaseMs[p]);
+                samples[kGpu].push_back(t.gpuMs);
+                gpu = gpu && t.gpuMs >= 0.0;
+                maxDrawCalls = std::max(maxDrawCalls, t.drawCalls);
+                maxParticles = std::max(maxParticles, t.liveParticles);
+                skinned = t.skinnedVertices;
+            }
+
+            QJsonObject phaseStats;
+            for (int p = 0; p < FrameProfiler::PhaseCount; ++p)
+                phaseStats[FrameProfiler::PhaseName(FrameProfiler::Phase(p))] = Stats(samples[std::size_t(p)]);
+            if (gpu)
+                phaseStats["gpu"] = Stats(samples[kGpu]);
+            phaseStats["frame"] = Stats(samples[kFrame]);
+            entry["phasesMs"] = phaseStats;
+            entry["drawCalls"] = maxDrawCalls;
+            entry["skinnedVertices"] = double(skinned);
+            entry["maxLiveParticles"] = double(maxParticles);
+            entry["textureMB"] = double(view.profiler().last() ? view.profiler().last()->textureBytes : 0) / (1024.0 * 1024.0);
+            results.append(entry);
+        }
+
+        view.setModel(std::nullopt, QString(), QString());
+
+        QJsonObject root;
+        root["tool"] = "render-bench";
+        root["version"] = QCoreApplication::applicationVersion();
+        root["qt"] = QString::fromLatin1(qVersion());
+#ifdef NDEBUG
+        root["build"] = "release";
+#else
+        root["build"] = "debug";
+#endif
+        root["gl"] = view.glInfo();
+        root["frames"] = opt.frames;
+        root["warmup"] = opt.warmup;
+        root["stepMs"] = opt.stepMs;
+        root["seed"] = double(opt.seed);
+        root["width"] = opt.width;
+        root["height"] = opt.height;
+        root["packedVertices"] = opt.packedVertices;
+        root["models"] = results;
+        if (!WriteReport(root, opt.outPath))
+            return 1;
+
+        LogSink::instance().log(QString("Render bench: %1 models, %2 failed").arg(opt.models.size()).arg(failed));
+        return failed > 0 ? 1 : 0;
+    }
+
+    int RunVertexDiff(const Options& opt)
+    {
+        GLModelView view;
+        view.setAttribute(Qt::WA_DontShowOnScreen);
+        view.resize(opt.width, opt.height);
+        view.setDeterministic(true, opt.seed);
+        view.show();
+        view.grabFramebuffer();
+        QCoreApplication::processEvents();
+
+        if (!opt.diffImageDir.isEmpty())
+            QDir().mkpath(opt.diffImageDir);
+
+        const float dt = float(opt.stepMs / 1000.0);
+        QJsonArray results;
+        int failed = 0;
+        double worstPx = 0.0;
+        for (const QString& path : opt.models)
+        {
+            std::fprintf(stderr, "%s\n", qPrintable(QFileInfo(path).fileName()));
+
+            QJsonObject entry;
+            entry["path"] = path;
+            QString err;
+            auto model = MdxLoader::LoadFromFile(path, &err);
+            if (!model)
+            {
+                entry["ok"] = false;
+                entry["error"] = err;
+                results.append(entry);
+                failed++;
+                continue;
+            }
+            MeshOptimizer::OptimizeModel(*model);
+
+            // Same seed and the same number of steps, so only the vertex format differs.
+            QImage images[2];
+            double errorPx = 0.0;
+            for (int packed = 0; packed < 2; ++packed)
+            {
+                view.setPackedVertices(packed != 0);
+                view.setModel(*model, QFileInfo(path).fileName(), path);
+                for (int i = 0; i < opt.warmup; ++i)
+                    view.renderFixedFrame(dt);
+                images[packed] = view.grabFramebuffer();
+                if (packed)
+                    errorPx = view.packedVertexErrorPixels(); // the animated frame just grabbed
+            }
+
+            const VertexPacking::Error vertexError = VertexPacking::MeasureError(
+                model->vertices.data(), model->vertices.size());
+            const ImageDiff diff = CompareImages(images[0], images[1]);
+            const bool subPixel = errorPx < 1.0;
+            worstPx = std::max(worstPx, errorPx);
+            if (!subPixel)
+                failed++;
+
+            entry["ok"] = subPixel;
+            entry["vertexErrorPx"] = errorPx;
+            entry["positionError"] = vertexError.maxPosition;
+            entry["normalErrorDeg"] = vertexError.maxNormalDegrees;
+            entry["uvError"] = vertexError.maxUv;
+            entry["maxChannelDiff"] = diff.maxChannel;
+            entry["meanChannelDiff"] = diff.meanChannel;
+            entry["changedPixelsPercent"] = diff.changedPercent;
+            if (!opt.diffImageDir.isEmpty())
+            {
+                const QString base = QDir(opt.diffImageDir).filePath(QFileInfo(path).completeBaseName());
+                images[0].save(base + ".float.png");
+                images[1].save(base + ".packed.png");
+                diff.visual.save(base + ".diff.png");
+            }
+            results.append(entry);
+        }
+
+        view.setModel(std::nullopt, QString(), QString());
+
+        QJsonObject root;
+        root["tool"] = "vertex-diff";
+        root["version"] = QCoreApplication::applicationVersion();
+        root["gl"] = view.glInfo();
+        root["warmup"] = opt.warmup;
+        root["stepMs"] = opt.stepMs;
+        root["seed"] = double(opt.seed);
+        root["width"] = opt.width;
+        root["height"] = opt.height;
+        root["changedThreshold"] = kChangedThreshold;
+        root["worstVertexErrorPx"] = worstPx;
+        root["models"] = results;
+        if (!WriteReport(root, opt.outPath))
+            return 1;
+
+        LogSink::instance().log(QString("Vertex diff: %1 models, worst %2 px, %3 failed")
+                                    .arg(opt.models.size())
+                                    .arg(worstPx, 0, 'f', 3)
+                                    .arg(failed));
+        return failed > 0 ? 1 : 0;
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+
+// End-to-end render benchmark: loads a model list and renders N frames per model
+// at a fixed simulated timestep with a seeded particle RNG, into an offscreen
+// GLModelView (no vsync). Reports per-phase CPU time, GPU time and percentiles as JSON.
+
+namespace RenderBench
+{
+    struct Options
+    {
+        QStringList models;
+        int frames = 300;
+        int warmup = 30;
+        double stepMs = 1000.0 / 60.0;
+        std::uint32_t seed = 1337u;
+        int width = 1280;
+        int height = 720;
+        QString outPath; // empty = stdout
+        bool packedVertices = false; // GLModelView::setPackedVertices
+        QString diffImageDir;        // RunVertexDiff: float / packed / difference PNGs per model; empty = none
+    };
+
+    // `input` is an .mdx file, a folder (scanned recursively) or a text file with one path per line.
+    QStringList CollectModels(const QString& input);
+
+    // Needs a QApplication. Returns the process exit code (1 if any model failed to load).
+    int Run(const Options& options);
+
+    // Renders every model after `warmup` fixed steps with float and with packed
+    // vertices and reports the image difference plus the largest vertex error in
+    // pixels at the default camera. Exit code 1 unless every model stays under a pixel.
+    int RunVertexDiff(const Options& options);
+}
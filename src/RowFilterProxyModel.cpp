@@ -0,0 +1,142 @@
+#include "RowFilterProxyModel.h"
+
+RowFilterProxyModel::RowFilterProxyModel(QObject* parent)
+    : QAbstractProxyModel(parent)
+{
+}
+
+void RowFilterProxyModel::setSourceModel(QAbstractItemModel* sourceModel)
+{
+    beginResetModel();
+    for (const auto& c : sourceConnections_)
+        disconnect(c);
+    sourceConnections_.clear();
+
+    QAbstractProxyModel::setSourceModel(sourceModel);
+    filtered_ = false;
+    rows_.clear();
+    sourceToProxy_.clear();
+
+    if (sourceModel)
+    {
+        // Any structural change in the source drops the filter; the owner re-applies it.
+        auto begin = [this]() { beginResetModel(); };
+        auto end = [this]()
+        {
+            filtered_ = false;
+            rows_.clear();
+            sourceToProxy_.clear();
+            endResetModel();
+        };
+        sourceConnections_ << connect(sourceModel, &QAbstractItemModel::modelAboutToBeReset, this, begin);
+        sourceConnections_ << connect(sourceModel, &QAbstractItemModel::modelReset, this, end);
+        sourceConnections_ << connect(sourceModel, &QAbstractItemModel::rowsAboutToBeInserted, this, begin);
+        sourceConnections_ << connect(sourceModel, &QAbstractItemModel::rowsInserted, this, end);
+        sourceConnections_ << connect(sourceModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, begin);
+        sourceConnections_ << connect(sourceModel, &QAbstractItemModel::rowsRemoved, this, end);
+        sourceConnections_ << connect(sourceModel, &QAbstractItemModel::columnsAboutToBeInserted, this, begin);
+        sourceConnections_ << connect(sourceModel, &QAbstractItemModel::columnsInserted, this, end);
+        sourceConnections_ << connect(sourceModel, &QAbstractItemModel::columnsAboutToBeRemoved, this, begin);
+        sourceConnections_ << connect(sourceModel, &QAbstractItemModel::columnsRemoved, this, end);
+        sourceConnections_ << connect(sourceModel, &QAbstractItemModel::dataChanged,
+                                      this, &RowFilterProxyModel::onSourceDataChanged);
+    }
+    endResetModel();
+}
+
+void RowFilterProxyModel::setRows(std::vector<int> rows)
+{
+    beginResetModel();
+    const int sourceRows = sourceModel() ? sourceModel()->rowCount() : 0;
+    sourceToProxy_.assign(std::size_t(sourceRows), -1);
+    rows_.clear();
+    rows_.reserve(rows.size());
+    for (int row : rows)
+    {
+        if (row < 0 || row >= sourceRows || sourceToProxy_[std::size_t(row)] >= 0)
+            continue;
+        sourceToProxy_[std::size_t(row)] = int(rows_.size());
+        rows_.push_back(row);
+    }
+    filtered_ = true;
+    endResetModel();
+}
+
+void RowFilterProxyModel::clearRows()
+{
+    if (!filtered_)
+        return;
+    beginResetModel();
+    filtered_ = false;
+    rows_.clear();
+    sourceToProxy_.clear();
+    endResetModel();
+}
+
+QModelIndex RowFilterProxyModel::index(int row, int column, const QModelIndex& parent) const
+{
+    if (parent.isValid() || row < 0 || column < 0 || row >= rowCount() || column >= columnCount())
+        return {};
+    return createIndex(row, column);
+}
+
+QModelIndex RowFilterProxyModel::parent(const QModelIndex& /*child*/) const
+{
+    return {};
+}
+
+int RowFilterProxyModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid() || !sourceModel())
+        return 0;
+    return filtered_ ? int(rows_.size()) : sourceModel()->rowCount();
+}
+
+int RowFilterProxyModel::columnCount(const QModelIndex& parent) const
+{
+    if (parent.isValid() || !sourceModel())
+        return 0;
+    return sourceModel()->columnCount();
+}
+
+QModelIndex RowFilterProxyModel::mapToSource(const QModelIndex& proxyIndex) const
+{
+    if (!proxyIndex.isValid() || !sourceModel())
+        return {};
+    const int row = filtered_ ? rows_[std::size_t(proxyIndex.row())] : proxyIndex.row();
+    return sourceModel()->index(row, proxyIndex.column());
+}
+
+QModelIndex RowFilterProxyModel::mapFromSource(const QModelIndex& sourceIndex) const
+{
+    if (!sourceIndex.isValid())
+        return {};
+    int row = sourceIndex.row();
+    if (filtered_)
+    {
+        if (row < 0 || row >= int(sourceToProxy_.size()))
+            return {};
+        row = sourceToProxy_[std::size_t(row)];
+        if (row < 0)
+            return {};
+    }
+    return createIndex(row, sourceIndex.column());
+}
+
+void RowFilterProxyModel::onSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles)
+{
+    if (!topLeft.isValid() || !bottomRight.isValid())
+        return;
+    if (!filtered_)
+    {
+        emit dataChanged(index(topLeft.row(), topLeft.column()),
+                         index(bottomRight.row(), bottomRight.column()), roles);
+        return;
+    }
+    for (int row = topLeft.row(); row <= bottomRight.row() && row < int(sourceToProxy_.size()); ++row)
+    {
+        const int proxyRow = sourceToProxy_[std::size_t(row)];
+        if (proxyRow >= 0)
+            emit dataChanged(index(proxyRow, topLeft.column()), index(proxyRow, bottomRight.column()), roles);
+    }
+}
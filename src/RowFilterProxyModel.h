@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QAbstractProxyModel>
+#include <vector>
+
+// Flat proxy that shows an explicit, ordered subset of source rows.
+// Filtering is computed elsewhere (FilterIndex) and handed over in one go,
+// so the proxy never evaluates rows itself.
+class RowFilterProxyModel final : public QAbstractProxyModel
+{
+    Q_OBJECT
+public:
+    explicit RowFilterProxyModel(QObject* parent = nullptr);
+
+    void setSourceModel(QAbstractItemModel* sourceModel) override;
+
+    // Shows only `rows` (source row numbers), in the given order.
+    void setRows(std::vector<int> rows);
+    // Shows every source row in source order.
+    void clearRows();
+    bool isFiltered() const { return filtered_; }
+
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex mapToSource(const QModelIndex& proxyIndex) const override;
+    QModelIndex mapFromSource(const QModelIndex& sourceIndex) const override;
+
+private:
+    void onSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles);
+
+    bool filtered_ = false;
+    std::vector<int> rows_;
+    std::vector<int> sourceToProxy_;
+    QList<QMetaObject::Connection> sourceConnections_;
+};
@@ -0,0 +1,506 @@
+#include "SimThread.h"
+
+#include <QElapsedTimer>
+#include <QtConcurrent/QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Trace.h"
+
+namespace
+{
+    constexpr std::uint32_t PRE2_MODEL_SPACE = 0x80000;
+
+    // Below this many live particles, fanning emitters out to the pool costs more than it saves.
+    constexpr std::size_t kParallelParticleThreshold = 2048;
+
+    static double ElapsedMs(const QElapsedTimer& t)
+    {
+        return double(t.nsecsElapsed()) / 1.0e6;
+    }
+
+    static int GetCell(const std::uint32_t interval[3], float factor, int totalFrames)
+    {
+        const float start = float(interval[0]);
+        const float end = float(interval[1]);
+        const float repeat = float(interval[2]);
+        const float spriteCount = end - start;
+        if (spriteCount > 0.0f)
+        {
+            const float idx = std::floor(spriteCount * repeat * factor);
+            const float modv = std::fmod(idx, spriteCount);
+            const float cell = std::min(start + modv, float(totalFrames - 1));
+            return int(cell);
+        }
+        return int(start);
+    }
+
+    static int PickFrame(const ModelData::ParticleEmitter2& e, float tLife, bool tailType, int totalFrames)
+    {
+        if (e.replaceableId == 1 || e.replaceableId == 2)
+            return 0;
+
+        float factor = tLife;
+        int intervalIndex = 0;
+        if (factor < e.timeMiddle)
+        {
+            factor = factor / std::max(0.0001f, e.timeMiddle);
+        }
+        else
+        {
+            factor = (factor - e.timeMiddle) / std::max(0.0001f, 1.0f - e.timeMiddle);
+            intervalIndex = 1;
+        }
+        factor = std::min(factor, 1.0f);
+
+        const std::uint32_t* interval = tailType ? e.tailIntervals[intervalIndex] : e.headIntervals[intervalIndex];
+        return GetCell(interval, factor, totalFrames);
+    }
+}
+
+SimThread::SimThread(std::function<void()> onFrame)
+    : onFrame_(std::move(onFrame)), queue_(new Command[kQueueCapacity])
+{
+    thread_ = std::thread(&SimThread::run, this);
+}
+
+SimThread::~SimThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wakeCv_.notify_one();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void SimThread::setModel(std::shared_ptr<const ModelData> model, std::uint64_t generation, std::uint32_t seed)
+{
+    Command cmd;
+    cmd.type = CommandType::SetModel;
+    cmd.model = std::move(model);
+    cmd.generation = generation;
+    cmd.seed = seed;
+    carriedDt_ = 0.0f;
+    post(std::move(cmd));
+}
+
+void SimThread::setSequence(int sequence)
+{
+    Command cmd;
+    cmd.type = CommandType::SetSequence;
+    cmd.sequence = sequence;
+    carriedDt_ = 0.0f;
+    post(std::move(cmd));
+}
+
+void SimThread::step(float dtSeconds, float playbackSpeed, bool forceVisible)
+{
+    carriedDt_ += dtSeconds;
+    if (queuedSteps_.load(std::memory_order_acquire) >= kMaxQueuedSteps)
+        return;
+
+    Command cmd;
+    cmd.type = CommandType::Step;
+    cmd.dtSeconds = std::min(carriedDt_, 0.1f);
+    cmd.playbackSpeed = playbackSpeed;
+    cmd.forceVisible = forceVisible;
+    carriedDt_ = 0.0f;
+    queuedSteps_.fetch_add(1, std::memory_order_release);
+    post(std::move(cmd));
+}
+
+void SimThread::post(Command&& cmd)
+{
+    // Steps are capped above, so the ring only fills if the thread is stuck;
+    // model and sequence changes must not be lost, so wait for a slot.
+    while (!tryPush(cmd))
+        std::this_thread::yield();
+    ++posted_;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wakeRequested_ = true;
+    }
+    wakeCv_.notify_one();
+}
+
+bool SimThread::tryPush(Command& cmd)
+{
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == kQueueCapacity)
+        return false;
+    queue_[head & (kQueueCapacity - 1)] = std::move(cmd);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool SimThread::tryPop(Command& out)
+{
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire))
+        return false;
+    out = std::move(queue_[tail & (kQueueCapacity - 1)]);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+void SimThread::waitIdle()
+{
+    const std::uint64_t target = posted_;
+    std::unique_lock<std::mutex> lock(mutex_);
+    idleCv_.wait(lock, [&] { return processed_ >= target; });
+}
+
+bool SimThread::acquire()
+{
+    if ((ready_.load(std::memory_order_relaxed) & kFreshBit) == 0)
+        return false;
+    front_ = ready_.exchange(front_, std::memory_order_acq_rel) & ~kFreshBit;
+    return true;
+}
+
+void SimThread::publish()
+{
+    published_ = back_;
+    back_ = ready_.exchange(back_ | kFreshBit, std::memory_order_acq_rel) & ~kFreshBit;
+    if (onFrame_)
+        onFrame_();
+}
+
+void SimThread::run()
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeCv_.wait(lock, [this] { return stop_ || wakeRequested_; });
+            if (stop_)
+                break;
+            wakeRequested_ = false;
+        }
+
+        // Consecutive steps collapse into one simulated frame; nobody would see
+        // the intermediate ones.
+        std::uint64_t n = 0;
+        float stepDt = 0.0f;
+        float stepAdvanceMs = 0.0f;
+        bool stepForceVisible = false;
+        bool stepPending = false;
+        Command cmd;
+        while (tryPop(cmd))
+        {
+            ++n;
+            if (cmd.type == CommandType::Step)
+            {
+                queuedSteps_.fetch_sub(1, std::memory_order_release);
+                stepDt += cmd.dtSeconds;
+                stepAdvanceMs += cmd.dtSeconds * 1000.0f * cmd.playbackSpeed;
+                stepForceVisible = cmd.forceVisible;
+                stepPending = true;
+                continue;
+            }
+            if (stepPending)
+            {
+                simulate(std::min(stepDt, 0.1f), stepAdvanceMs, stepForceVisible);
+                stepDt = stepAdvanceMs = 0.0f;
+                stepPending = false;
+            }
+            apply(cmd);
+            cmd = Command(); // drop the model reference
+        }
+        if (stepPending)
+            simulate(std::min(stepDt, 0.1f), stepAdvanceMs, stepForceVisible);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            processed_ += n;
+        }
+        idleCv_.notify_all();
+    }
+}
+
+void SimThread::apply(const Command& cmd)
+{
+    if (cmd.type == CommandType::SetModel)
+    {
+        model_ = cmd.model;
+        generation_ = cmd.generation;
+        sequence_ = 0;
+        localTimeMs_ = 0;
+        bindCacheSeq_ = -1;
+        invBindByNodeId_.clear();
+        pose_.clear();
+        poseValid_ = false;
+        emitters_.clear();
+        staticWithoutSequences_ = false;
+        if (model_)
+        {
+            staticWithoutSequences_ = model_->sequences.empty() &&
+                                      ModelAnim::IsPoseConstant(*model_, 0, std::numeric_limits<std::uint32_t>::max());
+            // Per-emitter RNG streams; the same seed replays the same particles.
+            ParticleSim::ResetEmitters(*model_, cmd.seed, emitters_);
+            pose_.reset(model_->maxObjectId >= 0 ? std::size_t(model_->maxObjectId + 1) : 0);
+        }
+        buildSkinPlan();
+    }
+    else if (cmd.type == CommandType::SetSequence)
+    {
+        sequence_ = cmd.sequence;
+        localTimeMs_ = 0;
+        bindCacheSeq_ = -1;
+        poseValid_ = false;
+    }
+    simulate(0.0f, 0.0f, false);
+}
+
+bool SimThread::ensureBindCache()
+{
+    int seqIndex = 0;
+    if (!model_->sequences.empty())
+        seqIndex = std::max(0, std::min(int(model_->sequences.size()) - 1, sequence_));
+
+    if (bindCacheSeq_ == seqIndex && invBindByNodeId_.size() == pose_.world.size())
+        return false;
+
+    const std::uint32_t tBind =
+        model_->sequences.empty() ? 0u : model_->sequences[std::size_t(seqIndex)].startMs;
+    ModelAnim::ComputeNodePose(*model_, tBind, pose_);
+
+    invBindByNodeId_.resize(pose_.world.size());
+    for (std::size_t i = 0; i < pose_.world.size(); ++i)
+    {
+        bool ok = true;
+        invBindByNodeId_[i] = pose_.world[i].inverted(&ok);
+        if (!ok)
+            invBindByNodeId_[i].setToIdentity();
+    }
+    bindCacheSeq_ = seqIndex;
+    return true; // pose_ now holds the bind pose
+}
+
+void SimThread::buildSkinPlan()
+{
+    skinRanges_.clear();
+    rigidGroups_.clear();
+    if (!model_)
+        return;
+    const ModelData& model = *model_;
+
+    // Ranges come from the indices actually drawn, so a malformed geoset
+    // cannot reference vertices that are never skinned.
+    std::vector<std::pair<std::size_t, std::size_t>> ranges;
+    for (const SubMesh& sm : model.subMeshes)
+    {
+        if (sm.rigidGroup >= 0)
+        {
+            rigidGroups_.push_back(std::uint16_t(sm.rigidGroup));
+            continue;
+        }
+        if (sm.indexCount == 0 || std::size_t(sm.indexOffset) + sm.indexCount > model.indices.size())
+            continue;
+        const auto first = model.indices.begin() + std::ptrdiff_t(sm.indexOffset);
+        const auto range = std::minmax_element(first, first + std::ptrdiff_t(sm.indexCount));
+        ranges.emplace_back(std::size_t(*range.first), std::size_t(*range.second) + 1);
+    }
+    std::sort(rigidGroups_.begin(), rigidGroups_.end());
+    rigidGroups_.erase(std::unique(rigidGroups_.begin(), rigidGroups_.end()), rigidGroups_.end());
+
+    std::sort(ranges.begin(), ranges.end());
+    for (const auto& r : ranges)
+    {
+        if (!skinRanges_.empty() && r.first <= skinRanges_.back().second)
+            skinRanges_.back().second = std::max(skinRanges_.back().second, r.second);
+        else
+            skinRanges_.push_back(r);
+    }
+}
+
+void SimThread::simulate(float dtSeconds, float advanceMs, bool forceVisible)
+{
+    Trace::Scope trace("sim", "frame");
+    Frame& frame = frames_[back_];
+    frame.generation = generation_;
+    frame.skinned = false;
+    frame.packed = false;
+    frame.instances.clear();
+    frame.batches.clear();
+    frame.liveParticles = 0;
+    frame.samplingMs = frame.skinningMs = frame.particlesMs = 0.0;
+
+    if (!model_)
+    {
+        frame.globalTimeMs = 0;
+        publish();
+        return;
+    }
+    const ModelData& model = *model_;
+
+    localTimeMs_ += std::uint32_t(advanceMs);
+
+    // Sequence mapping; poses of a static sequence are all sampled at its start.
+    std::uint32_t globalTimeMs = localTimeMs_;
+    std::uint32_t poseTimeMs = staticWithoutSequences_ ? 0 : globalTimeMs;
+    if (!model.sequences.empty())
+    {
+        const std::size_t seqIndex = std::min<std::size_t>(model.sequences.size() - 1,
+                                                           std::size_t(std::max(0, sequence_)));
+        const auto& seq = model.sequences[seqIndex];
+        const std::uint32_t start = seq.startMs;
+        const std::uint32_t end = std::max(seq.endMs, seq.startMs + 1);
+        const std::uint32_t len = end - start;
+        globalTimeMs = start + ((len != 0) ? (localTimeMs_ % len) : 0);
+        poseTimeMs = seq.staticPose ? start : globalTimeMs;
+    }
+    frame.globalTimeMs = globalTimeMs;
+
+    const bool skinnable = !model.bindVertices.empty() &&
+                           model.vertexGroups.size() == model.bindVertices.size() &&
+                           !model.skinGroups.empty() && !model.nodes.empty();
+
+    QElapsedTimer timer;
+    timer.start();
+    if (skinnable && ensureBindCache())
+        poseValid_ = false;
+    const bool packVertices = packVertices_.load(std::memory_order_relaxed);
+    const bool poseChanged = !poseValid_ || poseTimeMs != poseTimeMs_ || (skinnable && packVertices != posePacked_);
+    if (poseChanged)
+    {
+        ModelAnim::ComputeNodePose(model, poseTimeMs, pose_);
+        poseValid_ = true;
+        poseTimeMs_ = poseTimeMs;
+        posePacked_ = packVertices;
+        ++poseSerial_;
+    }
+    frame.samplingMs = ElapsedMs(timer);
+
+    timer.start();
+    if (!model.emitters2.empty())
+    {
+        ParticleSim::StepParams params;
+        params.globalTimeMs = globalTimeMs;
+        params.localTimeMs = localTimeMs_;
+        params.dtSeconds = dtSeconds;
+        params.forceVisible = forceVisible;
+
+        // Emitters only read the model and this frame's pose and each owns its
+        // RNG, so they can be stepped on the pool in any order.
+        std::size_t live = 0;
+        for (const auto& rt : emitters_)
+            live += rt.particles.size();
+        if (emitters_.size() < 2 || live < kParallelParticleThreshold)
+        {
+            ParticleSim::StepEmitters(model, pose_, params, emitters_);
+        }
+        else
+        {
+            const ParticleSim::EmitterState* first = emitters_.data();
+            QtConcurrent::blockingMap(emitters_, [&](ParticleSim::EmitterState& rt)
+            {
+                ParticleSim::StepEmitter(model, pose_, params, std::size_t(&rt - first), rt);
+            });
+        }
+        buildInstances(frame);
+    }
+    frame.particlesMs = ElapsedMs(timer);
+
+    if (skinnable && !poseChanged)
+    {
+        // Same pose as the last published frame: carry its skinning over
+        // unless this slot already holds it.
+        timer.start();
+        if (frame.poseSerial != poseSerial_)
+            copySkinning(frames_[published_], frame);
+        frame.skinned = true;
+        frame.packed = posePacked_ && !skinRanges_.empty();
+        frame.skinningMs = ElapsedMs(timer);
+    }
+    else if (skinnable)
+    {
+        timer.start();
+        skinMats_.resize(pose_.world.size());
+        for (std::size_t i = 0; i < pose_.world.size(); ++i)
+            skinMats_[i] = pose_.world[i] * invBindByNodeId_[i];
+        // Rigid submeshes get one matrix per group; only the rest is skinned per vertex.
+        frame.groupMatrices.resize(model.skinGroups.size());
+        for (std::uint16_t gid : rigidGroups_)
+            frame.groupMatrices[gid] = ModelAnim::GroupSkinMatrix(model.skinGroups[gid], skinMats_);
+        for (const auto& r : skinRanges_)
+            ModelAnim::SkinVertexRange(model, skinMats_, r.first, r.second - r.first, frame.skinnedVertices);
+        frame.skinnedRanges = skinRanges_;
+        frame.skinned = true;
+        if (packVertices && !skinRanges_.empty())
+        {
+            // Packed here so the GUI thread uploads half the bytes and does no conversion.
+            // Bounds cover the skinned span only; stale rigid vertices inside it are never drawn.
+            const std::size_t lo = skinRanges_.front().first;
+            const std::size_t hi = skinRanges_.back().second;
+            frame.packedVertices.resize(frame.skinnedVertices.size());
+            frame.packedDecode = VertexPacking::Pack(frame.skinnedVertices.data() + lo, hi - lo,
+                                                     frame.packedVertices.data() + lo);
+            frame.packed = true;
+        }
+        frame.skinningMs = ElapsedMs(timer);
+    }
+    frame.poseSerial = poseSerial_;
+
+    publish();
+}
+
+void SimThread::copySkinning(const Frame& from, Frame& to) const
+{
+    to.skinnedVertices = from.skinnedVertices;
+    to.skinnedRanges = from.skinnedRanges;
+    to.groupMatrices = from.groupMatrices;
+    to.packed = from.packed;
+    to.packedVertices = from.packedVertices;
+    to.packedDecode = from.packedDecode;
+}
+
+void SimThread::buildInstances(Frame& frame) const
+{
+    const ModelData& model = *model_;
+    frame.batches.resize(model.emitters2.size());
+    for (std::size_t ei = 0; ei < model.emitters2.size() && ei < emitters_.size(); ++ei)
+    {
+        const auto& e = model.emitters2[ei];
+        const auto& particles = emitters_[ei].particles;
+        frame.liveParticles += particles.size();
+
+        EmitterBatch& batch = frame.batches[ei];
+        batch.first = frame.instances.size();
+        if ((e.flags & PRE2_MODEL_SPACE) != 0 && e.objectId >= 0 && std::size_t(e.objectId) < pose_.world.size())
+        {
+            batch.world = pose_.world[std::size_t(e.objectId)];
+            batch.sizeScale = pose_.worldScale[std::size_t(e.objectId)].x();
+        }
+
+        // One instance per head / tail; the vertex shader builds the quads.
+        const int totalFrames = int(std::max<std::uint32_t>(1, e.rows * e.columns));
+        const bool drawTails = e.tailLength > 0.0001f;
+        for (std::size_t pi = 0; pi < particles.size(); ++pi)
+        {
+            const ParticleSim::Particle p = particles.at(pi);
+            const bool tail = (p.tailType == 1);
+            if (tail ? !drawTails : p.tailType != 0)
+                continue;
+
+            const float tLife = std::clamp(p.age / std::max(0.001f, p.life), 0.0f, 1.0f);
+            ParticleInstance inst;
+            inst.px = p.pos.x();
+            inst.py = p.pos.y();
+            inst.pz = p.pos.z();
+            inst.lifeT = tLife;
+            inst.vx = p.vel.x();
+            inst.vy = p.vel.y();
+            inst.vz = p.vel.z();
+            inst.facing = p.facing;
+            inst.frame = std::uint16_t(std::clamp(PickFrame(e, tLife, tail, totalFrames), 0, 0xFFFF));
+            inst.tailType = tail ? 1 : 0;
+            frame.instances.push_back(inst);
+        }
+        batch.count = frame.instances.size() - batch.first;
+    }
+}
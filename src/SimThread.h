@@ -0,0 +1,180 @@
+#pragma once
+
+#include <QMatrix4x4>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ModelAnim.h"
+#include "ModelData.h"
+#include "ParticleSim.h"
+#include "VertexPacking.h"
+
+// The model viewer's animation work on its own thread: node poses, CPU
+// skinning, PRE2 simulation and particle instance building. The GUI thread
+// posts commands into a lock-free single-producer / single-consumer ring and
+// takes the newest finished frame from a triple buffer, so paintGL only
+// uploads and draws and never waits for a heavy model to simulate.
+//
+// Models are handed over as shared_ptr through the same ring; the thread keeps
+// its reference until the next SetModel, so the GUI may drop its own at any time.
+
+class SimThread
+{
+public:
+    // Per-instance record for the particle shader.
+    struct ParticleInstance
+    {
+        float px, py, pz;
+        float lifeT; // age / life, clamped to [0, 1]
+        float vx, vy, vz;
+        float facing;
+        std::uint16_t frame;
+        std::uint16_t tailType;
+    };
+
+    // Instances of one emitter within Frame::instances.
+    struct EmitterBatch
+    {
+        std::size_t first = 0;
+        std::size_t count = 0;
+        QMatrix4x4 world;       // identity unless the emitter is in model space
+        float sizeScale = 1.0f;
+    };
+
+    struct Frame
+    {
+        std::uint64_t generation = 0; // SetModel() generation this frame belongs to
+        std::uint32_t globalTimeMs = 0;
+        std::uint64_t poseSerial = 0; // changes whenever the node pose (and so the skinning) does
+        bool skinned = false;
+        std::vector<ModelVertex> skinnedVertices; // only skinnedRanges are current
+        std::vector<std::pair<std::size_t, std::size_t>> skinnedRanges; // [first, end), sorted
+        std::vector<QMatrix4x4> groupMatrices; // per skin group; current for rigid submeshes' groups
+        bool packed = false; // packedVertices holds skinnedVertices in the compact GPU format
+        std::vector<VertexPacking::PackedVertex> packedVertices;
+        VertexPacking::Decode packedDecode;
+        std::vector<ParticleInstance> instances;
+        std::vector<EmitterBatch> batches; // indexed like model.emitters2
+        std::size_t liveParticles = 0;
+        double samplingMs = 0.0;
+        double skinningMs = 0.0;
+        double particlesMs = 0.0;
+    };
+
+    // `onFrame` runs on the simulation thread after each publish.
+    explicit SimThread(std::function<void()> onFrame);
+    ~SimThread();
+
+    SimThread(const SimThread&) = delete;
+    SimThread& operator=(const SimThread&) = delete;
+
+    // GUI thread only. Every command is followed by a published frame.
+    void setModel(std::shared_ptr<const ModelData> model, std::uint64_t generation, std::uint32_t seed);
+    void setSequence(int sequence); // restarts local time
+    // Steps queue up to a small depth; beyond that dt is carried into the next
+    // step, so a slow model plays slower instead of building a backlog.
+    void step(float dtSeconds, float playbackSpeed, bool forceVisible);
+    // Skinned frames also carry packed vertices from the next simulated frame on.
+    void setPackVertices(bool enabled) { packVertices_.store(enabled, std::memory_order_relaxed); }
+    // Blocks until every command posted so far has been processed and published.
+    void waitIdle();
+
+    // Swaps in the newest published frame; false if nothing new since the last call.
+    bool acquire();
+    const Frame& front() const { return frames_[front_]; }
+
+private:
+    enum class CommandType
+    {
+        SetModel,
+        SetSequence,
+        Step
+    };
+
+    struct Command
+    {
+        CommandType type = CommandType::Step;
+        std::shared_ptr<const ModelData> model;
+        std::uint64_t generation = 0;
+        std::uint32_t seed = 0;
+        int sequence = 0;
+        float dtSeconds = 0.0f;
+        float playbackSpeed = 1.0f;
+        bool forceVisible = false;
+    };
+
+    static constexpr std::size_t kQueueCapacity = 64; // power of two
+    static constexpr int kMaxQueuedSteps = 2;
+    static constexpr int kFreshBit = 4;
+
+    void post(Command&& cmd);
+    bool tryPush(Command& cmd);
+    bool tryPop(Command& out);
+    void run();
+    void apply(const Command& cmd);
+    void simulate(float dtSeconds, float advanceMs, bool forceVisible);
+    bool ensureBindCache();
+    void copySkinning(const Frame& from, Frame& to) const;
+    void buildSkinPlan();
+    void buildInstances(Frame& frame) const;
+    void publish();
+
+    std::function<void()> onFrame_;
+
+    // Command ring: head_ is written by the GUI thread, tail_ by the simulation thread.
+    std::unique_ptr<Command[]> queue_;
+    std::atomic<std::size_t> head_{0};
+    std::atomic<std::size_t> tail_{0};
+    std::atomic<int> queuedSteps_{0};
+    std::atomic<bool> packVertices_{false};
+    float carriedDt_ = 0.0f;   // GUI side
+    std::uint64_t posted_ = 0; // GUI side
+
+    // Triple buffer: the thread fills back_, ready_ holds the last published
+    // slot (plus kFreshBit until the GUI takes it), the GUI reads front_.
+    Frame frames_[3];
+    std::atomic<int> ready_{1};
+    int back_ = 2;
+    int front_ = 0;
+    int published_ = 1; // slot of the last publish(); read-only until it comes back as back_
+
+    std::mutex mutex_;
+    std::condition_variable wakeCv_;
+    std::condition_variable idleCv_;
+    bool wakeRequested_ = false;
+    bool stop_ = false;
+    std::uint64_t processed_ = 0;
+
+    // Simulation state, touched only by the simulation thread.
+    std::shared_ptr<const ModelData> model_;
+    std::uint64_t generation_ = 0;
+    int sequence_ = 0;
+    std::uint32_t localTimeMs_ = 0;
+    ModelAnim::NodePose pose_;
+    int bindCacheSeq_ = -1;
+    std::vector<QMatrix4x4> invBindByNodeId_;
+    std::vector<QMatrix4x4> skinMats_;
+    // Node pose dirty tracking: pose_ and the published skinning stay valid
+    // while the pose time (a static sequence's start) and packing are unchanged.
+    bool poseValid_ = false;
+    std::uint32_t poseTimeMs_ = 0;
+    bool posePacked_ = false;
+    std::uint64_t poseSerial_ = 0;
+    bool staticWithoutSequences_ = false;
+    // Vertices of submeshes that need per-vertex skinning, and the groups of
+    // the rigid ones (see ModelAnim::ClassifyRigidSubMeshes).
+    std::vector<std::pair<std::size_t, std::size_t>> skinRanges_;
+    std::vector<std::uint16_t> rigidGroups_;
+    std::vector<ParticleSim::EmitterState> emitters_;
+
+    std::thread thread_;
+};
@@ -0,0 +1,224 @@
+#include "Trace.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    constexpr std::size_t kChunkEvents = 4096;
+    constexpr std::size_t kMaxChunks = 256; // ~1M events per thread, then drop
+    constexpr int kDetailBytes = 64;
+
+    struct Event
+    {
+        const char* category;
+        const char* name;
+        std::int64_t startNs;
+        std::int64_t durNs;
+        char detail[kDetailBytes];
+    };
+
+    struct Chunk
+    {
+        Event events[kChunkEvents];
+    };
+
+    // Single producer (the owning thread). Events below `count` are immutable,
+    // so the exporter can read them with an acquire load and no lock.
+    struct ThreadBuffer
+    {
+        int tid = 0;
+        QString name; // guarded by registryMutex()
+        std::atomic<std::size_t> count{0};
+        std::atomic<std::uint64_t> dropped{0};
+        std::atomic<Chunk*> chunks[kMaxChunks]{};
+
+        ~ThreadBuffer()
+        {
+            for (auto& c : chunks)
+                delete c.load();
+        }
+    };
+
+    std::atomic<bool> g_enabled{false};
+    std::atomic<std::int64_t> g_clearedAtNs{-1};
+    const auto g_epoch = std::chrono::steady_clock::now();
+
+    static QMutex& registryMutex()
+    {
+        static QMutex m;
+        return m;
+    }
+
+    // Buffers outlive their threads so pool workers that exit still show up in the dump.
+    static std::vector<std::unique_ptr<ThreadBuffer>>& registry()
+    {
+        static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        return buffers;
+    }
+
+    static ThreadBuffer* threadBuffer()
+    {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (!buffer)
+        {
+            QMutexLocker lock(&registryMutex());
+            registry().push_back(std::make_unique<ThreadBuffer>());
+            buffer = registry().back().get();
+            buffer->tid = int(registry().size());
+            buffer->name = QString("thread %1").arg(buffer->tid);
+        }
+        return buffer;
+    }
+}
+
+namespace Trace
+{
+    void SetEnabled(bool enabled)
+    {
+        g_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool IsEnabled()
+    {
+        return g_enabled.load(std::memory_order_relaxed);
+    }
+
+    void SetThreadName(const QString& name)
+    {
+        ThreadBuffer* b = threadBuffer();
+        QMutexLocker lock(&registryMutex());
+        b->name = name;
+    }
+
+    std::int64_t NowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+    }
+
+    void Record(const char* category, const char* name, std::int64_t startNs, std::int64_t endNs, const QString& detail)
+    {
+        if (!IsEnabled())
+            return;
+
+        ThreadBuffer* b = threadBuffer();
+        const std::size_t idx = b->count.load(std::memory_order_relaxed);
+        const std::size_t chunkIndex = idx / kChunkEvents;
+        if (chunkIndex >= kMaxChunks)
+        {
+            b->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Chunk* chunk = b->chunks[chunkIndex].load(std::memory_order_relaxed);
+        if (!chunk)
+        {
+            chunk = new Chunk;
+            b->chunks[chunkIndex].store(chunk, std::memory_order_release);
+        }
+
+        Event& e = chunk->events[idx % kChunkEvents];
+        e.category = category;
+        e.name = name;
+        e.startNs = startNs;
+        e.durNs = std::max<std::int64_t>(0, endNs - startNs);
+        e.detail[0] = '\0';
+        if (!detail.isEmpty())
+        {
+            // Keep the tail: for paths that is the file name.
+            const QByteArray utf8 = detail.toUtf8();
+            int n = std::min<int>(int(utf8.size()), kDetailBytes - 1);
+            const char* tail = utf8.constData() + (utf8.size() - n);
+            // Start on a character boundary, not inside a multi-byte sequence.
+            while (n > 0 && (static_cast<unsigned char>(*tail) & 0xC0) == 0x80)
+            {
+                ++tail;
+                --n;
+            }
+            std::memcpy(e.detail, tail, std::size_t(n));
+            e.detail[n] = '\0';
+        }
+        b->count.store(idx + 1, std::memory_order_release);
+    }
+
+    void Clear()
+    {
+        g_clearedAtNs.store(NowNs(), std::memory_order_relaxed);
+    }
+
+    QByteArray ToChromeJson()
+    {
+        const std::int64_t clearedAt = g_clearedAtNs.load(std::memory_order_relaxed);
+        QJsonArray events;
+
+        QJsonObject process;
+        process["ph"] = "M";
+        process["name"] = "process_name";
+        process["pid"] = 1;
+        process["args"] = QJsonObject{ { "name", QCoreApplication::applicationName() } };
+        events.append(process);
+
+        QMutexLocker lock(&registryMutex());
+        std::uint64_t dropped = 0;
+        for (const auto& b : registry())
+        {
+            QJsonObject meta;
+            meta["ph"] = "M";
+            meta["name"] = "thread_name";
+            meta["pid"] = 1;
+            meta["tid"] = b->tid;
+            meta["args"] = QJsonObject{ { "name", b->name } };
+            events.append(meta);
+
+            dropped += b->dropped.load(std::memory_order_relaxed);
+            const std::size_t count = b->count.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const Chunk* chunk = b->chunks[i / kChunkEvents].load(std::memory_order_acquire);
+                const Event& e = chunk->events[i % kChunkEvents];
+                if (e.startNs < clearedAt)
+                    continue;
+
+                QJsonObject o;
+                o["ph"] = "X";
+                o["cat"] = QString::fromLatin1(e.category);
+                o["name"] = QString::fromLatin1(e.name);
+                o["pid"] = 1;
+                o["tid"] = b->tid;
+                o["ts"] = double(e.startNs) / 1000.0;
+                o["dur"] = double(e.durNs) / 1000.0;
+                if (e.detail[0] != '\0')
+                    o["args"] = QJsonObject{ { "detail", QString::fromUtf8(e.detail) } };
+                events.append(o);
+            }
+        }
+
+        QJsonObject root;
+        root["traceEvents"] = events;
+        root["displayTimeUnit"] = "ms";
+        root["otherData"] = QJsonObject{ { "droppedEvents", double(dropped) } };
+        return QJsonDocument(root).toJson(QJsonDocument::Compact);
+    }
+
+    bool WriteChromeJson(const QString& path, QString* outError)
+    {
+        QFile f(path);
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            if (outError) *outError = QString("Cannot write trace: %1").arg(path);
+            return false;
+        }
+        f.write(ToChromeJson());
+        return true;
+    }
+}
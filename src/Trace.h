@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <cstdint>
+
+// Span tracing for load / render timelines, exported as Chrome trace JSON
+// (chrome://tracing, ui.perfetto.dev). Each thread appends to its own
+// append-only buffer, so recording never takes a lock; only the first event
+// on a new thread registers its buffer.
+
+namespace Trace
+{
+    void SetEnabled(bool enabled);
+    bool IsEnabled();
+
+    // Label for the calling thread in the exported timeline.
+    void SetThreadName(const QString& name);
+
+    // Monotonic ns since process start.
+    std::int64_t NowNs();
+
+    // `category` and `name` must be string literals (stored by pointer).
+    void Record(const char* category, const char* name, std::int64_t startNs, std::int64_t endNs,
+                const QString& detail = QString());
+
+    // Drops events recorded so far (buffers are kept; older events are filtered on export).
+    void Clear();
+
+    QByteArray ToChromeJson();
+    bool WriteChromeJson(const QString& path, QString* outError = nullptr);
+
+    class Scope
+    {
+    public:
+        Scope(const char* category, const char* name, const QString& detail = QString())
+            : category_(category), name_(name), detail_(detail), startNs_(IsEnabled() ? NowNs() : -1)
+        {
+        }
+        ~Scope()
+        {
+            if (startNs_ >= 0)
+                Record(category_, name_, startNs_, NowNs(), detail_);
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* category_;
+        const char* name_;
+        QString detail_;
+        std::int64_t startNs_;
+    };
+}
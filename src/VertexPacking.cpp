@@ -0,0 +1,142 @@
+#include "VertexPacking.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    constexpr float kUnorm16 = 65535.0f;
+    constexpr float kSnorm16 = 32767.0f;
+
+    static std::uint16_t ToUnorm16(float value, float bias, float scale)
+    {
+        const float t = (value - bias) / scale;
+        return std::uint16_t(std::lround(std::clamp(t, 0.0f, 1.0f) * kUnorm16));
+    }
+
+    static std::int16_t ToSnorm16(float value)
+    {
+        return std::int16_t(std::lround(std::clamp(value, -1.0f, 1.0f) * kSnorm16));
+    }
+
+    static float SignNotZero(float v)
+    {
+        return v >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    // Range of one component over the set; a flat range still gets a usable scale.
+    static void Range(float lo, float hi, float& scale, float& bias)
+    {
+        bias = lo;
+        scale = hi > lo ? hi - lo : 1.0f;
+    }
+}
+
+namespace VertexPacking
+{
+    Decode Pack(const ModelVertex* in, std::size_t count, PackedVertex* out)
+    {
+        Decode d;
+        if (count == 0)
+            return d;
+
+        float lo[5], hi[5];
+        std::fill(lo, lo + 5, std::numeric_limits<float>::max());
+        std::fill(hi, hi + 5, std::numeric_limits<float>::lowest());
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const ModelVertex& v = in[i];
+            const float c[5] = {v.px, v.py, v.pz, v.u, v.v};
+            for (int k = 0; k < 5; ++k)
+            {
+                lo[k] = std::min(lo[k], c[k]);
+                hi[k] = std::max(hi[k], c[k]);
+            }
+        }
+        for (int k = 0; k < 3; ++k)
+            Range(lo[k], hi[k], d.posScale[k], d.posBias[k]);
+        for (int k = 0; k < 2; ++k)
+            Range(lo[3 + k], hi[3 + k], d.uvScale[k], d.uvBias[k]);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const ModelVertex& v = in[i];
+            PackedVertex& p = out[i];
+            p.px = ToUnorm16(v.px, d.posBias[0], d.posScale[0]);
+            p.py = ToUnorm16(v.py, d.posBias[1], d.posScale[1]);
+            p.pz = ToUnorm16(v.pz, d.posBias[2], d.posScale[2]);
+            p.pad = 0;
+
+            // Octahedral: project onto |x|+|y|+|z| = 1, fold the lower half over the diagonals.
+            const float l1 = std::fabs(v.nx) + std::fabs(v.ny) + std::fabs(v.nz);
+            float ox = 0.0f, oy = 0.0f;
+            if (l1 > 0.0f)
+            {
+                ox = v.nx / l1;
+                oy = v.ny / l1;
+                if (v.nz < 0.0f)
+                {
+                    const float fx = (1.0f - std::fabs(oy)) * SignNotZero(ox);
+                    const float fy = (1.0f - std::fabs(ox)) * SignNotZero(oy);
+                    ox = fx;
+                    oy = fy;
+                }
+            }
+            p.ox = ToSnorm16(ox);
+            p.oy = ToSnorm16(oy);
+
+            p.u = ToUnorm16(v.u, d.uvBias[0], d.uvScale[0]);
+            p.v = ToUnorm16(v.v, d.uvBias[1], d.uvScale[1]);
+        }
+        return d;
+    }
+
+    ModelVertex Unpack(const PackedVertex& p, const Decode& d)
+    {
+        ModelVertex v;
+        v.px = float(p.px) / kUnorm16 * d.posScale[0] + d.posBias[0];
+        v.py = float(p.py) / kUnorm16 * d.posScale[1] + d.posBias[1];
+        v.pz = float(p.pz) / kUnorm16 * d.posScale[2] + d.posBias[2];
+
+        // Same decode as the mesh vertex shader.
+        float nx = std::max(float(p.ox) / kSnorm16, -1.0f);
+        float ny = std::max(float(p.oy) / kSnorm16, -1.0f);
+        const float nz = 1.0f - std::fabs(nx) - std::fabs(ny);
+        const float t = std::max(-nz, 0.0f);
+        nx += nx >= 0.0f ? -t : t;
+        ny += ny >= 0.0f ? -t : t;
+        const float len = std::sqrt(nx * nx + ny * ny + nz * nz);
+        v.nx = nx / len;
+        v.ny = ny / len;
+        v.nz = nz / len;
+
+        v.u = float(p.u) / kUnorm16 * d.uvScale[0] + d.uvBias[0];
+        v.v = float(p.v) / kUnorm16 * d.uvScale[1] + d.uvBias[1];
+        return v;
+    }
+
+    Error MeasureError(const ModelVertex* in, std::size_t count)
+    {
+        Error e;
+        std::vector<PackedVertex> packed(count);
+        const Decode d = Pack(in, count, packed.data());
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const ModelVertex& a = in[i];
+            const ModelVertex b = Unpack(packed[i], d);
+            const float dx = a.px - b.px, dy = a.py - b.py, dz = a.pz - b.pz;
+            e.maxPosition = std::max(e.maxPosition, std::sqrt(dx * dx + dy * dy + dz * dz));
+            e.maxUv = std::max({e.maxUv, std::fabs(a.u - b.u), std::fabs(a.v - b.v)});
+
+            const float len = std::sqrt(a.nx * a.nx + a.ny * a.ny + a.nz * a.nz);
+            if (len > 0.0f)
+            {
+                const float c = std::clamp((a.nx * b.nx + a.ny * b.ny + a.nz * b.nz) / len, -1.0f, 1.0f);
+                e.maxNormalDegrees = std::max(e.maxNormalDegrees, std::acos(c) * 57.29578f);
+            }
+        }
+        return e;
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ModelData.h"
+
+// Compact 16-byte GPU vertex, half of ModelVertex:
+// - position: unsigned 16-bit normalized, relative to the packed set's bounds;
+// - normal: octahedral, two signed 16-bit normalized components;
+// - UV: unsigned 16-bit normalized, relative to the packed set's UV bounds.
+// The mesh shader maps positions and UVs back with the scale / bias in Decode.
+
+namespace VertexPacking
+{
+    struct PackedVertex
+    {
+        std::uint16_t px, py, pz;
+        std::uint16_t pad;
+        std::int16_t ox, oy;
+        std::uint16_t u, v;
+    };
+    static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay 16 bytes");
+
+    // value = normalized * scale + bias
+    struct Decode
+    {
+        float posScale[3] = {1.0f, 1.0f, 1.0f};
+        float posBias[3] = {0.0f, 0.0f, 0.0f};
+        float uvScale[2] = {1.0f, 1.0f};
+        float uvBias[2] = {0.0f, 0.0f};
+    };
+
+    // Packs `count` vertices into `out` (same count) and returns their decode.
+    Decode Pack(const ModelVertex* in, std::size_t count, PackedVertex* out);
+
+    // What the shader reconstructs; the normal is unit length.
+    ModelVertex Unpack(const PackedVertex& v, const Decode& decode);
+
+    struct Error
+    {
+        float maxPosition = 0.0f; // model units
+        float maxNormalDegrees = 0.0f;
+        float maxUv = 0.0f;
+    };
+    Error MeasureError(const ModelVertex* in, std::size_t count);
+}
@@ -3,8 +3,10 @@
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QSet>
 
 #include "LogSink.h"
+#include "Trace.h"
 
 #ifdef _UNICODE
 #define STORMLIB_UNICODE_WAS_DEFINED
@@ -17,7 +19,9 @@
 #define UNICODE 1
 #undef STORMLIB_UNICODE_WAS_DEFINED
 #endif
+#ifdef _WIN32
 #include <windows.h>
+#endif
 
 DiskVfs::DiskVfs(QString rootPath)
     : root_(std::move(rootPath))
@@ -44,6 +48,7 @@ bool DiskVfs::exists(const QString& path) const
 
 QByteArray DiskVfs::readAll(const QString& path) const
 {
+    Trace::Scope trace("vfs", "DiskRead", path);
     if (root_.isEmpty())
         return {};
     const QString candidate = QDir(root_).filePath(path);
@@ -101,6 +106,7 @@ QStringList MpqVfs::buildCandidatePaths(const QString& path) const
 
 bool MpqVfs::mountWar3Root(const QString& rootPath)
 {
+    QMutexLocker lock(&mutex_);
     for (auto& a : archives_)
     {
         if (a.handle)
@@ -131,41 +137,81 @@ bool MpqVfs::mountWar3Root(const QString& rootPath)
         const QString full = QDir(rootPath).filePath(name);
         if (!QFileInfo::exists(full))
             continue;
-
-        HANDLE h = nullptr;
-        const QByteArray fullBytes = QFile::encodeName(full);
-        const auto* fullPath = fullBytes.constData();
-        if (SFileOpenArchive(fullPath, 0, MPQ_OPEN_READ_ONLY, &h))
-        {
-            Archive a;
-            a.handle = h;
-            a.path = full;
-            archives_.push_back(a);
-            LogSink::instance().log(QString("MPQ mounted: %1").arg(full));
-        }
-        else
-        {
-            const DWORD err = GetLastError();
-            LogSink::instance().log(QString("MPQ mount failed: %1 (err=%2)").arg(full).arg(err));
-        }
+        openArchive(full);
     }
 
     return !archives_.empty();
 }
 
+bool MpqVfs::mountArchive(const QString& archivePath)
+{
+    QMutexLocker lock(&mutex_);
+    return openArchive(archivePath);
+}
+
+bool MpqVfs::openArchive(const QString& archivePath)
+{
+    HANDLE h = nullptr;
+    const QByteArray fullBytes = QFile::encodeName(archivePath);
+    const auto* fullPath = fullBytes.constData();
+    if (SFileOpenArchive(fullPath, 0, MPQ_OPEN_READ_ONLY, &h))
+    {
+        Archive a;
+        a.handle = h;
+        a.path = archivePath;
+        archives_.push_back(a);
+        LogSink::instance().log(QString("MPQ mounted: %1").arg(archivePath));
+        return true;
+    }
+
+    const DWORD err = GetLastError();
+    LogSink::instance().log(LogLevel::Warning, QString("MPQ mount failed: %1 (err=%2)").arg(archivePath).arg(err));
+    return false;
+}
+
 int MpqVfs::mountedCount() const
 {
+    QMutexLocker lock(&mutex_);
     return int(archives_.size());
 }
 
 QStringList MpqVfs::mountedArchives() const
 {
+    QMutexLocker lock(&mutex_);
     QStringList out;
     for (const auto& a : archives_)
         out << a.path;
     return out;
 }
 
+QStringList MpqVfs::listFiles(const QString& mask) const
+{
+    QMutexLocker lock(&mutex_);
+    const QByteArray maskBytes = mask.toUtf8();
+    QStringList out;
+    QSet<QString> seen;
+    for (auto it = archives_.rbegin(); it != archives_.rend(); ++it)
+    {
+        SFILE_FIND_DATA fd;
+        HANDLE hFind = SFileFindFirstFile(it->handle, maskBytes.constData(), &fd, nullptr);
+        if (!hFind)
+            continue;
+        do
+        {
+            const QString name = QString::fromLocal8Bit(fd.cFileName);
+            const QString key = name.toLower();
+            if (!seen.contains(key))
+            {
+                seen.insert(key);
+                out << name;
+            }
+        } while (SFileFindNextFile(hFind, &fd));
+        SFileFindClose(hFind);
+    }
+    out.sort(Qt::CaseInsensitive);
+    return out;
+}
+
 bool MpqVfs::openFileFromArchives(const QStringList& candidates, void** outFileHandle, QString* outArchive) const
 {
     for (auto it = archives_.rbegin(); it != archives_.rend(); ++it)
@@ -187,6 +233,7 @@ bool MpqVfs::openFileFromArchives(const QStringList& candidates, void** outFileH
 
 bool MpqVfs::exists(const QString& path) const
 {
+    QMutexLocker lock(&mutex_);
     const QStringList candidates = buildCandidatePaths(path);
 
     void* hFile = nullptr;
@@ -199,22 +246,26 @@ bool MpqVfs::exists(const QString& path) const
 
 QByteArray MpqVfs::readAll(const QString& path) const
 {
+    Trace::Scope trace("vfs", "MpqRead", path);
+    QMutexLocker lock(&mutex_);
     const QStringList candidates = buildCandidatePaths(path);
 
     HANDLE hFile = nullptr;
     QString archive;
     if (!openFileFromArchives(candidates, (void**)&hFile, &archive))
     {
-        LogSink::instance().log(QString("MPQ miss: %1").arg(path));
-        if (!archives_.empty())
+        static LogSink::RateLimit missLimit(20);
+        LogSink::instance().log(LogLevel::Warning, QString("MPQ miss: %1").arg(path), &missLimit);
+        if (LogSink::instance().isEnabled(LogLevel::Debug))
         {
             QStringList mounts;
             for (const auto& a : archives_)
                 mounts << a.path;
-            LogSink::instance().log(QString("MPQ mounted list: %1").arg(mounts.join("; ")));
+            if (!mounts.isEmpty())
+                LogSink::instance().log(LogLevel::Debug, QString("MPQ mounted list: %1").arg(mounts.join("; ")));
+            if (!candidates.isEmpty())
+                LogSink::instance().log(LogLevel::Debug, QString("MPQ tried: %1").arg(candidates.join(" | ")));
         }
-        if (!candidates.isEmpty())
-            LogSink::instance().log(QString("MPQ tried: %1").arg(candidates.join(" | ")));
         return {};
     }
 
@@ -238,6 +289,7 @@ QByteArray MpqVfs::readAll(const QString& path) const
 
 QString MpqVfs::resolveDebugInfo(const QString& path) const
 {
+    QMutexLocker lock(&mutex_);
     const QStringList candidates = buildCandidatePaths(path);
     HANDLE hFile = nullptr;
     QString archive;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QByteArray>
+#include <QMutex>
 #include <QString>
 #include <QStringList>
 #include <memory>
@@ -37,8 +38,12 @@ public:
     ~MpqVfs() override;
 
     bool mountWar3Root(const QString& rootPath);
+    // Mounts one more archive with the highest priority.
+    bool mountArchive(const QString& archivePath);
     int mountedCount() const;
     QStringList mountedArchives() const;
+    // Lists files matching a wildcard mask (e.g. "*.mdx") using each archive's (listfile).
+    QStringList listFiles(const QString& mask) const;
 
     bool exists(const QString& path) const override;
     QByteArray readAll(const QString& path) const override;
@@ -53,9 +58,12 @@ private:
 
     QString normalizePath(const QString& path) const;
     QStringList buildCandidatePaths(const QString& path) const;
+    bool openArchive(const QString& archivePath);
     bool openFileFromArchives(const QStringList& candidates, void** outFileHandle, QString* outArchive) const;
 
     std::vector<Archive> archives_;
+    // StormLib archive handles are not safe to read from several threads at once.
+    mutable QMutex mutex_;
 };
 
 class CompositeVfs final : public IVfs
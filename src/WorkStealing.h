@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Minimal work-stealing parallel-for for batch jobs (file validation, conversion).
+// Each worker starts on a contiguous shard of indices; when it runs dry it steals
+// the upper half of the busiest remaining shard, so a few huge models do not leave
+// the other cores idle. Items are claimed exactly once.
+
+namespace WorkStealing
+{
+    namespace detail
+    {
+        struct Shard
+        {
+            std::mutex mutex;
+            std::size_t begin = 0;
+            std::size_t end = 0;
+        };
+
+        inline bool PopFront(Shard& s, std::size_t& out)
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            if (s.begin >= s.end)
+                return false;
+            out = s.begin++;
+            return true;
+        }
+
+        inline bool Steal(std::vector<Shard>& shards, std::size_t self, std::size_t& out)
+        {
+            for (;;)
+            {
+                std::size_t victim = shards.size();
+                std::size_t best = 0;
+                for (std::size_t i = 0; i < shards.size(); ++i)
+                {
+                    if (i == self)
+                        continue;
+                    std::lock_guard<std::mutex> lock(shards[i].mutex);
+                    const std::size_t remaining = shards[i].end - shards[i].begin;
+                    if (shards[i].begin < shards[i].end && remaining > best)
+                    {
+                        best = remaining;
+                        victim = i;
+                    }
+                }
+                if (victim == shards.size())
+                    return false;
+
+                std::size_t first = 0;
+                std::size_t last = 0;
+                {
+                    Shard& v = shards[victim];
+                    std::lock_guard<std::mutex> lock(v.mutex);
+                    if (v.begin >= v.end)
+                        continue; // drained meanwhile; pick another victim
+                    const std::size_t take = (v.end - v.begin + 1) / 2;
+                    last = v.end;
+                    first = v.end - take;
+                    v.end = first;
+                }
+                {
+                    Shard& s = shards[self];
+                    std::lock_guard<std::mutex> lock(s.mutex);
+                    s.begin = first + 1;
+                    s.end = last;
+                }
+                out = first;
+                return true;
+            }
+        }
+    }
+
+    inline int ResolveThreadCount(int threads)
+    {
+        if (threads > 0)
+            return threads;
+        const unsigned hw = std::thread::hardware_concurrency();
+        return hw > 0 ? int(hw) : 1;
+    }
+
+    // Calls fn(index) for every index in [0, count). threads <= 0 uses all cores.
+    template<typename Fn>
+    void ParallelFor(std::size_t count, int threads, Fn&& fn)
+    {
+        if (count == 0)
+            return;
+        const std::size_t workers = std::min<std::size_t>(std::size_t(ResolveThreadCount(threads)), count);
+        if (workers <= 1)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+                fn(i);
+            return;
+        }
+
+        std::vector<detail::Shard> shards(workers);
+        for (std::size_t w = 0; w < workers; ++w)
+        {
+            shards[w].begin = count * w / workers;
+            shards[w].end = count * (w + 1) / workers;
+        }
+
+        auto run = [&](std::size_t self)
+        {
+            std::size_t index = 0;
+            for (;;)
+            {
+                if (!detail::PopFront(shards[self], index) && !detail::Steal(shards, self, index))
+                    break;
+                fn(index);
+            }
+        };
+
+        std::vector<std::thread> pool;
+        pool.reserve(workers - 1);
+        for (std::size_t w = 1; w < workers; ++w)
+            pool.emplace_back(run, w);
+        run(0);
+        for (auto& th : pool)
+            th.join();
+    }
+}
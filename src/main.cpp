@@ -1,4 +1,5 @@
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QDir>
 #include <QDirIterator>
 #include <QDebug>
@@ -6,11 +7,23 @@
 #include <QTextStream>
 #include <QSurfaceFormat>
 
+#include <algorithm>
+
 #include "MainWindow.h"
-#include "MdxLoader.h"
+#include "MdxValidator.h"
 #include "LogSink.h"
+#include "RenderBench.h"
+#include "Trace.h"
 
-static void ConfigureOpenGL()
+static bool HasArg(int argc, char* argv[], const char* name)
+{
+    for (int i = 1; i < argc; ++i)
+        if (qstrcmp(argv[i], name) == 0)
+            return true;
+    return false;
+}
+
+static void ConfigureOpenGL(bool noVsync)
 {
     // Request a modern core profile. If the system can't provide it,
     // Qt may fall back (e.g., ANGLE). The viewer handles that gracefully.
@@ -20,20 +33,71 @@ static void ConfigureOpenGL()
     fmt.setVersion(3, 3);
     fmt.setProfile(QSurfaceFormat::CoreProfile);
     fmt.setSamples(4);
+    if (noVsync)
+        fmt.setSwapInterval(0);
     QSurfaceFormat::setDefaultFormat(fmt);
 }
 
 int main(int argc, char *argv[])
 {
-    ConfigureOpenGL();
+    // The surface format must be set before QApplication exists.
+    const bool renderBench = HasArg(argc, argv, "--render-bench");
+    ConfigureOpenGL(renderBench);
 
     QApplication app(argc, argv);
     QApplication::setApplicationName("War3 Batch Model Previewer");
+    QApplication::setApplicationVersion("0.1.0");
     QApplication::setOrganizationName("Local");
 
     QDir(QDir::current()).mkpath("logs");
     LogSink::instance().init(QDir(QDir::current()).filePath("logs/latest.log"));
 
+    // Span tracing is cheap (per-thread append, no locks); dumped via Save Trace / Export Diagnostics.
+    Trace::SetEnabled(true);
+    Trace::SetThreadName("GUI");
+
+    if (renderBench)
+    {
+        QCommandLineParser parser;
+        parser.setApplicationDescription("Deterministic offscreen render benchmark.");
+        parser.addHelpOption();
+        const QCommandLineOption benchOpt("render-bench", "Model list: .mdx file, folder, or text file with one path per line.", "models");
+        const QCommandLineOption framesOpt("frames", "Timed frames per model (default 300).", "n", "300");
+        const QCommandLineOption warmupOpt("warmup", "Untimed frames per model (default 30).", "n", "30");
+        const QCommandLineOption stepOpt("step-ms", "Simulated time per frame in ms (default 16.667).", "ms", "16.667");
+        const QCommandLineOption seedOpt("seed", "Particle RNG seed (default 1337).", "n", "1337");
+        const QCommandLineOption sizeOpt("size", "Framebuffer size WxH (default 1280x720).", "size", "1280x720");
+        const QCommandLineOption outOpt("out", "Write the JSON report to <file> instead of stdout.", "file");
+        const QCommandLineOption packedOpt("packed-vertices", "Upload vertices in the packed 16-byte format.");
+        const QCommandLineOption diffOpt("vertex-diff", "Compare float and packed vertices instead of timing: image difference "
+                                                        "and vertex error in pixels after --warmup steps.");
+        const QCommandLineOption diffImagesOpt("diff-images", "With --vertex-diff, save float / packed / difference PNGs to <dir>.", "dir");
+        parser.addOptions({ benchOpt, framesOpt, warmupOpt, stepOpt, seedOpt, sizeOpt, outOpt, packedOpt, diffOpt, diffImagesOpt });
+        parser.process(app);
+
+        RenderBench::Options opt;
+        opt.models = RenderBench::CollectModels(parser.value(benchOpt));
+        opt.frames = std::max(1, parser.value(framesOpt).toInt());
+        opt.warmup = std::max(0, parser.value(warmupOpt).toInt());
+        opt.stepMs = std::max(0.0, parser.value(stepOpt).toDouble());
+        opt.seed = parser.value(seedOpt).toUInt();
+        const QStringList size = parser.value(sizeOpt).split('x');
+        if (size.size() == 2)
+        {
+            opt.width = std::max(1, size[0].toInt());
+            opt.height = std::max(1, size[1].toInt());
+        }
+        opt.outPath = parser.value(outOpt);
+        opt.packedVertices = parser.isSet(packedOpt);
+        opt.diffImageDir = parser.value(diffImagesOpt);
+        if (opt.models.isEmpty())
+        {
+            qWarning().noquote() << "render-bench: no .mdx files in" << parser.value(benchOpt);
+            return 2;
+        }
+        return parser.isSet(diffOpt) ? RenderBench::RunVertexDiff(opt) : RenderBench::Run(opt);
+    }
+
     if (qEnvironmentVariableIsSet("MDX_DEBUG_LOAD"))
     {
         QFile logFile;
@@ -63,42 +127,61 @@ int main(int argc, char *argv[])
         if (cwd.exists("resource"))
         {
             QDir res(cwd.filePath("resource"));
+            QStringList files;
             QDirIterator it(res.absolutePath(),
                             QStringList() << "*.mdx" << "*.MDX",
                             QDir::Files,
                             QDirIterator::Subdirectories);
             while (it.hasNext())
+                files << it.next();
+            files.sort(Qt::CaseInsensitive);
+
+            // MDX_DEBUG_THREADS=N limits workers (default: all cores).
+            const int threads = qEnvironmentVariableIntValue("MDX_DEBUG_THREADS");
+            MdxValidator::RunSummary summary;
+            const auto results = MdxValidator::ValidateFiles(files, threads, &summary);
+
+            for (const auto& r : results)
             {
-                const QString path = it.next();
-                QString err;
-                const auto model = MdxLoader::LoadFromFile(path, &err);
-                if (!model)
+                if (!r.loaded)
                 {
-                    logLine(QString("MDX load failed: %1 | %2").arg(path, err), true);
-                }
-                else
-                {
-                    std::uint32_t maxIndex = 0;
-                    for (std::uint32_t idx : model->indices)
-                        maxIndex = std::max(maxIndex, idx);
-                    const bool indexOk = model->indices.empty() || (maxIndex < model->vertices.size());
-
-                    logLine(QString("MDX load ok: %1 | verts %2 | tris %3 | submeshes %4 | maxIndex %5 | indexOk %6 | bounds [%7,%8,%9]-[%10,%11,%12]")
-                                .arg(path)
-                                .arg(model->vertices.size())
-                                .arg(model->indices.size() / 3)
-                                .arg(model->subMeshes.size())
-                                .arg(maxIndex)
-                                .arg(indexOk ? "yes" : "no")
-                                .arg(model->boundsMin[0], 0, 'f', 3)
-                                .arg(model->boundsMin[1], 0, 'f', 3)
-                                .arg(model->boundsMin[2], 0, 'f', 3)
-                                .arg(model->boundsMax[0], 0, 'f', 3)
-                                .arg(model->boundsMax[1], 0, 'f', 3)
-                                .arg(model->boundsMax[2], 0, 'f', 3),
-                            false);
+                    logLine(QString("MDX load failed: %1 | %2").arg(r.path, r.loadError), true);
+                    continue;
                 }
+
+                logLine(QString("MDX load ok: %1 | verts %2 | tris %3 | submeshes %4 | maxIndex %5 | indexOk %6 | bounds [%7,%8,%9]-[%10,%11,%12] | issues %13")
+                            .arg(r.path)
+                            .arg(r.vertexCount)
+                            .arg(r.triangleCount)
+                            .arg(r.subMeshCount)
+                            .arg(r.maxIndex)
+                            .arg(r.indexOk ? "yes" : "no")
+                            .arg(r.boundsMin[0], 0, 'f', 3)
+                            .arg(r.boundsMin[1], 0, 'f', 3)
+                            .arg(r.boundsMin[2], 0, 'f', 3)
+                            .arg(r.boundsMax[0], 0, 'f', 3)
+                            .arg(r.boundsMax[1], 0, 'f', 3)
+                            .arg(r.boundsMax[2], 0, 'f', 3)
+                            .arg(r.issues.size()),
+                        false);
+                for (const auto& issue : r.issues)
+                    logLine(QString("  [%1] %2").arg(issue.check, issue.message), true);
             }
+
+            QStringList counts;
+            for (const auto& c : summary.issueCounts)
+                counts << QString("%1=%2").arg(c.first).arg(c.second);
+            logLine(QString("MDX validation: %1 files | %2 loaded | %3 load failed | %4 with issues%5 | %6 threads | %7 ms | %8 files/s | %9 MB/s")
+                        .arg(summary.files)
+                        .arg(summary.loaded)
+                        .arg(summary.loadFailed)
+                        .arg(summary.withIssues)
+                        .arg(counts.isEmpty() ? QString() : QString(" (%1)").arg(counts.join(", ")))
+                        .arg(summary.threads)
+                        .arg(summary.wallMs, 0, 'f', 1)
+                        .arg(summary.filesPerSec, 0, 'f', 1)
+                        .arg(summary.mbPerSec, 0, 'f', 1),
+                    false);
         }
         else
         {